@@ -67,6 +67,9 @@ class Scheduler {
 
       // Thread affinity policy to use for worker threads.
       std::shared_ptr<Thread::Affinity::Policy> affinityPolicy;
+
+      // How long an idle worker spins looking for work before it sleeps.
+      std::chrono::microseconds spinDuration = std::chrono::milliseconds(1);
     };
 
     WorkerThread workerThread;
@@ -91,6 +94,8 @@ class Scheduler {
         const ThreadInitializer&);
     MARL_NO_EXPORT inline Config& setWorkerThreadAffinityPolicy(
         const std::shared_ptr<Thread::Affinity::Policy>&);
+    MARL_NO_EXPORT inline Config& setWorkerThreadSpinDuration(
+        std::chrono::microseconds);
   };
 
   // Constructor.
@@ -548,6 +553,12 @@ Scheduler::Config& Scheduler::Config::setWorkerThreadAffinityPolicy(
   return *this;
 }
 
+Scheduler::Config& Scheduler::Config::setWorkerThreadSpinDuration(
+    std::chrono::microseconds duration) {
+  workerThread.spinDuration = duration;
+  return *this;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Scheduler::Fiber
 ////////////////////////////////////////////////////////////////////////////////
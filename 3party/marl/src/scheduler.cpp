@@ -638,7 +638,7 @@ void Scheduler::Worker::spinForWorkAndLock() {
   TRACE("SPIN");
   Task stolen;
 
-  constexpr auto duration = std::chrono::milliseconds(1);
+  const auto duration = scheduler->cfg.workerThread.spinDuration;
   auto start = std::chrono::high_resolution_clock::now();
   while (std::chrono::high_resolution_clock::now() - start < duration) {
     for (int i = 0; i < 256; i++)  // Empirically picked magic number!
@@ -45,6 +45,7 @@ public:
     BufferT(BufferT &&buf) : size_(buf.size()), capacity_(buf.capacity()), data_(std::move(buf.data_))
     {
         IsConsistent();
+        buf.OnMovedFrom();
     }
 
     explicit BufferT(size_t size) : BufferT(size, size) {}
@@ -136,7 +137,7 @@ public:
     {
         const size_t old_size = size_;
         size_                 = 0;
-        AppentData(data, size);
+        AppendData(data, size);
         if (ZeroOnFree && size_ < old_size) { ZeroTrailingData(old_size - size_); }
     }
 
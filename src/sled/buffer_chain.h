@@ -0,0 +1,148 @@
+/**
+ * @file     : buffer_chain
+ * @created  : Saturday Oct 17, 2026 16:21:05 CST
+ * @license  : MIT
+ **/
+
+#pragma once
+#ifndef SLED_BUFFER_CHAIN_H
+#define SLED_BUFFER_CHAIN_H
+#include "sled/buffer.h"
+#include <deque>
+#include <utility>
+
+namespace sled {
+
+// iovec-like view of bytes owned by someone else
+struct BufferSlice {
+    BufferSlice() : data(nullptr), size(0) {}
+
+    BufferSlice(const void *data, size_t size) : data(static_cast<const uint8_t *>(data)), size(size) {}
+
+    BufferSlice(const Buffer &buffer) : data(buffer.data()), size(buffer.size()) {}
+
+    const uint8_t *data;
+    size_t size;
+};
+
+struct MutableBufferSlice {
+    MutableBufferSlice() : data(nullptr), size(0) {}
+
+    MutableBufferSlice(void *data, size_t size) : data(static_cast<uint8_t *>(data)), size(size) {}
+
+    // the whole capacity, SetSize() the buffer after the read
+    MutableBufferSlice(Buffer &buffer) : data(buffer.data()), size(buffer.capacity()) {}
+
+    uint8_t *data;
+    size_t size;
+};
+
+/**
+ * A sequence of owned Buffers read as one byte stream. Append/Prepend move
+ * buffers in, so framing can put a header in front of a payload without
+ * copying the payload; Socket::SendV() writes the segments with one syscall.
+ **/
+class BufferChain {
+public:
+    BufferChain() : size_(0) {}
+
+    BufferChain(BufferChain &&other) : segments_(std::move(other.segments_)), size_(other.size_) { other.size_ = 0; }
+
+    BufferChain &operator=(BufferChain &&other)
+    {
+        segments_ = std::move(other.segments_);
+        size_ = other.size_;
+        other.size_ = 0;
+        return *this;
+    }
+
+    BufferChain(const BufferChain &) = delete;
+    BufferChain &operator=(const BufferChain &) = delete;
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t segment_count() const { return segments_.size(); }
+
+    void Append(Buffer &&buffer)
+    {
+        if (buffer.size() == 0) { return; }
+        size_ += buffer.size();
+        segments_.push_back(Segment{std::move(buffer), 0});
+    }
+
+    void Append(const void *data, size_t size) { Append(Buffer(static_cast<const uint8_t *>(data), size)); }
+
+    void Append(BufferChain &&other)
+    {
+        for (auto &segment : other.segments_) { segments_.push_back(std::move(segment)); }
+        size_ += other.size_;
+        other.Clear();
+    }
+
+    void Prepend(Buffer &&buffer)
+    {
+        if (buffer.size() == 0) { return; }
+        size_ += buffer.size();
+        segments_.push_front(Segment{std::move(buffer), 0});
+    }
+
+    void Prepend(const void *data, size_t size) { Prepend(Buffer(static_cast<const uint8_t *>(data), size)); }
+
+    // drops `bytes` from the front, e.g. what a partial SendV() wrote
+    void Consume(size_t bytes)
+    {
+        while (bytes > 0 && !segments_.empty()) {
+            Segment &front = segments_.front();
+            const size_t available = front.buffer.size() - front.offset;
+            if (bytes < available) {
+                front.offset += bytes;
+                size_ -= bytes;
+                return;
+            }
+            bytes -= available;
+            size_ -= available;
+            segments_.pop_front();
+        }
+    }
+
+    void Clear()
+    {
+        segments_.clear();
+        size_ = 0;
+    }
+
+    // fills at most `max_slices` slices, returns the number filled
+    size_t GetSlices(BufferSlice *slices, size_t max_slices) const
+    {
+        size_t n = 0;
+        for (auto it = segments_.begin(); it != segments_.end() && n < max_slices; ++it, ++n) {
+            slices[n] = BufferSlice(it->buffer.data() + it->offset, it->buffer.size() - it->offset);
+        }
+        return n;
+    }
+
+    // copies everything into one contiguous buffer
+    Buffer Flatten() const
+    {
+        Buffer result(0, size_);
+        for (const auto &segment : segments_) {
+            result.AppendData(segment.buffer.data() + segment.offset, segment.buffer.size() - segment.offset);
+        }
+        return result;
+    }
+
+private:
+    struct Segment {
+        Buffer buffer;
+        size_t offset;
+    };
+
+    std::deque<Segment> segments_;
+    size_t size_;
+};
+
+}// namespace sled
+
+#endif// SLED_BUFFER_CHAIN_H
@@ -0,0 +1,43 @@
+#include <sled/buffer_chain.h>
+
+TEST_SUITE("BufferChain")
+{
+    TEST_CASE("prepend without copying the payload")
+    {
+        sled::Buffer payload(reinterpret_cast<const uint8_t *>("world"), 5);
+        const uint8_t *payload_data = payload.data();
+
+        sled::BufferChain chain;
+        chain.Append(std::move(payload));
+        chain.Prepend("hello ", 6);
+        CHECK_EQ(chain.size(), 11);
+        CHECK_EQ(chain.segment_count(), 2);
+        CHECK_EQ(payload.size(), 0);
+
+        sled::BufferSlice slices[4];
+        REQUIRE_EQ(chain.GetSlices(slices, 4), 2);
+        CHECK_EQ(slices[0].size, 6);
+        CHECK_EQ(slices[1].data, payload_data);
+
+        sled::Buffer flat = chain.Flatten();
+        CHECK_EQ(std::string(reinterpret_cast<const char *>(flat.data()), flat.size()), "hello world");
+    }
+
+    TEST_CASE("consume")
+    {
+        sled::BufferChain chain;
+        chain.Append("abc", 3);
+        chain.Append("defg", 4);
+        chain.Consume(4);
+        CHECK_EQ(chain.size(), 3);
+        CHECK_EQ(chain.segment_count(), 1);
+
+        sled::BufferSlice slice;
+        REQUIRE_EQ(chain.GetSlices(&slice, 1), 1);
+        CHECK_EQ(std::string(reinterpret_cast<const char *>(slice.data), slice.size), "efg");
+
+        chain.Consume(10);
+        CHECK(chain.empty());
+        CHECK_EQ(chain.segment_count(), 0);
+    }
+}
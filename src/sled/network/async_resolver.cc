@@ -1,8 +1,8 @@
 #include "sled/network/async_resolver.h"
+#include "sled/network/host_resolver.h"
 #include "sled/ref_counted_base.h"
 #include "sled/synchronization/mutex.h"
 #include "sled/task_queue/task_queue_base.h"
-#include <thread>
 
 namespace sled {
 struct AsyncResolver::State : public RefCountedBase {
@@ -13,30 +13,6 @@ struct AsyncResolver::State : public RefCountedBase {
     } status = Status::kLive;
 };
 
-int
-ResolveHostname(const std::string &hostname, int family, std::vector<IPAddress> *addresses)
-{
-    if (!addresses) { return -1; }
-
-    addresses->clear();
-    struct addrinfo *result = nullptr;
-    struct addrinfo hints = {0};
-    hints.ai_family = family;
-    hints.ai_flags = AI_ADDRCONFIG;
-    int ret = getaddrinfo(hostname.c_str(), nullptr, &hints, &result);
-    if (ret != 0) { return ret; }
-
-    struct addrinfo *cursor = result;
-    for (; cursor; cursor = cursor->ai_next) {
-        if (family == AF_UNSPEC || cursor->ai_family == family) {
-            IPAddress ip;
-            if (IPFromAddrInfo(cursor, &ip)) { addresses->push_back(ip); }
-        }
-    }
-    freeaddrinfo(result);
-    return 0;
-}
-
 AsyncResolver::AsyncResolver() : error_(-1), state_(new State) {}
 
 AsyncResolver::~AsyncResolver()
@@ -58,20 +34,19 @@ AsyncResolver::Start(const SocketAddress &addr, int family)
 
     auto caller_task_queue = TaskQueueBase::Current();
     auto state = state_;
-    auto thread_function = [this, addr, family, caller_task_queue, state] {
-        std::vector<IPAddress> addresses;
-        int error = ResolveHostname(addr.hostname(), family, &addresses);
-        caller_task_queue->PostTask([this, error, &addresses, state] {
-            bool live;
-            {
-                MutexLock lock(&state->mutex);
-                live = state->status == State::Status::kLive;
-            }
-            if (live) { ResolveDone(std::move(addresses), error); }
+    HostResolver::Default()->Resolve(
+        addr.hostname(),
+        family,
+        [this, caller_task_queue, state](int error, const std::vector<IPAddress> &addresses) {
+            caller_task_queue->PostTask([this, error, addresses, state] {
+                bool live;
+                {
+                    MutexLock lock(&state->mutex);
+                    live = state->status == State::Status::kLive;
+                }
+                if (live) { ResolveDone(addresses, error); }
+            });
         });
-    };
-    // TODO: Add new thread run function
-    std::thread(thread_function).detach();
 }
 
 bool
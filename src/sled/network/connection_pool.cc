@@ -0,0 +1,352 @@
+#include "sled/network/connection_pool.h"
+#include "sled/log/log.h"
+#include "sled/network/socket_server.h"
+#include "sled/system/thread.h"
+#include "sled/time_utils.h"
+#include "sled/utility/move_on_copy.h"
+#include <cstring>
+#include <vector>
+
+namespace sled {
+
+namespace {
+// connected, and the peer neither closed it nor sent anything unasked
+bool
+IsReusable(Socket *socket)
+{
+    if (socket->GetState() != Socket::CS_CONNECTED) { return false; }
+    // also re-enables the read event, which tells us when the peer goes away
+    char byte;
+    return socket->Recv(&byte, 1, nullptr) < 0 && socket->IsBlocking();
+}
+
+void
+PostResult(TaskQueueBase *task_queue,
+           ConnectionPool::AcquireCallback callback,
+           std::unique_ptr<Socket> socket,
+           int error)
+{
+    auto moved = MakeMoveOnCopy(std::move(socket));
+    task_queue->PostTask([callback, moved, error]() { callback(std::move(moved.value), error); });
+}
+}// namespace
+
+ConnectionPool::Options::Options()
+    : min_idle(0),
+      max_idle(8),
+      idle_timeout(TimeDelta::Seconds(60)),
+      connect_timeout(TimeDelta::Seconds(5)),
+      sweep_interval(TimeDelta::Seconds(1)),
+      keepalive(true),
+      keepalive_idle(TimeDelta::Seconds(30)),
+      keepalive_interval(TimeDelta::Seconds(10)),
+      keepalive_count(3)
+{}
+
+ConnectionPool::ConnectionPool(Thread *network_thread) : ConnectionPool(network_thread, Options()) {}
+
+ConnectionPool::ConnectionPool(Thread *network_thread, const Options &options)
+    : network_thread_(network_thread),
+      options_(options),
+      safety_(PendingTaskSafetyFlag::CreateDetached())
+{
+    // the timeouts check that they are used on the sequence they were created on
+    network_thread_->BlockingCall([this] {
+        timeout_factory_.reset(new TaskQueueTimeoutFactory(
+            *network_thread_,
+            [] { return static_cast<TimeMs>(TimeMillis()); },
+            [this](TimeoutID timeout_id) { timer_manager_->HandleTimeout(timeout_id); }));
+        timer_manager_.reset(new TimerManager([this](TaskQueueBase::DelayPrecision precision) {
+            return timeout_factory_->CreateTimeout(precision);
+        }));
+        sweep_timer_ = timer_manager_->CreateTimer("connection_pool", [this] {
+            Sweep();
+            return sled::optional<DurationMs>();
+        });
+        sweep_timer_->set_duration(DurationMs(options_.sweep_interval.ms()));
+        sweep_timer_->Start();
+    });
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    network_thread_->BlockingCall([this] {
+        safety_->SetNotAlive();
+        sweep_timer_.reset();
+        timer_manager_.reset();
+        timeout_factory_.reset();
+        for (auto &pair : entries_) {
+            for (auto &waiter : pair.second.waiters) { Deliver(std::move(waiter), nullptr, ECANCELED); }
+        }
+        for (auto &pair : idle_) { delete pair.first; }
+        for (auto &pair : connecting_) { delete pair.first; }
+        entries_.clear();
+        idle_.clear();
+        connecting_.clear();
+    });
+}
+
+void
+ConnectionPool::Acquire(const SocketAddress &addr, AcquireCallback callback)
+{
+    TaskQueueBase *current = TaskQueueBase::Current();
+    Waiter waiter = {std::move(callback), current ? current : network_thread_};
+    scoped_refptr<PendingTaskSafetyFlag> safety = safety_;
+    network_thread_->PostTask([this, safety, addr, waiter]() {
+        if (safety->alive()) {
+            DoAcquire(addr, waiter);
+        } else {
+            PostResult(waiter.task_queue, waiter.callback, nullptr, ECANCELED);
+        }
+    });
+}
+
+void
+ConnectionPool::Release(const SocketAddress &addr, std::unique_ptr<Socket> socket)
+{
+    if (!socket) { return; }
+    auto moved = MakeMoveOnCopy(std::move(socket));
+    scoped_refptr<PendingTaskSafetyFlag> safety = safety_;
+    // without the pool the socket is deleted along with the task
+    network_thread_->PostTask([this, safety, addr, moved]() {
+        if (safety->alive()) { DoRelease(addr, moved.value.release()); }
+    });
+}
+
+ConnectionPool::Stats
+ConnectionPool::GetStats(const SocketAddress &addr) const
+{
+    return network_thread_->BlockingCall([this, &addr] {
+        auto it = entries_.find(addr);
+        if (it == entries_.end()) { return Stats(); }
+        Stats stats = it->second.stats;
+        stats.idle = it->second.idle.size();
+        return stats;
+    });
+}
+
+void
+ConnectionPool::DoAcquire(const SocketAddress &addr, Waiter waiter)
+{
+    Entry &entry = entries_[addr];
+    while (!entry.idle.empty()) {
+        Socket *socket = entry.idle.back().socket;
+        entry.idle.pop_back();
+        idle_.erase(socket);
+        if (IsReusable(socket)) {
+            ++entry.stats.reuses;
+            Deliver(std::move(waiter), socket, 0);
+            return;
+        }
+        ++entry.stats.evictions;
+        Unwatch(socket);
+        delete socket;
+    }
+
+    entry.waiters.push_back(std::move(waiter));
+    if (entry.connecting < entry.waiters.size()) { Connect(addr); }
+}
+
+void
+ConnectionPool::DoRelease(const SocketAddress &addr, Socket *socket)
+{
+    if (!IsReusable(socket)) {
+        delete socket;
+        return;
+    }
+    Entry &entry = entries_[addr];
+    if (!entry.waiters.empty()) {
+        Waiter waiter = std::move(entry.waiters.front());
+        entry.waiters.pop_front();
+        ++entry.stats.reuses;
+        Deliver(std::move(waiter), socket, 0);
+        return;
+    }
+    Watch(socket);
+    AddIdle(addr, socket);
+}
+
+void
+ConnectionPool::Connect(const SocketAddress &addr)
+{
+    Entry &entry = entries_[addr];
+    ++entry.stats.connects;
+    ++entry.connecting;
+
+    Socket *socket = network_thread_->socketserver()->CreateSocket(addr.family(), SOCK_STREAM);
+    if (!socket) {
+        OnConnectDone(addr, nullptr, errno != 0 ? errno : EINVAL);
+        return;
+    }
+    socket->SetOption(Socket::OPT_NODELAY, 1);
+    if (options_.keepalive) {
+        socket->SetOption(Socket::OPT_KEEPALIVE, 1);
+        if (options_.keepalive_idle.seconds() > 0) {
+            socket->SetOption(Socket::OPT_KEEPIDLE, static_cast<int>(options_.keepalive_idle.seconds()));
+        }
+        if (options_.keepalive_interval.seconds() > 0) {
+            socket->SetOption(Socket::OPT_KEEPINTVL, static_cast<int>(options_.keepalive_interval.seconds()));
+        }
+        if (options_.keepalive_count > 0) { socket->SetOption(Socket::OPT_KEEPCNT, options_.keepalive_count); }
+    }
+    Watch(socket);
+    connecting_[socket] = Connecting{addr, TimeMillis() + options_.connect_timeout.ms()};
+
+    if (socket->Connect(addr) != 0 && !socket->IsBlocking()) {
+        OnConnectDone(addr, socket, socket->GetError());
+    } else if (socket->GetState() == Socket::CS_CONNECTED) {
+        OnConnectDone(addr, socket, 0);
+    }
+}
+
+void
+ConnectionPool::OnConnectDone(const SocketAddress &addr, Socket *socket, int error)
+{
+    if (socket) { connecting_.erase(socket); }
+    Entry &entry = entries_[addr];
+    --entry.connecting;
+
+    if (error != 0) {
+        LOGW("ConnectionPool", "connect to {}:{} failed: {}", addr.ipaddr().ToString(), addr.port(), strerror(error));
+        ++entry.stats.connect_failures;
+        ++entry.stats.consecutive_failures;
+        if (socket) { Dispose(socket); }
+        if (!entry.waiters.empty()) {
+            Waiter waiter = std::move(entry.waiters.front());
+            entry.waiters.pop_front();
+            Deliver(std::move(waiter), nullptr, error);
+        }
+        return;
+    }
+
+    entry.stats.consecutive_failures = 0;
+    if (!entry.waiters.empty()) {
+        Waiter waiter = std::move(entry.waiters.front());
+        entry.waiters.pop_front();
+        Deliver(std::move(waiter), socket, 0);
+        return;
+    }
+    AddIdle(addr, socket);
+}
+
+void
+ConnectionPool::AddIdle(const SocketAddress &addr, Socket *socket)
+{
+    Entry &entry = entries_[addr];
+    if (entry.idle.size() >= options_.max_idle) {
+        ++entry.stats.evictions;
+        Dispose(socket);
+        return;
+    }
+    entry.idle.push_back(Idle{socket, TimeMillis()});
+    idle_[socket] = addr;
+}
+
+void
+ConnectionPool::RemoveIdle(Socket *socket)
+{
+    auto it = idle_.find(socket);
+    if (it == idle_.end()) { return; }
+    Entry &entry = entries_[it->second];
+    for (auto idle = entry.idle.begin(); idle != entry.idle.end(); ++idle) {
+        if (idle->socket == socket) {
+            entry.idle.erase(idle);
+            break;
+        }
+    }
+    ++entry.stats.evictions;
+    idle_.erase(it);
+    Dispose(socket);
+}
+
+void
+ConnectionPool::Deliver(Waiter waiter, Socket *socket, int error)
+{
+    if (socket) { Unwatch(socket); }
+    PostResult(waiter.task_queue, std::move(waiter.callback), std::unique_ptr<Socket>(socket), error);
+}
+
+void
+ConnectionPool::Watch(Socket *socket)
+{
+    socket->SignalConnectEvent.connect(this, &ConnectionPool::OnConnectEvent);
+    socket->SignalCloseEvent.connect(this, &ConnectionPool::OnCloseEvent);
+    socket->SignalReadEvent.connect(this, &ConnectionPool::OnReadEvent);
+}
+
+void
+ConnectionPool::Unwatch(Socket *socket)
+{
+    socket->SignalConnectEvent.disconnect(this);
+    socket->SignalCloseEvent.disconnect(this);
+    socket->SignalReadEvent.disconnect(this);
+}
+
+void
+ConnectionPool::Dispose(Socket *socket)
+{
+    Unwatch(socket);
+    socket->Close();
+    auto moved = MakeMoveOnCopy(std::unique_ptr<Socket>(socket));
+    network_thread_->PostTask([moved]() { moved.value.reset(); });
+}
+
+void
+ConnectionPool::Sweep()
+{
+    const int64_t now_ms = TimeMillis();
+
+    std::vector<std::pair<Socket *, SocketAddress>> expired;
+    for (const auto &pair : connecting_) {
+        if (pair.second.deadline_ms <= now_ms) { expired.emplace_back(pair.first, pair.second.addr); }
+    }
+    for (const auto &pair : expired) { OnConnectDone(pair.second, pair.first, ETIMEDOUT); }
+
+    for (auto &pair : entries_) {
+        Entry &entry = pair.second;
+        // the oldest are at the front
+        while (entry.idle.size() > options_.min_idle
+               && now_ms - entry.idle.front().since_ms >= options_.idle_timeout.ms()) {
+            Socket *socket = entry.idle.front().socket;
+            entry.idle.pop_front();
+            idle_.erase(socket);
+            ++entry.stats.evictions;
+            Dispose(socket);
+        }
+        // a failing peer is only retried for Acquire()s, not to warm up
+        while (entry.stats.consecutive_failures == 0
+               && entry.idle.size() + entry.connecting < options_.min_idle + entry.waiters.size()) {
+            Connect(pair.first);
+        }
+    }
+}
+
+void
+ConnectionPool::OnConnectEvent(Socket *socket)
+{
+    auto it = connecting_.find(socket);
+    if (it == connecting_.end()) { return; }
+    const SocketAddress addr = it->second.addr;
+    OnConnectDone(addr, socket, 0);
+}
+
+void
+ConnectionPool::OnCloseEvent(Socket *socket, int error)
+{
+    auto it = connecting_.find(socket);
+    if (it != connecting_.end()) {
+        const SocketAddress addr = it->second.addr;
+        OnConnectDone(addr, socket, error != 0 ? error : ECONNRESET);
+        return;
+    }
+    RemoveIdle(socket);
+}
+
+void
+ConnectionPool::OnReadEvent(Socket *socket)
+{
+    // nothing is expected on an idle connection, the peer is closing it or out of sync
+    if (connecting_.count(socket) == 0) { RemoveIdle(socket); }
+}
+
+}// namespace sled
@@ -0,0 +1,151 @@
+/**
+ * @file     : connection_pool
+ * @created  : Sunday Oct 18, 2026 10:26:03 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_CONNECTION_POOL_H
+#define SLED_NETWORK_CONNECTION_POOL_H
+#pragma once
+
+#include "sled/network/socket.h"
+#include "sled/sigslot.h"
+#include "sled/task_queue/pending_task_safety_flag.h"
+#include "sled/timer/task_queue_timeout.h"
+#include "sled/timer/timer.h"
+#include "sled/units/time_delta.h"
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace sled {
+
+class Thread;
+
+/**
+ * Keeps outbound TCP connections open between bursts, so a client pays for
+ * connect and slow start once instead of on every burst.
+ *
+ * Connections are created and watched on `network_thread`, which must run a
+ * PhysicalSocketServer. Acquire() and Release() may be called on any
+ * thread. The callback runs on the task queue Acquire() was called on, or
+ * on the network thread if there is none. Socket events keep arriving on
+ * the network thread.
+ *
+ * Idle connections are dropped when the peer closes them or sends anything.
+ * A background sweep closes the ones idle for longer than idle_timeout, as
+ * long as more than min_idle remain, and opens new ones to get back up to
+ * min_idle for every address which was used.
+ **/
+class ConnectionPool final : public sigslot::has_slots<> {
+public:
+    struct Options {
+        Options();
+
+        // per address, kept open and connected ahead of time
+        size_t min_idle;
+        // per address, released connections beyond it are closed
+        size_t max_idle;
+        TimeDelta idle_timeout;
+        TimeDelta connect_timeout;
+        // how often idle connections and pending connects are checked
+        TimeDelta sweep_interval;
+        // SO_KEEPALIVE with these timings, zero leaves the system defaults
+        bool keepalive;
+        TimeDelta keepalive_idle;
+        TimeDelta keepalive_interval;
+        int keepalive_count;
+    };
+
+    struct Stats {
+        // connects started, and those which failed or timed out
+        size_t connects = 0;
+        size_t connect_failures = 0;
+        // failures in a row, reset by a successful connect
+        size_t consecutive_failures = 0;
+        // Acquire()s served by an idle connection
+        size_t reuses = 0;
+        // idle connections closed by the peer, by the sweep or for lack of room
+        size_t evictions = 0;
+        size_t idle = 0;
+    };
+
+    // `socket` is connected, or null with `error` set
+    using AcquireCallback = std::function<void(std::unique_ptr<Socket> socket, int error)>;
+
+    explicit ConnectionPool(Thread *network_thread);
+    ConnectionPool(Thread *network_thread, const Options &options);
+    // closes all connections, Acquire()s still waiting fail with ECANCELED
+    ~ConnectionPool();
+
+    // an idle connection to `addr` if there is one, a new one otherwise
+    void Acquire(const SocketAddress &addr, AcquireCallback callback);
+    // hands a connection back, it is closed unless it is still connected and there is room
+    void Release(const SocketAddress &addr, std::unique_ptr<Socket> socket);
+
+    // blocks on the network thread
+    Stats GetStats(const SocketAddress &addr) const;
+
+private:
+    struct Waiter {
+        AcquireCallback callback;
+        TaskQueueBase *task_queue;
+    };
+
+    struct Idle {
+        Socket *socket;
+        int64_t since_ms;
+    };
+
+    struct Connecting {
+        SocketAddress addr;
+        int64_t deadline_ms;
+    };
+
+    struct Entry {
+        // most recently released at the back, handed out first
+        std::deque<Idle> idle;
+        std::deque<Waiter> waiters;
+        size_t connecting = 0;
+        Stats stats;
+    };
+
+    void DoAcquire(const SocketAddress &addr, Waiter waiter);
+    void DoRelease(const SocketAddress &addr, Socket *socket);
+    void Connect(const SocketAddress &addr);
+    // a connect finished or failed with `error`, a failed `socket` is disposed of
+    void OnConnectDone(const SocketAddress &addr, Socket *socket, int error);
+    // keeps `socket` idle if there is room, disposes of it otherwise
+    void AddIdle(const SocketAddress &addr, Socket *socket);
+    void RemoveIdle(Socket *socket);
+    void Deliver(Waiter waiter, Socket *socket, int error);
+    void Watch(Socket *socket);
+    void Unwatch(Socket *socket);
+    // deletes `socket` in a task of its own, it may be emitting a signal
+    void Dispose(Socket *socket);
+    void Sweep();
+
+    void OnConnectEvent(Socket *socket);
+    void OnCloseEvent(Socket *socket, int error);
+    void OnReadEvent(Socket *socket);
+
+    Thread *const network_thread_;
+    const Options options_;
+    scoped_refptr<PendingTaskSafetyFlag> safety_;
+
+    // network thread only
+    std::map<SocketAddress, Entry> entries_;
+    std::map<Socket *, Connecting> connecting_;
+    // idle connection -> its address
+    std::map<Socket *, SocketAddress> idle_;
+
+    // created and destroyed on the network thread
+    std::unique_ptr<TaskQueueTimeoutFactory> timeout_factory_;
+    std::unique_ptr<TimerManager> timer_manager_;
+    std::unique_ptr<Timer> sweep_timer_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_CONNECTION_POOL_H
@@ -0,0 +1,223 @@
+#include <sled/network/connection_pool.h>
+#include <sled/network/socket_server.h>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/time_utils.h>
+
+namespace {
+std::unique_ptr<sled::Socket>
+AcquireSync(sled::ConnectionPool &pool, const sled::SocketAddress &addr, int *error = nullptr)
+{
+    std::unique_ptr<sled::Socket> result;
+    int result_error = -1;
+    sled::Event done;
+    pool.Acquire(addr, [&](std::unique_ptr<sled::Socket> socket, int error) {
+        result = std::move(socket);
+        result_error = error;
+        done.Set();
+    });
+    REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+    if (error) { *error = result_error; }
+    return result;
+}
+
+// polls `pool` until `pred` holds for the stats of `addr` or a second passed
+bool
+WaitForStats(sled::ConnectionPool &pool,
+             const sled::SocketAddress &addr,
+             std::function<bool(const sled::ConnectionPool::Stats &)> pred)
+{
+    const int64_t deadline_ms = sled::TimeMillis() + 1000;
+    while (!pred(pool.GetStats(addr))) {
+        if (sled::TimeMillis() > deadline_ms) { return false; }
+        sled::Thread::SleepMs(5);
+    }
+    return true;
+}
+
+class Listener {
+public:
+    explicit Listener(sled::Thread *thread) : thread_(thread)
+    {
+        thread_->BlockingCall([this] {
+            socket_.reset(thread_->socketserver()->CreateSocket(AF_INET, SOCK_STREAM));
+            socket_->Bind(sled::SocketAddress("127.0.0.1", 0));
+            socket_->Listen(16);
+        });
+    }
+
+    ~Listener()
+    {
+        thread_->BlockingCall([this] {
+            accepted_.clear();
+            socket_.reset();
+        });
+    }
+
+    sled::SocketAddress address() const { return socket_->GetLocalAddress(); }
+
+    // accepts what is in the backlog, returns the number of connections so far
+    size_t Accept()
+    {
+        return thread_->BlockingCall([this] {
+            sled::Socket *socket;
+            while ((socket = socket_->Accept(nullptr)) != nullptr) { accepted_.emplace_back(socket); }
+            return accepted_.size();
+        });
+    }
+
+    void CloseAccepted()
+    {
+        thread_->BlockingCall([this] { accepted_.clear(); });
+    }
+
+private:
+    sled::Thread *const thread_;
+    std::unique_ptr<sled::Socket> socket_;
+    std::vector<std::unique_ptr<sled::Socket>> accepted_;
+};
+}// namespace
+
+TEST_SUITE("ConnectionPool")
+{
+    TEST_CASE("reuse")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        Listener listener(thread.get());
+        {
+            sled::ConnectionPool pool(thread.get());
+            auto socket = AcquireSync(pool, listener.address());
+            REQUIRE(socket);
+            CHECK_EQ(socket->GetState(), sled::Socket::CS_CONNECTED);
+            sled::Socket *first = socket.get();
+            pool.Release(listener.address(), std::move(socket));
+            CHECK_EQ(pool.GetStats(listener.address()).idle, 1);
+
+            socket = AcquireSync(pool, listener.address());
+            CHECK_EQ(socket.get(), first);
+            auto stats = pool.GetStats(listener.address());
+            CHECK_EQ(stats.connects, 1);
+            CHECK_EQ(stats.reuses, 1);
+            CHECK_EQ(stats.idle, 0);
+            CHECK_EQ(listener.Accept(), 1);
+            thread->BlockingCall([&] { socket.reset(); });
+        }
+        thread->Stop();
+    }
+
+    TEST_CASE("max idle")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        Listener listener(thread.get());
+        {
+            sled::ConnectionPool::Options options;
+            options.max_idle = 1;
+            sled::ConnectionPool pool(thread.get(), options);
+            auto a = AcquireSync(pool, listener.address());
+            auto b = AcquireSync(pool, listener.address());
+            REQUIRE(a);
+            REQUIRE(b);
+            CHECK_NE(a.get(), b.get());
+            pool.Release(listener.address(), std::move(a));
+            pool.Release(listener.address(), std::move(b));
+            auto stats = pool.GetStats(listener.address());
+            CHECK_EQ(stats.connects, 2);
+            CHECK_EQ(stats.idle, 1);
+            CHECK_EQ(stats.evictions, 1);
+        }
+        thread->Stop();
+    }
+
+    TEST_CASE("idle timeout")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        Listener listener(thread.get());
+        {
+            sled::ConnectionPool::Options options;
+            options.idle_timeout = sled::TimeDelta::Millis(50);
+            options.sweep_interval = sled::TimeDelta::Millis(10);
+            sled::ConnectionPool pool(thread.get(), options);
+            pool.Release(listener.address(), AcquireSync(pool, listener.address()));
+            CHECK_EQ(pool.GetStats(listener.address()).idle, 1);
+            CHECK(WaitForStats(pool, listener.address(),
+                               [](const sled::ConnectionPool::Stats &stats) { return stats.idle == 0; }));
+            CHECK_EQ(pool.GetStats(listener.address()).evictions, 1);
+        }
+        thread->Stop();
+    }
+
+    TEST_CASE("peer close")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        Listener listener(thread.get());
+        {
+            sled::ConnectionPool pool(thread.get());
+            pool.Release(listener.address(), AcquireSync(pool, listener.address()));
+            REQUIRE_EQ(listener.Accept(), 1);
+            listener.CloseAccepted();
+            CHECK(WaitForStats(pool, listener.address(),
+                               [](const sled::ConnectionPool::Stats &stats) { return stats.idle == 0; }));
+            CHECK_EQ(pool.GetStats(listener.address()).evictions, 1);
+
+            // the next one is a fresh connection
+            auto socket = AcquireSync(pool, listener.address());
+            REQUIRE(socket);
+            CHECK_EQ(pool.GetStats(listener.address()).connects, 2);
+            thread->BlockingCall([&] { socket.reset(); });
+        }
+        thread->Stop();
+    }
+
+    TEST_CASE("connect failure")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        sled::SocketAddress closed;
+        {
+            // a port nobody listens on
+            Listener listener(thread.get());
+            closed = listener.address();
+        }
+        {
+            sled::ConnectionPool pool(thread.get());
+            int error = 0;
+            auto socket = AcquireSync(pool, closed, &error);
+            CHECK_FALSE(socket);
+            CHECK_EQ(error, ECONNREFUSED);
+            AcquireSync(pool, closed, &error);
+            auto stats = pool.GetStats(closed);
+            CHECK_EQ(stats.connects, 2);
+            CHECK_EQ(stats.connect_failures, 2);
+            CHECK_EQ(stats.consecutive_failures, 2);
+        }
+        thread->Stop();
+    }
+
+    TEST_CASE("min idle")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        Listener listener(thread.get());
+        {
+            sled::ConnectionPool::Options options;
+            options.min_idle = 2;
+            options.idle_timeout = sled::TimeDelta::Millis(10);
+            options.sweep_interval = sled::TimeDelta::Millis(10);
+            sled::ConnectionPool pool(thread.get(), options);
+            pool.Release(listener.address(), AcquireSync(pool, listener.address()));
+            CHECK(WaitForStats(pool, listener.address(),
+                               [](const sled::ConnectionPool::Stats &stats) { return stats.idle == 2; }));
+            // idle for longer than idle_timeout, but kept to stay at min_idle
+            sled::Thread::SleepMs(50);
+            auto stats = pool.GetStats(listener.address());
+            CHECK_EQ(stats.idle, 2);
+            CHECK_EQ(stats.connects, 2);
+            CHECK_EQ(stats.evictions, 0);
+        }
+        thread->Stop();
+    }
+}
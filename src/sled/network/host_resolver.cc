@@ -0,0 +1,144 @@
+#include "sled/network/host_resolver.h"
+#include "sled/time_utils.h"
+#include <netdb.h>
+
+namespace sled {
+
+int
+ResolveHostname(const std::string &hostname, int family, std::vector<IPAddress> *addresses)
+{
+    if (!addresses) { return -1; }
+
+    addresses->clear();
+    struct addrinfo *result = nullptr;
+    struct addrinfo hints = {};
+    hints.ai_family = family;
+    hints.ai_flags = AI_ADDRCONFIG;
+    int ret = getaddrinfo(hostname.c_str(), nullptr, &hints, &result);
+    if (ret != 0) { return ret; }
+
+    struct addrinfo *cursor = result;
+    for (; cursor; cursor = cursor->ai_next) {
+        if (family == AF_UNSPEC || cursor->ai_family == family) {
+            IPAddress ip;
+            if (IPFromAddrInfo(cursor, &ip)) { addresses->push_back(ip); }
+        }
+    }
+    freeaddrinfo(result);
+    return 0;
+}
+
+HostResolver::Options::Options()
+    : num_threads(4),
+      positive_ttl(TimeDelta::Seconds(60)),
+      negative_ttl(TimeDelta::Seconds(5)),
+      max_cache_entries(1024),
+      resolve(ResolveHostname)
+{}
+
+HostResolver::HostResolver() : HostResolver(Options()) {}
+
+HostResolver::HostResolver(const Options &options)
+    : options_(options),
+      lookup_count_(0),
+      pool_(options.num_threads)
+{}
+
+HostResolver::~HostResolver() = default;
+
+HostResolver *
+HostResolver::Default()
+{
+    static HostResolver *const resolver = new HostResolver();
+    return resolver;
+}
+
+void
+HostResolver::Resolve(const std::string &hostname, int family, Callback callback)
+{
+    Key key(hostname, family);
+    Entry cached;
+    bool hit = false;
+    {
+        MutexLock lock(&mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end() && it->second.expires_ms > TimeMillis()) {
+            cached = it->second;
+            hit = true;
+        } else {
+            auto &waiting = in_flight_[key];
+            waiting.push_back(std::move(callback));
+            // the lookup in progress answers this one too
+            if (waiting.size() > 1) { return; }
+            ++lookup_count_;
+        }
+    }
+    if (hit) {
+        callback(cached.error, cached.addresses);
+        return;
+    }
+    pool_.PostTask([this, key] { Lookup(key); });
+}
+
+void
+HostResolver::ClearCache()
+{
+    MutexLock lock(&mutex_);
+    cache_.clear();
+}
+
+size_t
+HostResolver::lookup_count() const
+{
+    MutexLock lock(&mutex_);
+    return lookup_count_;
+}
+
+void
+HostResolver::Lookup(const Key &key)
+{
+    Entry entry;
+    entry.error = options_.resolve(key.first, key.second, &entry.addresses);
+    // an empty answer is as useless as a failure, keep it for the shorter time
+    const bool positive = entry.error == 0 && !entry.addresses.empty();
+    const TimeDelta ttl = positive ? options_.positive_ttl : options_.negative_ttl;
+
+    std::vector<Callback> callbacks;
+    {
+        MutexLock lock(&mutex_);
+        const int64_t now_ms = TimeMillis();
+        entry.expires_ms = now_ms + ttl.ms();
+        if (ttl > TimeDelta::Zero()) {
+            // a refresh takes the slot of the entry it replaces
+            if (cache_.count(key) == 0) { EvictLocked(now_ms); }
+            cache_[key] = entry;
+        }
+        auto it = in_flight_.find(key);
+        callbacks = std::move(it->second);
+        in_flight_.erase(it);
+    }
+    for (auto &callback : callbacks) { callback(entry.error, entry.addresses); }
+}
+
+void
+HostResolver::EvictLocked(int64_t now_ms)
+{
+    if (cache_.size() < options_.max_cache_entries) { return; }
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (it->second.expires_ms <= now_ms) {
+            it = cache_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // still full of live entries, drop the one closest to expiry
+    while (!cache_.empty() && cache_.size() >= options_.max_cache_entries) {
+        auto oldest = cache_.begin();
+        for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+            if (it->second.expires_ms < oldest->second.expires_ms) { oldest = it; }
+        }
+        cache_.erase(oldest);
+    }
+}
+
+}// namespace sled
@@ -0,0 +1,92 @@
+/**
+ * @file     : host_resolver
+ * @created  : Saturday Oct 17, 2026 21:18:36 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_HOST_RESOLVER_H
+#define SLED_NETWORK_HOST_RESOLVER_H
+#pragma once
+
+#include "sled/network/ip_address.h"
+#include "sled/synchronization/mutex.h"
+#include "sled/system/thread_pool.h"
+#include "sled/units/time_delta.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sled {
+
+// blocking getaddrinfo(), returns 0 or an EAI_* error
+int ResolveHostname(const std::string &hostname, int family, std::vector<IPAddress> *addresses);
+
+/**
+ * Runs blocking hostname lookups on a small shared pool and caches the
+ * results, failures included, for a limited time. Lookups of a name which
+ * is already being resolved wait for that request instead of starting
+ * another one. AsyncResolver goes through Default().
+ **/
+class HostResolver final {
+public:
+    using ResolveFunction
+        = std::function<int(const std::string &hostname, int family, std::vector<IPAddress> *addresses)>;
+    // `error` is 0 or an EAI_* error
+    using Callback = std::function<void(int error, const std::vector<IPAddress> &addresses)>;
+
+    struct Options {
+        Options();
+
+        int num_threads;
+        TimeDelta positive_ttl;
+        TimeDelta negative_ttl;
+        // expired entries go first when the cache is full
+        size_t max_cache_entries;
+        // ResolveHostname by default, replaceable for tests
+        ResolveFunction resolve;
+    };
+
+    HostResolver();
+    explicit HostResolver(const Options &options);
+    ~HostResolver();
+
+    // process wide instance, never destroyed
+    static HostResolver *Default();
+
+    /**
+     * `callback` runs right away on a cache hit, otherwise on a pool thread.
+     * @param family AF_INET, AF_INET6 or AF_UNSPEC, part of the cache key
+     **/
+    void Resolve(const std::string &hostname, int family, Callback callback);
+
+    void ClearCache();
+
+    // lookups which actually called the resolve function
+    size_t lookup_count() const;
+
+private:
+    using Key = std::pair<std::string, int>;
+
+    struct Entry {
+        int error;
+        std::vector<IPAddress> addresses;
+        int64_t expires_ms;
+    };
+
+    void Lookup(const Key &key);
+    void EvictLocked(int64_t now_ms) SLED_REQUIRES(mutex_);
+
+    const Options options_;
+    mutable Mutex mutex_;
+    std::map<Key, Entry> cache_ SLED_GUARDED_BY(mutex_);
+    // callbacks waiting for a lookup in progress
+    std::map<Key, std::vector<Callback>> in_flight_ SLED_GUARDED_BY(mutex_);
+    size_t lookup_count_ SLED_GUARDED_BY(mutex_);
+    // last, waits for running lookups before the rest goes away
+    ThreadPool pool_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_HOST_RESOLVER_H
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <sled/network/host_resolver.h>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+
+namespace {
+void
+WaitFor(const std::function<bool()> &done)
+{
+    for (int i = 0; i < 500 && !done(); ++i) { sled::Thread::SleepMs(10); }
+}
+}// namespace
+
+TEST_SUITE("HostResolver")
+{
+    TEST_CASE("concurrent lookups coalesce")
+    {
+        sled::Event release;
+        std::atomic<int> calls(0);
+        sled::HostResolver::Options options;
+        options.resolve = [&](const std::string &, int, std::vector<sled::IPAddress> *addresses) {
+            ++calls;
+            release.Wait(sled::Event::kForever);
+            addresses->push_back(sled::IPAddress(INADDR_LOOPBACK));
+            return 0;
+        };
+        sled::HostResolver resolver(options);
+
+        constexpr int kLookups = 10;
+        std::atomic<int> answered(0);
+        for (int i = 0; i < kLookups; ++i) {
+            resolver.Resolve("example.test", AF_INET, [&](int error, const std::vector<sled::IPAddress> &addresses) {
+                if (error == 0 && addresses.size() == 1) { ++answered; }
+            });
+        }
+        release.Set();
+        WaitFor([&] { return answered.load() == kLookups; });
+        CHECK_EQ(answered.load(), kLookups);
+        CHECK_EQ(calls.load(), 1);
+        CHECK_EQ(resolver.lookup_count(), 1);
+    }
+
+    TEST_CASE("positive cache")
+    {
+        std::atomic<int> calls(0);
+        sled::HostResolver::Options options;
+        options.resolve = [&](const std::string &, int, std::vector<sled::IPAddress> *addresses) {
+            ++calls;
+            addresses->push_back(sled::IPAddress(INADDR_LOOPBACK));
+            return 0;
+        };
+        sled::HostResolver resolver(options);
+
+        std::atomic<bool> done(false);
+        resolver.Resolve("example.test", AF_INET, [&](int, const std::vector<sled::IPAddress> &) { done = true; });
+        WaitFor([&] { return done.load(); });
+
+        // a hit answers right away, on the calling thread
+        bool hit = false;
+        resolver.Resolve("example.test", AF_INET, [&](int error, const std::vector<sled::IPAddress> &addresses) {
+            hit = error == 0 && addresses.size() == 1;
+        });
+        CHECK(hit);
+        CHECK_EQ(calls.load(), 1);
+
+        // the family is part of the key
+        done = false;
+        resolver.Resolve("example.test", AF_INET6, [&](int, const std::vector<sled::IPAddress> &) { done = true; });
+        WaitFor([&] { return done.load(); });
+        CHECK_EQ(calls.load(), 2);
+
+        resolver.ClearCache();
+        done = false;
+        resolver.Resolve("example.test", AF_INET, [&](int, const std::vector<sled::IPAddress> &) { done = true; });
+        WaitFor([&] { return done.load(); });
+        CHECK_EQ(calls.load(), 3);
+    }
+
+    TEST_CASE("negative cache expires")
+    {
+        std::atomic<int> calls(0);
+        sled::HostResolver::Options options;
+        options.negative_ttl = sled::TimeDelta::Millis(50);
+        options.resolve = [&](const std::string &, int, std::vector<sled::IPAddress> *) {
+            ++calls;
+            return EAI_NONAME;
+        };
+        sled::HostResolver resolver(options);
+
+        std::atomic<int> error(0);
+        resolver.Resolve("missing.test", AF_INET, [&](int e, const std::vector<sled::IPAddress> &) { error = e; });
+        WaitFor([&] { return error.load() != 0; });
+        CHECK_EQ(error.load(), EAI_NONAME);
+
+        int cached_error = 0;
+        resolver.Resolve("missing.test", AF_INET, [&](int e, const std::vector<sled::IPAddress> &) { cached_error = e; });
+        CHECK_EQ(cached_error, EAI_NONAME);
+        CHECK_EQ(calls.load(), 1);
+
+        sled::Thread::SleepMs(100);
+        error = 0;
+        resolver.Resolve("missing.test", AF_INET, [&](int e, const std::vector<sled::IPAddress> &) { error = e; });
+        WaitFor([&] { return error.load() != 0; });
+        CHECK_EQ(calls.load(), 2);
+    }
+
+    TEST_CASE("cache is bounded")
+    {
+        sled::HostResolver::Options options;
+        options.max_cache_entries = 4;
+        std::atomic<int> calls(0);
+        options.resolve = [&](const std::string &, int, std::vector<sled::IPAddress> *addresses) {
+            ++calls;
+            addresses->push_back(sled::IPAddress(INADDR_LOOPBACK));
+            return 0;
+        };
+        sled::HostResolver resolver(options);
+
+        std::atomic<int> answered(0);
+        for (int i = 0; i < 8; ++i) {
+            resolver.Resolve("host" + std::to_string(i), AF_INET,
+                             [&](int, const std::vector<sled::IPAddress> &) { ++answered; });
+            WaitFor([&] { return answered.load() == i + 1; });
+        }
+        // the oldest names were evicted, the newest still hit
+        bool hit = false;
+        resolver.Resolve("host7", AF_INET, [&](int, const std::vector<sled::IPAddress> &) { hit = true; });
+        CHECK(hit);
+        CHECK_EQ(calls.load(), 8);
+        resolver.Resolve("host0", AF_INET, [&](int, const std::vector<sled::IPAddress> &) { ++answered; });
+        WaitFor([&] { return answered.load() == 9; });
+        CHECK_EQ(calls.load(), 9);
+    }
+
+    TEST_CASE("localhost")
+    {
+        std::atomic<bool> done(false);
+        std::atomic<bool> resolved(false);
+        sled::HostResolver::Default()->Resolve("localhost", AF_INET,
+                                               [&](int error, const std::vector<sled::IPAddress> &addresses) {
+                                                   resolved = error == 0 && !addresses.empty();
+                                                   done = true;
+                                               });
+        WaitFor([&] { return done.load(); });
+        CHECK(resolved.load());
+    }
+}
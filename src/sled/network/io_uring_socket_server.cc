@@ -0,0 +1,880 @@
+#include "sled/network/io_uring_socket_server.h"
+#include "sled/log/log.h"
+#include "sled/time_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(SLED_USE_EPOLL) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_EXT_ARG)
+#define SLED_HAS_IO_URING 1
+#include <endian.h>
+#include <linux/swab.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
+#endif
+#endif
+
+namespace sled {
+
+constexpr TimeDelta IoUringSocketServer::kDrainTimeout;
+
+struct IoUringSocketServer::Operation {
+    enum class Type {
+        kDispatcherPoll,
+        kAccept,
+        kConnect,
+        kRecv,
+        kSend,
+        kCancel,
+    };
+
+    Operation(Type type, IoUringSocket *socket) : type(type), socket(socket) {}
+
+    const Type type;
+    // cleared when the socket is closed, the operation is freed once the
+    // kernel is done with it
+    IoUringSocket *socket;
+    int fd = INVALID_SOCKET;
+    bool in_flight = false;
+    bool cancel_pending = false;
+    Operation *cancel_target = nullptr;
+    // the operations in flight are linked from IoUringSocketServer::in_flight_
+    Operation *prev = nullptr;
+    Operation *next = nullptr;
+
+    sockaddr_storage addr = {};
+    socklen_t addr_len = 0;
+    msghdr msg = {};
+    iovec iov = {};
+    // recv: SCM_TIMESTAMPNS
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(struct timespec))];
+    Buffer buffer;
+    // recv: [offset, length) is not consumed yet, send: bytes sent so far
+    size_t offset = 0;
+    size_t length = 0;
+    int64_t timestamp = -1;
+};
+
+#if defined(SLED_HAS_IO_URING)
+class IoUringSocketServer::Ring {
+public:
+    static std::unique_ptr<Ring> Create(uint32_t entries)
+    {
+        io_uring_params params = {};
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            LOGW("IoUringSocketServer", "io_uring_setup failed: {}", strerror(errno));
+            return nullptr;
+        }
+
+        std::unique_ptr<Ring> ring(new Ring(fd));
+        if (!(params.features & IORING_FEAT_EXT_ARG)) {
+            LOGW("IoUringSocketServer", "io_uring lacks IORING_FEAT_EXT_ARG");
+            return nullptr;
+        }
+
+        ring->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) { ring->sq_ring_size_ = ring->cq_ring_size_ = std::max(ring->sq_ring_size_, ring->cq_ring_size_); }
+
+        ring->sq_ring_ = Map(fd, ring->sq_ring_size_, IORING_OFF_SQ_RING);
+        if (ring->sq_ring_ == MAP_FAILED) { return nullptr; }
+        ring->cq_ring_ = single_mmap ? ring->sq_ring_ : Map(fd, ring->cq_ring_size_, IORING_OFF_CQ_RING);
+        if (ring->cq_ring_ == MAP_FAILED) { return nullptr; }
+        ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = Map(fd, ring->sqes_size_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) { return nullptr; }
+        ring->sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+        char *sq = static_cast<char *>(ring->sq_ring_);
+        ring->sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        ring->sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        ring->sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        ring->sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        ring->sq_entries_ = params.sq_entries;
+        ring->sqe_tail_ = *ring->sq_tail_;
+
+        char *cq = static_cast<char *>(ring->cq_ring_);
+        ring->cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        ring->cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        ring->cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        ring->cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return ring;
+    }
+
+    ~Ring()
+    {
+        if (sqes_) { munmap(sqes_, sqes_size_); }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) { munmap(cq_ring_, cq_ring_size_); }
+        if (sq_ring_ != MAP_FAILED) { munmap(sq_ring_, sq_ring_size_); }
+        close(fd_);
+    }
+
+    // returns false if the submission queue is full
+    bool Push(Operation *op)
+    {
+        const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sqe_tail_ - head >= sq_entries_) { return false; }
+
+        const unsigned index = sqe_tail_ & sq_mask_;
+        io_uring_sqe *sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = op->fd;
+        sqe->user_data = reinterpret_cast<uint64_t>(op);
+        switch (op->type) {
+        case Operation::Type::kDispatcherPoll:
+            sqe->opcode = IORING_OP_POLL_ADD;
+#if __BYTE_ORDER == __BIG_ENDIAN
+            sqe->poll32_events = __swahw32(POLLIN);
+#else
+            sqe->poll32_events = POLLIN;
+#endif
+            break;
+        case Operation::Type::kAccept:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->addr = reinterpret_cast<uint64_t>(&op->addr);
+            sqe->addr2 = reinterpret_cast<uint64_t>(&op->addr_len);
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            break;
+        case Operation::Type::kConnect:
+            sqe->opcode = IORING_OP_CONNECT;
+            sqe->addr = reinterpret_cast<uint64_t>(&op->addr);
+            sqe->off = op->addr_len;
+            break;
+        case Operation::Type::kRecv:
+            sqe->opcode = IORING_OP_RECVMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+            sqe->len = 1;
+            break;
+        case Operation::Type::kSend:
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+            sqe->len = 1;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            break;
+        case Operation::Type::kCancel:
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = reinterpret_cast<uint64_t>(op->cancel_target);
+            break;
+        }
+        sq_array_[index] = index;
+        ++sqe_tail_;
+        return true;
+    }
+
+    // publishes the pushed entries, returns the number not consumed by the kernel yet
+    unsigned FlushSq()
+    {
+        __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+        return sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    }
+
+    // returns the number of submitted entries or -errno
+    int Enter(unsigned to_submit, unsigned min_complete, int64_t timeout_us)
+    {
+        unsigned flags = IORING_ENTER_EXT_ARG;
+        if (min_complete > 0) { flags |= IORING_ENTER_GETEVENTS; }
+
+        __kernel_timespec ts = {};
+        io_uring_getevents_arg arg = {};
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeout_us >= 0) {
+            ts.tv_sec = timeout_us / kNumMicrosecsPerSec;
+            ts.tv_nsec = (timeout_us % kNumMicrosecsPerSec) * kNumNanosecsPerMicrosec;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+        int ret = static_cast<int>(
+            syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, &arg, sizeof(arg)));
+        return ret < 0 ? -errno : ret;
+    }
+
+    void Reap(std::vector<std::pair<Operation *, int32_t>> *completions)
+    {
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+            completions->emplace_back(reinterpret_cast<Operation *>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    explicit Ring(int fd) : fd_(fd) {}
+
+    static void *Map(int fd, size_t size, off_t offset)
+    {
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (ptr == MAP_FAILED) { LOGW("IoUringSocketServer", "mmap io_uring failed: {}", strerror(errno)); }
+        return ptr;
+    }
+
+    const int fd_;
+    void *sq_ring_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    void *cq_ring_ = MAP_FAILED;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    // entries pushed but not published to the kernel yet
+    unsigned sqe_tail_ = 0;
+
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+};
+#else
+class IoUringSocketServer::Ring {
+public:
+    static std::unique_ptr<Ring> Create(uint32_t entries) { return nullptr; }
+
+    bool Push(Operation *op) { return false; }
+
+    unsigned FlushSq() { return 0; }
+
+    int Enter(unsigned to_submit, unsigned min_complete, int64_t timeout_us) { return -ENOSYS; }
+
+    void Reap(std::vector<std::pair<Operation *, int32_t>> *completions) {}
+};
+#endif
+
+std::unique_ptr<IoUringSocketServer>
+IoUringSocketServer::Create(uint32_t entries)
+{
+    std::unique_ptr<Ring> ring = Ring::Create(entries);
+    if (!ring) { return nullptr; }
+
+    std::unique_ptr<IoUringSocketServer> ss(new IoUringSocketServer(std::move(ring)));
+    // the Add()ed dispatchers are only reachable through the epoll descriptor
+    if (ss->backend() != Backend::kEpoll) { return nullptr; }
+    ss->ArmDispatcherPoll();
+    return ss;
+}
+
+IoUringSocketServer::IoUringSocketServer(std::unique_ptr<Ring> ring)
+    : ring_(std::move(ring)),
+      in_flight_(nullptr),
+      dispatcher_poll_op_(new Operation(Operation::Type::kDispatcherPoll, nullptr))
+{}
+
+IoUringSocketServer::~IoUringSocketServer()
+{
+    // closing the ring doesn't wait for the kernel to let go of the buffers,
+    // so cancel what is in flight and reap it first
+    std::vector<Operation *> outstanding;
+    {
+        MutexLock lock(&ring_mutex_);
+        wait_thread_id_ = std::this_thread::get_id();
+        for (Operation *op = in_flight_; op; op = op->next) {
+            if (op->type != Operation::Type::kCancel && !op->cancel_pending) { outstanding.push_back(op); }
+        }
+    }
+    for (Operation *op : outstanding) {
+        // a socket left open past its server must not reach the operation any more
+        if (IoUringSocket *socket = op->socket) {
+            for (Operation **slot : {&socket->accept_op_, &socket->connect_op_, &socket->recv_op_, &socket->send_op_}) {
+                if (*slot == op) { *slot = nullptr; }
+            }
+        }
+        Cancel(op);
+    }
+    // from here on its completion is like that of a closed socket's operation,
+    // Cancel() frees it once reaped, or right away if it isn't in flight
+    Operation *dispatcher_poll = dispatcher_poll_op_;
+    dispatcher_poll_op_ = nullptr;
+    Cancel(dispatcher_poll);
+
+    const int64_t stop_us = TimeMicros() + kDrainTimeout.us();
+    std::vector<std::pair<Operation *, int32_t>> completions;
+    while (HasInFlight() && TimeMicros() < stop_us) {
+        unsigned to_submit;
+        {
+            MutexLock lock(&ring_mutex_);
+            to_submit = ring_->FlushSq();
+        }
+        const int ret = ring_->Enter(to_submit, 1, std::max<int64_t>(0, stop_us - TimeMicros()));
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) { break; }
+        completions.clear();
+        ring_->Reap(&completions);
+        for (const auto &completion : completions) { ProcessCompletion(completion.first, completion.second); }
+    }
+    if (HasInFlight()) {
+        // the kernel may still write into them, leak them rather than free them under it
+        LOGW("IoUringSocketServer", "io_uring operations still in flight after {}ms, leaking them",
+             kDrainTimeout.ms());
+    }
+}
+
+Socket *
+IoUringSocketServer::CreateSocket(int family, int type)
+{
+    IoUringSocket *socket = new IoUringSocket(this);
+    if (socket->Create(family, type)) {
+        return socket;
+    } else {
+        delete socket;
+        return nullptr;
+    }
+}
+
+Socket *
+IoUringSocketServer::WrapSocket(SOCKET s)
+{
+    IoUringSocket *socket = new IoUringSocket(this, s);
+    if (socket->Initialize()) {
+        return socket;
+    } else {
+        delete socket;
+        return nullptr;
+    }
+}
+
+bool
+IoUringSocketServer::Wait(TimeDelta max_wait_duration, bool process_io)
+{
+    // only the wakeup signaler is watched, completions stay queued for the next Wait() that processes io
+    if (!process_io) { return PhysicalSocketServer::Wait(max_wait_duration, false); }
+
+    {
+        MutexLock lock(&ring_mutex_);
+        wait_thread_id_ = std::this_thread::get_id();
+    }
+
+    const bool forever = max_wait_duration == kForever;
+    const int64_t stop_us = forever ? 0 : TimeMicros() + max_wait_duration.RoundUpTo(TimeDelta::Micros(1)).us();
+    std::vector<std::pair<Operation *, int32_t>> completions;
+
+    bool waiting = true;
+    while (waiting) {
+        int64_t timeout_us = -1;
+        if (!forever) { timeout_us = std::max<int64_t>(0, stop_us - TimeMicros()); }
+
+        unsigned to_submit;
+        {
+            MutexLock lock(&ring_mutex_);
+            to_submit = ring_->FlushSq();
+        }
+        int ret = ring_->Enter(to_submit, 1, timeout_us);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+            LOGE("IoUringSocketServer", "io_uring_enter failed: {}", strerror(-ret));
+            return false;
+        }
+
+        completions.clear();
+        ring_->Reap(&completions);
+        for (const auto &completion : completions) {
+            if (completion.first == dispatcher_poll_op_) {
+                Untrack(dispatcher_poll_op_);
+                if (!PollDispatchers()) { waiting = false; }
+                ArmDispatcherPoll();
+            } else {
+                ProcessCompletion(completion.first, completion.second);
+            }
+        }
+
+        if (!forever && TimeMicros() >= stop_us) { break; }
+    }
+    return true;
+}
+
+bool
+IoUringSocketServer::Submit(Operation *op)
+{
+    MutexLock lock(&ring_mutex_);
+    if (!ring_->Push(op)) {
+        // the submission queue is full, hand it over to the kernel and retry
+        ring_->Enter(ring_->FlushSq(), 0, -1);
+        if (!ring_->Push(op)) {
+            LOGE("IoUringSocketServer", "io_uring submission queue is full");
+            return false;
+        }
+    }
+    op->in_flight = true;
+    op->prev = nullptr;
+    op->next = in_flight_;
+    if (in_flight_) { in_flight_->prev = op; }
+    in_flight_ = op;
+
+    if (std::this_thread::get_id() != wait_thread_id_) { ring_->Enter(ring_->FlushSq(), 0, -1); }
+    return true;
+}
+
+void
+IoUringSocketServer::Cancel(Operation *op)
+{
+    op->socket = nullptr;
+    if (!op->in_flight) {
+        delete op;
+        return;
+    }
+
+    // keep the target alive until the cancel completes, otherwise its
+    // address may be reused by a new operation that gets cancelled instead
+    Operation *cancel = new Operation(Operation::Type::kCancel, nullptr);
+    cancel->cancel_target = op;
+    op->cancel_pending = true;
+    if (!Submit(cancel)) {
+        op->cancel_pending = false;
+        delete cancel;
+    }
+}
+
+void
+IoUringSocketServer::ArmDispatcherPoll()
+{
+#if defined(SLED_USE_EPOLL)
+    dispatcher_poll_op_->fd = epoll_fd();
+#endif
+    Submit(dispatcher_poll_op_);
+}
+
+void
+IoUringSocketServer::Untrack(Operation *op)
+{
+    MutexLock lock(&ring_mutex_);
+    op->in_flight = false;
+    if (op->prev) {
+        op->prev->next = op->next;
+    } else {
+        in_flight_ = op->next;
+    }
+    if (op->next) { op->next->prev = op->prev; }
+    op->prev = op->next = nullptr;
+}
+
+bool
+IoUringSocketServer::HasInFlight()
+{
+    MutexLock lock(&ring_mutex_);
+    return in_flight_ != nullptr;
+}
+
+void
+IoUringSocketServer::ProcessCompletion(Operation *op, int32_t res)
+{
+    Untrack(op);
+
+    if (op->type == Operation::Type::kCancel) {
+        Operation *target = op->cancel_target;
+        target->cancel_pending = false;
+        if (!target->in_flight) { delete target; }
+        delete op;
+        return;
+    }
+
+    IoUringSocket *socket = op->socket;
+    if (!socket) {
+        if (!op->cancel_pending) { delete op; }
+        return;
+    }
+
+    switch (op->type) {
+    case Operation::Type::kAccept:
+        socket->OnAcceptDone(op, res);
+        break;
+    case Operation::Type::kConnect:
+        socket->OnConnectDone(op, res);
+        break;
+    case Operation::Type::kRecv:
+        socket->OnRecvDone(op, res);
+        break;
+    case Operation::Type::kSend:
+        socket->OnSendDone(op, res);
+        break;
+    default:
+        break;
+    }
+}
+
+IoUringSocket::IoUringSocket(IoUringSocketServer *ss, SOCKET s) : PhysicalSocket(ss, s) {}
+
+IoUringSocket::~IoUringSocket() { Close(); }
+
+IoUringSocketServer *
+IoUringSocket::uring_ss() const
+{
+    return static_cast<IoUringSocketServer *>(ss_);
+}
+
+bool
+IoUringSocket::Initialize()
+{
+    fcntl(s_, F_SETFL, fcntl(s_, F_GETFL, 0) | O_NONBLOCK);
+    // wrapped sockets are connected already
+    if (state_ == CS_CONNECTED) { StartRecv(); }
+    return true;
+}
+
+bool
+IoUringSocket::Create(int family, int type)
+{
+    if (!PhysicalSocket::Create(family, type)) { return false; }
+    return Initialize();
+}
+
+int
+IoUringSocket::Bind(const SocketAddress &bind_addr)
+{
+    int err = PhysicalSocket::Bind(bind_addr);
+    if (err == 0 && udp_) { StartRecv(); }
+    return err;
+}
+
+int
+IoUringSocket::Send(const void *pv, size_t cb)
+{
+    // datagrams without address go to the connected peer
+    if (udp_) { return SendTo(pv, cb, SocketAddress()); }
+
+    if (state_ != CS_CONNECTED) {
+        SetError(ENOTCONN);
+        return SOCKET_ERROR;
+    }
+    if (IsSendBufferFull(false)) {
+        write_blocked_ = true;
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+
+    const size_t accepted = std::min(cb, kMaxSendBufferSize - BufferedSendSize());
+    pending_send_.AppendData(static_cast<const uint8_t *>(pv), accepted);
+    if (accepted < cb) { write_blocked_ = true; }
+    StartSend();
+    return static_cast<int>(accepted);
+}
+
+int
+IoUringSocket::SendTo(const void *pv, size_t cb, const SocketAddress &addr)
+{
+    if (!udp_) { return Send(pv, cb); }
+
+    if (IsSendBufferFull(false)) {
+        write_blocked_ = true;
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+
+    pending_datagrams_.emplace_back();
+    pending_datagrams_.back().data.SetData(static_cast<const uint8_t *>(pv), cb);
+    pending_datagrams_.back().addr = addr;
+    StartSend();
+    // sendmsg() binds the socket implicitly
+    StartRecv();
+    return static_cast<int>(cb);
+}
+
+int
+IoUringSocket::Recv(void *pv, size_t cb, int64_t *timestamp)
+{
+    return RecvFrom(pv, cb, nullptr, timestamp);
+}
+
+int
+IoUringSocket::RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp)
+{
+    Operation *op = recv_op_;
+    if (!op || op->in_flight || op->offset >= op->length) {
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+
+    const size_t received = std::min(cb, op->length - op->offset);
+    std::memcpy(pv, op->buffer.data() + op->offset, received);
+    op->offset += received;
+    if (paddr && udp_) { SocketAddressFromSockAddrStorage(op->addr, paddr); }
+    if (timestamp) { *timestamp = op->timestamp; }
+
+    // a datagram is consumed by a single read, the remainder is truncated
+    if (udp_ || op->offset >= op->length) {
+        op->offset = op->length = 0;
+        StartRecv();
+    }
+    SetError(0);
+    return static_cast<int>(received);
+}
+
+int
+IoUringSocket::Listen(int backlog)
+{
+    int err = PhysicalSocket::Listen(backlog);
+    if (err == 0) { StartAccept(); }
+    return err;
+}
+
+Socket *
+IoUringSocket::Accept(SocketAddress *paddr)
+{
+    if (accepted_.empty()) {
+        StartAccept();
+        if (GetError() == 0) { SetError(EWOULDBLOCK); }
+        return nullptr;
+    }
+
+    SOCKET s = accepted_.front().first;
+    if (paddr) { *paddr = accepted_.front().second; }
+    accepted_.pop_front();
+    SetError(0);
+    return uring_ss()->WrapSocket(s);
+}
+
+int
+IoUringSocket::Close()
+{
+    if (s_ == INVALID_SOCKET) { return 0; }
+
+    for (Operation **op : {&accept_op_, &connect_op_, &recv_op_, &send_op_}) {
+        if (*op) {
+            uring_ss()->Cancel(*op);
+            *op = nullptr;
+        }
+    }
+    for (const auto &accepted : accepted_) { ::close(accepted.first); }
+    accepted_.clear();
+    pending_send_.Clear();
+    pending_datagrams_.clear();
+    write_blocked_ = false;
+    return PhysicalSocket::Close();
+}
+
+int
+IoUringSocket::DoConnect(const SocketAddress &addr)
+{
+    if ((s_ == INVALID_SOCKET) && !Create(addr.family(), SOCK_STREAM)) { return SOCKET_ERROR; }
+
+    if (!connect_op_) { connect_op_ = new Operation(Operation::Type::kConnect, this); }
+    if (connect_op_->in_flight) {
+        SetError(EALREADY);
+        return SOCKET_ERROR;
+    }
+
+    connect_op_->fd = s_;
+    connect_op_->addr_len = static_cast<socklen_t>(addr.ToSockAddrStorage(&connect_op_->addr));
+    if (!uring_ss()->Submit(connect_op_)) {
+        SetError(ENOBUFS);
+        return SOCKET_ERROR;
+    }
+    state_ = CS_CONNECTING;
+    return 0;
+}
+
+void
+IoUringSocket::StartRecv()
+{
+    if (s_ == INVALID_SOCKET) { return; }
+    if (!recv_op_) {
+        recv_op_ = new Operation(Operation::Type::kRecv, this);
+        recv_op_->buffer.SetSize(kRecvBufferSize);
+    }
+
+    Operation *op = recv_op_;
+    // in flight, or holding data not consumed by Recv() yet
+    if (op->in_flight || op->offset < op->length) { return; }
+
+    op->fd = s_;
+    op->offset = op->length = 0;
+    op->iov.iov_base = op->buffer.data();
+    op->iov.iov_len = op->buffer.size();
+    op->msg = {};
+    op->msg.msg_iov = &op->iov;
+    op->msg.msg_iovlen = 1;
+    if (udp_) {
+        op->msg.msg_name = &op->addr;
+        op->msg.msg_namelen = sizeof(op->addr);
+    }
+    if (timestamps()) {
+        op->msg.msg_control = op->control;
+        op->msg.msg_controllen = sizeof(op->control);
+    }
+    if (!uring_ss()->Submit(op)) { OnError(ENOBUFS); }
+}
+
+void
+IoUringSocket::StartSend()
+{
+    if (s_ == INVALID_SOCKET) { return; }
+    if (!send_op_) { send_op_ = new Operation(Operation::Type::kSend, this); }
+
+    Operation *op = send_op_;
+    if (op->in_flight) { return; }
+
+    op->msg = {};
+    if (udp_) {
+        if (pending_datagrams_.empty()) { return; }
+        Datagram &datagram = pending_datagrams_.front();
+        op->buffer = std::move(datagram.data);
+        if (!datagram.addr.IsNil()) {
+            op->addr_len = static_cast<socklen_t>(datagram.addr.ToSockAddrStorage(&op->addr));
+            op->msg.msg_name = &op->addr;
+            op->msg.msg_namelen = op->addr_len;
+        }
+        pending_datagrams_.pop_front();
+    } else {
+        if (pending_send_.empty()) { return; }
+        // reuse the capacity of the finished send for the next batch
+        using std::swap;
+        swap(op->buffer, pending_send_);
+        pending_send_.Clear();
+    }
+
+    op->fd = s_;
+    op->offset = 0;
+    op->iov.iov_base = op->buffer.data();
+    op->iov.iov_len = op->buffer.size();
+    op->msg.msg_iov = &op->iov;
+    op->msg.msg_iovlen = 1;
+    if (!uring_ss()->Submit(op)) { OnError(ENOBUFS); }
+}
+
+void
+IoUringSocket::StartAccept()
+{
+    if (s_ == INVALID_SOCKET) { return; }
+    if (!accept_op_) { accept_op_ = new Operation(Operation::Type::kAccept, this); }
+    if (accept_op_->in_flight) { return; }
+
+    accept_op_->fd = s_;
+    accept_op_->addr_len = sizeof(accept_op_->addr);
+    if (!uring_ss()->Submit(accept_op_)) { SetError(ENOBUFS); }
+}
+
+size_t
+IoUringSocket::BufferedSendSize() const
+{
+    size_t size = pending_send_.size();
+    if (send_op_ && send_op_->in_flight) { size += send_op_->buffer.size() - send_op_->offset; }
+    return size;
+}
+
+bool
+IoUringSocket::IsSendBufferFull(bool low_watermark) const
+{
+    if (udp_) {
+        return pending_datagrams_.size() >= (low_watermark ? kMaxPendingDatagrams / 2 : kMaxPendingDatagrams);
+    }
+    return BufferedSendSize() >= (low_watermark ? kMaxSendBufferSize / 2 : kMaxSendBufferSize);
+}
+
+void
+IoUringSocket::OnAcceptDone(Operation *op, int32_t res)
+{
+    if (res == -ECANCELED) { return; }
+
+    if (res >= 0) {
+        SocketAddress addr;
+        SocketAddressFromSockAddrStorage(op->addr, &addr);
+        accepted_.emplace_back(res, addr);
+        StartAccept();
+    } else if (res == -EAGAIN || res == -EINTR || res == -ECONNABORTED) {
+        StartAccept();
+        return;
+    } else {
+        // reported by the next Accept()
+        SetError(-res);
+    }
+    SignalReadEvent(this);
+}
+
+void
+IoUringSocket::OnConnectDone(Operation *op, int32_t res)
+{
+    if (res == -ECANCELED) { return; }
+    if (res < 0) {
+        OnError(-res);
+        return;
+    }
+
+    state_ = CS_CONNECTED;
+    StartRecv();
+    SignalConnectEvent(this);
+}
+
+void
+IoUringSocket::OnRecvDone(Operation *op, int32_t res)
+{
+    if (res == -ECANCELED) { return; }
+    if (res < 0) {
+        if (res == -EAGAIN || res == -EINTR || (udp_ && res == -ECONNREFUSED)) {
+            StartRecv();
+        } else {
+            OnError(-res);
+        }
+        return;
+    }
+
+    if (res == 0) {
+        if (udp_) {
+            StartRecv();
+        } else {
+            // orderly shutdown by the peer
+            state_ = CS_CLOSED;
+            SignalCloseEvent(this, 0);
+        }
+        return;
+    }
+
+    op->offset = 0;
+    op->length = static_cast<size_t>(res);
+    op->timestamp = ControlMessageTimestamp(&op->msg);
+    SignalReadEvent(this);
+}
+
+void
+IoUringSocket::OnSendDone(Operation *op, int32_t res)
+{
+    if (res == -ECANCELED) { return; }
+
+    if (res == -EAGAIN || res == -EINTR) {
+        uring_ss()->Submit(op);
+        return;
+    } else if (res < 0) {
+        // a failed datagram is dropped, a stream is broken
+        if (!udp_) {
+            OnError(-res);
+            return;
+        }
+    } else if (!udp_) {
+        op->offset += static_cast<size_t>(res);
+        if (op->offset < op->buffer.size()) {
+            op->iov.iov_base = op->buffer.data() + op->offset;
+            op->iov.iov_len = op->buffer.size() - op->offset;
+            uring_ss()->Submit(op);
+            return;
+        }
+    }
+
+    op->buffer.Clear();
+    StartSend();
+    if (write_blocked_ && !IsSendBufferFull(true)) {
+        write_blocked_ = false;
+        SignalWriteEvent(this);
+    }
+}
+
+void
+IoUringSocket::OnError(int error)
+{
+    SetError(error);
+    state_ = CS_CLOSED;
+    SignalCloseEvent(this, error);
+}
+
+}// namespace sled
@@ -0,0 +1,135 @@
+/**
+ * @file     : io_uring_socket_server
+ * @created  : Saturday Oct 17, 2026 10:12:40 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_IO_URING_SOCKET_SERVER_H
+#define SLED_NETWORK_IO_URING_SOCKET_SERVER_H
+#pragma once
+
+#include "sled/buffer.h"
+#include "sled/network/physical_socket_server.h"
+#include <deque>
+#include <memory>
+#include <thread>
+
+namespace sled {
+
+class IoUringSocket;
+
+/**
+ * Completion based socket server, recv/send/accept/connect are submitted
+ * to an io_uring in batch and reaped in Wait(). Dispatchers Add()ed to the
+ * base PhysicalSocketServer keep working, their epoll descriptor is polled
+ * through the ring as well.
+ **/
+class IoUringSocketServer : public PhysicalSocketServer {
+public:
+    static constexpr uint32_t kDefaultEntries = 256;
+    // how long the destructor waits for the kernel to give back the operations in flight
+    static constexpr TimeDelta kDrainTimeout = TimeDelta::Seconds(1);
+
+    // returns nullptr if the kernel lacks io_uring
+    static std::unique_ptr<IoUringSocketServer> Create(uint32_t entries = kDefaultEntries);
+    // cancels the operations in flight and waits for them, sockets should be gone by then
+    ~IoUringSocketServer() override;
+
+    Socket *CreateSocket(int family, int type) override;
+    Socket *WrapSocket(SOCKET s) override;
+    bool Wait(TimeDelta max_wait_duration, bool process_io) override;
+
+private:
+    friend class IoUringSocket;
+    class Ring;
+    struct Operation;
+
+    explicit IoUringSocketServer(std::unique_ptr<Ring> ring);
+
+    // queued operations are submitted by the next Wait(), or right away
+    // when called from a thread other than the one running Wait()
+    bool Submit(Operation *op);
+    void Cancel(Operation *op);
+    void ArmDispatcherPoll();
+    // the kernel is done with `op`
+    void Untrack(Operation *op);
+    bool HasInFlight();
+    void ProcessCompletion(Operation *op, int32_t res);
+
+    std::unique_ptr<Ring> ring_;
+    Mutex ring_mutex_;
+    std::thread::id wait_thread_id_ GUARDED_BY(ring_mutex_);
+    // the operations submitted and not completed yet
+    Operation *in_flight_ GUARDED_BY(ring_mutex_);
+    // polls the epoll descriptor of the base PhysicalSocketServer
+    Operation *dispatcher_poll_op_;
+};
+
+class IoUringSocket : public PhysicalSocket {
+public:
+    IoUringSocket(IoUringSocketServer *ss, SOCKET s = INVALID_SOCKET);
+    ~IoUringSocket() override;
+
+    bool Initialize();
+    bool Create(int family, int type) override;
+
+    int Bind(const SocketAddress &bind_addr) override;
+    int Send(const void *pv, size_t cb) override;
+    int SendTo(const void *pv, size_t cb, const SocketAddress &addr) override;
+    int Recv(void *pv, size_t cb, int64_t *timestamp) override;
+    int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) override;
+    // reads and writes go through the ring, not readv/writev/recvmmsg/sendmmsg/sendfile
+    using Socket::SendV;
+    int SendV(const BufferSlice *slices, size_t count) override { return Socket::SendV(slices, count); }
+    int RecvV(const MutableBufferSlice *slices, size_t count) override { return Socket::RecvV(slices, count); }
+    int SendFile(int fd, int64_t offset, size_t length) override { return Socket::SendFile(fd, offset, length); }
+    int SendZeroCopy(const void *pv, size_t cb, int64_t *send_id) override
+    {
+        return Socket::SendZeroCopy(pv, cb, send_id);
+    }
+    int RecvFromBatch(Datagram *datagrams, size_t count) override { return Socket::RecvFromBatch(datagrams, count); }
+    int SendToBatch(const Datagram *datagrams, size_t count) override { return Socket::SendToBatch(datagrams, count); }
+    int Listen(int backlog) override;
+    Socket *Accept(SocketAddress *paddr) override;
+    int Close() override;
+
+protected:
+    int DoConnect(const SocketAddress &addr) override;
+
+private:
+    friend class IoUringSocketServer;
+    using Operation = IoUringSocketServer::Operation;
+
+    static constexpr size_t kRecvBufferSize = 64 * 1024;
+    static constexpr size_t kMaxSendBufferSize = 256 * 1024;
+    static constexpr size_t kMaxPendingDatagrams = 1024;
+
+    IoUringSocketServer *uring_ss() const;
+    void StartRecv();
+    void StartSend();
+    void StartAccept();
+    size_t BufferedSendSize() const;
+    bool IsSendBufferFull(bool low_watermark) const;
+
+    void OnAcceptDone(Operation *op, int32_t res);
+    void OnConnectDone(Operation *op, int32_t res);
+    void OnRecvDone(Operation *op, int32_t res);
+    void OnSendDone(Operation *op, int32_t res);
+    void OnError(int error);
+
+    Operation *accept_op_ = nullptr;
+    Operation *connect_op_ = nullptr;
+    Operation *recv_op_ = nullptr;
+    Operation *send_op_ = nullptr;
+
+    std::deque<std::pair<SOCKET, SocketAddress>> accepted_;
+    // tcp: bytes waiting for the in-flight send to finish
+    Buffer pending_send_;
+    // udp: datagrams waiting for the in-flight send to finish
+    std::deque<Datagram> pending_datagrams_;
+    bool write_blocked_ = false;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_IO_URING_SOCKET_SERVER_H
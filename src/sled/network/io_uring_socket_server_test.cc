@@ -0,0 +1,205 @@
+#include <sled/network/io_uring_socket_server.h>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/time_utils.h>
+
+namespace {
+struct SocketEventRecorder : public sigslot::has_slots<> {
+    void Watch(sled::Socket *socket)
+    {
+        socket->SignalReadEvent.connect(this, &SocketEventRecorder::OnReadEvent);
+        socket->SignalWriteEvent.connect(this, &SocketEventRecorder::OnWriteEvent);
+        socket->SignalConnectEvent.connect(this, &SocketEventRecorder::OnConnectEvent);
+        socket->SignalCloseEvent.connect(this, &SocketEventRecorder::OnCloseEvent);
+    }
+
+    void OnReadEvent(sled::Socket *) { ++read_events; }
+
+    void OnWriteEvent(sled::Socket *) { ++write_events; }
+
+    void OnConnectEvent(sled::Socket *) { ++connect_events; }
+
+    void OnCloseEvent(sled::Socket *, int) { ++close_events; }
+
+    int read_events    = 0;
+    int write_events   = 0;
+    int connect_events = 0;
+    int close_events   = 0;
+};
+
+template<typename Predicate>
+bool
+WaitUntil(sled::SocketServer *ss, Predicate &&pred)
+{
+    for (int i = 0; i < 100 && !pred(); ++i) { ss->Wait(sled::TimeDelta::Millis(10), true); }
+    return pred();
+}
+}// namespace
+
+TEST_SUITE("IoUringSocketServer")
+{
+    TEST_CASE("fallback")
+    {
+        auto ss = sled::CreateIoUringSocketServer();
+        CHECK(ss);
+    }
+
+    TEST_CASE("wakeup")
+    {
+        auto ss = sled::IoUringSocketServer::Create();
+        if (!ss) { return; }
+        ss->WakeUp();
+        CHECK(ss->Wait(sled::SocketServer::kForever, true));
+        CHECK(ss->Wait(sled::TimeDelta::Millis(1), true));
+    }
+
+    TEST_CASE("tcp loopback")
+    {
+        auto ss = sled::IoUringSocketServer::Create();
+        if (!ss) { return; }
+        SocketEventRecorder server_events;
+        SocketEventRecorder client_events;
+        SocketEventRecorder accepted_events;
+
+        std::unique_ptr<sled::Socket> server(ss->CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE(server);
+        server_events.Watch(server.get());
+        REQUIRE_EQ(server->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(server->Listen(5), 0);
+        sled::SocketAddress server_addr = server->GetLocalAddress();
+
+        std::unique_ptr<sled::Socket> client(ss->CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE(client);
+        client_events.Watch(client.get());
+        REQUIRE_EQ(client->Connect(server_addr), 0);
+        CHECK(WaitUntil(ss.get(), [&] { return server_events.read_events > 0 && client_events.connect_events > 0; }));
+        CHECK_EQ(client->GetState(), sled::Socket::CS_CONNECTED);
+
+        sled::SocketAddress accepted_addr;
+        std::unique_ptr<sled::Socket> accepted(server->Accept(&accepted_addr));
+        REQUIRE(accepted);
+        accepted_events.Watch(accepted.get());
+        CHECK_EQ(accepted_addr.port(), client->GetLocalAddress().port());
+        CHECK_EQ(server->Accept(nullptr), nullptr);
+        CHECK(server->IsBlocking());
+
+        // larger than the send buffer, exercises partial sends and SignalWriteEvent
+        std::string message(1024 * 1024, 'x');
+        for (size_t i = 0; i < message.size(); ++i) { message[i] = static_cast<char>('a' + i % 26); }
+        size_t sent = 0;
+        std::string received;
+        char buf[16 * 1024];
+        for (int i = 0; i < 1000 && received.size() < message.size(); ++i) {
+            while (sent < message.size()) {
+                int n = client->Send(message.data() + sent, message.size() - sent);
+                if (n < 0) {
+                    CHECK(client->IsBlocking());
+                    break;
+                }
+                sent += n;
+            }
+            ss->Wait(sled::TimeDelta::Millis(10), true);
+            int n;
+            while ((n = accepted->Recv(buf, sizeof(buf), nullptr)) > 0) { received.append(buf, n); }
+        }
+        CHECK_EQ(received.size(), message.size());
+        CHECK(received == message);
+        CHECK_GT(client_events.write_events, 0);
+
+        client->Close();
+        CHECK(WaitUntil(ss.get(), [&] { return accepted_events.close_events > 0; }));
+        CHECK_EQ(accepted->GetState(), sled::Socket::CS_CLOSED);
+    }
+
+    TEST_CASE("udp")
+    {
+        auto ss = sled::IoUringSocketServer::Create();
+        if (!ss) { return; }
+        SocketEventRecorder receiver_events;
+
+        std::unique_ptr<sled::Socket> receiver(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE(receiver);
+        REQUIRE(sender);
+        receiver_events.Watch(receiver.get());
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(sender->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+
+        const char kMessage[] = "datagram";
+        CHECK_EQ(sender->SendTo(kMessage, sizeof(kMessage), receiver->GetLocalAddress()), sizeof(kMessage));
+        CHECK(WaitUntil(ss.get(), [&] { return receiver_events.read_events > 0; }));
+
+        char buf[64] = {0};
+        sled::SocketAddress from;
+        int64_t timestamp = -1;
+        CHECK_EQ(receiver->RecvFrom(buf, sizeof(buf), &from, &timestamp), sizeof(kMessage));
+        CHECK_EQ(std::string(buf), std::string(kMessage));
+        CHECK_EQ(from.port(), sender->GetLocalAddress().port());
+        // the kernel's SCM_TIMESTAMPNS, on the UTC clock
+        CHECK_GT(timestamp, 0);
+        CHECK_LE(timestamp, sled::TimeUTCMicros());
+        CHECK_GT(timestamp, sled::TimeUTCMicros() - 10 * sled::kNumMicrosecsPerSec);
+        CHECK_EQ(receiver->RecvFrom(buf, sizeof(buf), &from, nullptr), -1);
+        CHECK(receiver->IsBlocking());
+    }
+
+    TEST_CASE("wait without process_io")
+    {
+        auto ss = sled::IoUringSocketServer::Create();
+        if (!ss) { return; }
+        SocketEventRecorder receiver_events;
+
+        std::unique_ptr<sled::Socket> receiver(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE(receiver);
+        REQUIRE(sender);
+        receiver_events.Watch(receiver.get());
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(sender->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        // submits the receive
+        ss->Wait(sled::TimeDelta::Zero(), true);
+
+        const char kMessage[] = "datagram";
+        CHECK_EQ(sender->SendTo(kMessage, sizeof(kMessage), receiver->GetLocalAddress()), sizeof(kMessage));
+        for (int i = 0; i < 5; ++i) { CHECK(ss->Wait(sled::TimeDelta::Millis(10), false)); }
+        CHECK_EQ(receiver_events.read_events, 0);
+        ss->WakeUp();
+        CHECK(ss->Wait(sled::SocketServer::kForever, false));
+        CHECK_EQ(receiver_events.read_events, 0);
+
+        CHECK(WaitUntil(ss.get(), [&] { return receiver_events.read_events > 0; }));
+    }
+
+    TEST_CASE("destroyed with operations in flight")
+    {
+        auto ss = sled::IoUringSocketServer::Create();
+        if (!ss) { return; }
+        std::unique_ptr<sled::Socket> closed(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> listener(ss->CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE(closed);
+        REQUIRE(listener);
+        REQUIRE_EQ(closed->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(listener->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(listener->Listen(5), 0);
+        ss->Wait(sled::TimeDelta::Zero(), true);
+
+        // the cancels of the receive and the accept aren't reaped yet, the
+        // server waits for them instead of freeing the buffers under the kernel
+        closed.reset();
+        listener.reset();
+        const int64_t start_ms = sled::TimeMillis();
+        ss.reset();
+        CHECK_LT(sled::TimeMillis() - start_ms, sled::IoUringSocketServer::kDrainTimeout.ms());
+    }
+
+    TEST_CASE("thread")
+    {
+        auto thread = sled::Thread::CreateWithIoUringSocketServer();
+        thread->Start();
+        CHECK_EQ(thread->BlockingCall([] { return 42; }), 42);
+        sled::Event done;
+        thread->PostDelayedTask([&done] { done.Set(); }, sled::TimeDelta::Millis(10));
+        CHECK(done.Wait(sled::TimeDelta::Seconds(1)));
+        thread->Stop();
+    }
+}
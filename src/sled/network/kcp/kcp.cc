@@ -0,0 +1,609 @@
+#include "sled/network/kcp/kcp.h"
+#include "sled/byte_order.h"
+#include <algorithm>
+
+namespace sled {
+namespace {
+constexpr uint32_t kRtoNoDelay = 30;// no delay min rto
+constexpr uint32_t kRtoMin = 100;   // normal min rto
+constexpr uint32_t kRtoDefault = 200;
+constexpr uint32_t kRtoMax = 60000;
+constexpr uint32_t kAskSend = 1;// need to send WASK
+constexpr uint32_t kAskTell = 2;// need to send WINS
+constexpr uint32_t kWndSnd = 32;
+constexpr uint32_t kWndRcv = 128;// must > KCP::kMaxFragments
+constexpr uint32_t kInterval = 100;
+constexpr uint32_t kDeadLink = 20;
+constexpr uint32_t kThreshInit = 2;
+constexpr uint32_t kThreshMin = 2;
+constexpr uint32_t kProbeInit = 7000;   // 7 secs to probe window size
+constexpr uint32_t kProbeLimit = 120000;// up to 120 secs to probe window
+constexpr uint32_t kFastAckLimit = 5;   // max times to trigger fastack
+
+// sequence numbers and timestamps wrap around
+inline int32_t
+Diff(uint32_t later, uint32_t earlier)
+{
+    return static_cast<int32_t>(later - earlier);
+}
+
+inline uint8_t *
+Encode32(uint8_t *p, uint32_t v)
+{
+    v = htole32(v);
+    std::memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+}
+
+inline uint8_t *
+Encode16(uint8_t *p, uint16_t v)
+{
+    v = htole16(v);
+    std::memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+}
+
+inline const uint8_t *
+Decode32(const uint8_t *p, uint32_t *v)
+{
+    std::memcpy(v, p, sizeof(*v));
+    *v = le32toh(*v);
+    return p + sizeof(*v);
+}
+
+inline const uint8_t *
+Decode16(const uint8_t *p, uint16_t *v)
+{
+    std::memcpy(v, p, sizeof(*v));
+    *v = le16toh(*v);
+    return p + sizeof(*v);
+}
+
+inline uint8_t *
+EncodeHeader(uint8_t *p, const KCPHeader &header)
+{
+    p = Encode32(p, header.conv);
+    *p++ = header.cmd;
+    *p++ = header.frg;
+    p = Encode16(p, header.wnd);
+    p = Encode32(p, header.ts);
+    p = Encode32(p, header.sn);
+    p = Encode32(p, header.una);
+    return Encode32(p, header.len);
+}
+
+inline const uint8_t *
+DecodeHeader(const uint8_t *p, KCPHeader *header)
+{
+    p = Decode32(p, &header->conv);
+    header->cmd = *p++;
+    header->frg = *p++;
+    p = Decode16(p, &header->wnd);
+    p = Decode32(p, &header->ts);
+    p = Decode32(p, &header->sn);
+    p = Decode32(p, &header->una);
+    return Decode32(p, &header->len);
+}
+}// namespace
+
+constexpr uint32_t KCP::kMaxFragments;
+
+KCP::KCP(uint32_t conv, OutputCallback output)
+    : conv_(conv),
+      output_(std::move(output)),
+      mtu_(kDefaultMtu),
+      mss_(kDefaultMtu - kOverhead),
+      ssthresh_(kThreshInit),
+      rx_rto_(kRtoDefault),
+      rx_minrto_(kRtoMin),
+      snd_wnd_(kWndSnd),
+      rcv_wnd_(kWndRcv),
+      rmt_wnd_(kWndRcv),
+      interval_(kInterval),
+      ts_flush_(kInterval),
+      dead_link_(kDeadLink),
+      fastlimit_(kFastAckLimit)
+{
+    buffer_.EnsureCapacity(mtu_);
+}
+
+KCP::Segment
+KCP::NewSegment(const uint8_t *data, size_t size)
+{
+    Segment segment;
+    std::memset(&segment.header, 0, sizeof(segment.header));
+    segment.header.len = static_cast<uint32_t>(size);
+    segment.resendts = segment.rto = segment.fastack = segment.xmit = 0;
+    if (size > 0) { segment.data.SetData(data, size); }
+    return segment;
+}
+
+int
+KCP::Send(const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+
+    // append to the previous segment in streaming mode
+    if (stream_ && !snd_queue_.empty()) {
+        Segment &last = snd_queue_.back();
+        if (last.data.size() < mss_) {
+            const size_t extend = std::min<size_t>(size, mss_ - last.data.size());
+            last.data.AppendData(p, extend);
+            last.header.len = static_cast<uint32_t>(last.data.size());
+            last.header.frg = 0;
+            p += extend;
+            size -= extend;
+        }
+        if (size == 0) { return 0; }
+    }
+
+    size_t count = size <= mss_ ? 1 : (size + mss_ - 1) / mss_;
+    if (count > kMaxFragments) { return -1; }
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t len = std::min<size_t>(size, mss_);
+        Segment segment = NewSegment(p, len);
+        segment.header.frg = stream_ ? 0 : static_cast<uint8_t>(count - i - 1);
+        snd_queue_.push_back(std::move(segment));
+        p += len;
+        size -= len;
+    }
+    return 0;
+}
+
+int
+KCP::PeekSize() const
+{
+    if (rcv_queue_.empty()) { return -1; }
+
+    const Segment &front = rcv_queue_.front();
+    if (front.header.frg == 0) { return static_cast<int>(front.data.size()); }
+    if (rcv_queue_.size() < front.header.frg + 1u) { return -1; }
+
+    size_t length = 0;
+    for (const Segment &segment : rcv_queue_) {
+        length += segment.data.size();
+        if (segment.header.frg == 0) { break; }
+    }
+    return static_cast<int>(length);
+}
+
+int
+KCP::Recv(void *buffer, size_t size)
+{
+    const int peek_size = PeekSize();
+    if (peek_size < 0) { return -1; }
+    if (static_cast<size_t>(peek_size) > size) { return -2; }
+
+    const bool recover = rcv_queue_.size() >= rcv_wnd_;
+
+    uint8_t *p = static_cast<uint8_t *>(buffer);
+    while (!rcv_queue_.empty()) {
+        Segment &segment = rcv_queue_.front();
+        const uint8_t frg = segment.header.frg;
+        std::memcpy(p, segment.data.data(), segment.data.size());
+        p += segment.data.size();
+        rcv_queue_.pop_front();
+        if (frg == 0) { break; }
+    }
+
+    MoveToReceiveQueue();
+
+    // the window was full, tell the remote it opened again
+    if (recover && rcv_queue_.size() < rcv_wnd_) { probe_ |= kAskTell; }
+    return peek_size;
+}
+
+void
+KCP::MoveToReceiveQueue()
+{
+    while (!rcv_buf_.empty()) {
+        Segment &segment = rcv_buf_.front();
+        if (segment.header.sn != rcv_nxt_ || rcv_queue_.size() >= rcv_wnd_) { break; }
+        rcv_queue_.push_back(std::move(segment));
+        rcv_buf_.pop_front();
+        ++rcv_nxt_;
+    }
+}
+
+void
+KCP::UpdateAck(int32_t rtt)
+{
+    if (rx_srtt_ == 0) {
+        rx_srtt_ = rtt;
+        rx_rttval_ = rtt / 2;
+    } else {
+        const int32_t delta = rtt > rx_srtt_ ? rtt - rx_srtt_ : rx_srtt_ - rtt;
+        rx_rttval_ = (3 * rx_rttval_ + delta) / 4;
+        rx_srtt_ = (7 * rx_srtt_ + rtt) / 8;
+        if (rx_srtt_ < 1) { rx_srtt_ = 1; }
+    }
+    const int32_t rto = rx_srtt_ + std::max<int32_t>(interval_, 4 * rx_rttval_);
+    rx_rto_ = std::min<int32_t>(std::max<int32_t>(rx_minrto_, rto), kRtoMax);
+}
+
+void
+KCP::ShrinkBuf()
+{
+    snd_una_ = snd_buf_.empty() ? snd_nxt_ : snd_buf_.front().header.sn;
+}
+
+void
+KCP::ParseAck(uint32_t sn)
+{
+    if (Diff(sn, snd_una_) < 0 || Diff(sn, snd_nxt_) >= 0) { return; }
+
+    for (auto it = snd_buf_.begin(); it != snd_buf_.end(); ++it) {
+        if (it->header.sn == sn) {
+            snd_buf_.erase(it);
+            break;
+        }
+        if (Diff(sn, it->header.sn) < 0) { break; }
+    }
+}
+
+void
+KCP::ParseUna(uint32_t una)
+{
+    while (!snd_buf_.empty() && Diff(una, snd_buf_.front().header.sn) > 0) { snd_buf_.pop_front(); }
+}
+
+void
+KCP::ParseFastAck(uint32_t sn)
+{
+    if (Diff(sn, snd_una_) < 0 || Diff(sn, snd_nxt_) >= 0) { return; }
+
+    // every segment older than the newest ack was skipped once more
+    for (Segment &segment : snd_buf_) {
+        if (Diff(sn, segment.header.sn) < 0) { break; }
+        if (sn != segment.header.sn) { ++segment.fastack; }
+    }
+}
+
+void
+KCP::ParseData(Segment &&segment)
+{
+    const uint32_t sn = segment.header.sn;
+    if (Diff(sn, rcv_nxt_ + rcv_wnd_) >= 0 || Diff(sn, rcv_nxt_) < 0) { return; }
+
+    auto it = rcv_buf_.end();
+    bool repeat = false;
+    while (it != rcv_buf_.begin()) {
+        auto prev = it - 1;
+        if (prev->header.sn == sn) {
+            repeat = true;
+            break;
+        }
+        if (Diff(sn, prev->header.sn) > 0) { break; }
+        it = prev;
+    }
+    if (!repeat) { rcv_buf_.insert(it, std::move(segment)); }
+
+    MoveToReceiveQueue();
+}
+
+int
+KCP::Input(const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const uint32_t prev_una = snd_una_;
+    bool has_ack = false;
+    uint32_t maxack = 0;
+
+    if (size < kOverhead) { return -1; }
+
+    while (size >= kOverhead) {
+        KCPHeader header;
+        p = DecodeHeader(p, &header);
+        if (header.conv != conv_) { return -1; }
+        size -= kOverhead;
+        if (size < header.len) { return -2; }
+
+        const KCPCommand cmd = static_cast<KCPCommand>(header.cmd);
+        if (cmd != KCPCommand::kPush && cmd != KCPCommand::kAck && cmd != KCPCommand::kWask
+            && cmd != KCPCommand::kWins) {
+            return -3;
+        }
+
+        rmt_wnd_ = header.wnd;
+        ParseUna(header.una);
+        ShrinkBuf();
+
+        switch (cmd) {
+        case KCPCommand::kAck:
+            if (Diff(current_, header.ts) >= 0) { UpdateAck(Diff(current_, header.ts)); }
+            ParseAck(header.sn);
+            ShrinkBuf();
+            if (!has_ack || Diff(header.sn, maxack) > 0) {
+                has_ack = true;
+                maxack = header.sn;
+            }
+            break;
+        case KCPCommand::kPush:
+            if (Diff(header.sn, rcv_nxt_ + rcv_wnd_) < 0) {
+                acklist_.emplace_back(header.sn, header.ts);
+                if (Diff(header.sn, rcv_nxt_) >= 0) {
+                    Segment segment = NewSegment(p, header.len);
+                    segment.header = header;
+                    ParseData(std::move(segment));
+                }
+            }
+            break;
+        case KCPCommand::kWask:
+            // ready to send back kWins in Flush()
+            probe_ |= kAskTell;
+            break;
+        case KCPCommand::kWins:
+            // rmt_wnd_ was updated above
+            break;
+        }
+
+        p += header.len;
+        size -= header.len;
+    }
+
+    if (has_ack) { ParseFastAck(maxack); }
+
+    // congestion window grows on new acks, slow start then congestion avoidance
+    if (Diff(snd_una_, prev_una) > 0 && cwnd_ < rmt_wnd_) {
+        const uint32_t mss = mss_;
+        if (cwnd_ < ssthresh_) {
+            ++cwnd_;
+            incr_ += mss;
+        } else {
+            if (incr_ < mss) { incr_ = mss; }
+            incr_ += (mss * mss) / incr_ + (mss / 16);
+            if ((cwnd_ + 1) * mss <= incr_) { cwnd_ = (incr_ + mss - 1) / (mss > 0 ? mss : 1); }
+        }
+        if (cwnd_ > rmt_wnd_) {
+            cwnd_ = rmt_wnd_;
+            incr_ = rmt_wnd_ * mss;
+        }
+    }
+    return 0;
+}
+
+uint16_t
+KCP::UnusedWindow() const
+{
+    return rcv_queue_.size() < rcv_wnd_ ? static_cast<uint16_t>(rcv_wnd_ - rcv_queue_.size()) : 0;
+}
+
+void
+KCP::FlushBuffer()
+{
+    if (buffer_.size() > 0) {
+        output_(buffer_.data(), buffer_.size());
+        buffer_.Clear();
+    }
+}
+
+void
+KCP::Output(const KCPHeader &header, const Buffer *data)
+{
+    const size_t need = kOverhead + (data ? data->size() : 0);
+    if (buffer_.size() + need > mtu_) { FlushBuffer(); }
+
+    uint8_t encoded[kOverhead];
+    EncodeHeader(encoded, header);
+    buffer_.AppendData(encoded, kOverhead);
+    if (data && data->size() > 0) { buffer_.AppendData(data->data(), data->size()); }
+}
+
+void
+KCP::Flush()
+{
+    if (!updated_) { return; }
+    const uint32_t current = current_;
+    bool change = false;
+    bool lost = false;
+
+    KCPHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.conv = conv_;
+    header.cmd = static_cast<uint8_t>(KCPCommand::kAck);
+    header.wnd = UnusedWindow();
+    header.una = rcv_nxt_;
+
+    // flush acknowledges
+    for (const auto &ack : acklist_) {
+        header.sn = ack.first;
+        header.ts = ack.second;
+        Output(header, nullptr);
+    }
+    acklist_.clear();
+
+    // probe window size if the remote window is zero
+    if (rmt_wnd_ == 0) {
+        if (probe_wait_ == 0) {
+            probe_wait_ = kProbeInit;
+            ts_probe_ = current + probe_wait_;
+        } else if (Diff(current, ts_probe_) >= 0) {
+            if (probe_wait_ < kProbeInit) { probe_wait_ = kProbeInit; }
+            probe_wait_ += probe_wait_ / 2;
+            if (probe_wait_ > kProbeLimit) { probe_wait_ = kProbeLimit; }
+            ts_probe_ = current + probe_wait_;
+            probe_ |= kAskSend;
+        }
+    } else {
+        ts_probe_ = 0;
+        probe_wait_ = 0;
+    }
+
+    header.sn = header.ts = 0;
+    if (probe_ & kAskSend) {
+        header.cmd = static_cast<uint8_t>(KCPCommand::kWask);
+        Output(header, nullptr);
+    }
+    if (probe_ & kAskTell) {
+        header.cmd = static_cast<uint8_t>(KCPCommand::kWins);
+        Output(header, nullptr);
+    }
+    probe_ = 0;
+
+    uint32_t cwnd = std::min(snd_wnd_, rmt_wnd_);
+    if (!nocwnd_) { cwnd = std::min(cwnd_, cwnd); }
+
+    // move data from snd_queue_ to snd_buf_
+    while (Diff(snd_nxt_, snd_una_ + cwnd) < 0 && !snd_queue_.empty()) {
+        Segment segment = std::move(snd_queue_.front());
+        snd_queue_.pop_front();
+        segment.header.conv = conv_;
+        segment.header.cmd = static_cast<uint8_t>(KCPCommand::kPush);
+        segment.header.wnd = header.wnd;
+        segment.header.ts = current;
+        segment.header.sn = snd_nxt_++;
+        segment.header.una = rcv_nxt_;
+        segment.resendts = current;
+        segment.rto = rx_rto_;
+        segment.fastack = 0;
+        segment.xmit = 0;
+        snd_buf_.push_back(std::move(segment));
+    }
+
+    const uint32_t resent = fastresend_ > 0 ? fastresend_ : 0xffffffff;
+    const uint32_t rtomin = nodelay_ == 0 ? (rx_rto_ >> 3) : 0;
+
+    for (Segment &segment : snd_buf_) {
+        bool needsend = false;
+        if (segment.xmit == 0) {
+            // first transmission
+            needsend = true;
+            ++segment.xmit;
+            segment.rto = rx_rto_;
+            segment.resendts = current + segment.rto + rtomin;
+        } else if (Diff(current, segment.resendts) >= 0) {
+            // timeout retransmission, back off
+            needsend = true;
+            ++segment.xmit;
+            ++xmit_;
+            if (nodelay_ == 0) {
+                segment.rto += std::max<uint32_t>(segment.rto, rx_rto_);
+            } else {
+                const uint32_t step = nodelay_ < 2 ? segment.rto : rx_rto_;
+                segment.rto += step / 2;
+            }
+            segment.resendts = current + segment.rto;
+            lost = true;
+        } else if (segment.fastack >= resent) {
+            // fast retransmission, skipped by `resent` later acks
+            if (segment.xmit <= fastlimit_ || fastlimit_ == 0) {
+                needsend = true;
+                ++segment.xmit;
+                ++xmit_;
+                segment.fastack = 0;
+                segment.resendts = current + segment.rto;
+                change = true;
+            }
+        }
+
+        if (needsend) {
+            segment.header.ts = current;
+            segment.header.wnd = header.wnd;
+            segment.header.una = rcv_nxt_;
+            Output(segment.header, &segment.data);
+            if (segment.xmit >= dead_link_) { dead_ = true; }
+        }
+    }
+
+    FlushBuffer();
+
+    if (change) {
+        const uint32_t inflight = snd_nxt_ - snd_una_;
+        ssthresh_ = std::max(inflight / 2, kThreshMin);
+        cwnd_ = ssthresh_ + resent;
+        incr_ = cwnd_ * mss_;
+    }
+    if (lost) {
+        ssthresh_ = std::max(cwnd / 2, kThreshMin);
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+    if (cwnd_ < 1) {
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+}
+
+void
+KCP::Update(uint32_t current)
+{
+    current_ = current;
+    if (!updated_) {
+        updated_ = true;
+        ts_flush_ = current_;
+    }
+
+    int32_t slap = Diff(current_, ts_flush_);
+    if (slap >= 10000 || slap < -10000) {
+        ts_flush_ = current_;
+        slap = 0;
+    }
+
+    if (slap >= 0) {
+        ts_flush_ += interval_;
+        if (Diff(current_, ts_flush_) >= 0) { ts_flush_ = current_ + interval_; }
+        Flush();
+    }
+}
+
+uint32_t
+KCP::Check(uint32_t current) const
+{
+    if (!updated_) { return current; }
+
+    uint32_t ts_flush = ts_flush_;
+    if (Diff(current, ts_flush) >= 10000 || Diff(current, ts_flush) < -10000) { ts_flush = current; }
+    if (Diff(current, ts_flush) >= 0) { return current; }
+
+    const int32_t tm_flush = Diff(ts_flush, current);
+    int32_t tm_packet = 0x7fffffff;
+    for (const Segment &segment : snd_buf_) {
+        const int32_t diff = Diff(segment.resendts, current);
+        if (diff <= 0) { return current; }
+        tm_packet = std::min(tm_packet, diff);
+    }
+
+    uint32_t minimal = static_cast<uint32_t>(std::min(tm_packet, tm_flush));
+    if (minimal >= interval_) { minimal = interval_; }
+    return current + minimal;
+}
+
+int
+KCP::SetMtu(uint32_t mtu)
+{
+    if (mtu < 50 || mtu < kOverhead) { return -1; }
+    FlushBuffer();
+    mtu_ = mtu;
+    mss_ = mtu - kOverhead;
+    buffer_.EnsureCapacity(mtu_);
+    return 0;
+}
+
+void
+KCP::SetInterval(uint32_t interval)
+{
+    interval_ = std::min<uint32_t>(std::max<uint32_t>(interval, 10), 5000);
+}
+
+void
+KCP::SetNoDelay(int nodelay, int interval, int resend, bool no_congestion_control)
+{
+    if (nodelay >= 0) {
+        nodelay_ = nodelay;
+        rx_minrto_ = nodelay ? kRtoNoDelay : kRtoMin;
+    }
+    if (interval >= 0) { SetInterval(interval); }
+    if (resend >= 0) { fastresend_ = resend; }
+    nocwnd_ = no_congestion_control;
+}
+
+void
+KCP::SetWindowSize(uint32_t send_window, uint32_t receive_window)
+{
+    if (send_window > 0) { snd_wnd_ = send_window; }
+    // must be able to hold the largest fragmented message
+    if (receive_window > 0) { rcv_wnd_ = std::max(receive_window, kWndRcv); }
+}
+
+}// namespace sled
@@ -3,8 +3,12 @@
 
 #pragma once
 
+#include "sled/buffer.h"
+#include <deque>
+#include <functional>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 /**
  kcp header
@@ -23,11 +27,12 @@
 */
 namespace sled {
 
+// wire values, compatible with ikcp
 enum class KCPCommand {
-    kPush,
-    kAck,
-    kWask,
-    kWins,
+    kPush = 81,
+    kAck = 82,
+    kWask = 83,
+    kWins = 84,
 };
 
 struct KCPHeader {
@@ -47,6 +52,144 @@ struct KCPPacket {
     char data[1];
 };
 
+/**
+ * The KCP ARQ state machine, independent of any transport or clock: packets
+ * leave through the output callback, arrive through Input(), and Update()
+ * is driven with a millisecond clock (see KcpSocket for a socket on top).
+ **/
+class KCP {
+public:
+    // encoded size of KCPHeader
+    static constexpr uint32_t kOverhead = 24;
+    static constexpr uint32_t kDefaultMtu = 1400;
+    // the most segments Send() splits one message into
+    static constexpr uint32_t kMaxFragments = 127;
+
+    using OutputCallback = std::function<void(const uint8_t *data, size_t size)>;
+
+    KCP(uint32_t conv, OutputCallback output);
+
+    /**
+     * Queues a message, fragmented by the mss. In stream mode messages are
+     * merged and Recv() returns an arbitrary split of the byte stream.
+     * @return 0, or -1 if the message needs more than kMaxFragments segments
+     **/
+    int Send(const void *data, size_t size);
+    /**
+     * @return the message size, -1 if none is complete yet, -2 if `size` is
+     * smaller than the next message (see PeekSize())
+     **/
+    int Recv(void *buffer, size_t size);
+    // size of the next complete message, -1 if there is none
+    int PeekSize() const;
+
+    // @return 0, or < 0 if the datagram is not a valid packet for this conv
+    int Input(const void *data, size_t size);
+
+    // call every interval(), or at Check(); `current` is in milliseconds
+    void Update(uint32_t current);
+    // when Update() needs to be called next
+    uint32_t Check(uint32_t current) const;
+    // sends pending acks and data right away, Update() must have run once
+    void Flush();
+
+    int SetMtu(uint32_t mtu);
+    void SetInterval(uint32_t interval);
+    /**
+     * @param nodelay 0 normal, 1 lower minimum rto and gentler backoff, 2 even less backoff
+     * @param interval Update() period in milliseconds, 10-5000
+     * @param resend fast retransmit after this many skipping acks, 0 disables
+     * @param no_congestion_control ignore the congestion window, only use the send/receive windows
+     **/
+    void SetNoDelay(int nodelay, int interval, int resend, bool no_congestion_control);
+    void SetWindowSize(uint32_t send_window, uint32_t receive_window);
+    void SetStreamMode(bool stream) { stream_ = stream; }
+    // a segment sent this many times marks the link dead, see IsDead()
+    void SetDeadLink(uint32_t dead_link) { dead_link_ = dead_link; }
+
+    uint32_t conv() const { return conv_; }
+
+    uint32_t mss() const { return mss_; }
+
+    uint32_t interval() const { return interval_; }
+
+    uint32_t send_window() const { return snd_wnd_; }
+
+    // segments queued or in flight
+    size_t WaitSnd() const { return snd_buf_.size() + snd_queue_.size(); }
+
+    // retransmissions sent so far
+    uint32_t retransmits() const { return xmit_; }
+
+    bool IsDead() const { return dead_; }
+
+private:
+    struct Segment {
+        KCPHeader header;
+        uint32_t resendts;
+        uint32_t rto;
+        uint32_t fastack;
+        uint32_t xmit;
+        Buffer data;
+    };
+
+    Segment NewSegment(const uint8_t *data, size_t size);
+    void UpdateAck(int32_t rtt);
+    void ShrinkBuf();
+    void ParseAck(uint32_t sn);
+    void ParseUna(uint32_t una);
+    void ParseFastAck(uint32_t sn);
+    void ParseData(Segment &&segment);
+    void MoveToReceiveQueue();
+    uint16_t UnusedWindow() const;
+    void Output(const KCPHeader &header, const Buffer *data);
+    void FlushBuffer();
+
+    const uint32_t conv_;
+    const OutputCallback output_;
+    uint32_t mtu_;
+    uint32_t mss_;
+    bool dead_ = false;
+    bool stream_ = false;
+
+    uint32_t snd_una_ = 0;
+    uint32_t snd_nxt_ = 0;
+    uint32_t rcv_nxt_ = 0;
+    uint32_t ssthresh_;
+    int32_t rx_rttval_ = 0;
+    int32_t rx_srtt_ = 0;
+    int32_t rx_rto_;
+    int32_t rx_minrto_;
+    uint32_t snd_wnd_;
+    uint32_t rcv_wnd_;
+    uint32_t rmt_wnd_;
+    uint32_t cwnd_ = 0;
+    uint32_t probe_ = 0;
+    uint32_t current_ = 0;
+    uint32_t interval_;
+    uint32_t ts_flush_;
+    uint32_t xmit_ = 0;
+    int nodelay_ = 0;
+    bool updated_ = false;
+    uint32_t ts_probe_ = 0;
+    uint32_t probe_wait_ = 0;
+    uint32_t dead_link_;
+    uint32_t incr_ = 0;
+    uint32_t fastresend_ = 0;
+    uint32_t fastlimit_;
+    bool nocwnd_ = false;
+
+    std::deque<Segment> snd_queue_;
+    std::deque<Segment> rcv_queue_;
+    std::deque<Segment> snd_buf_;
+    // ordered by sn
+    std::deque<Segment> rcv_buf_;
+    // (sn, ts) pairs to acknowledge in the next flush
+    std::vector<std::pair<uint32_t, uint32_t>> acklist_;
+    // packets of one flush are coalesced up to the mtu
+    Buffer buffer_;
+};
+
 }// namespace sled
 
 #endif// SLED_NETWORK_KCP_KCP_H
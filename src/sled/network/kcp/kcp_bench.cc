@@ -0,0 +1,92 @@
+#include <cstring>
+#include <sled/network/kcp/kcp.h>
+#include <sled/testing/benchmark.h>
+#include <sled/testing/lossy_link.h>
+
+// one iteration is one 1KB message delivered over a 20ms link, the virtual
+// clock advances 1ms per iteration. The result is the number of
+// retransmissions, or with `latency` the mean time from Send() until the
+// message could be Recv()ed, in virtual microseconds.
+static void
+KcpTransfer(picobench::state &s, uint32_t loss_percent, bool latency)
+{
+    uint32_t now = 0;
+    sled::LossyLink a_to_b(20, loss_percent, 1);
+    sled::LossyLink b_to_a(20, loss_percent, 2);
+    sled::KCP a(1, [&](const uint8_t *data, size_t size) { a_to_b.Send(now, data, size); });
+    sled::KCP b(1, [&](const uint8_t *data, size_t size) { b_to_a.Send(now, data, size); });
+    a.SetNoDelay(1, 10, 2, true);
+    b.SetNoDelay(1, 10, 2, true);
+    a.SetWindowSize(256, 256);
+    b.SetWindowSize(256, 256);
+
+    // every message starts with the time it was sent
+    std::string message(1024, 'k');
+    char buf[2048];
+    int received = 0;
+    uint64_t total_latency_ms = 0;
+    s.start_timer();
+    for (int sent = 0; received < s.iterations(); ++now) {
+        if (sent < s.iterations()) {
+            std::memcpy(&message[0], &now, sizeof(now));
+            a.Send(message.data(), message.size());
+            ++sent;
+        }
+        a.Update(now);
+        b.Update(now);
+        a_to_b.Deliver(now, &b);
+        b_to_a.Deliver(now, &a);
+        while (b.Recv(buf, sizeof(buf)) > 0) {
+            uint32_t sent_ms;
+            std::memcpy(&sent_ms, buf, sizeof(sent_ms));
+            total_latency_ms += now - sent_ms;
+            ++received;
+        }
+    }
+    s.stop_timer();
+    s.set_result(latency ? total_latency_ms * 1000 / s.iterations() : a.retransmits());
+}
+
+static void
+KcpTransferNoLoss(picobench::state &s)
+{
+    KcpTransfer(s, 0, false);
+}
+
+static void
+KcpTransfer10PercentLoss(picobench::state &s)
+{
+    KcpTransfer(s, 10, false);
+}
+
+static void
+KcpTransfer30PercentLoss(picobench::state &s)
+{
+    KcpTransfer(s, 30, false);
+}
+
+static void
+KcpLatencyNoLoss(picobench::state &s)
+{
+    KcpTransfer(s, 0, true);
+}
+
+static void
+KcpLatency10PercentLoss(picobench::state &s)
+{
+    KcpTransfer(s, 10, true);
+}
+
+static void
+KcpLatency30PercentLoss(picobench::state &s)
+{
+    KcpTransfer(s, 30, true);
+}
+
+PICOBENCH_SUITE("KCP");
+PICOBENCH(KcpTransferNoLoss);
+PICOBENCH(KcpTransfer10PercentLoss);
+PICOBENCH(KcpTransfer30PercentLoss);
+PICOBENCH(KcpLatencyNoLoss);
+PICOBENCH(KcpLatency10PercentLoss);
+PICOBENCH(KcpLatency30PercentLoss);
@@ -0,0 +1,288 @@
+#include "sled/network/kcp/kcp_socket.h"
+#include "sled/time_utils.h"
+#include <algorithm>
+
+namespace sled {
+
+KcpSocket::KcpSocket(TaskQueueBase *task_queue, Socket *socket, uint32_t conv)
+    : task_queue_(task_queue),
+      socket_(socket),
+      kcp_(conv, [this](const uint8_t *data, size_t size) { Output(data, size); }),
+      timeout_factory_(
+          *task_queue,
+          [] { return static_cast<TimeMs>(TimeMillis()); },
+          [this](TimeoutID timeout_id) { timer_manager_.HandleTimeout(timeout_id); }),
+      timer_manager_([this](TaskQueueBase::DelayPrecision precision) {
+          return timeout_factory_.CreateTimeout(precision);
+      }),
+      timer_(timer_manager_.CreateTimer("kcp", [this] { return OnTimer(); })),
+      safety_(PendingTaskSafetyFlag::CreateDetached())
+{
+    recv_buffer_.EnsureCapacity(kMaxDatagramSize);
+    socket_->SignalReadEvent.connect(this, &KcpSocket::OnReadEvent);
+    socket_->SignalCloseEvent.connect(this, &KcpSocket::OnCloseEvent);
+}
+
+KcpSocket::~KcpSocket()
+{
+    safety_->SetNotAlive();
+    Close();
+}
+
+SocketAddress
+KcpSocket::GetLocalAddress() const
+{
+    return socket_->GetLocalAddress();
+}
+
+SocketAddress
+KcpSocket::GetRemoteAddress() const
+{
+    return remote_addr_;
+}
+
+int
+KcpSocket::Bind(const SocketAddress &addr)
+{
+    int err = socket_->Bind(addr);
+    if (err != 0) { SetError(socket_->GetError()); }
+    return err;
+}
+
+int
+KcpSocket::Connect(const SocketAddress &addr)
+{
+    if (state_ != CS_CLOSED) {
+        SetError(EALREADY);
+        return SOCKET_ERROR;
+    }
+    remote_addr_ = addr;
+    state_ = CS_CONNECTED;
+    timer_->set_duration(kcp_.interval());
+    timer_->Start();
+    return 0;
+}
+
+int
+KcpSocket::Send(const void *pv, size_t cb)
+{
+    if (state_ != CS_CONNECTED) {
+        SetError(ENOTCONN);
+        return SOCKET_ERROR;
+    }
+    // keep at most two windows queued, the rest is the caller's backlog
+    const size_t queue_limit = 2 * kcp_.send_window();
+    if (kcp_.WaitSnd() >= queue_limit) {
+        write_blocked_ = true;
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+    // like a stream socket take what fits, in message mode no more than one message either
+    const size_t segments = std::min<size_t>(queue_limit - kcp_.WaitSnd(), KCP::kMaxFragments);
+    const size_t accepted = std::min<size_t>(cb, segments * kcp_.mss());
+    if (kcp_.Send(pv, accepted) != 0) {
+        SetError(EMSGSIZE);
+        return SOCKET_ERROR;
+    }
+    if (accepted < cb) { write_blocked_ = true; }
+    if (!flush_posted_) {
+        flush_posted_ = true;
+        task_queue_->PostTask(SafeTask(safety_, [this] { Flush(); }));
+    }
+    return static_cast<int>(accepted);
+}
+
+int
+KcpSocket::SendTo(const void *pv, size_t cb, const SocketAddress &addr)
+{
+    if (state_ == CS_CONNECTED && addr != remote_addr_) {
+        SetError(EISCONN);
+        return SOCKET_ERROR;
+    }
+    return Send(pv, cb);
+}
+
+int
+KcpSocket::Recv(void *pv, size_t cb, int64_t *timestamp)
+{
+    if (timestamp) { *timestamp = -1; }
+
+    if (pending_offset_ < pending_recv_.size()) {
+        const size_t len = std::min(cb, pending_recv_.size() - pending_offset_);
+        std::memcpy(pv, pending_recv_.data() + pending_offset_, len);
+        pending_offset_ += len;
+        PostReadEvent();
+        return static_cast<int>(len);
+    }
+
+    const int peek_size = kcp_.PeekSize();
+    if (peek_size < 0) {
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+    if (static_cast<size_t>(peek_size) <= cb) {
+        const int received = kcp_.Recv(pv, cb);
+        PostReadEvent();
+        return received;
+    }
+
+    pending_recv_.SetSize(peek_size);
+    kcp_.Recv(pending_recv_.data(), pending_recv_.size());
+    std::memcpy(pv, pending_recv_.data(), cb);
+    pending_offset_ = cb;
+    PostReadEvent();
+    return static_cast<int>(cb);
+}
+
+int
+KcpSocket::RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp)
+{
+    int received = Recv(pv, cb, timestamp);
+    if (received >= 0 && paddr) { *paddr = remote_addr_; }
+    return received;
+}
+
+int
+KcpSocket::Listen(int backlog)
+{
+    SetError(EOPNOTSUPP);
+    return SOCKET_ERROR;
+}
+
+Socket *
+KcpSocket::Accept(SocketAddress *paddr)
+{
+    SetError(EOPNOTSUPP);
+    return nullptr;
+}
+
+int
+KcpSocket::Close()
+{
+    timer_->Stop();
+    state_ = CS_CLOSED;
+    return socket_->Close();
+}
+
+int
+KcpSocket::GetError() const
+{
+    return error_;
+}
+
+void
+KcpSocket::SetError(int error)
+{
+    error_ = error;
+}
+
+Socket::ConnState
+KcpSocket::GetState() const
+{
+    return state_;
+}
+
+int
+KcpSocket::GetOption(Option opt, int *value)
+{
+    return socket_->GetOption(opt, value);
+}
+
+int
+KcpSocket::SetOption(Option opt, int value)
+{
+    return socket_->SetOption(opt, value);
+}
+
+void
+KcpSocket::OnReadEvent(Socket *socket)
+{
+    const uint32_t now = static_cast<uint32_t>(TimeMillis());
+    bool input = false;
+    // Input() needs the current time for the rtt of acks
+    kcp_.Update(now);
+    while (true) {
+        SocketAddress addr;
+        recv_buffer_.SetSize(recv_buffer_.capacity());
+        int received = socket_->RecvFrom(recv_buffer_.data(), recv_buffer_.size(), &addr, nullptr);
+        if (received < 0) { break; }
+        if (state_ == CS_CONNECTED && addr != remote_addr_) { continue; }
+        if (kcp_.Input(recv_buffer_.data(), received) != 0) { continue; }
+        input = true;
+        // passive open, the first valid packet picks the peer
+        if (state_ != CS_CONNECTED) { Connect(addr); }
+    }
+    if (!input) { return; }
+
+    // acknowledge right away instead of on the next interval
+    kcp_.Flush();
+    CheckState();
+    if (state_ == CS_CONNECTED && kcp_.PeekSize() >= 0) { SignalReadEvent(this); }
+}
+
+void
+KcpSocket::OnCloseEvent(Socket *socket, int error)
+{
+    timer_->Stop();
+    state_ = CS_CLOSED;
+    SignalCloseEvent(this, error);
+}
+
+void
+KcpSocket::Output(const uint8_t *data, size_t size)
+{
+    socket_->SendTo(data, size, remote_addr_);
+}
+
+sled::optional<DurationMs>
+KcpSocket::OnTimer()
+{
+    const uint32_t now = static_cast<uint32_t>(TimeMillis());
+    kcp_.Update(now);
+    DurationMs next = std::max<uint32_t>(kcp_.Check(now) - now, 1);
+    CheckState();
+    return next;
+}
+
+bool
+KcpSocket::Readable() const
+{
+    return pending_offset_ < pending_recv_.size() || kcp_.PeekSize() >= 0;
+}
+
+void
+KcpSocket::PostReadEvent()
+{
+    if (read_event_posted_ || !Readable()) { return; }
+    read_event_posted_ = true;
+    task_queue_->PostTask(SafeTask(safety_, [this] {
+        read_event_posted_ = false;
+        if (state_ == CS_CONNECTED && Readable()) { SignalReadEvent(this); }
+    }));
+}
+
+void
+KcpSocket::Flush()
+{
+    flush_posted_ = false;
+    if (state_ != CS_CONNECTED) { return; }
+    kcp_.Update(static_cast<uint32_t>(TimeMillis()));
+    kcp_.Flush();
+}
+
+void
+KcpSocket::CheckState()
+{
+    if (kcp_.IsDead() && state_ == CS_CONNECTED) {
+        timer_->Stop();
+        state_ = CS_CLOSED;
+        SignalCloseEvent(this, ETIMEDOUT);
+        return;
+    }
+    if (write_blocked_ && kcp_.WaitSnd() < kcp_.send_window()) {
+        write_blocked_ = false;
+        SignalWriteEvent(this);
+    }
+}
+
+}// namespace sled
@@ -0,0 +1,96 @@
+/**
+ * @file     : kcp_socket
+ * @created  : Saturday Oct 17, 2026 19:40:18 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_KCP_KCP_SOCKET_H
+#define SLED_NETWORK_KCP_KCP_SOCKET_H
+#pragma once
+
+#include "sled/network/kcp/kcp.h"
+#include "sled/network/socket.h"
+#include "sled/task_queue/pending_task_safety_flag.h"
+#include "sled/timer/task_queue_timeout.h"
+#include "sled/timer/timer.h"
+#include <memory>
+
+namespace sled {
+
+/**
+ * A reliable stream over a UDP socket, using the KCP ARQ. There is no
+ * handshake: Connect() only sets the peer, and a socket which was just
+ * Bind()ed adopts the sender of the first valid packet. Both ends must use
+ * the same conv. Retransmissions are driven by a TimerManager on
+ * `task_queue`, which must be the thread delivering the UDP socket events;
+ * create, use and destroy the KcpSocket there as well.
+ *
+ * Send() takes what fits two send windows and one KCP message, and returns
+ * the count. The data goes out in a task posted behind the caller's, so the
+ * writes of one task share segments, instead of waiting for the next
+ * interval (100ms by default).
+ **/
+class KcpSocket : public Socket, public sigslot::has_slots<> {
+public:
+    // takes ownership of `socket`
+    KcpSocket(TaskQueueBase *task_queue, Socket *socket, uint32_t conv);
+    ~KcpSocket() override;
+
+    // tuning, e.g. kcp()->SetNoDelay(1, 10, 2, true) for the fast mode
+    KCP *kcp() { return &kcp_; }
+
+    SocketAddress GetLocalAddress() const override;
+    SocketAddress GetRemoteAddress() const override;
+
+    int Bind(const SocketAddress &addr) override;
+    int Connect(const SocketAddress &addr) override;
+    int Send(const void *pv, size_t cb) override;
+    int SendTo(const void *pv, size_t cb, const SocketAddress &addr) override;
+    int Recv(void *pv, size_t cb, int64_t *timestamp) override;
+    int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) override;
+    int Listen(int backlog) override;
+    Socket *Accept(SocketAddress *paddr) override;
+    int Close() override;
+    int GetError() const override;
+    void SetError(int error) override;
+    ConnState GetState() const override;
+    int GetOption(Option opt, int *value) override;
+    int SetOption(Option opt, int value) override;
+
+private:
+    void OnReadEvent(Socket *socket);
+    void OnCloseEvent(Socket *socket, int error);
+    void Output(const uint8_t *data, size_t size);
+    sled::optional<DurationMs> OnTimer();
+    // reports dead links and reopened send windows
+    void CheckState();
+    void Flush();
+    // the rest of a message, or another one, is left to read
+    bool Readable() const;
+    // SignalReadEvent comes only with new datagrams, so Recv() posts one
+    // for what it leaves behind, like PhysicalSocket re-arms DE_READ
+    void PostReadEvent();
+
+    TaskQueueBase *const task_queue_;
+    std::unique_ptr<Socket> socket_;
+    KCP kcp_;
+    SocketAddress remote_addr_;
+    ConnState state_ = CS_CLOSED;
+    int error_ = 0;
+    bool write_blocked_ = false;
+    bool flush_posted_ = false;
+    bool read_event_posted_ = false;
+    // rest of a message which didn't fit the Recv() buffer
+    Buffer pending_recv_;
+    size_t pending_offset_ = 0;
+    Buffer recv_buffer_;
+
+    TaskQueueTimeoutFactory timeout_factory_;
+    TimerManager timer_manager_;
+    std::unique_ptr<Timer> timer_;
+    scoped_refptr<PendingTaskSafetyFlag> safety_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_KCP_KCP_SOCKET_H
@@ -0,0 +1,229 @@
+#include <sled/network/kcp/kcp.h>
+#include <sled/network/kcp/kcp_socket.h>
+#include <sled/network/physical_socket_server.h>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/testing/lossy_link.h>
+
+namespace {
+// sends `count` numbered messages over links with `loss_percent`, returns them in arrival order
+std::vector<uint32_t>
+Transfer(int count, uint32_t loss_percent, bool fast)
+{
+    uint32_t now = 0;
+    sled::LossyLink a_to_b(20, loss_percent, 1);
+    sled::LossyLink b_to_a(20, loss_percent, 2);
+    sled::KCP a(0x1234, [&](const uint8_t *data, size_t size) { a_to_b.Send(now, data, size); });
+    sled::KCP b(0x1234, [&](const uint8_t *data, size_t size) { b_to_a.Send(now, data, size); });
+    if (fast) {
+        a.SetNoDelay(1, 10, 2, true);
+        b.SetNoDelay(1, 10, 2, true);
+    }
+    a.SetWindowSize(128, 128);
+    b.SetWindowSize(128, 128);
+
+    std::vector<uint32_t> received;
+    std::string message(3000, 'x');// fragmented into 3 segments
+    for (uint32_t i = 0; i < static_cast<uint32_t>(count); ++i) {
+        std::memcpy(&message[0], &i, sizeof(i));
+        REQUIRE_EQ(a.Send(message.data(), message.size()), 0);
+    }
+    for (; now < 600000 && received.size() < static_cast<size_t>(count); now += 10) {
+        a.Update(now);
+        b.Update(now);
+        a_to_b.Deliver(now, &b);
+        b_to_a.Deliver(now, &a);
+        char buf[4096];
+        int size;
+        while ((size = b.Recv(buf, sizeof(buf))) > 0) {
+            CHECK_EQ(size, message.size());
+            uint32_t id;
+            std::memcpy(&id, buf, sizeof(id));
+            received.push_back(id);
+        }
+    }
+    return received;
+}
+// collects what a socket receives until there are `expected` bytes
+struct Reader : public sigslot::has_slots<> {
+    void OnReadEvent(sled::Socket *socket)
+    {
+        char buf[1024];
+        int size;
+        while ((size = socket->Recv(buf, sizeof(buf), nullptr)) > 0) { received->append(buf, size); }
+        if (received->size() >= expected) { done->Set(); }
+    }
+
+    std::string *received;
+    size_t expected;
+    sled::Event *done;
+};
+
+// takes a single Recv() of at most `chunk` bytes per event
+struct OneRecvReader : public sigslot::has_slots<> {
+    void OnReadEvent(sled::Socket *socket)
+    {
+        char buf[64];
+        const int size = socket->Recv(buf, std::min(chunk, sizeof(buf)), nullptr);
+        if (size > 0) { received->append(buf, size); }
+        if (received->size() >= expected) { done->Set(); }
+    }
+
+    std::string *received;
+    size_t expected;
+    size_t chunk;
+    sled::Event *done;
+};
+}// namespace
+
+TEST_SUITE("KCP")
+{
+    TEST_CASE("in order delivery over lossy links")
+    {
+        for (uint32_t loss : {0, 10, 30}) {
+            CAPTURE(loss);
+            std::vector<uint32_t> received = Transfer(200, loss, loss != 10);
+            REQUIRE_EQ(received.size(), 200);
+            for (uint32_t i = 0; i < received.size(); ++i) { CHECK_EQ(received[i], i); }
+        }
+    }
+
+    TEST_CASE("recv reports short buffers")
+    {
+        std::deque<std::string> wire;
+        sled::KCP a(1, [&](const uint8_t *data, size_t size) { wire.emplace_back((const char *) data, size); });
+        sled::KCP b(1, [](const uint8_t *, size_t) {});
+        a.Update(0);
+        b.Update(0);
+        CHECK_EQ(b.Recv(nullptr, 0), -1);
+        a.Send("hello world", 11);
+        a.Flush();
+        for (auto &packet : wire) { CHECK_EQ(b.Input(packet.data(), packet.size()), 0); }
+        CHECK_EQ(b.PeekSize(), 11);
+        char buf[16];
+        CHECK_EQ(b.Recv(buf, 4), -2);
+        CHECK_EQ(b.Recv(buf, sizeof(buf)), 11);
+        CHECK_EQ(std::string(buf, 11), "hello world");
+        CHECK_LT(b.Input("garbage", 7), 0);
+    }
+
+    TEST_CASE("socket over udp loopback")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        std::unique_ptr<sled::KcpSocket> client;
+        std::unique_ptr<sled::KcpSocket> server;
+        std::string received;
+        sled::Event done;
+
+        Reader reader;
+        const std::string payload(64 * 1024, 'k');
+        reader.received = &received;
+        reader.expected = payload.size();
+        reader.done = &done;
+
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            server.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 7));
+            client.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 7));
+            server->kcp()->SetNoDelay(1, 10, 2, true);
+            client->kcp()->SetNoDelay(1, 10, 2, true);
+            server->kcp()->SetStreamMode(true);
+            client->kcp()->SetStreamMode(true);
+            server->Bind(sled::SocketAddress("127.0.0.1", 0));
+            client->Bind(sled::SocketAddress("127.0.0.1", 0));
+            server->SignalReadEvent.connect(&reader, &Reader::OnReadEvent);
+            client->Connect(server->GetLocalAddress());
+            // 64 sends of 1KB fit in two windows of 32 segments
+            for (size_t offset = 0; offset < payload.size(); offset += 1024) {
+                CHECK_EQ(client->Send(payload.data() + offset, 1024), 1024);
+            }
+        });
+        CHECK(done.Wait(sled::TimeDelta::Seconds(10)));
+        thread->BlockingCall([&] {
+            CHECK_EQ(server->GetState(), sled::Socket::CS_CONNECTED);
+            CHECK_EQ(server->GetRemoteAddress().port(), client->GetLocalAddress().port());
+            client.reset();
+            server.reset();
+        });
+        CHECK(received == payload);
+    }
+
+    TEST_CASE("socket send takes part of a large buffer")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        std::unique_ptr<sled::KcpSocket> client;
+        std::unique_ptr<sled::KcpSocket> server;
+        std::string received;
+        sled::Event done;
+        Reader reader;
+        const std::string payload(1024 * 1024, 'k');
+        reader.received = &received;
+        reader.done = &done;
+
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            server.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 7));
+            client.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 7));
+            server->kcp()->SetNoDelay(1, 10, 2, true);
+            client->kcp()->SetNoDelay(1, 10, 2, true);
+            server->Bind(sled::SocketAddress("127.0.0.1", 0));
+            client->Bind(sled::SocketAddress("127.0.0.1", 0));
+            server->SignalReadEvent.connect(&reader, &Reader::OnReadEvent);
+            client->Connect(server->GetLocalAddress());
+            // message mode, more than kMaxFragments segments and two windows
+            const int sent = client->Send(payload.data(), payload.size());
+            CHECK_GT(sent, 0);
+            CHECK_LE(sent, 2 * client->kcp()->send_window() * client->kcp()->mss());
+            reader.expected = sent;
+            CHECK_EQ(client->Send(payload.data(), payload.size()), -1);
+            CHECK(client->IsBlocking());
+        });
+        CHECK(done.Wait(sled::TimeDelta::Seconds(10)));
+        thread->BlockingCall([&] {
+            client.reset();
+            server.reset();
+        });
+        CHECK_EQ(received.size(), reader.expected);
+    }
+
+    TEST_CASE("socket signals what one recv leaves behind")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        std::unique_ptr<sled::KcpSocket> client;
+        std::unique_ptr<sled::KcpSocket> server;
+        std::string received;
+        sled::Event done;
+        OneRecvReader reader;
+        reader.received = &received;
+        reader.done = &done;
+        // shorter than a message, so a part of each waits in the socket too
+        reader.chunk = 4;
+        std::string expected;
+        for (int i = 0; i < 5; ++i) { expected += "message-" + std::to_string(i); }
+        reader.expected = expected.size();
+
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            server.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 9));
+            client.reset(new sled::KcpSocket(thread.get(), ss->CreateSocket(AF_INET, SOCK_DGRAM), 9));
+            server->Bind(sled::SocketAddress("127.0.0.1", 0));
+            client->Bind(sled::SocketAddress("127.0.0.1", 0));
+            server->SignalReadEvent.connect(&reader, &OneRecvReader::OnReadEvent);
+            client->Connect(server->GetLocalAddress());
+            // one flush, the messages arrive together and raise a single event
+            for (int i = 0; i < 5; ++i) {
+                const std::string message = "message-" + std::to_string(i);
+                CHECK_EQ(client->Send(message.data(), message.size()), message.size());
+            }
+        });
+        CHECK(done.Wait(sled::TimeDelta::Seconds(5)));
+        thread->BlockingCall([&] {
+            client.reset();
+            server.reset();
+        });
+        CHECK_EQ(received, expected);
+    }
+}
@@ -0,0 +1,408 @@
+#include "sled/network/paced_socket.h"
+#include "sled/time_utils.h"
+#include <algorithm>
+#include <limits>
+
+namespace sled {
+
+namespace {
+constexpr size_t kMaxSlices = 64;
+
+// the first `max` bytes of `slices`, returns the number of slices in `out`
+size_t
+CapSlices(const BufferSlice *slices, size_t count, size_t max, BufferSlice *out, size_t *total)
+{
+    size_t n = 0;
+    *total = 0;
+    for (size_t i = 0; i < count && *total < max; ++i) {
+        out[n] = slices[i];
+        out[n].size = std::min(out[n].size, max - *total);
+        *total += out[n].size;
+        ++n;
+    }
+    return n;
+}
+}// namespace
+
+PacedSocket::PacedSocket(Socket *socket,
+                         TaskQueueBase *task_queue,
+                         std::vector<std::shared_ptr<TokenBucket>> limiters,
+                         size_t max_queued_bytes)
+    : socket_(socket),
+      task_queue_(task_queue),
+      limiters_(std::move(limiters)),
+      max_queued_bytes_(max_queued_bytes),
+      safety_(PendingTaskSafetyFlag::CreateDetached())
+{
+    socket_->SignalReadEvent.connect(this, &PacedSocket::OnReadEvent);
+    socket_->SignalWriteEvent.connect(this, &PacedSocket::OnWriteEvent);
+    socket_->SignalConnectEvent.connect(this, &PacedSocket::OnConnectEvent);
+    socket_->SignalCloseEvent.connect(this, &PacedSocket::OnCloseEvent);
+    socket_->SignalSendComplete.connect(this, &PacedSocket::OnSendComplete);
+}
+
+PacedSocket::~PacedSocket() { safety_->SetNotAlive(); }
+
+PacedSocket::Stats
+PacedSocket::GetPacingStats() const
+{
+    Stats stats = stats_;
+    stats.queued_bytes = queued_bytes();
+    return stats;
+}
+
+SocketAddress
+PacedSocket::GetLocalAddress() const
+{
+    return socket_->GetLocalAddress();
+}
+
+SocketAddress
+PacedSocket::GetRemoteAddress() const
+{
+    return socket_->GetRemoteAddress();
+}
+
+int
+PacedSocket::Bind(const SocketAddress &addr)
+{
+    return socket_->Bind(addr);
+}
+
+int
+PacedSocket::Connect(const SocketAddress &addr)
+{
+    return socket_->Connect(addr);
+}
+
+int
+PacedSocket::Send(const void *pv, size_t cb)
+{
+    const BufferSlice slice(pv, cb);
+    return SendV(&slice, 1);
+}
+
+int
+PacedSocket::SendTo(const void *pv, size_t cb, const SocketAddress &addr)
+{
+    if (queue_empty() && TimeUntilSendable().IsZero()) {
+        const int sent = socket_->SendTo(pv, cb, addr);
+        if (sent >= 0) {
+            Consume(sent);
+            return sent;
+        }
+        if (!socket_->IsBlocking()) { return sent; }
+    }
+
+    // a datagram is queued whole or not at all
+    if (Room(cb) < cb) {
+        blocked_ = true;
+        socket_->SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+    datagram_queue_.push_back(QueuedDatagram{Buffer(static_cast<const uint8_t *>(pv), cb), addr});
+    datagram_queue_bytes_ += cb;
+    Defer(cb);
+    ScheduleDrain(TimeUntilSendable());
+    return static_cast<int>(cb);
+}
+
+int
+PacedSocket::SendV(const BufferSlice *slices, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) { total += slices[i].size; }
+
+    size_t sent = 0;
+    bool kernel_full = false;
+    if (queue_empty() && TimeUntilSendable().IsZero()) {
+        BufferSlice capped[kMaxSlices];
+        size_t chunk;
+        const size_t n = CapSlices(slices, std::min(count, kMaxSlices), MaxChunk(), capped, &chunk);
+        const int result = socket_->SendV(capped, n);
+        if (result < 0 && !socket_->IsBlocking()) { return result; }
+        if (result > 0) {
+            sent = result;
+            Consume(sent);
+        }
+        if (sent == total) { return static_cast<int>(sent); }
+        kernel_full = sent < chunk;
+    }
+
+    // the rest is queued as far as there is room
+    const size_t queued = Room(total - sent);
+    if (queued == 0) { return sent > 0 ? static_cast<int>(sent) : SOCKET_ERROR; }
+    size_t skip = sent;
+    size_t left = queued;
+    for (size_t i = 0; i < count && left > 0; ++i) {
+        if (skip >= slices[i].size) {
+            skip -= slices[i].size;
+            continue;
+        }
+        const size_t len = std::min(slices[i].size - skip, left);
+        stream_queue_.Append(slices[i].data + skip, len);
+        skip = 0;
+        left -= len;
+    }
+    Defer(queued);
+    // a full kernel buffer is waited for with SignalWriteEvent
+    if (!kernel_full) { ScheduleDrain(TimeUntilSendable()); }
+    return static_cast<int>(sent + queued);
+}
+
+int
+PacedSocket::Recv(void *pv, size_t cb, int64_t *timestamp)
+{
+    return socket_->Recv(pv, cb, timestamp);
+}
+
+int
+PacedSocket::RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp)
+{
+    return socket_->RecvFrom(pv, cb, paddr, timestamp);
+}
+
+int
+PacedSocket::RecvV(const MutableBufferSlice *slices, size_t count)
+{
+    return socket_->RecvV(slices, count);
+}
+
+int
+PacedSocket::RecvFromBatch(Datagram *datagrams, size_t count)
+{
+    return socket_->RecvFromBatch(datagrams, count);
+}
+
+int
+PacedSocket::RecvWithFds(void *pv, size_t cb, int *fds, size_t *fd_count)
+{
+    return socket_->RecvWithFds(pv, cb, fds, fd_count);
+}
+
+int
+PacedSocket::GetStats(SocketStats *stats)
+{
+    return socket_->GetStats(stats);
+}
+
+int
+PacedSocket::Listen(int backlog)
+{
+    return socket_->Listen(backlog);
+}
+
+Socket *
+PacedSocket::Accept(SocketAddress *paddr)
+{
+    return socket_->Accept(paddr);
+}
+
+int
+PacedSocket::Close()
+{
+    stream_queue_.Clear();
+    datagram_queue_.clear();
+    datagram_queue_bytes_ = 0;
+    blocked_ = false;
+    return socket_->Close();
+}
+
+int
+PacedSocket::GetError() const
+{
+    return socket_->GetError();
+}
+
+void
+PacedSocket::SetError(int error)
+{
+    socket_->SetError(error);
+}
+
+Socket::ConnState
+PacedSocket::GetState() const
+{
+    return socket_->GetState();
+}
+
+int
+PacedSocket::GetOption(Option opt, int *value)
+{
+    return socket_->GetOption(opt, value);
+}
+
+int
+PacedSocket::SetOption(Option opt, int value)
+{
+    return socket_->SetOption(opt, value);
+}
+
+size_t
+PacedSocket::queued_bytes() const
+{
+    return stream_queue_.size() + datagram_queue_bytes_;
+}
+
+bool
+PacedSocket::queue_empty() const
+{
+    return stream_queue_.empty() && datagram_queue_.empty();
+}
+
+TimeDelta
+PacedSocket::TimeUntilSendable() const
+{
+    const int64_t now_us = TimeMicros();
+    TimeDelta wait = TimeDelta::Zero();
+    for (const auto &limiter : limiters_) { wait = std::max(wait, limiter->TimeUntilAvailable(now_us)); }
+    return wait;
+}
+
+size_t
+PacedSocket::MaxChunk() const
+{
+    size_t chunk = std::numeric_limits<size_t>::max();
+    for (const auto &limiter : limiters_) {
+        if (limiter->burst_bytes() > 0) { chunk = std::min(chunk, static_cast<size_t>(limiter->burst_bytes())); }
+    }
+    return chunk;
+}
+
+void
+PacedSocket::Consume(size_t bytes)
+{
+    const int64_t now_us = TimeMicros();
+    for (const auto &limiter : limiters_) { limiter->Consume(bytes, 1, now_us); }
+}
+
+size_t
+PacedSocket::Room(size_t cb)
+{
+    const size_t queued = queued_bytes();
+    const size_t room = max_queued_bytes_ > queued ? max_queued_bytes_ - queued : 0;
+    if (room == 0) {
+        blocked_ = true;
+        socket_->SetError(EWOULDBLOCK);
+    }
+    return std::min(cb, room);
+}
+
+void
+PacedSocket::Defer(size_t bytes)
+{
+    stats_.deferred_bytes += bytes;
+    ++stats_.deferred_packets;
+}
+
+void
+PacedSocket::ScheduleDrain(TimeDelta delay)
+{
+    if (drain_scheduled_) { return; }
+    drain_scheduled_ = true;
+    task_queue_->PostDelayedHighPrecisionTask(SafeTask(safety_,
+                                                       [this] {
+                                                           drain_scheduled_ = false;
+                                                           Drain();
+                                                           MaybeSignalWritable();
+                                                       }),
+                                              delay);
+}
+
+void
+PacedSocket::Drain()
+{
+    if (DrainDatagrams()) { DrainStream(); }
+}
+
+void
+PacedSocket::MaybeSignalWritable()
+{
+    if (!blocked_ || queued_bytes() >= max_queued_bytes_) { return; }
+    blocked_ = false;
+    SignalWriteEvent(this);
+}
+
+bool
+PacedSocket::DrainDatagrams()
+{
+    while (!datagram_queue_.empty()) {
+        const TimeDelta wait = TimeUntilSendable();
+        if (!wait.IsZero()) {
+            ScheduleDrain(wait);
+            return false;
+        }
+        const QueuedDatagram &datagram = datagram_queue_.front();
+        const int sent = socket_->SendTo(datagram.data.data(), datagram.data.size(), datagram.addr);
+        // blocked until SignalWriteEvent, other errors drop the datagram as the kernel would
+        if (sent < 0 && socket_->IsBlocking()) { return false; }
+        if (sent >= 0) { Consume(sent); }
+        datagram_queue_bytes_ -= datagram.data.size();
+        datagram_queue_.pop_front();
+    }
+    return true;
+}
+
+bool
+PacedSocket::DrainStream()
+{
+    while (!stream_queue_.empty()) {
+        const TimeDelta wait = TimeUntilSendable();
+        if (!wait.IsZero()) {
+            ScheduleDrain(wait);
+            return false;
+        }
+        BufferSlice slices[kMaxSlices];
+        BufferSlice capped[kMaxSlices];
+        size_t chunk;
+        const size_t n = CapSlices(slices, stream_queue_.GetSlices(slices, kMaxSlices), MaxChunk(), capped, &chunk);
+        const int sent = socket_->SendV(capped, n);
+        if (sent < 0) {
+            // the stream is broken, SignalCloseEvent follows
+            if (!socket_->IsBlocking()) { stream_queue_.Clear(); }
+            return false;
+        }
+        Consume(sent);
+        stream_queue_.Consume(sent);
+        if (static_cast<size_t>(sent) < chunk) { return false; }
+    }
+    return true;
+}
+
+void
+PacedSocket::OnReadEvent(Socket *)
+{
+    SignalReadEvent(this);
+}
+
+void
+PacedSocket::OnWriteEvent(Socket *)
+{
+    Drain();
+    if (queue_empty()) {
+        blocked_ = false;
+        SignalWriteEvent(this);
+    } else {
+        MaybeSignalWritable();
+    }
+}
+
+void
+PacedSocket::OnConnectEvent(Socket *)
+{
+    SignalConnectEvent(this);
+}
+
+void
+PacedSocket::OnCloseEvent(Socket *, int error)
+{
+    SignalCloseEvent(this, error);
+}
+
+void
+PacedSocket::OnSendComplete(Socket *, int64_t send_id)
+{
+    SignalSendComplete(this, send_id);
+}
+
+}// namespace sled
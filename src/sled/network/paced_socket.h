@@ -0,0 +1,126 @@
+/**
+ * @file     : paced_socket
+ * @created  : Sunday Oct 18, 2026 11:20:15 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_PACED_SOCKET_H
+#define SLED_NETWORK_PACED_SOCKET_H
+#pragma once
+
+#include "sled/network/socket.h"
+#include "sled/network/token_bucket.h"
+#include "sled/task_queue/pending_task_safety_flag.h"
+#include "sled/task_queue/task_queue_base.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace sled {
+
+/**
+ * Wraps a socket and spreads what is sent on it over time, so a burst from
+ * one connection doesn't fill the NIC queues everyone shares.
+ *
+ * Every send has to get past all `limiters`: one of its own and, say, one
+ * shared by all sockets of a tenant. What may not go out yet, or what the
+ * kernel doesn't take, is queued and sent from a high precision delayed
+ * task or when the socket becomes writable again. Send() and SendTo() only
+ * fail with EWOULDBLOCK once max_queued_bytes are queued; SignalWriteEvent
+ * follows when there is room again.
+ *
+ * Send() and SendV() queue a byte stream, SendTo() whole datagrams, so use
+ * SendTo() on datagram sockets. Everything else is passed through. Use and
+ * destroy it on `task_queue`, the thread which runs the socket's server.
+ * Close() drops what is still queued.
+ **/
+class PacedSocket final : public Socket, public sigslot::has_slots<> {
+public:
+    static constexpr size_t kDefaultMaxQueuedBytes = 1024 * 1024;
+
+    struct Stats {
+        // bytes and sends which were queued instead of going straight to the kernel
+        int64_t deferred_bytes = 0;
+        int64_t deferred_packets = 0;
+        // bytes waiting right now
+        size_t queued_bytes = 0;
+    };
+
+    // takes ownership of `socket`
+    PacedSocket(Socket *socket,
+                TaskQueueBase *task_queue,
+                std::vector<std::shared_ptr<TokenBucket>> limiters,
+                size_t max_queued_bytes = kDefaultMaxQueuedBytes);
+    ~PacedSocket() override;
+
+    Stats GetPacingStats() const;
+
+    SocketAddress GetLocalAddress() const override;
+    SocketAddress GetRemoteAddress() const override;
+    int Bind(const SocketAddress &addr) override;
+    int Connect(const SocketAddress &addr) override;
+    int Send(const void *pv, size_t cb) override;
+    int SendTo(const void *pv, size_t cb, const SocketAddress &addr) override;
+    int SendV(const BufferSlice *slices, size_t count) override;
+    using Socket::SendV;
+    int Recv(void *pv, size_t cb, int64_t *timestamp) override;
+    int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) override;
+    int RecvV(const MutableBufferSlice *slices, size_t count) override;
+    int RecvFromBatch(Datagram *datagrams, size_t count) override;
+    int RecvWithFds(void *pv, size_t cb, int *fds, size_t *fd_count) override;
+    int GetStats(SocketStats *stats) override;
+    int Listen(int backlog) override;
+    Socket *Accept(SocketAddress *paddr) override;
+    int Close() override;
+    int GetError() const override;
+    void SetError(int error) override;
+    ConnState GetState() const override;
+    int GetOption(Option opt, int *value) override;
+    int SetOption(Option opt, int value) override;
+
+private:
+    struct QueuedDatagram {
+        Buffer data;
+        SocketAddress addr;
+    };
+
+    size_t queued_bytes() const;
+    bool queue_empty() const;
+    // zero if all limiters let a send start now
+    TimeDelta TimeUntilSendable() const;
+    // the most one write to the kernel should carry
+    size_t MaxChunk() const;
+    void Consume(size_t bytes);
+    // the part of `cb` there is room for in the queue, sets EWOULDBLOCK if none
+    size_t Room(size_t cb);
+    void Defer(size_t bytes);
+    void ScheduleDrain(TimeDelta delay);
+    void Drain();
+    void MaybeSignalWritable();
+    bool DrainDatagrams();
+    bool DrainStream();
+
+    void OnReadEvent(Socket *socket);
+    void OnWriteEvent(Socket *socket);
+    void OnConnectEvent(Socket *socket);
+    void OnCloseEvent(Socket *socket, int error);
+    void OnSendComplete(Socket *socket, int64_t send_id);
+
+    const std::unique_ptr<Socket> socket_;
+    TaskQueueBase *const task_queue_;
+    const std::vector<std::shared_ptr<TokenBucket>> limiters_;
+    const size_t max_queued_bytes_;
+    scoped_refptr<PendingTaskSafetyFlag> safety_;
+
+    BufferChain stream_queue_;
+    std::deque<QueuedDatagram> datagram_queue_;
+    size_t datagram_queue_bytes_ = 0;
+    bool drain_scheduled_ = false;
+    // a send failed for lack of room, SignalWriteEvent is owed
+    bool blocked_ = false;
+    Stats stats_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_PACED_SOCKET_H
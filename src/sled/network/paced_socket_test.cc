@@ -0,0 +1,182 @@
+#include <sled/network/paced_socket.h>
+#include <sled/network/socket_server.h>
+#include <sled/system/thread.h>
+#include <sled/time_utils.h>
+
+namespace {
+std::shared_ptr<sled::TokenBucket>
+Limiter(int64_t bytes_per_second, int64_t packets_per_second)
+{
+    sled::TokenBucket::Config config;
+    config.bytes_per_second = bytes_per_second;
+    config.packets_per_second = packets_per_second;
+    return std::make_shared<sled::TokenBucket>(config);
+}
+
+// polls `pred` on `thread` until it holds or two seconds passed
+template<typename Predicate>
+bool
+WaitOn(sled::Thread *thread, Predicate &&pred)
+{
+    const int64_t deadline_ms = sled::TimeMillis() + 2000;
+    while (!thread->BlockingCall([&] { return pred(); })) {
+        if (sled::TimeMillis() > deadline_ms) { return false; }
+        sled::Thread::SleepMs(1);
+    }
+    return true;
+}
+
+struct WriteEvents : public sigslot::has_slots<> {
+    void OnWriteEvent(sled::Socket *) { ++count; }
+
+    int count = 0;
+};
+}// namespace
+
+TEST_SUITE("PacedSocket")
+{
+    TEST_CASE("token bucket")
+    {
+        sled::TokenBucket::Config config;
+        config.bytes_per_second = 1000;
+        config.burst_bytes = 100;
+        config.packets_per_second = 10;
+        config.burst_packets = 2;
+        sled::TokenBucket bucket(config);
+        CHECK_EQ(bucket.burst_bytes(), 100);
+        CHECK(bucket.TimeUntilAvailable(0).IsZero());
+
+        // goes into debt, 200 bytes at 1000 bytes/s
+        bucket.Consume(300, 1, 0);
+        CHECK_EQ(bucket.TimeUntilAvailable(0).ms(), 201);
+        CHECK_EQ(bucket.TimeUntilAvailable(100 * 1000).ms(), 101);
+        CHECK(bucket.TimeUntilAvailable(201 * 1000).IsZero());
+
+        // refills no further than the burst, the packet limit applies on its own
+        bucket.Consume(0, 2, 10 * 1000 * 1000);
+        CHECK_EQ(bucket.TimeUntilAvailable(10 * 1000 * 1000).ms(), 100);
+
+        CHECK_EQ(sled::TokenBucket(sled::TokenBucket::Config()).burst_bytes(), 0);
+        CHECK(sled::TokenBucket(sled::TokenBucket::Config()).TimeUntilAvailable(0).IsZero());
+    }
+
+    TEST_CASE("datagrams share a limiter")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        // 100 datagrams/s for both senders together
+        auto shared = Limiter(0, 100);
+        std::unique_ptr<sled::Socket> receiver;
+        std::unique_ptr<sled::PacedSocket> a;
+        std::unique_ptr<sled::PacedSocket> b;
+        const int64_t start_ms = sled::TimeMillis();
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            receiver.reset(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+            receiver->Bind(sled::SocketAddress("127.0.0.1", 0));
+            a.reset(new sled::PacedSocket(ss->CreateSocket(AF_INET, SOCK_DGRAM), thread.get(), {shared}));
+            b.reset(new sled::PacedSocket(ss->CreateSocket(AF_INET, SOCK_DGRAM), thread.get(), {shared}));
+            for (int i = 0; i < 10; ++i) {
+                CHECK_EQ(a->SendTo("a", 1, receiver->GetLocalAddress()), 1);
+                CHECK_EQ(b->SendTo("b", 1, receiver->GetLocalAddress()), 1);
+            }
+            CHECK_EQ(a->GetPacingStats().queued_bytes + b->GetPacingStats().queued_bytes, 19);
+        });
+
+        int received = 0;
+        CHECK(WaitOn(thread.get(), [&] {
+            char buf[8];
+            while (receiver->Recv(buf, sizeof(buf), nullptr) > 0) { ++received; }
+            return received == 20;
+        }));
+        // the first one went out right away
+        CHECK_GE(sled::TimeMillis() - start_ms, 180);
+        thread->BlockingCall([&] {
+            CHECK_EQ(a->GetPacingStats().deferred_packets + b->GetPacingStats().deferred_packets, 19);
+            CHECK_EQ(a->GetPacingStats().queued_bytes, 0);
+            receiver.reset();
+            a.reset();
+            b.reset();
+        });
+        thread->Stop();
+    }
+
+    TEST_CASE("stream")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        std::unique_ptr<sled::Socket> listener;
+        std::unique_ptr<sled::Socket> accepted;
+        std::unique_ptr<sled::PacedSocket> client;
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            listener.reset(ss->CreateSocket(AF_INET, SOCK_STREAM));
+            listener->Bind(sled::SocketAddress("127.0.0.1", 0));
+            listener->Listen(1);
+            client.reset(new sled::PacedSocket(ss->CreateSocket(AF_INET, SOCK_STREAM), thread.get(),
+                                               {Limiter(320 * 1000, 0)}));
+            client->Connect(listener->GetLocalAddress());
+        });
+        REQUIRE(WaitOn(thread.get(), [&] {
+            if (!accepted) { accepted.reset(listener->Accept(nullptr)); }
+            return accepted && client->GetState() == sled::Socket::CS_CONNECTED;
+        }));
+
+        // 64KB at 320KB/s
+        std::string payload(64 * 1024, 0);
+        for (size_t i = 0; i < payload.size(); ++i) { payload[i] = static_cast<char>(i * 7); }
+        const int64_t start_ms = sled::TimeMillis();
+        thread->BlockingCall([&] {
+            CHECK_EQ(client->Send(payload.data(), payload.size()), static_cast<int>(payload.size()));
+            CHECK_GT(client->GetPacingStats().deferred_bytes, 0);
+        });
+        std::string received;
+        CHECK(WaitOn(thread.get(), [&] {
+            char buf[4096];
+            int n;
+            while ((n = accepted->Recv(buf, sizeof(buf), nullptr)) > 0) { received.append(buf, n); }
+            return received.size() == payload.size();
+        }));
+        CHECK(received == payload);
+        CHECK_GE(sled::TimeMillis() - start_ms, 150);
+        thread->BlockingCall([&] {
+            listener.reset();
+            accepted.reset();
+            client.reset();
+        });
+        thread->Stop();
+    }
+
+    TEST_CASE("queue limit")
+    {
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+        std::unique_ptr<sled::Socket> receiver;
+        std::unique_ptr<sled::PacedSocket> sender;
+        WriteEvents events;
+        thread->BlockingCall([&] {
+            sled::SocketServer *ss = thread->socketserver();
+            receiver.reset(ss->CreateSocket(AF_INET, SOCK_DGRAM));
+            receiver->Bind(sled::SocketAddress("127.0.0.1", 0));
+            // one datagram every 10ms, at most 250 bytes queued
+            sender.reset(new sled::PacedSocket(ss->CreateSocket(AF_INET, SOCK_DGRAM), thread.get(),
+                                               {Limiter(0, 100)}, 250));
+            sender->SignalWriteEvent.connect(&events, &WriteEvents::OnWriteEvent);
+            const std::string datagram(100, 'x');
+            const sled::SocketAddress to = receiver->GetLocalAddress();
+            CHECK_EQ(sender->SendTo(datagram.data(), datagram.size(), to), 100);
+            CHECK_EQ(sender->SendTo(datagram.data(), datagram.size(), to), 100);
+            CHECK_EQ(sender->SendTo(datagram.data(), datagram.size(), to), 100);
+            CHECK_LT(sender->SendTo(datagram.data(), datagram.size(), to), 0);
+            CHECK(sender->IsBlocking());
+            CHECK_EQ(sender->GetPacingStats().queued_bytes, 200);
+        });
+        CHECK(WaitOn(thread.get(), [&] { return events.count > 0 && sender->GetPacingStats().queued_bytes == 0; }));
+        thread->BlockingCall([&] {
+            CHECK_EQ(sender->SendTo("x", 1, receiver->GetLocalAddress()), 1);
+            receiver.reset();
+            sender.reset();
+        });
+        thread->Stop();
+    }
+}
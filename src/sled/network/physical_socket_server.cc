@@ -6,14 +6,28 @@
 #include "sled/synchronization/mutex.h"
 #include "sled/time_utils.h"
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <pthread.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#endif
 #include <unistd.h>
 
 namespace {
+// per SendV()/RecvV() call, the caller loops for the rest
+constexpr size_t kMaxIovecs = 64;
+
 class ScopedSetTrue {
 public:
     ScopedSetTrue(bool *value) : value_(value) { *value_ = true; }
@@ -32,9 +46,18 @@ public:
         : ss_(ss),
           afd_([] {
               std::array<int, 2> afd = {INVALID_SOCKET, INVALID_SOCKET};
+#if defined(__linux__)
+              // a single eventfd is both ends, one counter instead of a pipe buffer
+              afd[0] = afd[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+              if (afd[0] < 0) {
+                  LOGE("Signaler", "eventfd failed: {}", strerror(errno));
+              }
+#else
               if (pipe(afd.data()) < 0) {
-                  // TODO: add log here
+                  LOGE("Signaler", "pipe failed: {}", strerror(errno));
               }
+              fcntl(afd[0], F_SETFL, fcntl(afd[0], F_GETFL, 0) | O_NONBLOCK);
+#endif
               return afd;
           }()),
           fSignaled_(false),
@@ -47,29 +70,41 @@ public:
     {
         ss_->Remove(this);
         close(afd_[0]);
-        close(afd_[1]);
+        if (afd_[1] != afd_[0]) { close(afd_[1]); }
     }
 
     virtual void Signal()
     {
-        MutexLock lock(&mutex_);
-        if (!fSignaled_) {
-            const uint8_t b[1] = {0};
-            const ssize_t res = write(afd_[1], b, sizeof(b));
-            fSignaled_ = true;
-        }
+        // only the first Signal() after OnEvent() pays for the syscall
+        if (fSignaled_.exchange(true, std::memory_order_acq_rel)) { return; }
+#if defined(__linux__)
+        const uint64_t value = 1;
+        const ssize_t res = write(afd_[1], &value, sizeof(value));
+#else
+        const uint8_t b[1] = {0};
+        const ssize_t res = write(afd_[1], b, sizeof(b));
+#endif
+        (void) res;
     }
 
     uint32_t GetRequestedEvents() override { return DE_READ; }
 
     void OnEvent(uint32_t ff, int err) override
     {
-        MutexLock lock(&mutex_);
-        if (fSignaled_) {
-            uint8_t b[4];
-            const ssize_t res = read(afd_[0], b, sizeof(b));
-            fSignaled_ = false;
-        }
+#if defined(__linux__)
+        uint64_t value;
+        const ssize_t res = read(afd_[0], &value, sizeof(value));
+#else
+        uint8_t b[4];
+        ssize_t res;
+        do {
+            res = read(afd_[0], b, sizeof(b));
+        } while (res == sizeof(b));
+#endif
+        (void) res;
+        // drain before clearing: a Signal() that sees the flag still set is
+        // answered by this wakeup, one that sees it cleared writes again
+        fSignaled_.store(false, std::memory_order_release);
         flag_to_clear_ = false;
     }
 
@@ -80,14 +115,41 @@ public:
 private:
     PhysicalSocketServer *const ss_;
     const std::array<int, 2> afd_;
-    bool fSignaled_;
-    Mutex mutex_;
+    std::atomic<bool> fSignaled_;
     bool &flag_to_clear_;
 };
 
-PhysicalSocketServer::PhysicalSocketServer() : fWait_(false) { signal_wakeup_ = new Signaler(this, fWait_); }
+PhysicalSocketServer::PhysicalSocketServer()
+    :
+#if defined(SLED_USE_EPOLL)
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+#endif
+      fWait_(false)
+{
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ == INVALID_SOCKET) {
+        LOGW("PhysicalSocketServer", "epoll_create1 failed: {}, fallback to select", strerror(errno));
+    }
+#endif
+    signal_wakeup_ = new Signaler(this, fWait_);
+}
 
-PhysicalSocketServer::~PhysicalSocketServer() { delete signal_wakeup_; }
+PhysicalSocketServer::~PhysicalSocketServer()
+{
+    delete signal_wakeup_;
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ != INVALID_SOCKET) { close(epoll_fd_); }
+#endif
+}
+
+PhysicalSocketServer::Backend
+PhysicalSocketServer::backend() const
+{
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ != INVALID_SOCKET) { return Backend::kEpoll; }
+#endif
+    return Backend::kSelect;
+}
 
 void
 PhysicalSocketServer::WakeUp()
@@ -128,6 +190,9 @@ PhysicalSocketServer::Add(Dispatcher *pdispatcher)
     uint64_t key = next_dispatcher_key_++;
     dispatcher_by_key_.emplace(key, pdispatcher);
     key_by_dispatcher_.emplace(pdispatcher, key);
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ != INVALID_SOCKET) { AddEpoll(pdispatcher, key); }
+#endif
 }
 
 void
@@ -139,17 +204,22 @@ PhysicalSocketServer::Remove(Dispatcher *pdispatcher)
     uint64_t key = key_by_dispatcher_.at(pdispatcher);
     key_by_dispatcher_.erase(pdispatcher);
     dispatcher_by_key_.erase(key);
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ != INVALID_SOCKET) { RemoveEpoll(pdispatcher); }
+#endif
 }
 
 void
 PhysicalSocketServer::Update(Dispatcher *pdispatcher)
 {
-    return;
-    /*
-    MutexLock lock(&lock_);
-    if (!key_by_dispatcher_.count(pdispatcher)) { return; }
-    UpdateEpoll();
-    */
+#if defined(SLED_USE_EPOLL)
+    if (epoll_fd_ == INVALID_SOCKET) { return; }
+
+    RecursiveMutexLock lock(&lock_);
+    auto iter = key_by_dispatcher_.find(pdispatcher);
+    if (iter == key_by_dispatcher_.end()) { return; }
+    UpdateEpoll(pdispatcher, iter->second);
+#endif
 }
 
 int
@@ -165,9 +235,21 @@ PhysicalSocketServer::Wait(TimeDelta max_wait_duration, bool process_io)
     ScopedSetTrue s(&waiting_);
     const int64_t cusWait = ToCusWait(max_wait_duration);
 
+#if defined(SLED_USE_EPOLL)
+    // without process_io only the wakeup signaler is watched, select is enough
+    if (epoll_fd_ != INVALID_SOCKET && process_io) { return WaitEpoll(cusWait); }
+#endif
     return WaitSelect(cusWait, process_io);
 }
 
+bool
+PhysicalSocketServer::PollDispatchers()
+{
+    // signal_wakeup_ clears fWait_ when it fires
+    PhysicalSocketServer::Wait(TimeDelta::Zero(), true);
+    return fWait_;
+}
+
 static void
 ProcessEvents(Dispatcher *pdispatcher, bool readable, bool writable, bool error_event, bool check_error)
 {
@@ -188,6 +270,9 @@ ProcessEvents(Dispatcher *pdispatcher, bool readable, bool writable, bool error_
             ff |= DE_CLOSE;
         } else if (requested_events & DE_ACCEPT) {
             ff |= DE_ACCEPT;
+        } else if ((requested_events & (DE_READ | DE_ERRQUEUE)) == DE_ERRQUEUE) {
+            // select() reports a non-empty error queue as readable
+            ff |= DE_ERRQUEUE;
         } else {
             ff |= DE_READ;
         }
@@ -201,7 +286,11 @@ ProcessEvents(Dispatcher *pdispatcher, bool readable, bool writable, bool error_
         }
     }
 
-    if (errcode) { ff |= DE_CLOSE; }
+    if (errcode) {
+        ff |= DE_CLOSE;
+    } else if (error_event && (requested_events & DE_ERRQUEUE)) {
+        ff |= DE_ERRQUEUE;
+    }
 
     if (ff != 0) { pdispatcher->OnEvent(ff, errcode); }
 }
@@ -234,12 +323,17 @@ PhysicalSocketServer::WaitSelect(int64_t cusWait, bool process_io)
                 uint64_t key = kv.first;
                 Dispatcher *pdispatcher = kv.second;
                 if (!process_io && (pdispatcher != signal_wakeup_)) { continue; }
-                current_dispatcher_keys_.push_back(key);
                 int fd = pdispatcher->GetDescriptor();
+                // FD_SET on a descriptor beyond FD_SETSIZE is undefined behavior
+                if (fd < 0 || fd >= FD_SETSIZE) {
+                    LOGW_EVERY_N(100, "PhysicalSocketServer", "select() can not watch fd={}", fd);
+                    continue;
+                }
+                current_dispatcher_keys_.push_back(key);
                 if (fd > fdmax) { fdmax = fd; }
 
                 uint32_t ff = pdispatcher->GetRequestedEvents();
-                if (ff & (DE_READ | DE_ACCEPT)) { FD_SET(fd, &fdsRead); }
+                if (ff & (DE_READ | DE_ACCEPT | DE_ERRQUEUE)) { FD_SET(fd, &fdsRead); }
 
                 if (ff & (DE_WRITE | DE_CONNECT)) { FD_SET(fd, &fdsWrite); }
             }
@@ -259,6 +353,7 @@ PhysicalSocketServer::WaitSelect(int64_t cusWait, bool process_io)
 
                 Dispatcher *pdispatcher = dispatcher_by_key_.at(key);
                 int fd = pdispatcher->GetDescriptor();
+                if (fd < 0 || fd >= FD_SETSIZE) { continue; }
 
                 bool readable = FD_ISSET(fd, &fdsRead);
                 if (readable) { FD_CLR(fd, &fdsRead); }
@@ -285,6 +380,118 @@ PhysicalSocketServer::WaitSelect(int64_t cusWait, bool process_io)
     return true;
 }
 
+#if defined(SLED_USE_EPOLL)
+static uint32_t
+GetEpollEvents(uint32_t ff)
+{
+    uint32_t events = 0;
+    if (ff & (DE_READ | DE_ACCEPT)) { events |= EPOLLIN; }
+    if (ff & (DE_WRITE | DE_CONNECT)) { events |= EPOLLOUT; }
+    // always reported, but keeps the descriptor registered while nothing else is
+    if (ff & DE_ERRQUEUE) { events |= EPOLLERR; }
+    return events;
+}
+
+void
+PhysicalSocketServer::AddEpoll(Dispatcher *pdispatcher, uint64_t key)
+{
+    int fd = pdispatcher->GetDescriptor();
+    if (fd == INVALID_SOCKET) { return; }
+
+    // a dispatcher without interest is registered lazily by UpdateEpoll(),
+    // otherwise EPOLLHUP/EPOLLERR would be reported for it over and over
+    uint32_t events = GetEpollEvents(pdispatcher->GetRequestedEvents());
+    if (events == 0) { return; }
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.u64 = key;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+        LOGE("PhysicalSocketServer", "epoll_ctl EPOLL_CTL_ADD fd={} failed: {}", fd, strerror(errno));
+    }
+}
+
+void
+PhysicalSocketServer::RemoveEpoll(Dispatcher *pdispatcher)
+{
+    int fd = pdispatcher->GetDescriptor();
+    if (fd == INVALID_SOCKET) { return; }
+
+    struct epoll_event event = {};
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &event) == -1 && errno != ENOENT && errno != EBADF) {
+        LOGE("PhysicalSocketServer", "epoll_ctl EPOLL_CTL_DEL fd={} failed: {}", fd, strerror(errno));
+    }
+}
+
+void
+PhysicalSocketServer::UpdateEpoll(Dispatcher *pdispatcher, uint64_t key)
+{
+    int fd = pdispatcher->GetDescriptor();
+    if (fd == INVALID_SOCKET) { return; }
+
+    uint32_t events = GetEpollEvents(pdispatcher->GetRequestedEvents());
+    if (events == 0) {
+        RemoveEpoll(pdispatcher);
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.u64 = key;
+    int err = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+    if (err == -1 && errno == ENOENT) { err = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event); }
+    if (err == -1) {
+        LOGE("PhysicalSocketServer", "epoll_ctl EPOLL_CTL_MOD fd={} failed: {}", fd, strerror(errno));
+    }
+}
+
+bool
+PhysicalSocketServer::WaitEpoll(int64_t cusWait)
+{
+    int64_t msWait = kForeverMs;
+    int64_t stop_us = 0;
+    if (cusWait != kForeverMs) {
+        // round up, epoll_wait() only supports millisecond resolution
+        msWait = (cusWait + kNumMicrosecsPerMillisec - 1) / kNumMicrosecsPerMillisec;
+        stop_us = TimeMicros() + cusWait;
+    }
+
+    fWait_ = true;
+    while (fWait_) {
+        int n = epoll_wait(epoll_fd_, epoll_events_.data(), static_cast<int>(epoll_events_.size()),
+                           static_cast<int>(msWait));
+        if (n < 0) {
+            if (errno != EINTR) {
+                LOGE("PhysicalSocketServer", "epoll_wait failed: {}", strerror(errno));
+                return false;
+            }
+        } else if (n == 0) {
+            return true;
+        } else {
+            RecursiveMutexLock lock(&lock_);
+            for (int i = 0; i < n; ++i) {
+                const epoll_event &event = epoll_events_[i];
+                // skip if the dispatcher is removed
+                auto iter = dispatcher_by_key_.find(event.data.u64);
+                if (iter == dispatcher_by_key_.end()) { continue; }
+
+                bool readable = (event.events & (EPOLLIN | EPOLLPRI));
+                bool writable = (event.events & EPOLLOUT);
+                bool error = (event.events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP));
+                ProcessEvents(iter->second, readable, writable, error, error);
+            }
+        }
+
+        if (cusWait != kForeverMs) {
+            int64_t time_left_us = stop_us - TimeMicros();
+            if (time_left_us <= 0) { break; }
+            msWait = (time_left_us + kNumMicrosecsPerMillisec - 1) / kNumMicrosecsPerMillisec;
+        }
+    }
+    return true;
+}
+#endif
+
 PhysicalSocket::PhysicalSocket(PhysicalSocketServer *ss, SOCKET s)
     : ss_(ss),
       s_(s),
@@ -298,6 +505,11 @@ PhysicalSocket::PhysicalSocket(PhysicalSocketServer *ss, SOCKET s)
         socklen_t len = sizeof(type);
         const int res = getsockopt(s_, SOL_SOCKET, SO_TYPE, (void *) &type, &len);
         udp_ = (SOCK_DGRAM == type);
+#if defined(SO_DOMAIN)
+        len = sizeof(family_);
+        getsockopt(s_, SOL_SOCKET, SO_DOMAIN, (void *) &family_, &len);
+#endif
+        EnableTimestamps();
     }
 }
 
@@ -312,6 +524,7 @@ PhysicalSocket::Create(int family, int type)
     udp_ = (SOCK_DGRAM == type);
     family_ = family;
     UpdateLastError();
+    if (s_ != INVALID_SOCKET) { EnableTimestamps(); }
     if (udp_) { SetEnabledEvents(DE_READ | DE_WRITE); }
     return s_ != INVALID_SOCKET;
 }
@@ -325,7 +538,9 @@ PhysicalSocket::GetLocalAddress() const
     int result = ::getsockname(s_, addr, &addrlen);
     SocketAddress address;
     if (result >= 0) {
+        SocketAddressFromSockAddr(addr, addrlen, &address);
     } else {
+        LOGW("PhysicalSocket", "GetAddress: unable to get address, fd={}, err={}", s_, errno);
     }
     return address;
 }
@@ -339,7 +554,9 @@ PhysicalSocket::GetRemoteAddress() const
     int result = ::getpeername(s_, addr, &addrlen);
     SocketAddress address;
     if (result >= 0) {
+        SocketAddressFromSockAddr(addr, addrlen, &address);
     } else {
+        LOGW("PhysicalSocket", "GetAddress: unable to get address, fd={}, err={}", s_, errno);
     }
     return address;
 }
@@ -409,15 +626,47 @@ PhysicalSocket::SetOption(Option opt, int value)
     int sopt;
     if (TranslateOption(opt, &slevel, &sopt) == -1) { return -1; }
     int result = ::setsockopt(s_, slevel, sopt, (void *) &value, sizeof(value));
-    if (result != 0) { UpdateLastError(); }
+    if (result != 0) {
+        UpdateLastError();
+    } else if (opt == OPT_ZEROCOPY) {
+        zerocopy_ = value != 0;
+    } else if (opt == OPT_TIMESTAMPNS) {
+        timestamps_ = value != 0;
+    }
     return result;
 }
 
+void
+PhysicalSocket::EnableTimestamps()
+{
+#if defined(SO_TIMESTAMPNS)
+    int on = 1;
+    timestamps_ = ::setsockopt(s_, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0;
+#endif
+}
+
+void
+PhysicalSocket::CountSent(int result, size_t datagrams)
+{
+    if (result < 0) { return; }
+    bytes_sent_ += result;
+    if (udp_) { datagrams_sent_ += datagrams; }
+}
+
+void
+PhysicalSocket::CountReceived(int result, size_t datagrams)
+{
+    if (result < 0) { return; }
+    bytes_received_ += result;
+    if (udp_) { datagrams_received_ += datagrams; }
+}
+
 int
 PhysicalSocket::Send(const void *pv, size_t cb)
 {
     int sent = DoSend(s_, reinterpret_cast<const char *>(pv), static_cast<int>(cb), MSG_NOSIGNAL);
     UpdateLastError();
+    CountSent(sent);
     if ((sent > 0 && sent < static_cast<int>(cb)) || (sent < 0 && IsBlockingError(GetError()))) {
         EnableEvents(DE_WRITE);
     }
@@ -433,12 +682,312 @@ PhysicalSocket::SendTo(const void *buffer, size_t length, const SocketAddress &a
     int sent = DoSendTo(s_, static_cast<const char *>(buffer), static_cast<int>(length), MSG_NOSIGNAL,
                         reinterpret_cast<sockaddr *>(&saddr), static_cast<int>(len));
     UpdateLastError();
+    CountSent(sent);
     if ((sent > 0 && sent < static_cast<int>(length)) || (sent < 0 && IsBlockingError(GetError()))) {
         EnableEvents(DE_WRITE);
     }
     return sent;
 }
 
+int
+PhysicalSocket::SendV(const BufferSlice *slices, size_t count)
+{
+    if (count > kMaxIovecs) { count = kMaxIovecs; }
+    size_t length = 0;
+    iovec iovs[kMaxIovecs];
+    for (size_t i = 0; i < count; ++i) {
+        iovs[i].iov_base = const_cast<uint8_t *>(slices[i].data);
+        iovs[i].iov_len = slices[i].size;
+        length += slices[i].size;
+    }
+    // sendmsg() rather than writev() for MSG_NOSIGNAL
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iovs;
+    msg.msg_iovlen = count;
+    int sent = ::sendmsg(s_, &msg, MSG_NOSIGNAL);
+    UpdateLastError();
+    CountSent(sent);
+    if ((sent >= 0 && sent < static_cast<int>(length)) || (sent < 0 && IsBlockingError(GetError()))) {
+        EnableEvents(DE_WRITE);
+    }
+    return sent;
+}
+
+int
+PhysicalSocket::RecvV(const MutableBufferSlice *slices, size_t count)
+{
+    if (count > kMaxIovecs) { count = kMaxIovecs; }
+    size_t length = 0;
+    iovec iovs[kMaxIovecs];
+    for (size_t i = 0; i < count; ++i) {
+        iovs[i].iov_base = slices[i].data;
+        iovs[i].iov_len = slices[i].size;
+        length += slices[i].size;
+    }
+    int received = ::readv(s_, iovs, static_cast<int>(count));
+    CountReceived(received);
+    if ((received == 0) && (length != 0)) {
+        EnableEvents(DE_READ);
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+
+    UpdateLastError();
+    bool success = (received >= 0) || IsBlockingError(GetError());
+    if (udp_ || success) { EnableEvents(DE_READ); }
+    return received;
+}
+
+int
+PhysicalSocket::SendFile(int fd, int64_t offset, size_t length)
+{
+#if defined(__linux__)
+    off_t off = static_cast<off_t>(offset);
+    ssize_t sent = ::sendfile(s_, fd, &off, std::min<size_t>(length, std::numeric_limits<int>::max()));
+    if (sent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+        // `fd` can't be mmap()ed, e.g. a pipe
+        return Socket::SendFile(fd, offset, length);
+    }
+    UpdateLastError();
+    CountSent(static_cast<int>(sent));
+    if ((sent >= 0 && static_cast<size_t>(sent) < length) || (sent < 0 && IsBlockingError(GetError()))) {
+        EnableEvents(DE_WRITE);
+    }
+    return static_cast<int>(sent);
+#else
+    return Socket::SendFile(fd, offset, length);
+#endif
+}
+
+int
+PhysicalSocket::SendZeroCopy(const void *pv, size_t cb, int64_t *send_id)
+{
+#if defined(MSG_ZEROCOPY)
+    if (!zerocopy_) { return Socket::SendZeroCopy(pv, cb, send_id); }
+
+    int sent = DoSend(s_, reinterpret_cast<const char *>(pv), static_cast<int>(cb), MSG_NOSIGNAL | MSG_ZEROCOPY);
+    // out of optmem for pinned pages, copy instead
+    if (sent < 0 && errno == ENOBUFS) { return Socket::SendZeroCopy(pv, cb, send_id); }
+    UpdateLastError();
+    CountSent(sent);
+    if ((sent > 0 && sent < static_cast<int>(cb)) || (sent < 0 && IsBlockingError(GetError()))) {
+        EnableEvents(DE_WRITE);
+    }
+    if (send_id) { *send_id = -1; }
+    if (sent >= 0) {
+        // the kernel numbers every successful MSG_ZEROCOPY send
+        if (send_id) { *send_id = zerocopy_next_id_; }
+        ++zerocopy_next_id_;
+        ++zerocopy_pending_;
+        EnableEvents(DE_ERRQUEUE);
+    }
+    return sent;
+#else
+    return Socket::SendZeroCopy(pv, cb, send_id);
+#endif
+}
+
+#if defined(__linux__)
+// the head of the kernel's struct tcp_info, glibc's copy stops before the segment counters
+struct KernelTcpInfo {
+    uint8_t state;
+    uint8_t ca_state;
+    uint8_t retransmits;
+    uint8_t probes;
+    uint8_t backoff;
+    uint8_t options;
+    uint8_t wscale;
+    uint8_t flags;
+    uint32_t rto;
+    uint32_t ato;
+    uint32_t snd_mss;
+    uint32_t rcv_mss;
+    uint32_t unacked;
+    uint32_t sacked;
+    uint32_t lost;
+    uint32_t retrans;
+    uint32_t fackets;
+    uint32_t last_data_sent;
+    uint32_t last_ack_sent;
+    uint32_t last_data_recv;
+    uint32_t last_ack_recv;
+    uint32_t pmtu;
+    uint32_t rcv_ssthresh;
+    uint32_t rtt;
+    uint32_t rttvar;
+    uint32_t snd_ssthresh;
+    uint32_t snd_cwnd;
+    uint32_t advmss;
+    uint32_t reordering;
+    uint32_t rcv_rtt;
+    uint32_t rcv_space;
+    uint32_t total_retrans;
+    uint64_t pacing_rate;
+    uint64_t max_pacing_rate;
+    uint64_t bytes_acked;
+    uint64_t bytes_received;
+    uint32_t segs_out;
+    uint32_t segs_in;
+};
+
+static_assert(offsetof(KernelTcpInfo, total_retrans) == offsetof(struct tcp_info, tcpi_total_retrans),
+              "KernelTcpInfo must match the kernel layout");
+#endif
+
+int
+PhysicalSocket::GetStats(SocketStats *stats)
+{
+    if (!stats) { return SOCKET_ERROR; }
+    *stats = SocketStats();
+    stats->bytes_sent = bytes_sent_;
+    stats->bytes_received = bytes_received_;
+    stats->packets_sent = datagrams_sent_;
+    stats->packets_received = datagrams_received_;
+#if defined(__linux__)
+    if (!udp_) {
+        KernelTcpInfo info;
+        memset(&info, 0, sizeof(info));
+        socklen_t len = sizeof(info);
+        // fails on non TCP streams, older kernels fill less and say so in `len`
+        if (::getsockopt(s_, IPPROTO_TCP, TCP_INFO, &info, &len) == 0
+            && len >= offsetof(KernelTcpInfo, total_retrans) + sizeof(info.total_retrans)) {
+            stats->rtt_us = info.rtt;
+            stats->rtt_var_us = info.rttvar;
+            stats->cwnd = info.snd_cwnd;
+            stats->retransmits = info.total_retrans;
+            if (len >= offsetof(KernelTcpInfo, segs_in) + sizeof(info.segs_in)) {
+                stats->packets_sent = info.segs_out;
+                stats->packets_received = info.segs_in;
+            }
+        }
+    }
+#endif
+    return 0;
+}
+
+int
+PhysicalSocket::SendWithFds(const void *pv, size_t cb, const int *fds, size_t fd_count)
+{
+    // other families drop SCM_RIGHTS without a word
+    if (family_ != AF_UNIX) {
+        SetError(EOPNOTSUPP);
+        return SOCKET_ERROR;
+    }
+    if (fd_count > kMaxFds) {
+        SetError(EINVAL);
+        return SOCKET_ERROR;
+    }
+    if (fd_count == 0) { return Send(pv, cb); }
+
+    iovec iov;
+    iov.iov_base = const_cast<void *>(pv);
+    iov.iov_len = cb;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+
+    int sent = ::sendmsg(s_, &msg, MSG_NOSIGNAL);
+    UpdateLastError();
+    CountSent(sent);
+    if ((sent >= 0 && sent < static_cast<int>(cb)) || (sent < 0 && IsBlockingError(GetError()))) {
+        EnableEvents(DE_WRITE);
+    }
+    return sent;
+}
+
+int
+PhysicalSocket::RecvWithFds(void *pv, size_t cb, int *fds, size_t *fd_count)
+{
+    const size_t capacity = fd_count ? *fd_count : 0;
+    size_t n = 0;
+
+    iovec iov;
+    iov.iov_base = pv;
+    iov.iov_len = cb;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+#if defined(MSG_CMSG_CLOEXEC)
+    int received = ::recvmsg(s_, &msg, MSG_CMSG_CLOEXEC);
+#else
+    int received = ::recvmsg(s_, &msg, 0);
+#endif
+    if (received >= 0) {
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+            const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+                // no room left for it, don't leak it
+                if (n < capacity) {
+                    fds[n++] = fd;
+                } else {
+                    ::close(fd);
+                }
+            }
+        }
+    }
+    if (fd_count) { *fd_count = n; }
+    CountReceived(received);
+    if ((received == 0) && (cb != 0)) {
+        EnableEvents(DE_READ);
+        SetError(EWOULDBLOCK);
+        return SOCKET_ERROR;
+    }
+
+    UpdateLastError();
+    bool success = (received >= 0) || IsBlockingError(GetError());
+    if (udp_ || success) { EnableEvents(DE_READ); }
+    return received;
+}
+
+void
+PhysicalSocket::ProcessErrorQueue()
+{
+#if defined(SO_EE_ORIGIN_ZEROCOPY)
+    while (zerocopy_pending_ > 0) {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_storage))];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (::recvmsg(s_, &msg, MSG_ERRQUEUE) < 0) { break; }
+
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                && !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+            sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) { continue; }
+            // [ee_info, ee_data] is an inclusive range of send ids, it may wrap
+            for (uint32_t id = err.ee_info;; ++id) {
+                if (zerocopy_pending_ > 0) { --zerocopy_pending_; }
+                SignalSendComplete(this, id);
+                if (id == err.ee_data) { break; }
+            }
+        }
+    }
+#endif
+    if (zerocopy_pending_ == 0) { DisableEvents(DE_ERRQUEUE); }
+}
+
 int
 PhysicalSocket::Recv(void *buffer, size_t length, int64_t *timestamp)
 {
@@ -495,6 +1044,21 @@ GetSocketRecvTimestamp(int socket)
     return timestamp;
 }
 
+int64_t
+PhysicalSocket::ControlMessageTimestamp(msghdr *msg)
+{
+#if defined(SCM_TIMESTAMPNS)
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return static_cast<int64_t>(ts.tv_sec) * kNumMicrosecsPerSec + ts.tv_nsec / kNumNanosecsPerMicrosec;
+        }
+    }
+#endif
+    return -1;
+}
+
 int
 PhysicalSocket::DoReadFromSocket(void *buffer, size_t length, SocketAddress *out_addr, int64_t *timestamp)
 {
@@ -503,17 +1067,167 @@ PhysicalSocket::DoReadFromSocket(void *buffer, size_t length, SocketAddress *out
     sockaddr *addr = reinterpret_cast<sockaddr *>(&addr_storage);
 
     int received = 0;
-    if (out_addr) {
+    if (timestamp) { *timestamp = -1; }
+    if (timestamp && timestamps_) {
+        // the stamp arrives with the data, no extra ioctl() per read
+        iovec iov;
+        iov.iov_base = buffer;
+        iov.iov_len = length;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec))];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        if (out_addr) {
+            msg.msg_name = addr;
+            msg.msg_namelen = addr_len;
+        }
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        received = ::recvmsg(s_, &msg, 0);
+        if (received >= 0) {
+            if (out_addr) { SocketAddressFromSockAddr(addr, msg.msg_namelen, out_addr); }
+            *timestamp = ControlMessageTimestamp(&msg);
+        }
+    } else if (out_addr) {
         received = ::recvfrom(s_, static_cast<char *>(buffer), static_cast<int>(length), 0, addr, &addr_len);
-        SocketAddressFromSockAddrStorage(addr_storage, out_addr);
+        if (received >= 0) { SocketAddressFromSockAddr(addr, addr_len, out_addr); }
     } else {
         received = ::recv(s_, static_cast<char *>(buffer), static_cast<int>(length), 0);
     }
-    if (timestamp) { *timestamp = GetSocketRecvTimestamp(s_); }
+    // the ioctl() would clobber errno of a failed read, AF_UNIX doesn't know it
+    if (timestamp && *timestamp == -1 && received >= 0 && family_ != AF_UNIX) {
+        *timestamp = GetSocketRecvTimestamp(s_);
+    }
+    CountReceived(received);
+
+    return received;
+}
+
+#if defined(__linux__)
+int
+PhysicalSocket::RecvFromBatch(Datagram *datagrams, size_t count)
+{
+    if (count > kMaxBatchSize) { count = kMaxBatchSize; }
+    if (count == 0) { return 0; }
+
+    static constexpr size_t kControlSize = CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec));
+    mmsghdr msgs[kMaxBatchSize];
+    iovec iovs[kMaxBatchSize];
+    sockaddr_storage addrs[kMaxBatchSize];
+    alignas(cmsghdr) char control[kMaxBatchSize][kControlSize];
+    memset(msgs, 0, sizeof(mmsghdr) * count);
+    for (size_t i = 0; i < count; ++i) {
+        Buffer &data = datagrams[i].data;
+        if (data.capacity() == 0) { data.EnsureCapacity(kMaxDatagramSize); }
+        data.SetSize(data.capacity());
+        iovs[i].iov_base = data.data();
+        iovs[i].iov_len = data.size();
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i];
+        msgs[i].msg_hdr.msg_controllen = kControlSize;
+    }
+
+    int received = ::recvmmsg(s_, msgs, static_cast<unsigned int>(count), 0, nullptr);
+    UpdateLastError();
+    EnableEvents(DE_READ);
+    if (received < 0) {
+        for (size_t i = 0; i < count; ++i) { datagrams[i].data.Clear(); }
+        return SOCKET_ERROR;
+    }
 
+    // without SO_TIMESTAMP(NS) the kernel only keeps the stamp of the last datagram
+    int64_t batch_timestamp = -1;
+    for (size_t i = 0; i < count; ++i) {
+        Datagram &datagram = datagrams[i];
+        if (i >= static_cast<size_t>(received)) {
+            datagram.data.Clear();
+            continue;
+        }
+        datagram.data.SetSize(msgs[i].msg_len);
+        SocketAddressFromSockAddr(reinterpret_cast<sockaddr *>(&addrs[i]), msgs[i].msg_hdr.msg_namelen, &datagram.addr);
+        datagram.segment_size = 0;
+        datagram.timestamp = ControlMessageTimestamp(&msgs[i].msg_hdr);
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+#if defined(UDP_GRO)
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int segment_size;
+                memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+                if (segment_size > 0 && static_cast<size_t>(segment_size) < datagram.data.size()) {
+                    datagram.segment_size = segment_size;
+                }
+            }
+#endif
+        }
+        const size_t size = datagram.data.size();
+        CountReceived(static_cast<int>(size),
+                      datagram.segment_size > 0 ? (size + datagram.segment_size - 1) / datagram.segment_size : 1);
+        if (datagram.timestamp == -1) {
+            if (batch_timestamp == -1) { batch_timestamp = GetSocketRecvTimestamp(s_); }
+            datagram.timestamp = batch_timestamp;
+        }
+    }
     return received;
 }
 
+int
+PhysicalSocket::SendToBatch(const Datagram *datagrams, size_t count)
+{
+    if (count > kMaxBatchSize) { count = kMaxBatchSize; }
+    if (count == 0) { return 0; }
+
+    static constexpr size_t kControlSize = CMSG_SPACE(sizeof(uint16_t));
+    mmsghdr msgs[kMaxBatchSize];
+    iovec iovs[kMaxBatchSize];
+    sockaddr_storage addrs[kMaxBatchSize];
+    alignas(cmsghdr) char control[kMaxBatchSize][kControlSize];
+    memset(msgs, 0, sizeof(mmsghdr) * count);
+    for (size_t i = 0; i < count; ++i) {
+        const Datagram &datagram = datagrams[i];
+        iovs[i].iov_base = const_cast<uint8_t *>(datagram.data.data());
+        iovs[i].iov_len = datagram.data.size();
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(datagram.addr.ToSockAddrStorage(&addrs[i]));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (datagram.segment_size > 0 && datagram.segment_size < datagram.data.size()) {
+#if defined(UDP_SEGMENT)
+            // UDP GSO, the kernel splits data into segment_size datagrams
+            msgs[i].msg_hdr.msg_control = control[i];
+            msgs[i].msg_hdr.msg_controllen = kControlSize;
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t segment_size = static_cast<uint16_t>(datagram.segment_size);
+            memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+#else
+            return Socket::SendToBatch(datagrams, count);
+#endif
+        }
+    }
+
+    int sent = ::sendmmsg(s_, msgs, static_cast<unsigned int>(count), MSG_NOSIGNAL);
+    UpdateLastError();
+    for (int i = 0; i < sent; ++i) {
+        const Datagram &datagram = datagrams[i];
+        const size_t size = datagram.data.size();
+        CountSent(static_cast<int>(size),
+                  datagram.segment_size > 0 && datagram.segment_size < size
+                      ? (size + datagram.segment_size - 1) / datagram.segment_size
+                      : 1);
+    }
+    if ((sent >= 0 && sent < static_cast<int>(count)) || (sent < 0 && IsBlockingError(GetError()))) {
+        EnableEvents(DE_WRITE);
+    }
+    return sent;
+}
+#endif
+
 int
 PhysicalSocket::Listen(int backlog)
 {
@@ -537,7 +1251,7 @@ PhysicalSocket::Accept(SocketAddress *out_addr)
     SOCKET s = DoAccept(s_, addr, &addr_len);
     UpdateLastError();
     if (s == INVALID_SOCKET) { return nullptr; }
-    if (out_addr) { SocketAddressFromSockAddrStorage(addr_storage, out_addr); }
+    if (out_addr) { SocketAddressFromSockAddr(addr, addr_len, out_addr); }
 
     return ss_->WrapSocket(s);
 }
@@ -551,6 +1265,8 @@ PhysicalSocket::Close()
     UpdateLastError();
     s_ = INVALID_SOCKET;
     state_ = CS_CLOSED;
+    zerocopy_ = false;
+    zerocopy_pending_ = 0;
     SetEnabledEvents(0);
     if (resolver_) {
         resolver_->Destroy(false);
@@ -659,6 +1375,56 @@ PhysicalSocket::TranslateOption(Option opt, int *slevel, int *sopt)
         *slevel = IPPROTO_TCP;
         *sopt = TCP_NODELAY;
         break;
+    case OPT_REUSEADDR:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_REUSEADDR;
+        break;
+#if defined(SO_REUSEPORT)
+    case OPT_REUSEPORT:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_REUSEPORT;
+        break;
+#endif
+#if defined(UDP_GRO)
+    case OPT_UDP_GRO:
+        *slevel = SOL_UDP;
+        *sopt = UDP_GRO;
+        break;
+#endif
+#if defined(SO_ZEROCOPY)
+    case OPT_ZEROCOPY:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_ZEROCOPY;
+        break;
+#endif
+#if defined(SO_TIMESTAMPNS)
+    case OPT_TIMESTAMPNS:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_TIMESTAMPNS;
+        break;
+#endif
+    case OPT_KEEPALIVE:
+        *slevel = SOL_SOCKET;
+        *sopt = SO_KEEPALIVE;
+        break;
+#if defined(TCP_KEEPIDLE)
+    case OPT_KEEPIDLE:
+        *slevel = IPPROTO_TCP;
+        *sopt = TCP_KEEPIDLE;
+        break;
+#endif
+#if defined(TCP_KEEPINTVL)
+    case OPT_KEEPINTVL:
+        *slevel = IPPROTO_TCP;
+        *sopt = TCP_KEEPINTVL;
+        break;
+#endif
+#if defined(TCP_KEEPCNT)
+    case OPT_KEEPCNT:
+        *slevel = IPPROTO_TCP;
+        *sopt = TCP_KEEPCNT;
+        break;
+#endif
     default:
         return -1;
     }
@@ -696,6 +1462,52 @@ SocketDispatcher::Create(int family, int type)
     return true;
 }
 
+void
+SocketDispatcher::StartBatchedEventUpdates()
+{
+    saved_enabled_events_ = enabled_events();
+}
+
+void
+SocketDispatcher::FinishBatchedEventUpdates()
+{
+    if (saved_enabled_events_ == -1) { return; }
+    uint8_t old_events = static_cast<uint8_t>(saved_enabled_events_ & 0xff);
+    saved_enabled_events_ = -1;
+    MaybeUpdateDispatcher(old_events);
+}
+
+void
+SocketDispatcher::MaybeUpdateDispatcher(uint8_t old_events)
+{
+    if (saved_enabled_events_ != -1) { return; }
+    if (enabled_events() != old_events) { ss_->Update(this); }
+}
+
+void
+SocketDispatcher::SetEnabledEvents(uint8_t events)
+{
+    uint8_t old_events = enabled_events();
+    PhysicalSocket::SetEnabledEvents(events);
+    MaybeUpdateDispatcher(old_events);
+}
+
+void
+SocketDispatcher::EnableEvents(uint8_t events)
+{
+    uint8_t old_events = enabled_events();
+    PhysicalSocket::EnableEvents(events);
+    MaybeUpdateDispatcher(old_events);
+}
+
+void
+SocketDispatcher::DisableEvents(uint8_t events)
+{
+    uint8_t old_events = enabled_events();
+    PhysicalSocket::DisableEvents(events);
+    MaybeUpdateDispatcher(old_events);
+}
+
 int
 SocketDispatcher::GetDescriptor()
 {
@@ -749,6 +1561,12 @@ SocketDispatcher::OnEvent(uint32_t ff, int err)
 
     if ((ff & DE_CLOSE) != 0) { state_ = CS_CLOSED; }
 
+    // the signal handlers may re-enable the events disabled here, so
+    // combine all changes into one Update() at the end
+    StartBatchedEventUpdates();
+
+    if ((enabled_events() & DE_ERRQUEUE) != 0) { ProcessErrorQueue(); }
+
     if ((ff & DE_CONNECT) != 0) {
         DisableEvents(DE_CONNECT);
         SignalConnectEvent(this);
@@ -771,8 +1589,13 @@ SocketDispatcher::OnEvent(uint32_t ff, int err)
 
     if ((ff & DE_CLOSE) != 0) {
         SetEnabledEvents(0);
+        // the close handler is allowed to destroy this socket
+        FinishBatchedEventUpdates();
         SignalCloseEvent(this, err);
+        return;
     }
+
+    FinishBatchedEventUpdates();
 }
 
 int
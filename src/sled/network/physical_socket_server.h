@@ -13,8 +13,15 @@
 #include "sled/synchronization/mutex.h"
 #include "socket.h"
 #include "socket_server.h"
+#include <sys/socket.h>
 #include <unordered_map>
 
+#if defined(__linux__)
+#define SLED_USE_EPOLL 1
+#include <array>
+#include <sys/epoll.h>
+#endif
+
 typedef int SOCKET;
 
 namespace sled {
@@ -25,6 +32,7 @@ enum DispatcherEvent {
     DE_CONNECT = 0x0004,
     DE_CLOSE = 0x0008,
     DE_ACCEPT = 0x0010,
+    DE_ERRQUEUE = 0x0020,// MSG_ZEROCOPY completions are pending
 };
 
 class Signaler;
@@ -41,6 +49,11 @@ public:
 
 class PhysicalSocketServer : public SocketServer {
 public:
+    enum class Backend {
+        kSelect,
+        kEpoll,
+    };
+
     PhysicalSocketServer();
     ~PhysicalSocketServer() override;
     Socket *CreateSocket(int family, int type) override;
@@ -52,12 +65,36 @@ public:
     void Remove(Dispatcher *dispatcher);
     void Update(Dispatcher *dispatcher);
 
+    // select() is used when epoll is unavailable at compile time or
+    // epoll_create1() fails at runtime
+    Backend backend() const;
+
+protected:
+    // Dispatches the events already pending on the Add()ed dispatchers
+    // without blocking. Returns false once WakeUp() has been signaled.
+    bool PollDispatchers();
+
+#if defined(SLED_USE_EPOLL)
+    int epoll_fd() const { return epoll_fd_; }
+#endif
+
 private:
     static const int kForeverMs = -1;
     static int ToCusWait(TimeDelta max_wait_duration);
 
     bool WaitSelect(int64_t cusWait, bool process_io);
 
+#if defined(SLED_USE_EPOLL)
+    void AddEpoll(Dispatcher *dispatcher, uint64_t key);
+    void RemoveEpoll(Dispatcher *dispatcher);
+    void UpdateEpoll(Dispatcher *dispatcher, uint64_t key);
+    bool WaitEpoll(int64_t cusWait);
+
+    static const int kNumEpollEvents = 128;
+    std::array<epoll_event, kNumEpollEvents> epoll_events_;
+    const int epoll_fd_ = INVALID_SOCKET;
+#endif
+
     uint64_t next_dispatcher_key_ = 0;
     std::unordered_map<uint64_t, Dispatcher *> dispatcher_by_key_ GUARDED_BY(lock_);
     std::unordered_map<Dispatcher *, uint64_t> key_by_dispatcher_ GUARDED_BY(lock_);
@@ -92,6 +129,24 @@ public:
     int SendTo(const void *pv, size_t cb, const SocketAddress &addr) override;
     int Recv(void *pv, size_t cb, int64_t *timestamp) override;
     int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) override;
+    using Socket::SendV;
+    // sendmsg()/readv(), at most 64 slices per call
+    int SendV(const BufferSlice *slices, size_t count) override;
+    int RecvV(const MutableBufferSlice *slices, size_t count) override;
+#if defined(__linux__)
+    // recvmmsg()/sendmmsg(), at most kMaxBatchSize datagrams per call
+    static constexpr size_t kMaxBatchSize = 64;
+    int RecvFromBatch(Datagram *datagrams, size_t count) override;
+    int SendToBatch(const Datagram *datagrams, size_t count) override;
+#endif
+    int SendFile(int fd, int64_t offset, size_t length) override;
+    int SendZeroCopy(const void *pv, size_t cb, int64_t *send_id) override;
+    // at most kMaxFds descriptors per call
+    static constexpr size_t kMaxFds = 64;
+    int SendWithFds(const void *pv, size_t cb, const int *fds, size_t fd_count) override;
+    int RecvWithFds(void *pv, size_t cb, int *fds, size_t *fd_count) override;
+    // byte and datagram counters kept here, TCP segments, rtt and cwnd from TCP_INFO
+    int GetStats(SocketStats *stats) override;
     int Listen(int backlog) override;
     Socket *Accept(SocketAddress *paddr) override;
 
@@ -102,7 +157,7 @@ public:
     SOCKET GetSocketFD() const { return s_; }
 
 protected:
-    int DoConnect(const SocketAddress &addr);
+    virtual int DoConnect(const SocketAddress &addr);
     virtual SOCKET DoAccept(SOCKET socket, sockaddr *addr, socklen_t *addrlen);
     virtual int DoSend(SOCKET socket, const char *buf, int len, int flags);
     virtual int
@@ -111,6 +166,16 @@ protected:
 
     void OnResolveResult(AsyncResolverInterface *resolver);
     void UpdateLastError();
+    // reads MSG_ZEROCOPY completions off the error queue, emits SignalSendComplete
+    void ProcessErrorQueue();
+    // counts the outcome of a send/recv call, `datagrams` only matters for UDP
+    void CountSent(int result, size_t datagrams = 1);
+    void CountReceived(int result, size_t datagrams = 1);
+    // SO_TIMESTAMPNS on new sockets, quietly skipped where unsupported
+    void EnableTimestamps();
+    bool timestamps() const { return timestamps_; }
+    // SCM_TIMESTAMPNS of a recvmsg(), -1 if there is none
+    static int64_t ControlMessageTimestamp(msghdr *msg);
 
     uint8_t enabled_events() const { return enabled_events_; }
 
@@ -130,6 +195,14 @@ protected:
 
 private:
     uint8_t enabled_events_ = 0;
+    bool zerocopy_ = false;
+    uint32_t zerocopy_next_id_ = 0;
+    size_t zerocopy_pending_ = 0;
+    bool timestamps_ = false;
+    int64_t bytes_sent_ = 0;
+    int64_t bytes_received_ = 0;
+    int64_t datagrams_sent_ = 0;
+    int64_t datagrams_received_ = 0;
 };
 
 class SocketDispatcher : public Dispatcher, public PhysicalSocket {
@@ -150,6 +223,20 @@ public:
     void OnEvent(uint32_t ff, int err) override;
 
     int Close() override;
+
+protected:
+    void SetEnabledEvents(uint8_t events) override;
+    void EnableEvents(uint8_t events) override;
+    void DisableEvents(uint8_t events) override;
+
+private:
+    // OnEvent() toggles several event bits in a row, coalesce them into
+    // a single Update() call
+    void StartBatchedEventUpdates();
+    void FinishBatchedEventUpdates();
+    void MaybeUpdateDispatcher(uint8_t old_events);
+
+    int saved_enabled_events_ = -1;
 };
 
 }// namespace sled
@@ -0,0 +1,126 @@
+#include <sled/network/physical_socket_server.h>
+
+// loopback packets per second, one iteration is one 64 byte datagram sent and received
+struct UdpLoopback {
+    UdpLoopback()
+        : receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM)),
+          sender(ss.CreateSocket(AF_INET, SOCK_DGRAM))
+    {
+        receiver->SetOption(sled::Socket::OPT_RCVBUF, 4 * 1024 * 1024);
+        receiver->Bind(sled::SocketAddress("127.0.0.1", 0));
+        sender->Bind(sled::SocketAddress("127.0.0.1", 0));
+        addr = receiver->GetLocalAddress();
+    }
+
+    sled::PhysicalSocketServer ss;
+    std::unique_ptr<sled::Socket> receiver;
+    std::unique_ptr<sled::Socket> sender;
+    sled::SocketAddress addr;
+    uint8_t payload[64] = {0};
+};
+
+static void
+UdpSendToRecvFrom(picobench::state &s)
+{
+    UdpLoopback loopback;
+    uint8_t buf[sled::Socket::kMaxDatagramSize];
+    for (auto _ : s) {
+        loopback.sender->SendTo(loopback.payload, sizeof(loopback.payload), loopback.addr);
+        loopback.receiver->RecvFrom(buf, sizeof(buf), nullptr, nullptr);
+    }
+}
+
+static void
+UdpSendToRecvFromBatch(picobench::state &s)
+{
+    static const size_t kBatchSize = 64;
+    UdpLoopback loopback;
+    std::vector<sled::Datagram> out(kBatchSize);
+    std::vector<sled::Datagram> in(kBatchSize);
+    for (auto &datagram : out) {
+        datagram.data.SetData(loopback.payload, sizeof(loopback.payload));
+        datagram.addr = loopback.addr;
+    }
+
+    size_t pending = 0;
+    size_t done = 0;
+    for (auto _ : s) {
+        if (++pending < kBatchSize && done + pending < static_cast<size_t>(s.iterations())) { continue; }
+        loopback.sender->SendToBatch(out.data(), pending);
+        size_t received = 0;
+        while (received < pending) {
+            int n = loopback.receiver->RecvFromBatch(in.data(), pending - received);
+            if (n <= 0) { break; }
+            received += n;
+        }
+        done += pending;
+        pending = 0;
+    }
+}
+
+// a connected stream pair, `family` AF_INET for tcp loopback or AF_UNIX
+struct StreamPair {
+    explicit StreamPair(int family)
+    {
+        const sled::SocketAddress addr = family == AF_UNIX
+                                           ? sled::SocketAddress::AbstractUnix("sled_bench_" + std::to_string(getpid()))
+                                           : sled::SocketAddress("127.0.0.1", 0);
+        std::unique_ptr<sled::Socket> server(ss.CreateSocket(family, SOCK_STREAM));
+        server->Bind(addr);
+        server->Listen(1);
+        client.reset(ss.CreateSocket(family, SOCK_STREAM));
+        client->SetOption(sled::Socket::OPT_NODELAY, 1);
+        client->Connect(server->GetLocalAddress());
+        while (!(accepted = std::unique_ptr<sled::Socket>(server->Accept(nullptr)))) {
+            ss.Wait(sled::TimeDelta::Millis(1), true);
+        }
+        accepted->SetOption(sled::Socket::OPT_NODELAY, 1);
+    }
+
+    // spins until `size` bytes arrived
+    static void RecvExactly(sled::Socket *socket, uint8_t *buf, size_t size)
+    {
+        size_t received = 0;
+        while (received < size) {
+            int n = socket->Recv(buf + received, size - received, nullptr);
+            if (n > 0) { received += n; }
+        }
+    }
+
+    sled::PhysicalSocketServer ss;
+    std::unique_ptr<sled::Socket> client;
+    std::unique_ptr<sled::Socket> accepted;
+    uint8_t payload[64] = {0};
+};
+
+// same host round trip, one iteration is a 64 byte request and its echo
+static void
+StreamPingPong(picobench::state &s, int family)
+{
+    StreamPair pair(family);
+    uint8_t buf[sizeof(pair.payload)];
+    for (auto _ : s) {
+        pair.client->Send(pair.payload, sizeof(pair.payload));
+        StreamPair::RecvExactly(pair.accepted.get(), buf, sizeof(buf));
+        pair.accepted->Send(buf, sizeof(buf));
+        StreamPair::RecvExactly(pair.client.get(), buf, sizeof(buf));
+    }
+}
+
+static void
+TcpLoopbackPingPong(picobench::state &s)
+{
+    StreamPingPong(s, AF_INET);
+}
+
+static void
+UnixStreamPingPong(picobench::state &s)
+{
+    StreamPingPong(s, AF_UNIX);
+}
+
+PICOBENCH_SUITE("PhysicalSocketServer");
+PICOBENCH(UdpSendToRecvFrom);
+PICOBENCH(UdpSendToRecvFromBatch);
+PICOBENCH(TcpLoopbackPingPong);
+PICOBENCH(UnixStreamPingPong);
@@ -0,0 +1,579 @@
+#include <sled/network/physical_socket_server.h>
+#include <sled/time_utils.h>
+#include <atomic>
+#include <functional>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+std::function<void()> before_next_read;
+std::atomic<bool> before_next_read_armed(false);
+
+// runs `hook` in the next read() of this process, right before it reads
+void
+BeforeNextRead(std::function<void()> hook)
+{
+    before_next_read = std::move(hook);
+    before_next_read_armed.store(true, std::memory_order_release);
+}
+}// namespace
+
+// comes before the one of libc, so a test can step in between the
+// syscalls of a Dispatcher::OnEvent()
+extern "C" ssize_t
+read(int fd, void *buf, size_t count)
+{
+    if (before_next_read_armed.exchange(false, std::memory_order_acq_rel)) {
+        std::function<void()> hook = std::move(before_next_read);
+        hook();
+    }
+    return syscall(SYS_read, fd, buf, count);
+}
+
+namespace {
+struct SocketEventRecorder : public sigslot::has_slots<> {
+    void Watch(sled::Socket *socket)
+    {
+        socket->SignalReadEvent.connect(this, &SocketEventRecorder::OnReadEvent);
+        socket->SignalWriteEvent.connect(this, &SocketEventRecorder::OnWriteEvent);
+        socket->SignalConnectEvent.connect(this, &SocketEventRecorder::OnConnectEvent);
+        socket->SignalCloseEvent.connect(this, &SocketEventRecorder::OnCloseEvent);
+        socket->SignalSendComplete.connect(this, &SocketEventRecorder::OnSendComplete);
+    }
+
+    void OnReadEvent(sled::Socket *) { ++read_events; }
+
+    void OnWriteEvent(sled::Socket *) { ++write_events; }
+
+    void OnConnectEvent(sled::Socket *) { ++connect_events; }
+
+    void OnCloseEvent(sled::Socket *, int) { ++close_events; }
+
+    void OnSendComplete(sled::Socket *, int64_t send_id) { completed_sends.push_back(send_id); }
+
+    int read_events    = 0;
+    int write_events   = 0;
+    int connect_events = 0;
+    int close_events   = 0;
+    std::vector<int64_t> completed_sends;
+};
+
+template<typename Predicate>
+bool
+WaitUntil(sled::PhysicalSocketServer &ss, Predicate &&pred)
+{
+    for (int i = 0; i < 100 && !pred(); ++i) { ss.Wait(sled::TimeDelta::Millis(10), true); }
+    return pred();
+}
+
+// takes `budget` SendTo() calls, then would block
+class BlockingSocket : public sled::SocketDispatcher {
+public:
+    BlockingSocket(sled::PhysicalSocketServer *ss, int budget) : sled::SocketDispatcher(ss), budget_(budget) {}
+
+    int SendTo(const void *pv, size_t cb, const sled::SocketAddress &addr) override
+    {
+        if (budget_ == 0) {
+            SetError(EWOULDBLOCK);
+            return -1;
+        }
+        --budget_;
+        return sled::SocketDispatcher::SendTo(pv, cb, addr);
+    }
+
+private:
+    int budget_;
+};
+
+// a connected tcp pair, `accepted` is the server side of `client`
+struct TcpPair {
+    explicit TcpPair(sled::PhysicalSocketServer &ss)
+    {
+        std::unique_ptr<sled::Socket> server(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        SocketEventRecorder server_events;
+        server_events.Watch(server.get());
+        server->Bind(sled::SocketAddress("127.0.0.1", 0));
+        server->Listen(5);
+        client.reset(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        client->Connect(server->GetLocalAddress());
+        WaitUntil(ss, [&] { return server_events.read_events > 0; });
+        accepted.reset(server->Accept(nullptr));
+        WaitUntil(ss, [&] { return client->GetState() == sled::Socket::CS_CONNECTED; });
+        client_events.Watch(client.get());
+        if (accepted) { accepted_events.Watch(accepted.get()); }
+    }
+
+    std::unique_ptr<sled::Socket> client;
+    std::unique_ptr<sled::Socket> accepted;
+    SocketEventRecorder client_events;
+    SocketEventRecorder accepted_events;
+};
+
+std::string
+RecvAll(sled::PhysicalSocketServer &ss, sled::Socket *socket, size_t size)
+{
+    std::string result;
+    char buf[4096];
+    WaitUntil(ss, [&] {
+        int received;
+        while ((received = socket->Recv(buf, sizeof(buf), nullptr)) > 0) { result.append(buf, received); }
+        return result.size() >= size;
+    });
+    return result;
+}
+}// namespace
+
+TEST_SUITE("PhysicalSocketServer")
+{
+    TEST_CASE("backend")
+    {
+        sled::PhysicalSocketServer ss;
+#if defined(SLED_USE_EPOLL)
+        CHECK_EQ(ss.backend(), sled::PhysicalSocketServer::Backend::kEpoll);
+#else
+        CHECK_EQ(ss.backend(), sled::PhysicalSocketServer::Backend::kSelect);
+#endif
+    }
+
+    TEST_CASE("wakeup")
+    {
+        sled::PhysicalSocketServer ss;
+        ss.WakeUp();
+        CHECK(ss.Wait(sled::SocketServer::kForever, true));
+    }
+
+    TEST_CASE("wakeup racing with the drain is not lost")
+    {
+        sled::PhysicalSocketServer ss;
+        ss.WakeUp();
+        // a second WakeUp() lands while the first one is drained
+        BeforeNextRead([&ss] { ss.WakeUp(); });
+        CHECK(ss.Wait(sled::SocketServer::kForever, true));
+
+        std::thread waker([&ss] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ss.WakeUp();
+        });
+        const int64_t start = sled::TimeMillis();
+        CHECK(ss.Wait(sled::TimeDelta::Seconds(2), true));
+        waker.join();
+        CHECK_LT(sled::TimeMillis() - start, 1000);
+    }
+
+    TEST_CASE("tcp loopback")
+    {
+        sled::PhysicalSocketServer ss;
+        SocketEventRecorder server_events;
+        SocketEventRecorder client_events;
+        SocketEventRecorder accepted_events;
+
+        std::unique_ptr<sled::Socket> server(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE(server);
+        server_events.Watch(server.get());
+        REQUIRE_EQ(server->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(server->Listen(5), 0);
+        sled::SocketAddress server_addr = server->GetLocalAddress();
+        REQUIRE_NE(server_addr.port(), 0);
+
+        std::unique_ptr<sled::Socket> client(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE(client);
+        client_events.Watch(client.get());
+        REQUIRE_EQ(client->Connect(server_addr), 0);
+
+        CHECK(WaitUntil(ss, [&] { return server_events.read_events > 0 && client_events.connect_events > 0; }));
+        CHECK_EQ(client->GetState(), sled::Socket::CS_CONNECTED);
+
+        std::unique_ptr<sled::Socket> accepted(server->Accept(nullptr));
+        REQUIRE(accepted);
+        accepted_events.Watch(accepted.get());
+        CHECK_EQ(accepted->GetRemoteAddress().port(), client->GetLocalAddress().port());
+
+        const char kMessage[] = "hello";
+        CHECK_EQ(client->Send(kMessage, sizeof(kMessage)), sizeof(kMessage));
+        CHECK(WaitUntil(ss, [&] { return accepted_events.read_events > 0; }));
+
+        char buf[sizeof(kMessage)] = {0};
+        CHECK_EQ(accepted->Recv(buf, sizeof(buf), nullptr), sizeof(kMessage));
+        CHECK_EQ(std::string(buf), std::string(kMessage));
+
+        client->Close();
+        CHECK(WaitUntil(ss, [&] { return accepted_events.close_events > 0; }));
+    }
+
+    TEST_CASE("udp batch")
+    {
+        sled::PhysicalSocketServer ss;
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE(receiver);
+        REQUIRE(sender);
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(sender->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        const sled::SocketAddress receiver_addr = receiver->GetLocalAddress();
+
+        std::vector<sled::Datagram> out(10);
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i].data.SetData(reinterpret_cast<const uint8_t *>(&i), sizeof(i));
+            out[i].addr = receiver_addr;
+        }
+        CHECK_EQ(sender->SendToBatch(out.data(), out.size()), out.size());
+
+        std::vector<sled::Datagram> in(16);
+        CHECK_EQ(receiver->RecvFromBatch(in.data(), in.size()), out.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            CHECK(in[i].data == out[i].data);
+            CHECK_EQ(in[i].addr.port(), sender->GetLocalAddress().port());
+            CHECK_EQ(in[i].segment_size, 0);
+        }
+        CHECK_EQ(in[out.size()].data.size(), 0);
+
+        CHECK_EQ(receiver->RecvFromBatch(in.data(), in.size()), -1);
+        CHECK(receiver->IsBlocking());
+    }
+
+    TEST_CASE("udp gso")
+    {
+        sled::PhysicalSocketServer ss;
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(sender->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+
+        sled::Datagram datagram;
+        datagram.data.SetSize(2500);
+        for (size_t i = 0; i < datagram.data.size(); ++i) { datagram.data[i] = static_cast<uint8_t>(i); }
+        datagram.addr = receiver->GetLocalAddress();
+        datagram.segment_size = 1000;
+        CHECK_EQ(sender->SendToBatch(&datagram, 1), 1);
+
+        // without OPT_UDP_GRO the segments arrive as separate datagrams
+        sled::Datagram in[4];
+        CHECK_EQ(receiver->RecvFromBatch(in, 4), 3);
+        CHECK_EQ(in[0].data.size(), 1000);
+        CHECK_EQ(in[1].data.size(), 1000);
+        CHECK_EQ(in[2].data.size(), 500);
+        CHECK_EQ(in[2].data[499], static_cast<uint8_t>(2499));
+    }
+
+    TEST_CASE("default SendToBatch counts a partly sent gso datagram")
+    {
+        sled::PhysicalSocketServer ss;
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+
+        std::vector<sled::Datagram> out(2);
+        for (sled::Datagram &datagram : out) {
+            datagram.data.SetSize(2500);
+            datagram.addr = receiver->GetLocalAddress();
+            datagram.segment_size = 1000;
+        }
+
+        // blocks on the second segment of the first datagram
+        BlockingSocket partly(&ss, 1);
+        REQUIRE(partly.Create(AF_INET, SOCK_DGRAM));
+        CHECK_EQ(partly.sled::Socket::SendToBatch(out.data(), out.size()), 1);
+
+        // blocks on the first segment of the second datagram
+        BlockingSocket whole(&ss, 3);
+        REQUIRE(whole.Create(AF_INET, SOCK_DGRAM));
+        CHECK_EQ(whole.sled::Socket::SendToBatch(out.data(), out.size()), 1);
+
+        BlockingSocket none(&ss, 0);
+        REQUIRE(none.Create(AF_INET, SOCK_DGRAM));
+        CHECK_EQ(none.sled::Socket::SendToBatch(out.data(), out.size()), -1);
+        CHECK(none.IsBlocking());
+    }
+
+    TEST_CASE("tcp scatter gather")
+    {
+        sled::PhysicalSocketServer ss;
+        SocketEventRecorder server_events;
+        SocketEventRecorder accepted_events;
+        std::unique_ptr<sled::Socket> server(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        server_events.Watch(server.get());
+        REQUIRE_EQ(server->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(server->Listen(5), 0);
+        std::unique_ptr<sled::Socket> client(ss.CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE_EQ(client->Connect(server->GetLocalAddress()), 0);
+        REQUIRE(WaitUntil(ss, [&] { return server_events.read_events > 0; }));
+        std::unique_ptr<sled::Socket> accepted(server->Accept(nullptr));
+        REQUIRE(accepted);
+        accepted_events.Watch(accepted.get());
+        REQUIRE(WaitUntil(ss, [&] { return client->GetState() == sled::Socket::CS_CONNECTED; }));
+
+        sled::BufferChain chain;
+        chain.Append("payload", 7);
+        chain.Prepend("head:", 5);
+        CHECK_EQ(client->SendV(chain), 12);
+        CHECK(WaitUntil(ss, [&] { return accepted_events.read_events > 0; }));
+
+        char head[5];
+        char payload[16];
+        const sled::MutableBufferSlice slices[] = {{head, sizeof(head)}, {payload, sizeof(payload)}};
+        CHECK_EQ(accepted->RecvV(slices, 2), 12);
+        CHECK_EQ(std::string(head, sizeof(head)), "head:");
+        CHECK_EQ(std::string(payload, 7), "payload");
+    }
+
+    TEST_CASE("send file")
+    {
+        sled::PhysicalSocketServer ss;
+        TcpPair pair(ss);
+        REQUIRE(pair.accepted);
+
+        std::string content(100 * 1024, '\0');
+        for (size_t i = 0; i < content.size(); ++i) { content[i] = static_cast<char>('a' + i % 26); }
+        char path[] = "/tmp/sled_send_file_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE_GE(fd, 0);
+        unlink(path);
+        REQUIRE_EQ(write(fd, content.data(), content.size()), content.size());
+
+        const int64_t kOffset = 10;
+        std::string received;
+        int64_t offset = kOffset;
+        while (offset < static_cast<int64_t>(content.size())) {
+            int sent = pair.client->SendFile(fd, offset, content.size() - offset);
+            if (sent > 0) { offset += sent; }
+            received += RecvAll(ss, pair.accepted.get(), 1);
+        }
+        received += RecvAll(ss, pair.accepted.get(), content.size() - kOffset - received.size());
+        close(fd);
+        CHECK(received == content.substr(kOffset));
+    }
+
+    TEST_CASE("send zero copy")
+    {
+        sled::PhysicalSocketServer ss;
+        TcpPair pair(ss);
+        REQUIRE(pair.accepted);
+
+        const std::string payload(64 * 1024, 'z');
+        int64_t send_id = 0;
+        // without OPT_ZEROCOPY the data is copied and nothing is pending
+        CHECK_EQ(pair.client->SendZeroCopy(payload.data(), 1024, &send_id), 1024);
+        CHECK_EQ(send_id, -1);
+        CHECK_EQ(RecvAll(ss, pair.accepted.get(), 1024).size(), 1024);
+
+        if (pair.client->SetOption(sled::Socket::OPT_ZEROCOPY, 1) != 0) { return; }
+        int sent = pair.client->SendZeroCopy(payload.data(), payload.size(), &send_id);
+        REQUIRE_GT(sent, 0);
+        CHECK_EQ(send_id, 0);
+        CHECK_EQ(RecvAll(ss, pair.accepted.get(), sent).size(), sent);
+        CHECK(WaitUntil(ss, [&] { return !pair.client_events.completed_sends.empty(); }));
+        CHECK_EQ(pair.client_events.completed_sends.front(), 0);
+    }
+
+    TEST_CASE("receive timestamps")
+    {
+        sled::PhysicalSocketServer ss;
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        int enabled = 0;
+        REQUIRE_EQ(receiver->GetOption(sled::Socket::OPT_TIMESTAMPNS, &enabled), 0);
+        CHECK_NE(enabled, 0);
+
+        const int64_t before_us = sled::TimeUTCMicros();
+        CHECK_EQ(sender->SendTo("ping", 4, receiver->GetLocalAddress()), 4);
+        char buf[16];
+        int64_t timestamp = 0;
+        int received = 0;
+        REQUIRE(WaitUntil(ss, [&] {
+            if (received <= 0) { received = receiver->Recv(buf, sizeof(buf), &timestamp); }
+            return received == 4;
+        }));
+        CHECK_GE(timestamp, before_us);
+        CHECK_LE(timestamp, sled::TimeUTCMicros());
+
+        // a failed read keeps its errno and reports no timestamp
+        CHECK_EQ(receiver->Recv(buf, sizeof(buf), &timestamp), -1);
+        CHECK(receiver->IsBlocking());
+        CHECK_EQ(timestamp, -1);
+
+        TcpPair pair(ss);
+        REQUIRE(pair.accepted);
+        const int64_t sent_us = sled::TimeUTCMicros();
+        CHECK_EQ(pair.client->Send("hello", 5), 5);
+        received = 0;
+        REQUIRE(WaitUntil(ss, [&] {
+            if (received <= 0) { received = pair.accepted->Recv(buf, sizeof(buf), &timestamp); }
+            return received == 5;
+        }));
+        CHECK_GE(timestamp, sent_us);
+        CHECK_LE(timestamp, sled::TimeUTCMicros());
+    }
+
+    TEST_CASE("socket stats")
+    {
+        sled::PhysicalSocketServer ss;
+        TcpPair pair(ss);
+        REQUIRE(pair.accepted);
+        const std::string payload(256 * 1024, 's');
+        size_t sent = 0;
+        std::string received;
+        while (received.size() < payload.size()) {
+            if (sent < payload.size()) {
+                int n = pair.client->Send(payload.data() + sent, payload.size() - sent);
+                if (n > 0) { sent += n; }
+            }
+            const std::string chunk = RecvAll(ss, pair.accepted.get(), 1);
+            if (chunk.empty()) { break; }
+            received += chunk;
+        }
+        REQUIRE_EQ(received.size(), payload.size());
+
+        sled::SocketStats client_stats;
+        sled::SocketStats accepted_stats;
+        REQUIRE_EQ(pair.client->GetStats(&client_stats), 0);
+        REQUIRE_EQ(pair.accepted->GetStats(&accepted_stats), 0);
+        CHECK_EQ(client_stats.bytes_sent, payload.size());
+        CHECK_EQ(client_stats.bytes_received, 0);
+        CHECK_EQ(accepted_stats.bytes_received, payload.size());
+        CHECK_GT(client_stats.packets_sent, 0);
+        CHECK_GT(accepted_stats.packets_received, 0);
+        CHECK_GE(client_stats.rtt_us, 0);
+        CHECK_GE(client_stats.rtt_var_us, 0);
+        CHECK_GT(client_stats.cwnd, 0);
+        CHECK_GE(client_stats.retransmits, 0);
+
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        sled::Datagram datagram;
+        datagram.data.SetSize(2500);
+        datagram.addr = receiver->GetLocalAddress();
+        datagram.segment_size = 1000;
+        CHECK_EQ(sender->SendToBatch(&datagram, 1), 1);
+        CHECK_EQ(sender->SendTo("x", 1, receiver->GetLocalAddress()), 1);
+        sled::Datagram in[8];
+        REQUIRE(WaitUntil(ss, [&] {
+            receiver->RecvFromBatch(in, 8);
+            sled::SocketStats stats;
+            receiver->GetStats(&stats);
+            return stats.packets_received == 4;
+        }));
+
+        sled::SocketStats sender_stats;
+        sled::SocketStats receiver_stats;
+        REQUIRE_EQ(sender->GetStats(&sender_stats), 0);
+        REQUIRE_EQ(receiver->GetStats(&receiver_stats), 0);
+        CHECK_EQ(sender_stats.bytes_sent, 2501);
+        CHECK_EQ(sender_stats.packets_sent, 4);
+        CHECK_EQ(receiver_stats.bytes_received, 2501);
+        CHECK_EQ(sender_stats.rtt_us, -1);
+        CHECK_EQ(sender_stats.cwnd, -1);
+    }
+
+    TEST_CASE("unix stream")
+    {
+        const sled::SocketAddress abstract_addr
+            = sled::SocketAddress::AbstractUnix("sled_test_" + std::to_string(getpid()));
+        CHECK(abstract_addr.IsUnix());
+        CHECK(abstract_addr.IsAbstractUnix());
+        CHECK_EQ(abstract_addr.family(), AF_UNIX);
+        CHECK(abstract_addr.IsComplete());
+        char dir[] = "/tmp/sled_unix_XXXXXX";
+        REQUIRE(mkdtemp(dir));
+        const std::string path = std::string(dir) + "/socket";
+        const sled::SocketAddress path_addr = sled::SocketAddress::UnixPath(path);
+        CHECK_FALSE(path_addr.IsAbstractUnix());
+        CHECK_NE(path_addr, abstract_addr);
+
+        for (const sled::SocketAddress &addr : {abstract_addr, path_addr}) {
+            sled::PhysicalSocketServer ss;
+            SocketEventRecorder server_events;
+            std::unique_ptr<sled::Socket> server(ss.CreateSocket(AF_UNIX, SOCK_STREAM));
+            REQUIRE(server);
+            server_events.Watch(server.get());
+            REQUIRE_EQ(server->Bind(addr), 0);
+            REQUIRE_EQ(server->Listen(5), 0);
+            CHECK_EQ(server->GetLocalAddress(), addr);
+
+            std::unique_ptr<sled::Socket> client(ss.CreateSocket(AF_UNIX, SOCK_STREAM));
+            REQUIRE(client);
+            CHECK_EQ(client->Connect(addr), 0);
+            REQUIRE(WaitUntil(ss, [&] { return server_events.read_events > 0; }));
+            sled::SocketAddress remote;
+            std::unique_ptr<sled::Socket> accepted(server->Accept(&remote));
+            REQUIRE(accepted);
+            // the client never bound, so it has no name
+            CHECK(remote.IsUnix());
+            CHECK(remote.unix_path().empty());
+            CHECK(WaitUntil(ss, [&] { return client->GetState() == sled::Socket::CS_CONNECTED; }));
+            CHECK_EQ(client->GetRemoteAddress(), addr);
+
+            CHECK_EQ(client->Send("hello", 5), 5);
+            CHECK_EQ(RecvAll(ss, accepted.get(), 5), "hello");
+            sled::SocketStats stats;
+            REQUIRE_EQ(accepted->GetStats(&stats), 0);
+            CHECK_EQ(stats.bytes_received, 5);
+            CHECK_EQ(stats.rtt_us, -1);
+        }
+        unlink(path.c_str());
+        rmdir(dir);
+    }
+
+    TEST_CASE("unix datagram")
+    {
+        sled::PhysicalSocketServer ss;
+        const std::string name = "sled_test_dgram_" + std::to_string(getpid());
+        std::unique_ptr<sled::Socket> receiver(ss.CreateSocket(AF_UNIX, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> sender(ss.CreateSocket(AF_UNIX, SOCK_DGRAM));
+        REQUIRE_EQ(receiver->Bind(sled::SocketAddress::AbstractUnix(name)), 0);
+        REQUIRE_EQ(sender->Bind(sled::SocketAddress::AbstractUnix(name + "_sender")), 0);
+
+        CHECK_EQ(sender->SendTo("ping", 4, sled::SocketAddress::AbstractUnix(name)), 4);
+        char buf[16];
+        sled::SocketAddress from;
+        int received = 0;
+        REQUIRE(WaitUntil(ss, [&] {
+            if (received <= 0) { received = receiver->RecvFrom(buf, sizeof(buf), &from, nullptr); }
+            return received == 4;
+        }));
+        CHECK_EQ(from, sled::SocketAddress::AbstractUnix(name + "_sender"));
+        CHECK_EQ(std::string(buf, 4), "ping");
+    }
+
+    TEST_CASE("unix fd passing")
+    {
+        sled::PhysicalSocketServer ss;
+        int sv[2];
+        REQUIRE_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        std::unique_ptr<sled::Socket> a(ss.WrapSocket(sv[0]));
+        std::unique_ptr<sled::Socket> b(ss.WrapSocket(sv[1]));
+        REQUIRE(a);
+        REQUIRE(b);
+        CHECK(a->GetLocalAddress().IsUnix());
+
+        int pipe_fds[2];
+        REQUIRE_EQ(pipe(pipe_fds), 0);
+        CHECK_EQ(a->SendWithFds("f", 1, &pipe_fds[1], 1), 1);
+        close(pipe_fds[1]);
+
+        char c = 0;
+        int fds[4] = {-1, -1, -1, -1};
+        size_t fd_count = 4;
+        int received = 0;
+        REQUIRE(WaitUntil(ss, [&] {
+            if (received <= 0) { received = b->RecvWithFds(&c, 1, fds, &fd_count); }
+            return received == 1;
+        }));
+        CHECK_EQ(c, 'f');
+        REQUIRE_EQ(fd_count, 1);
+        // the received descriptor is a new one for the same pipe
+        CHECK_EQ(write(fds[0], "x", 1), 1);
+        char x = 0;
+        CHECK_EQ(read(pipe_fds[0], &x, 1), 1);
+        CHECK_EQ(x, 'x');
+        close(fds[0]);
+        close(pipe_fds[0]);
+
+        sled::PhysicalSocketServer tcp_ss;
+        TcpPair pair(tcp_ss);
+        REQUIRE(pair.client);
+        CHECK_EQ(pair.client->SendWithFds("f", 1, &sv[0], 1), -1);
+        CHECK_EQ(pair.client->GetError(), EOPNOTSUPP);
+    }
+}
@@ -0,0 +1,118 @@
+#include "sled/network/reactor_group.h"
+#include "sled/log/log.h"
+#include "sled/network/socket_server.h"
+#include <cerrno>
+#include <cstring>
+
+namespace sled {
+
+class ReactorGroup::Reactor : public sigslot::has_slots<> {
+public:
+    // bounds the accept loop so one busy listener can't starve the rest of the reactor
+    static constexpr int kMaxAcceptsPerEvent = 64;
+
+    Reactor(ReactorGroup *group, std::unique_ptr<Thread> thread) : group_(group), thread_(std::move(thread))
+    {
+        thread_->Start();
+    }
+
+    ~Reactor() override { thread_->Stop(); }
+
+    Thread *thread() const { return thread_.get(); }
+
+    SocketAddress local_address() const { return local_address_; }
+
+    // runs on thread(), returns 0 or the socket error
+    int Listen(const SocketAddress &addr, int backlog)
+    {
+        std::unique_ptr<Socket> listener(thread_->socketserver()->CreateSocket(addr.family(), SOCK_STREAM));
+        if (!listener) { return errno; }
+        if (listener->SetOption(Socket::OPT_REUSEADDR, 1) != 0 || listener->SetOption(Socket::OPT_REUSEPORT, 1) != 0) {
+            // an option the platform lacks fails before any syscall, with no error set
+            return listener->GetError() != 0 ? listener->GetError() : ENOPROTOOPT;
+        }
+        if (listener->Bind(addr) != 0 || listener->Listen(backlog) != 0) { return listener->GetError(); }
+        listener->SignalReadEvent.connect(this, &Reactor::OnAcceptEvent);
+        local_address_ = listener->GetLocalAddress();
+        listener_ = std::move(listener);
+        return 0;
+    }
+
+    // runs on thread()
+    void StopListening() { listener_.reset(); }
+
+private:
+    void OnAcceptEvent(Socket *listener)
+    {
+        for (int i = 0; i < kMaxAcceptsPerEvent; ++i) {
+            SocketAddress remote_addr;
+            std::unique_ptr<Socket> socket(listener->Accept(&remote_addr));
+            if (!socket) { break; }
+            group_->accept_handler_(thread_.get(), std::move(socket), remote_addr);
+        }
+    }
+
+    ReactorGroup *const group_;
+    std::unique_ptr<Thread> thread_;
+    std::unique_ptr<Socket> listener_;
+    SocketAddress local_address_;
+};
+
+ReactorGroup::ReactorGroup(int num_reactors) : ReactorGroup(num_reactors, CreateDefaultSocketServer) {}
+
+ReactorGroup::ReactorGroup(int num_reactors, const SocketServerFactory &factory) : next_reactor_(0), error_(0)
+{
+    if (num_reactors <= 0) { num_reactors = std::max<int>(1, std::thread::hardware_concurrency()); }
+    reactors_.reserve(num_reactors);
+    for (int i = 0; i < num_reactors; ++i) {
+        reactors_.emplace_back(new Reactor(this, std::unique_ptr<Thread>(new Thread(factory()))));
+    }
+}
+
+ReactorGroup::~ReactorGroup() { StopListening(); }
+
+bool
+ReactorGroup::Listen(const SocketAddress &addr, AcceptHandler handler, int backlog)
+{
+    StopListening();
+    accept_handler_ = std::move(handler);
+
+    SocketAddress bind_addr = addr;
+    for (auto &reactor : reactors_) {
+        int err = reactor->thread()->BlockingCall([&] { return reactor->Listen(bind_addr, backlog); });
+        if (err != 0) {
+            LOGE("ReactorGroup", "listen failed: {}", strerror(err));
+            StopListening();
+            error_ = err;
+            return false;
+        }
+        // the remaining listeners share the port the kernel picked for the first one
+        if (bind_addr.port() == 0) { bind_addr.SetPort(reactor->local_address().port()); }
+    }
+    local_address_ = bind_addr;
+    error_ = 0;
+    return true;
+}
+
+void
+ReactorGroup::StopListening()
+{
+    for (auto &reactor : reactors_) {
+        reactor->thread()->BlockingCall([&] { reactor->StopListening(); });
+    }
+    local_address_ = SocketAddress();
+}
+
+Thread *
+ReactorGroup::reactor(size_t index) const
+{
+    return reactors_[index % reactors_.size()]->thread();
+}
+
+Thread *
+ReactorGroup::NextReactor()
+{
+    return reactor(next_reactor_.fetch_add(1, std::memory_order_relaxed));
+}
+
+}// namespace sled
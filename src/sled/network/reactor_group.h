@@ -0,0 +1,71 @@
+/**
+ * @file     : reactor_group
+ * @created  : Saturday Oct 17, 2026 14:05:12 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_REACTOR_GROUP_H
+#define SLED_NETWORK_REACTOR_GROUP_H
+#pragma once
+
+#include "sled/network/socket.h"
+#include "sled/network/socket_address.h"
+#include "sled/network/socket_server.h"
+#include "sled/system/thread.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sled {
+
+/**
+ * N reactor threads, each running its own PhysicalSocketServer. Listen()
+ * binds one SO_REUSEPORT listener per reactor so the kernel spreads incoming
+ * connections across them; an accepted socket stays on the reactor which
+ * accepted it and must only be used (and destroyed) on that thread.
+ **/
+class ReactorGroup final {
+public:
+    // called on the owning reactor thread, `reactor` is Thread::Current()
+    using AcceptHandler
+        = std::function<void(Thread *reactor, std::unique_ptr<Socket> socket, const SocketAddress &remote_addr)>;
+    using SocketServerFactory = std::function<std::unique_ptr<SocketServer>()>;
+
+    /**
+    * @param num_reactors The number of reactor threads. If -1, the number of
+    * reactors will be equal to the number of hardware threads
+    **/
+    ReactorGroup(int num_reactors = -1);
+    // every reactor runs a SocketServer made by `factory` instead of a PhysicalSocketServer
+    ReactorGroup(int num_reactors, const SocketServerFactory &factory);
+    ~ReactorGroup();
+
+    // returns false if any of the listeners failed, none are left open then
+    bool Listen(const SocketAddress &addr, AcceptHandler handler, int backlog = SOMAXCONN);
+    void StopListening();
+    // the error the last failed Listen() saw, 0 after one that succeeded
+    int GetError() const { return error_; }
+
+    // the bound address, with the port filled in when Listen() asked for 0
+    SocketAddress local_address() const { return local_address_; }
+
+    size_t size() const { return reactors_.size(); }
+
+    Thread *reactor(size_t index) const;
+    // round robin, for sockets not created by Listen()
+    Thread *NextReactor();
+
+private:
+    class Reactor;
+
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::atomic<size_t> next_reactor_;
+    AcceptHandler accept_handler_;
+    SocketAddress local_address_;
+    int error_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_REACTOR_GROUP_H
@@ -0,0 +1,109 @@
+#include <arpa/inet.h>
+#include <set>
+#include <sled/network/physical_socket_server.h>
+#include <sled/network/reactor_group.h>
+#include <sled/synchronization/mutex.h>
+#include <unistd.h>
+
+namespace {
+int
+ConnectBlocking(const sled::SocketAddress &addr)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sin{};
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(addr.port());
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&sin), sizeof(sin)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// fails OPT_REUSEPORT the way PhysicalSocket does where SO_REUSEPORT isn't defined
+class NoReusePortSocket : public sled::SocketDispatcher {
+public:
+    using sled::SocketDispatcher::SocketDispatcher;
+
+    int SetOption(Option opt, int value) override
+    {
+        if (opt == OPT_REUSEPORT) { return -1; }
+        return sled::SocketDispatcher::SetOption(opt, value);
+    }
+};
+
+class NoReusePortSocketServer : public sled::PhysicalSocketServer {
+public:
+    sled::Socket *CreateSocket(int family, int type) override
+    {
+        NoReusePortSocket *socket = new NoReusePortSocket(this);
+        if (socket->Create(family, type)) { return socket; }
+        delete socket;
+        return nullptr;
+    }
+};
+}// namespace
+
+TEST_SUITE("ReactorGroup")
+{
+    TEST_CASE("reuseport listeners spread accepts across reactors")
+    {
+        constexpr int kConnections = 64;
+        sled::ReactorGroup group(4);
+        REQUIRE_EQ(group.size(), 4);
+
+        sled::Mutex mutex;
+        std::set<sled::Thread *> reactors;
+        std::atomic<int> accepted(0);
+        std::atomic<int> wrong_thread(0);
+        REQUIRE(group.Listen(sled::SocketAddress("127.0.0.1", 0),
+                             [&](sled::Thread *reactor, std::unique_ptr<sled::Socket> socket,
+                                 const sled::SocketAddress &) {
+                                 if (!reactor->IsCurrent()) { ++wrong_thread; }
+                                 {
+                                     sled::MutexLock lock(&mutex);
+                                     reactors.insert(reactor);
+                                 }
+                                 ++accepted;
+                             }));
+        REQUIRE_NE(group.local_address().port(), 0);
+
+        std::vector<int> clients;
+        for (int i = 0; i < kConnections; ++i) {
+            int fd = ConnectBlocking(group.local_address());
+            REQUIRE_GE(fd, 0);
+            clients.push_back(fd);
+        }
+        for (int i = 0; i < 200 && accepted.load() < kConnections; ++i) { sled::Thread::SleepMs(10); }
+        CHECK_EQ(accepted.load(), kConnections);
+        CHECK_EQ(wrong_thread.load(), 0);
+        {
+            sled::MutexLock lock(&mutex);
+            CHECK_GT(reactors.size(), 1);
+        }
+
+        group.StopListening();
+        CHECK_LT(ConnectBlocking(group.local_address()), 0);
+        for (int fd : clients) { ::close(fd); }
+    }
+
+    TEST_CASE("listen fails without SO_REUSEPORT")
+    {
+        sled::ReactorGroup group(2, [] {
+            return std::unique_ptr<sled::SocketServer>(new NoReusePortSocketServer());
+        });
+        CHECK_FALSE(group.Listen(sled::SocketAddress("127.0.0.1", 0),
+                                 [](sled::Thread *, std::unique_ptr<sled::Socket>, const sled::SocketAddress &) {}));
+        CHECK_EQ(group.GetError(), ENOPROTOOPT);
+        CHECK(group.local_address().IsNil());
+    }
+
+    TEST_CASE("next reactor")
+    {
+        sled::ReactorGroup group(2);
+        sled::Thread *first = group.NextReactor();
+        CHECK_NE(first, group.NextReactor());
+        CHECK_EQ(first, group.NextReactor());
+    }
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <sled/network/reactor_group.h>
+#include <sled/network/rpc_socket_connection.h>
+#include <sled/network/socket_server.h>
+#include <sled/synchronization/event.h>
+#include <sled/time_utils.h>
+
+// an echo rpc over loopback TCP, the server on a reactor, the client on its own thread
+struct RpcLoopback {
+    RpcLoopback() : group(1)
+    {
+        group.Listen(sled::SocketAddress("127.0.0.1", 0),
+                     [this](sled::Thread *reactor, std::unique_ptr<sled::Socket> socket, const sled::SocketAddress &) {
+                         server = sled::rpc::create(
+                             std::make_shared<sled::RpcSocketConnection>(reactor, socket.release()));
+                         server->set_timer(sled::RpcSocketConnection::TimerOn(reactor));
+                         server->subscribe("echo", [](const std::string &s) { return s; });
+                         server->set_ready(true);
+                     });
+        client_thread = sled::Thread::CreateWithSocketServer();
+        client_thread->Start();
+        client_thread->BlockingCall([this] {
+            sled::Socket *socket = client_thread->socketserver()->CreateSocket(AF_INET, SOCK_STREAM);
+            socket->Connect(group.local_address());
+            client = sled::rpc::create(std::make_shared<sled::RpcSocketConnection>(client_thread.get(), socket));
+            client->set_timer(sled::RpcSocketConnection::TimerOn(client_thread.get()));
+            client->set_ready(true);
+        });
+    }
+
+    ~RpcLoopback()
+    {
+        client_thread->BlockingCall([this] { client.reset(); });
+        group.reactor(0)->BlockingCall([this] { server.reset(); });
+    }
+
+    // keeps `depth` requests in flight until `count` were answered, returns the latencies in us
+    std::vector<int64_t> Run(int count, int depth)
+    {
+        std::vector<int64_t> latencies;
+        latencies.reserve(count);
+        sled::Event done;
+        int sent = 0;
+        std::function<void()> send_one = [&] {
+            const int64_t start = sled::TimeMicros();
+            ++sent;
+            client->cmd("echo")
+                ->msg(payload)
+                ->rsp([&, start](const std::string &) {
+                    latencies.push_back(sled::TimeMicros() - start);
+                    if (sent < count) { send_one(); }
+                    if (static_cast<int>(latencies.size()) == count) { done.Set(); }
+                })
+                ->call();
+        };
+        client_thread->PostTask([&] {
+            for (int i = 0; i < depth && sent < count; ++i) { send_one(); }
+        });
+        done.Wait(sled::Event::kForever);
+        return latencies;
+    }
+
+    sled::ReactorGroup group;
+    std::unique_ptr<sled::Thread> client_thread;
+    std::shared_ptr<sled::rpc> client;
+    std::shared_ptr<sled::rpc> server;
+    std::string payload = std::string(64, 'r');
+};
+
+// one iteration is one request, the result is the p99 latency in microseconds (see -out-fmt=csv)
+static void
+RpcSocketEcho(picobench::state &s, int depth)
+{
+    RpcLoopback loopback;
+    // warm up the connection
+    loopback.Run(depth, depth);
+    s.start_timer();
+    std::vector<int64_t> latencies = loopback.Run(s.iterations(), depth);
+    s.stop_timer();
+    std::sort(latencies.begin(), latencies.end());
+    s.set_result(latencies[latencies.size() * 99 / 100]);
+}
+
+static void
+RpcSocketEchoDepth1(picobench::state &s)
+{
+    RpcSocketEcho(s, 1);
+}
+
+static void
+RpcSocketEchoDepth16(picobench::state &s)
+{
+    RpcSocketEcho(s, 16);
+}
+
+static void
+RpcSocketEchoDepth256(picobench::state &s)
+{
+    RpcSocketEcho(s, 256);
+}
+
+PICOBENCH_SUITE("RPC");
+PICOBENCH(RpcSocketEchoDepth1);
+PICOBENCH(RpcSocketEchoDepth16);
+PICOBENCH(RpcSocketEchoDepth256);
@@ -0,0 +1,178 @@
+#include "sled/network/rpc_socket_connection.h"
+#include "sled/byte_order.h"
+#include "sled/log/log.h"
+#include "sled/units/time_delta.h"
+#include <algorithm>
+#include <cstring>
+
+namespace sled {
+
+namespace {
+const size_t kHeaderSize = 4;
+// the tail goes to the write queue once it grows past this
+const size_t kCoalesceSize = 64 * 1024;
+const size_t kReadSize = 64 * 1024;
+}// namespace
+
+RpcSocketConnection::RpcSocketConnection(TaskQueueBase *task_queue, Socket *socket, size_t max_package_size)
+    : task_queue_(task_queue),
+      socket_(socket),
+      max_package_size_(max_package_size),
+      safety_flag_(PendingTaskSafetyFlag::Create())
+{
+    SLED_DCHECK(task_queue_->IsCurrent(), "must be created on the socket thread");
+    // small packages are batched here, don't let Nagle delay them again
+    socket_->SetOption(Socket::OPT_NODELAY, 1);
+    socket_->SignalConnectEvent.connect(this, &RpcSocketConnection::OnConnectEvent);
+    socket_->SignalReadEvent.connect(this, &RpcSocketConnection::OnReadEvent);
+    socket_->SignalWriteEvent.connect(this, &RpcSocketConnection::OnWriteEvent);
+    socket_->SignalCloseEvent.connect(this, &RpcSocketConnection::OnCloseEvent);
+    send_package_impl = [this](std::string package) { SendPackage(package); };
+}
+
+RpcSocketConnection::~RpcSocketConnection()
+{
+    safety_flag_->SetNotAlive();
+    Close();
+}
+
+rpc_core::detail::msg_dispatcher::timer_impl
+RpcSocketConnection::TimerOn(TaskQueueBase *task_queue)
+{
+    return [task_queue](uint32_t ms, rpc_core::detail::msg_dispatcher::timeout_cb cb) {
+        task_queue->PostDelayedTask(std::move(cb), TimeDelta::Millis(ms));
+    };
+}
+
+void
+RpcSocketConnection::Close()
+{
+    if (closed_) { return; }
+    closed_ = true;
+    write_tail_.Clear();
+    write_queue_.Clear();
+    socket_->Close();
+}
+
+bool
+RpcSocketConnection::connected() const
+{
+    return !closed_ && socket_->GetState() == Socket::CS_CONNECTED;
+}
+
+void
+RpcSocketConnection::SendPackage(const std::string &package)
+{
+    SLED_DCHECK(task_queue_->IsCurrent(), "rpc used off the socket thread");
+    if (closed_) { return; }
+    if (package.size() > max_package_size_) {
+        LOGW("RpcSocketConnection", "drop package of {} bytes, limit is {}", package.size(), max_package_size_);
+        return;
+    }
+
+    const uint32_t header = HostToNetwork32(static_cast<uint32_t>(package.size()));
+    write_tail_.AppendData(reinterpret_cast<const uint8_t *>(&header), kHeaderSize);
+    write_tail_.AppendData(package.data(), package.size());
+    if (write_tail_.size() >= kCoalesceSize) { write_queue_.Append(std::move(write_tail_)); }
+
+    // everything sent until the posted task runs leaves with one SendV()
+    if (!flush_posted_) {
+        flush_posted_ = true;
+        task_queue_->PostTask(SafeTask(safety_flag_, [this] {
+            flush_posted_ = false;
+            Flush();
+        }));
+    }
+}
+
+void
+RpcSocketConnection::Flush()
+{
+    if (closed_ || socket_->GetState() != Socket::CS_CONNECTED) { return; }
+    if (!write_tail_.empty()) { write_queue_.Append(std::move(write_tail_)); }
+    while (!write_queue_.empty()) {
+        int sent = socket_->SendV(write_queue_);
+        if (sent < 0) {
+            // the rest goes out on the next write event
+            if (socket_->IsBlocking()) { return; }
+            CloseWithError(socket_->GetError());
+            return;
+        }
+        write_queue_.Consume(sent);
+    }
+}
+
+void
+RpcSocketConnection::OnConnectEvent(Socket *socket)
+{
+    Flush();
+}
+
+void
+RpcSocketConnection::OnReadEvent(Socket *socket)
+{
+    while (!closed_) {
+        const size_t offset = read_buffer_.size();
+        read_buffer_.SetSize(offset + kReadSize);
+        int received = socket_->Recv(read_buffer_.data() + offset, kReadSize, nullptr);
+        read_buffer_.SetSize(offset + std::max(received, 0));
+        if (received == 0) {
+            CloseWithError(0);
+            return;
+        }
+        if (received < 0) {
+            if (!socket_->IsBlocking()) { CloseWithError(socket_->GetError()); }
+            return;
+        }
+        DeliverPackages();
+    }
+}
+
+void
+RpcSocketConnection::DeliverPackages()
+{
+    size_t consumed = 0;
+    while (!closed_ && read_buffer_.size() - consumed >= kHeaderSize) {
+        uint32_t header;
+        std::memcpy(&header, read_buffer_.data() + consumed, kHeaderSize);
+        const size_t package_size = NetworkToHost32(header);
+        if (package_size > max_package_size_) {
+            LOGE("RpcSocketConnection", "package of {} bytes exceeds the limit of {}", package_size,
+                 max_package_size_);
+            CloseWithError(EMSGSIZE);
+            return;
+        }
+        if (read_buffer_.size() - consumed < kHeaderSize + package_size) { break; }
+        const char *begin = reinterpret_cast<const char *>(read_buffer_.data() + consumed + kHeaderSize);
+        consumed += kHeaderSize + package_size;
+        on_recv_package(std::string(begin, package_size));
+    }
+    if (closed_) { return; }
+
+    // keep the partial package for the next read
+    const size_t left = read_buffer_.size() - consumed;
+    if (consumed > 0 && left > 0) { std::memmove(read_buffer_.data(), read_buffer_.data() + consumed, left); }
+    read_buffer_.SetSize(left);
+}
+
+void
+RpcSocketConnection::OnWriteEvent(Socket *socket)
+{
+    Flush();
+}
+
+void
+RpcSocketConnection::OnCloseEvent(Socket *socket, int error)
+{
+    CloseWithError(error);
+}
+
+void
+RpcSocketConnection::CloseWithError(int error)
+{
+    if (closed_) { return; }
+    Close();
+    SignalClosed(this, error);
+}
+
+}// namespace sled
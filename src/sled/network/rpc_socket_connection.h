@@ -0,0 +1,85 @@
+/**
+ * @file     : rpc_socket_connection
+ * @created  : Saturday Oct 17, 2026 20:31:47 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_RPC_SOCKET_CONNECTION_H
+#define SLED_NETWORK_RPC_SOCKET_CONNECTION_H
+#pragma once
+
+#include "sled/buffer.h"
+#include "sled/buffer_chain.h"
+#include "sled/network/rpc.h"
+#include "sled/network/socket.h"
+#include "sled/sigslot.h"
+#include "sled/task_queue/pending_task_safety_flag.h"
+#include "sled/task_queue/task_queue_base.h"
+#include <memory>
+
+namespace sled {
+
+/**
+ * Carries rpc_core packages over a stream socket, each one prefixed with its
+ * length as a 4 byte big endian integer. rpc_core matches responses by seq,
+ * so any number of requests can be in flight on one connection.
+ *
+ * Packages sent within one task are coalesced and written with a single
+ * SendV() from a task posted to `task_queue`, which must be the thread
+ * delivering the socket events. Create, use and destroy the connection (and
+ * the rpc on top of it) on that thread.
+ *
+ *   auto conn = std::make_shared<RpcSocketConnection>(thread, socket);
+ *   auto rpc = rpc::create(conn);
+ *   rpc->set_timer(RpcSocketConnection::TimerOn(thread));
+ *   rpc->set_ready(true);
+ **/
+class RpcSocketConnection : public rpc_core::connection, public sigslot::has_slots<> {
+public:
+    static constexpr size_t kDefaultMaxPackageSize = 16 * 1024 * 1024;
+
+    // takes ownership of `socket`, which may still be connecting
+    RpcSocketConnection(TaskQueueBase *task_queue, Socket *socket, size_t max_package_size = kDefaultMaxPackageSize);
+    ~RpcSocketConnection() override;
+
+    // an rpc timer which fires on `task_queue`, for rpc::set_timer()
+    static rpc_core::detail::msg_dispatcher::timer_impl TimerOn(TaskQueueBase *task_queue);
+
+    void Close();
+
+    bool connected() const;
+
+    Socket *socket() const { return socket_.get(); }
+
+    // bytes framed but not accepted by the socket yet
+    size_t pending_write_size() const { return write_queue_.size() + write_tail_.size(); }
+
+    // the peer closed, the socket failed or a package exceeded the size limit
+    sigslot::signal2<RpcSocketConnection *, int> SignalClosed;
+
+private:
+    void SendPackage(const std::string &package);
+    void Flush();
+    void OnConnectEvent(Socket *socket);
+    void OnReadEvent(Socket *socket);
+    // hands every complete package in read_buffer_ to on_recv_package
+    void DeliverPackages();
+    void OnWriteEvent(Socket *socket);
+    void OnCloseEvent(Socket *socket, int error);
+    void CloseWithError(int error);
+
+    TaskQueueBase *const task_queue_;
+    std::unique_ptr<Socket> socket_;
+    const size_t max_package_size_;
+    bool closed_ = false;
+    bool flush_posted_ = false;
+    // frames are appended to the tail until it is large enough to be queued
+    Buffer write_tail_;
+    BufferChain write_queue_;
+    Buffer read_buffer_;
+    scoped_refptr<PendingTaskSafetyFlag> safety_flag_;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_RPC_SOCKET_CONNECTION_H
@@ -1,8 +1,69 @@
+#include <atomic>
 #include <sled/lang/attributes.h>
+#include <sled/network/reactor_group.h>
 #include <sled/network/rpc.h>
+#include <sled/network/rpc_socket_connection.h>
+#include <sled/network/socket_server.h>
 #include <sled/random.h>
 #include <sled/time_utils.h>
 
+namespace {
+// an rpc over loopback TCP, the server half runs on a ReactorGroup
+struct RpcSocketPair {
+    explicit RpcSocketPair(std::function<void(sled::rpc &)> setup_server) : group(1)
+    {
+        group.Listen(sled::SocketAddress("127.0.0.1", 0),
+                     [this, setup_server](sled::Thread *reactor, std::unique_ptr<sled::Socket> socket,
+                                          const sled::SocketAddress &) {
+                         if (!setup_server) {
+                             raw_server_socket = std::move(socket);
+                             return;
+                         }
+                         server = sled::rpc::create(
+                             std::make_shared<sled::RpcSocketConnection>(reactor, socket.release()));
+                         server->set_timer(sled::RpcSocketConnection::TimerOn(reactor));
+                         setup_server(*server);
+                         server->set_ready(true);
+                     });
+        client_thread = sled::Thread::CreateWithSocketServer();
+        client_thread->Start();
+        client_thread->BlockingCall([this] {
+            sled::Socket *socket = client_thread->socketserver()->CreateSocket(AF_INET, SOCK_STREAM);
+            socket->Connect(group.local_address());
+            client_conn = std::make_shared<sled::RpcSocketConnection>(client_thread.get(), socket);
+            client = sled::rpc::create(client_conn);
+            client->set_timer(sled::RpcSocketConnection::TimerOn(client_thread.get()));
+            client->set_ready(true);
+        });
+    }
+
+    ~RpcSocketPair()
+    {
+        client_thread->BlockingCall([this] {
+            client.reset();
+            client_conn.reset();
+        });
+        group.reactor(0)->BlockingCall([this] {
+            server.reset();
+            raw_server_socket.reset();
+        });
+    }
+
+    sled::ReactorGroup group;
+    std::unique_ptr<sled::Thread> client_thread;
+    std::shared_ptr<sled::RpcSocketConnection> client_conn;
+    std::shared_ptr<sled::rpc> client;
+    std::shared_ptr<sled::rpc> server;
+    std::unique_ptr<sled::Socket> raw_server_socket;
+};
+
+void
+WaitFor(const std::function<bool()> &done)
+{
+    for (int i = 0; i < 500 && !done(); ++i) { sled::Thread::SleepMs(10); }
+}
+}// namespace
+
 TEST_SUITE("RPC")
 {
     TEST_CASE("loopback")
@@ -30,4 +91,89 @@ TEST_SUITE("RPC")
             ->rsp([random_value](int x) { CHECK_EQ(x, random_value + 1); })
             ->call();
     }
+
+    TEST_CASE("socket pipelining")
+    {
+        constexpr int kRequests = 1000;
+        RpcSocketPair pair([](sled::rpc &server) { server.subscribe("cmd", [](int x) { return x + 1; }); });
+
+        std::atomic<int> responses(0);
+        std::atomic<int> mismatches(0);
+        // all requests are in flight before the first flush
+        pair.client_thread->BlockingCall([&] {
+            for (int i = 0; i < kRequests; ++i) {
+                pair.client->cmd("cmd")
+                    ->msg(i)
+                    ->rsp([&, i](int x) {
+                        if (x != i + 1) { ++mismatches; }
+                        ++responses;
+                    })
+                    ->call();
+            }
+        });
+        WaitFor([&] { return responses.load() == kRequests; });
+        CHECK_EQ(responses.load(), kRequests);
+        CHECK_EQ(mismatches.load(), 0);
+    }
+
+    TEST_CASE("socket large package")
+    {
+        RpcSocketPair pair([](sled::rpc &server) {
+            server.subscribe("echo", [](const std::string &s) { return s; });
+        });
+
+        std::string payload(1024 * 1024, '\0');
+        for (size_t i = 0; i < payload.size(); ++i) { payload[i] = static_cast<char>('a' + i % 26); }
+        std::atomic<bool> echoed(false);
+        std::atomic<bool> equal(false);
+        pair.client_thread->BlockingCall([&] {
+            pair.client->cmd("echo")
+                ->msg(payload)
+                ->rsp([&](const std::string &s) {
+                    equal = s == payload;
+                    echoed = true;
+                })
+                ->call();
+        });
+        WaitFor([&] { return echoed.load(); });
+        CHECK(echoed.load());
+        CHECK(equal.load());
+    }
+
+    TEST_CASE("socket timeout")
+    {
+        // nothing answers on the server side
+        RpcSocketPair pair(nullptr);
+
+        std::atomic<bool> timed_out(false);
+        pair.client_thread->BlockingCall([&] {
+            pair.client->cmd("cmd")
+                ->msg(1)
+                ->rsp([](int) {})
+                ->timeout_ms(50)
+                ->finally([&](sled::request::finally_t t) { timed_out = t == sled::request::finally_t::timeout; })
+                ->call();
+        });
+        WaitFor([&] { return timed_out.load(); });
+        CHECK(timed_out.load());
+    }
+
+    TEST_CASE("socket peer close")
+    {
+        struct ClosedRecorder : public sigslot::has_slots<> {
+            void OnClosed(sled::RpcSocketConnection *, int) { closed = true; }
+
+            std::atomic<bool> closed{false};
+        } recorder;
+
+        RpcSocketPair pair(nullptr);
+        WaitFor([&] { return pair.group.reactor(0)->BlockingCall([&] { return pair.raw_server_socket != nullptr; }); });
+
+        pair.client_thread->BlockingCall(
+            [&] { pair.client_conn->SignalClosed.connect(&recorder, &ClosedRecorder::OnClosed); });
+        pair.group.reactor(0)->BlockingCall([&] { pair.raw_server_socket.reset(); });
+        WaitFor([&] { return recorder.closed.load(); });
+        CHECK(recorder.closed.load());
+        pair.client_thread->BlockingCall([&] { CHECK_FALSE(pair.client_conn->connected()); });
+    }
 }
@@ -8,9 +8,14 @@
 #define SLED_NETWORK_SOCKET_H
 #pragma once
 
+#include "sled/buffer.h"
+#include "sled/buffer_chain.h"
 #include "sled/network/socket_address.h"
 #include "sled/sigslot.h"
+#include <algorithm>
 #include <cerrno>
+#include <cstring>
+#include <unistd.h>
 
 #define INVALID_SOCKET (-1)
 #define SOCKET_ERROR (-1)
@@ -23,8 +28,34 @@ IsBlockingError(int e)
     return (e == EWOULDBLOCK || e == EAGAIN || e == EINPROGRESS);
 }
 
+struct Datagram {
+    Buffer data;
+    SocketAddress addr;
+    int64_t timestamp = -1;
+    // non-zero: data holds several datagrams of this size back to back (the
+    // last one may be shorter), sent with UDP GSO / received with UDP GRO
+    size_t segment_size = 0;
+};
+
+// see Socket::GetStats()
+struct SocketStats {
+    // payload bytes through this socket
+    int64_t bytes_sent = 0;
+    int64_t bytes_received = 0;
+    // datagrams, or TCP segments as counted by the kernel (0 if it doesn't)
+    int64_t packets_sent = 0;
+    int64_t packets_received = 0;
+    // TCP only, -1 when unknown
+    int64_t rtt_us = -1;// smoothed
+    int64_t rtt_var_us = -1;
+    int64_t cwnd = -1;// in segments
+    int64_t retransmits = -1;// segments retransmitted over the connection
+};
+
 class Socket {
 public:
+    static constexpr size_t kMaxDatagramSize = 64 * 1024;
+
     virtual ~Socket() = default;
 
     Socket(const Socket &) = delete;
@@ -37,8 +68,58 @@ public:
     virtual int Connect(const SocketAddress &addr) = 0;
     virtual int Send(const void *pv, size_t cb) = 0;
     virtual int SendTo(const void *pv, size_t cb, const SocketAddress &addr) = 0;
+    // *timestamp: when the kernel received the data, in UTC microseconds, -1 if unknown
     virtual int Recv(void *pv, size_t cb, int64_t *timestamp) = 0;
     virtual int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) = 0;
+    /**
+     * Gather write, the slices are sent as if they were one contiguous buffer.
+     * @return bytes sent, like Send()
+     **/
+    virtual int SendV(const BufferSlice *slices, size_t count);
+    // scatter read, like Recv() but fills the slices in order
+    virtual int RecvV(const MutableBufferSlice *slices, size_t count);
+    // sends from the front of the chain, Consume() what was sent
+    int SendV(const BufferChain &chain);
+
+    /**
+     * Receives up to `count` datagrams. Each data buffer is filled up to its
+     * capacity (kMaxDatagramSize when empty) and resized to what arrived.
+     * @return the number of datagrams read, -1 if none (see GetError())
+     **/
+    virtual int RecvFromBatch(Datagram *datagrams, size_t count);
+    /**
+     * Sends datagrams in order, stops at the first one that would block.
+     * The default sends the segments of a GSO datagram one by one, one
+     * that blocks after its first segment counts as sent and drops the
+     * rest, so the caller doesn't send the segments out twice.
+     * @return the number of datagrams sent, -1 if none (see GetError())
+     **/
+    virtual int SendToBatch(const Datagram *datagrams, size_t count);
+    /**
+     * Sends up to `length` bytes of file `fd` starting at `offset`, without
+     * reading them into user space where the socket supports it.
+     * @return bytes sent, like Send()
+     **/
+    virtual int SendFile(int fd, int64_t offset, size_t length);
+    /**
+     * Like Send(), but with OPT_ZEROCOPY the kernel transmits straight from
+     * `pv`, which must stay valid until SignalSendComplete reports `*send_id`.
+     * *send_id is -1 when the data was copied and nothing is pending.
+     **/
+    virtual int SendZeroCopy(const void *pv, size_t cb, int64_t *send_id);
+    /**
+     * AF_UNIX only, passes open file descriptors along with the data
+     * (SCM_RIGHTS). On a stream socket they ride on the first byte sent.
+     * @return bytes sent, like Send()
+     **/
+    virtual int SendWithFds(const void *pv, size_t cb, const int *fds, size_t fd_count);
+    /**
+     * Like Recv(). *fd_count is the room in `fds` on the way in and the number
+     * of descriptors received on the way out, the caller owns and closes them.
+     **/
+    virtual int RecvWithFds(void *pv, size_t cb, int *fds, size_t *fd_count);
+    // traffic counters and transport state, -1 if the socket keeps none
+    virtual int GetStats(SocketStats *stats);
     virtual int Listen(int backlog) = 0;
     virtual Socket *Accept(SocketAddress *paddr) = 0;
     virtual int Close() = 0;
@@ -59,6 +140,15 @@ public:
         OPT_IPV6_V6ONLY,// Whether the socket is IPv6 only
         OPT_DSCP,       // DSCP code
         OPT_RTP_SENDTIME_EXTN_ID,
+        OPT_REUSEADDR,// SO_REUSEADDR
+        OPT_REUSEPORT,// SO_REUSEPORT, must be set before Bind()
+        OPT_UDP_GRO,  // coalesce received datagrams, see Datagram::segment_size
+        OPT_ZEROCOPY, // SO_ZEROCOPY, enables the zero copy path of SendZeroCopy()
+        OPT_TIMESTAMPNS,// SO_TIMESTAMPNS, receive timestamps from the kernel, on by default
+        OPT_KEEPALIVE,  // SO_KEEPALIVE
+        OPT_KEEPIDLE,   // TCP_KEEPIDLE, seconds idle before the first probe
+        OPT_KEEPINTVL,  // TCP_KEEPINTVL, seconds between probes
+        OPT_KEEPCNT,    // TCP_KEEPCNT, unanswered probes before the connection is dropped
     };
 
     virtual int GetOption(Option opt, int *value) = 0;
@@ -67,11 +157,131 @@ public:
     sigslot::signal1<Socket *, sigslot::multi_threaded_local> SignalWriteEvent;
     sigslot::signal1<Socket *> SignalConnectEvent;
     sigslot::signal2<Socket *, int> SignalCloseEvent;
+    // a SendZeroCopy() buffer is no longer referenced by the kernel
+    sigslot::signal2<Socket *, int64_t> SignalSendComplete;
 
 protected:
     Socket() = default;
 };
 
+// copies through a contiguous buffer, sockets with writev()/readv() override these
+inline int
+Socket::SendV(const BufferSlice *slices, size_t count)
+{
+    if (count == 1) { return Send(slices[0].data, slices[0].size); }
+    Buffer buffer;
+    for (size_t i = 0; i < count; ++i) { buffer.AppendData(slices[i].data, slices[i].size); }
+    return Send(buffer.data(), buffer.size());
+}
+
+inline int
+Socket::RecvV(const MutableBufferSlice *slices, size_t count)
+{
+    if (count == 1) { return Recv(slices[0].data, slices[0].size, nullptr); }
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) { total += slices[i].size; }
+    Buffer buffer(total);
+    int received = Recv(buffer.data(), buffer.size(), nullptr);
+    size_t offset = 0;
+    for (size_t i = 0; i < count && received > 0 && offset < static_cast<size_t>(received); ++i) {
+        const size_t len = std::min(slices[i].size, static_cast<size_t>(received) - offset);
+        std::memcpy(slices[i].data, buffer.data() + offset, len);
+        offset += len;
+    }
+    return received;
+}
+
+inline int
+Socket::SendV(const BufferChain &chain)
+{
+    static const size_t kMaxSlices = 64;
+    BufferSlice slices[kMaxSlices];
+    const size_t count = chain.GetSlices(slices, kMaxSlices);
+    if (count == 0) { return 0; }
+    return SendV(slices, count);
+}
+
+inline int
+Socket::SendFile(int fd, int64_t offset, size_t length)
+{
+    uint8_t buf[16 * 1024];
+    const ssize_t nread = ::pread(fd, buf, std::min(length, sizeof(buf)), offset);
+    if (nread < 0) {
+        SetError(errno);
+        return SOCKET_ERROR;
+    }
+    return Send(buf, nread);
+}
+
+inline int
+Socket::SendZeroCopy(const void *pv, size_t cb, int64_t *send_id)
+{
+    if (send_id) { *send_id = -1; }
+    return Send(pv, cb);
+}
+
+inline int
+Socket::SendWithFds(const void *, size_t, const int *, size_t)
+{
+    SetError(EOPNOTSUPP);
+    return SOCKET_ERROR;
+}
+
+inline int
+Socket::RecvWithFds(void *, size_t, int *, size_t *)
+{
+    SetError(EOPNOTSUPP);
+    return SOCKET_ERROR;
+}
+
+inline int
+Socket::GetStats(SocketStats *)
+{
+    SetError(EOPNOTSUPP);
+    return SOCKET_ERROR;
+}
+
+// one datagram per RecvFrom()/SendTo(), sockets with a batched syscall override these
+inline int
+Socket::RecvFromBatch(Datagram *datagrams, size_t count)
+{
+    size_t n = 0;
+    for (; n < count; ++n) {
+        Datagram &datagram = datagrams[n];
+        if (datagram.data.capacity() == 0) { datagram.data.EnsureCapacity(kMaxDatagramSize); }
+        datagram.data.SetSize(datagram.data.capacity());
+        datagram.segment_size = 0;
+        int received = RecvFrom(datagram.data.data(), datagram.data.size(), &datagram.addr, &datagram.timestamp);
+        if (received < 0) {
+            datagram.data.Clear();
+            break;
+        }
+        datagram.data.SetSize(received);
+    }
+    return n > 0 ? static_cast<int>(n) : SOCKET_ERROR;
+}
+
+inline int
+Socket::SendToBatch(const Datagram *datagrams, size_t count)
+{
+    size_t n = 0;
+    for (; n < count; ++n) {
+        const Datagram &datagram = datagrams[n];
+        const size_t segment_size = datagram.segment_size > 0 ? datagram.segment_size : datagram.data.size();
+        size_t offset = 0;
+        do {
+            const size_t len = std::min(segment_size, datagram.data.size() - offset);
+            if (SendTo(datagram.data.data() + offset, len, datagram.addr) < 0) {
+                // the segments already sent are out, count the datagram with them
+                if (offset > 0) { ++n; }
+                return n > 0 ? static_cast<int>(n) : SOCKET_ERROR;
+            }
+            offset += len;
+        } while (offset < datagram.data.size());
+    }
+    return static_cast<int>(n);
+}
+
 }// namespace sled
 
 #endif// SLED_NETWORK_SOCKET_H
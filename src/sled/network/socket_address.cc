@@ -1,23 +1,30 @@
 #include "sled/network/socket_address.h"
 #include "sled/network/ip_address.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sys/un.h>
 
 namespace sled {
 
 SocketAddress::SocketAddress() { Clear(); }
 
 SocketAddress::SocketAddress(const std::string &hostname, int port)
+    : unix_(false)
 {
     SetIP(hostname);
     SetPort(port);
 }
 
 SocketAddress::SocketAddress(uint32_t ip_as_host_order_integer, int port)
+    : unix_(false)
 {
     SetIP(IPAddress(ip_as_host_order_integer));
     SetPort(port);
 }
 
 SocketAddress::SocketAddress(const IPAddress &ip, int port)
+    : unix_(false)
 {
     SetIP(ip);
     SetPort(port);
@@ -28,6 +35,26 @@ SocketAddress::SocketAddress(const SocketAddress &addr)
     this->operator=(addr);
 }
 
+SocketAddress
+SocketAddress::UnixPath(const std::string &path)
+{
+    SocketAddress addr;
+    addr.unix_ = true;
+    addr.unix_path_ = path;
+    return addr;
+}
+
+SocketAddress
+SocketAddress::AbstractUnix(const std::string &name)
+{
+    SocketAddress addr;
+    addr.unix_ = true;
+    addr.unix_path_.reserve(name.size() + 1);
+    addr.unix_path_.push_back('\0');
+    addr.unix_path_.append(name);
+    return addr;
+}
+
 void
 SocketAddress::Clear()
 {
@@ -36,17 +63,40 @@ SocketAddress::Clear()
     ip_ = IPAddress();
     port_ = 0;
     scope_id_ = 0;
+    unix_ = false;
+    unix_path_.clear();
 }
 
 bool
 SocketAddress::IsNil() const
 {
-    return hostname_.empty() && IPIsUnspec(ip_) && 0 == port_;
+    return !unix_ && hostname_.empty() && IPIsUnspec(ip_) && 0 == port_;
+}
+
+bool
+SocketAddress::operator==(const SocketAddress &addr) const
+{
+    if (unix_ || addr.unix_) { return unix_ == addr.unix_ && unix_path_ == addr.unix_path_; }
+    if (port_ != addr.port_) { return false; }
+    if (IPIsUnspec(ip_) && IPIsUnspec(addr.ip_)) { return hostname_ == addr.hostname_; }
+    return ip_ == addr.ip_;
+}
+
+bool
+SocketAddress::operator<(const SocketAddress &addr) const
+{
+    // IP addresses first
+    if (unix_ != addr.unix_) { return addr.unix_; }
+    if (unix_) { return unix_path_ < addr.unix_path_; }
+    if (ip_ != addr.ip_) { return ip_ < addr.ip_; }
+    if (IPIsUnspec(ip_) && hostname_ != addr.hostname_) { return hostname_ < addr.hostname_; }
+    return port_ < addr.port_;
 }
 
 bool
 SocketAddress::IsComplete() const
 {
+    if (unix_) { return !unix_path_.empty(); }
     return (!IPIsAny(ip_)) && (0 != port_);
 }
 
@@ -58,6 +108,8 @@ SocketAddress::operator=(const SocketAddress &addr)
     port_ = addr.port_;
     scope_id_ = addr.scope_id_;
     literal_ = addr.literal_;
+    unix_ = addr.unix_;
+    unix_path_ = addr.unix_path_;
     return *this;
 }
 
@@ -149,7 +201,7 @@ SocketAddress::IsPrivateIP() const
 bool
 SocketAddress::IsUnresolvedIP() const
 {
-    return IPIsUnspec(ip_) && !literal_ && !hostname_.empty();
+    return !unix_ && IPIsUnspec(ip_) && !literal_ && !hostname_.empty();
 }
 
 void
@@ -207,25 +259,55 @@ ToSocketAddrStorageHelper(sockaddr_storage *addr,
 size_t
 SocketAddress::ToSockAddrStorage(sockaddr_storage *saddr) const
 {
-    return ToSocketAddrStorageHelper(saddr, ip_, port_, scope_id_);
+    if (!unix_) { return ToSocketAddrStorageHelper(saddr, ip_, port_, scope_id_); }
+
+    ::memset(saddr, 0, sizeof(sockaddr_storage));
+    sockaddr_un *uaddr = reinterpret_cast<sockaddr_un *>(saddr);
+    // a path needs room for its terminator, an abstract name has none
+    const size_t terminator = IsAbstractUnix() ? 0 : 1;
+    if (unix_path_.size() + terminator > sizeof(uaddr->sun_path)) { return 0; }
+    uaddr->sun_family = AF_UNIX;
+    ::memcpy(uaddr->sun_path, unix_path_.data(), unix_path_.size());
+    return offsetof(sockaddr_un, sun_path) + unix_path_.size() + terminator;
 }
 
 bool
 SocketAddressFromSockAddrStorage(const sockaddr_storage &addr,
                                  SocketAddress *out)
 {
-    if (!out) { return false; }
+    socklen_t len = sizeof(addr);
+    const sockaddr_un *uaddr = reinterpret_cast<const sockaddr_un *>(&addr);
+    if (addr.ss_family == AF_UNIX && uaddr->sun_path[0] == '\0') {
+        // no length to go by, an abstract name ends at the zero filled rest
+        size_t size = sizeof(uaddr->sun_path);
+        while (size > 1 && uaddr->sun_path[size - 1] == '\0') { --size; }
+        len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + size);
+    }
+    return SocketAddressFromSockAddr(reinterpret_cast<const sockaddr *>(&addr), len, out);
+}
+
+bool
+SocketAddressFromSockAddr(const sockaddr *saddr, socklen_t len, SocketAddress *out)
+{
+    if (!out || len < sizeof(sa_family_t)) { return false; }
+
+    if (saddr->sa_family == AF_UNIX) {
+        const sockaddr_un *uaddr = reinterpret_cast<const sockaddr_un *>(saddr);
+        const size_t offset = offsetof(sockaddr_un, sun_path);
+        size_t size = len > offset ? std::min<size_t>(len - offset, sizeof(uaddr->sun_path)) : 0;
+        // a path may carry its terminator in `len`, an abstract name is all of `len`
+        if (size > 0 && uaddr->sun_path[0] != '\0') { size = strnlen(uaddr->sun_path, size); }
+        *out = SocketAddress::UnixPath(std::string(uaddr->sun_path, size));
+        return true;
+    }
 
-    if (addr.ss_family == AF_INET) {
-        const sockaddr_in *saddr = reinterpret_cast<const sockaddr_in *>(&addr);
-        *out = SocketAddress(IPAddress(saddr->sin_addr),
-                             NetworkToHost16(saddr->sin_port));
+    if (saddr->sa_family == AF_INET && len >= sizeof(sockaddr_in)) {
+        const sockaddr_in *addr = reinterpret_cast<const sockaddr_in *>(saddr);
+        *out = SocketAddress(IPAddress(addr->sin_addr), NetworkToHost16(addr->sin_port));
         return true;
-    } else if (addr.ss_family == AF_INET6) {
-        const sockaddr_in6 *saddr =
-            reinterpret_cast<const sockaddr_in6 *>(&addr);
-        *out = SocketAddress(IPAddress(saddr->sin6_addr),
-                             NetworkToHost16(saddr->sin6_port));
+    } else if (saddr->sa_family == AF_INET6 && len >= sizeof(sockaddr_in6)) {
+        const sockaddr_in6 *addr = reinterpret_cast<const sockaddr_in6 *>(saddr);
+        *out = SocketAddress(IPAddress(addr->sin6_addr), NetworkToHost16(addr->sin6_port));
         return true;
     }
 
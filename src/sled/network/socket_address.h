@@ -9,6 +9,7 @@
 #pragma once
 
 #include "sled/network/ip_address.h"
+#include <string>
 
 namespace sled {
 
@@ -20,6 +21,11 @@ public:
     SocketAddress(const IPAddress &ip, int port);
     SocketAddress(const SocketAddress &addr);
 
+    // AF_UNIX socket at a filesystem path, Bind() creates the file and nothing removes it
+    static SocketAddress UnixPath(const std::string &path);
+    // AF_UNIX socket in the Linux abstract namespace, gone with the last socket bound to it
+    static SocketAddress AbstractUnix(const std::string &name);
+
     // Resets to the nil address
     void Clear();
     // empty hostname, any IP, null port
@@ -27,6 +33,13 @@ public:
     // Returns true if ip and port are set
     bool IsComplete() const;
     SocketAddress &operator=(const SocketAddress &addr);
+    // same ip (or hostname if unresolved) and port
+    bool operator==(const SocketAddress &addr) const;
+
+    bool operator!=(const SocketAddress &addr) const { return !(*this == addr); }
+
+    // orders by ip (or hostname if unresolved), then port, for map keys
+    bool operator<(const SocketAddress &addr) const;
 
     // set ip
     void SetIP(uint32_t ip_as_host_order_integer);
@@ -40,7 +53,14 @@ public:
 
     uint32_t ip() const;
 
-    int family() const { return ip_.family(); }
+    int family() const { return unix_ ? AF_UNIX : ip_.family(); }
+
+    bool IsUnix() const { return unix_; }
+
+    bool IsAbstractUnix() const { return unix_ && !unix_path_.empty() && unix_path_[0] == '\0'; }
+
+    // sun_path, abstract names start with '\0', empty for an unnamed socket
+    const std::string &unix_path() const { return unix_path_; }
 
     const IPAddress &ipaddr() const;
     uint16_t port() const;
@@ -63,9 +83,13 @@ private:
     uint16_t port_;
     int scope_id_;
     bool literal_;
+    bool unix_;
+    std::string unix_path_;
 };
 
 bool SocketAddressFromSockAddrStorage(const sockaddr_storage &saddr, SocketAddress *out);
+// `len` as returned by accept(), getsockname() and friends, AF_UNIX names need it
+bool SocketAddressFromSockAddr(const sockaddr *saddr, socklen_t len, SocketAddress *out);
 }// namespace sled
 
 #endif// SLED_NETWORK_SOCKET_ADDRESS_H
@@ -5,6 +5,7 @@
  */
 
 #include "sled/network/socket_server.h"
+#include "sled/network/io_uring_socket_server.h"
 #include "sled/network/physical_socket_server.h"
 
 namespace sled {
@@ -15,4 +16,12 @@ CreateDefaultSocketServer()
 {
     return std::unique_ptr<sled::SocketServer>(new PhysicalSocketServer());
 }
+
+std::unique_ptr<sled::SocketServer>
+CreateIoUringSocketServer()
+{
+    std::unique_ptr<sled::SocketServer> ss = IoUringSocketServer::Create();
+    if (!ss) { return CreateDefaultSocketServer(); }
+    return ss;
+}
 }// namespace sled
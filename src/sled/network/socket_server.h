@@ -28,6 +28,9 @@ public:
 };
 
 std::unique_ptr<sled::SocketServer> CreateDefaultSocketServer();
+// completion based socket server, falls back to CreateDefaultSocketServer()
+// when the kernel lacks io_uring
+std::unique_ptr<sled::SocketServer> CreateIoUringSocketServer();
 
 }// namespace sled
 
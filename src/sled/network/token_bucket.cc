@@ -0,0 +1,68 @@
+#include "sled/network/token_bucket.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sled {
+
+namespace {
+constexpr int64_t kMinBurstBytes = 1500;
+
+int64_t
+BurstOrDefault(int64_t burst, int64_t rate, int64_t min_burst)
+{
+    if (rate <= 0) { return 0; }
+    if (burst > 0) { return burst; }
+    return std::max(rate / 100, min_burst);
+}
+
+// how long `rate` takes to bring `tokens` up to `needed`
+int64_t
+WaitUs(double tokens, double needed, int64_t rate)
+{
+    if (rate <= 0 || tokens >= needed) { return 0; }
+    return static_cast<int64_t>(std::ceil((needed - tokens) * 1000000.0 / rate));
+}
+}// namespace
+
+TokenBucket::Config::Config() : bytes_per_second(0), packets_per_second(0), burst_bytes(0), burst_packets(0) {}
+
+TokenBucket::TokenBucket(const Config &config)
+    : bytes_per_second_(config.bytes_per_second),
+      packets_per_second_(config.packets_per_second),
+      burst_bytes_(BurstOrDefault(config.burst_bytes, config.bytes_per_second, kMinBurstBytes)),
+      burst_packets_(BurstOrDefault(config.burst_packets, config.packets_per_second, 1)),
+      bytes_(static_cast<double>(burst_bytes_)),
+      packets_(static_cast<double>(burst_packets_)),
+      last_refill_us_(-1)
+{}
+
+TimeDelta
+TokenBucket::TimeUntilAvailable(int64_t now_us)
+{
+    MutexLock lock(&mutex_);
+    Refill(now_us);
+    // one token is enough to start, the send may then go into debt
+    return TimeDelta::Micros(std::max(WaitUs(bytes_, 1, bytes_per_second_), WaitUs(packets_, 1, packets_per_second_)));
+}
+
+void
+TokenBucket::Consume(size_t bytes, size_t packets, int64_t now_us)
+{
+    MutexLock lock(&mutex_);
+    Refill(now_us);
+    if (bytes_per_second_ > 0) { bytes_ -= static_cast<double>(bytes); }
+    if (packets_per_second_ > 0) { packets_ -= static_cast<double>(packets); }
+}
+
+void
+TokenBucket::Refill(int64_t now_us)
+{
+    if (last_refill_us_ >= 0 && now_us > last_refill_us_) {
+        const double elapsed_s = (now_us - last_refill_us_) / 1000000.0;
+        bytes_ = std::min(bytes_ + elapsed_s * bytes_per_second_, static_cast<double>(burst_bytes_));
+        packets_ = std::min(packets_ + elapsed_s * packets_per_second_, static_cast<double>(burst_packets_));
+    }
+    if (now_us > last_refill_us_) { last_refill_us_ = now_us; }
+}
+
+}// namespace sled
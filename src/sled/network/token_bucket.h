@@ -0,0 +1,66 @@
+/**
+ * @file     : token_bucket
+ * @created  : Sunday Oct 18, 2026 11:02:47 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_TOKEN_BUCKET_H
+#define SLED_NETWORK_TOKEN_BUCKET_H
+#pragma once
+
+#include "sled/synchronization/mutex.h"
+#include "sled/units/time_delta.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace sled {
+
+/**
+ * Limits bytes and packets per second. Tokens refill at the configured
+ * rate up to the burst size; a send may start while there are tokens left
+ * and takes what it needs, going into debt if it is larger than what was
+ * left. The debt delays the next send, so the average stays at the rate
+ * without ever splitting a packet.
+ *
+ * Thread safe, one bucket may shape several sockets, e.g. all connections
+ * of a tenant or of the process.
+ **/
+class TokenBucket final {
+public:
+    struct Config {
+        Config();
+
+        // zero is unlimited
+        int64_t bytes_per_second;
+        int64_t packets_per_second;
+        // how much may go out at once after being idle, zero is 10ms worth
+        int64_t burst_bytes;
+        int64_t burst_packets;
+    };
+
+    explicit TokenBucket(const Config &config);
+
+    // zero if a send may start at `now_us`, otherwise how long until it may
+    TimeDelta TimeUntilAvailable(int64_t now_us);
+    void Consume(size_t bytes, size_t packets, int64_t now_us);
+
+    // the most bytes one send should carry, zero without a byte limit
+    int64_t burst_bytes() const { return burst_bytes_; }
+
+private:
+    void Refill(int64_t now_us) SLED_REQUIRES(mutex_);
+
+    const int64_t bytes_per_second_;
+    const int64_t packets_per_second_;
+    const int64_t burst_bytes_;
+    const int64_t burst_packets_;
+
+    Mutex mutex_;
+    double bytes_ SLED_GUARDED_BY(mutex_);
+    double packets_ SLED_GUARDED_BY(mutex_);
+    int64_t last_refill_us_ SLED_GUARDED_BY(mutex_);
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_TOKEN_BUCKET_H
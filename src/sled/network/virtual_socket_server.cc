@@ -0,0 +1,605 @@
+#include "sled/network/virtual_socket_server.h"
+#include "sled/log/log.h"
+#include "sled/system_time.h"
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+
+namespace sled {
+
+namespace {
+// stream data crosses the links in segments of this size
+const size_t kStreamSegmentSize = 1460;
+const int kDefaultSendBufferSize = 64 * 1024;
+const int64_t kForeverNs = std::numeric_limits<int64_t>::max();
+
+IPAddress
+AnyIP(int family)
+{
+    return family == AF_INET6 ? IPAddress(in6addr_any) : IPAddress(INADDR_ANY);
+}
+
+IPAddress
+LoopbackIP(int family)
+{
+    return family == AF_INET6 ? IPAddress(in6addr_loopback) : IPAddress(INADDR_LOOPBACK);
+}
+}// namespace
+
+class VirtualSocket : public Socket {
+public:
+    VirtualSocket(VirtualSocketServer *server, int family, int type)
+        : server_(server),
+          id_(server->Register(this)),
+          family_(family),
+          type_(type),
+          local_addr_(AnyIP(family), 0)
+    {}
+
+    ~VirtualSocket() override
+    {
+        Close();
+        server_->Unregister(id_);
+    }
+
+    SocketAddress GetLocalAddress() const override { return local_addr_; }
+
+    SocketAddress GetRemoteAddress() const override { return remote_addr_; }
+
+    int Bind(const SocketAddress &addr) override
+    {
+        if (bound_) { return Fail(EINVAL); }
+        SocketAddress local = addr;
+        if (IPIsAny(local.ipaddr()) && local.family() != family_) { local.SetIP(AnyIP(family_)); }
+        int err = server_->Bind(this, &local);
+        if (err != 0) { return Fail(err); }
+        local_addr_ = local;
+        bound_ = true;
+        return 0;
+    }
+
+    int Connect(const SocketAddress &addr) override
+    {
+        if (state_ != CS_CLOSED || listening_) { return Fail(EALREADY); }
+        if (!bound_ && Bind(SocketAddress(LoopbackIP(family_), 0)) != 0) { return SOCKET_ERROR; }
+        remote_addr_ = addr;
+        if (type_ == SOCK_DGRAM) {
+            state_ = CS_CONNECTED;
+            return 0;
+        }
+
+        int64_t arrival_ns;
+        server_->Transmit(SourceAddress(), addr, 0, true, &arrival_ns);
+        VirtualSocketServer *server = server_;
+        const uint64_t id = id_;
+        const SocketAddress from = SourceAddress();
+        server_->Post(arrival_ns, [server, id, from, addr] {
+            VirtualSocket *listener = server->FindBinding(addr);
+            if (listener && listener->listening_) {
+                listener->OnConnectRequest(id, from, addr);
+            } else {
+                VirtualSocket::RefuseConnect(server, id, addr, from);
+            }
+        });
+        state_ = CS_CONNECTING;
+        return Fail(EINPROGRESS);
+    }
+
+    int Send(const void *pv, size_t cb) override
+    {
+        if (state_ != CS_CONNECTED) { return Fail(ENOTCONN); }
+        if (type_ == SOCK_DGRAM) { return SendTo(pv, cb, remote_addr_); }
+
+        const size_t space = SendBufferSize() > send_buffered_ ? SendBufferSize() - send_buffered_ : 0;
+        if (space == 0) {
+            write_blocked_ = true;
+            return Fail(EWOULDBLOCK);
+        }
+        const size_t len = std::min(cb, space);
+        const uint8_t *data = static_cast<const uint8_t *>(pv);
+        for (size_t offset = 0; offset < len; offset += kStreamSegmentSize) {
+            const size_t size = std::min(kStreamSegmentSize, len - offset);
+            SendSegment(Buffer(data + offset, size));
+        }
+        return static_cast<int>(len);
+    }
+
+    int SendTo(const void *pv, size_t cb, const SocketAddress &addr) override
+    {
+        if (type_ != SOCK_DGRAM) {
+            if (addr != remote_addr_) { return Fail(EISCONN); }
+            return Send(pv, cb);
+        }
+        if (cb > kMaxDatagramSize) { return Fail(EMSGSIZE); }
+        if (!bound_ && Bind(SocketAddress(LoopbackIP(family_), 0)) != 0) { return SOCKET_ERROR; }
+
+        int64_t arrival_ns;
+        // a lost datagram looks sent to the sender
+        if (!server_->Transmit(SourceAddress(), addr, cb, false, &arrival_ns)) { return static_cast<int>(cb); }
+        VirtualSocketServer *server = server_;
+        const SocketAddress from = SourceAddress();
+        std::shared_ptr<Buffer> data = std::make_shared<Buffer>(static_cast<const uint8_t *>(pv), cb);
+        server_->Post(arrival_ns, [server, from, addr, data] {
+            VirtualSocket *socket = server->FindBinding(addr);
+            if (socket && socket->type_ == SOCK_DGRAM) { socket->OnDatagram(std::move(*data), from); }
+        });
+        return static_cast<int>(cb);
+    }
+
+    int Recv(void *pv, size_t cb, int64_t *timestamp) override { return RecvFrom(pv, cb, nullptr, timestamp); }
+
+    int RecvFrom(void *pv, size_t cb, SocketAddress *paddr, int64_t *timestamp) override
+    {
+        if (type_ == SOCK_DGRAM) {
+            if (datagrams_.empty()) { return Fail(EWOULDBLOCK); }
+            Datagram &datagram = datagrams_.front();
+            const size_t len = std::min(cb, datagram.data.size());
+            std::memcpy(pv, datagram.data.data(), len);
+            if (paddr) { *paddr = datagram.addr; }
+            if (timestamp) { *timestamp = datagram.timestamp; }
+            datagrams_.pop_front();
+            return static_cast<int>(len);
+        }
+
+        if (recv_offset_ == recv_buffer_.size()) {
+            // everything the peer sent before closing was read
+            if (peer_closed_) { return 0; }
+            return Fail(EWOULDBLOCK);
+        }
+        const size_t len = std::min(cb, recv_buffer_.size() - recv_offset_);
+        std::memcpy(pv, recv_buffer_.data() + recv_offset_, len);
+        recv_offset_ += len;
+        if (recv_offset_ == recv_buffer_.size()) {
+            recv_buffer_.Clear();
+            recv_offset_ = 0;
+        }
+        if (paddr) { *paddr = remote_addr_; }
+        if (timestamp) { *timestamp = last_recv_us_; }
+        return static_cast<int>(len);
+    }
+
+    int Listen(int backlog) override
+    {
+        if (type_ != SOCK_STREAM) { return Fail(EOPNOTSUPP); }
+        if (!bound_) { return Fail(EINVAL); }
+        listening_ = true;
+        state_ = CS_CONNECTING;
+        return 0;
+    }
+
+    Socket *Accept(SocketAddress *paddr) override
+    {
+        if (pending_accepts_.empty()) {
+            Fail(EWOULDBLOCK);
+            return nullptr;
+        }
+        VirtualSocket *socket = pending_accepts_.front().release();
+        pending_accepts_.pop_front();
+        if (paddr) { *paddr = socket->remote_addr_; }
+        return socket;
+    }
+
+    int Close() override
+    {
+        if (peer_id_ != 0) {
+            int64_t arrival_ns;
+            server_->Transmit(SourceAddress(), remote_addr_, 0, true, &arrival_ns);
+            VirtualSocketServer *server = server_;
+            const uint64_t peer_id = peer_id_;
+            server_->Post(arrival_ns, [server, peer_id] {
+                VirtualSocket *peer = server->FindSocket(peer_id);
+                if (peer) { peer->OnPeerClosed(); }
+            });
+            peer_id_ = 0;
+        }
+        if (bound_) {
+            server_->Unbind(local_addr_, this);
+            bound_ = false;
+        }
+        pending_accepts_.clear();
+        listening_ = false;
+        state_ = CS_CLOSED;
+        return 0;
+    }
+
+    int GetError() const override { return error_; }
+
+    void SetError(int error) override { error_ = error; }
+
+    ConnState GetState() const override { return state_; }
+
+    int GetOption(Option opt, int *value) override
+    {
+        auto it = options_.find(opt);
+        if (it == options_.end()) { return -1; }
+        *value = it->second;
+        return 0;
+    }
+
+    int SetOption(Option opt, int value) override
+    {
+        options_[opt] = value;
+        return 0;
+    }
+
+private:
+    int Fail(int error)
+    {
+        error_ = error;
+        return SOCKET_ERROR;
+    }
+
+    // what the peer sees, a socket bound to the any address sends from loopback
+    SocketAddress SourceAddress() const
+    {
+        if (!IPIsAny(local_addr_.ipaddr())) { return local_addr_; }
+        return SocketAddress(LoopbackIP(family_), local_addr_.port());
+    }
+
+    size_t SendBufferSize() const
+    {
+        auto it = options_.find(OPT_SNDBUF);
+        return static_cast<size_t>(it == options_.end() ? kDefaultSendBufferSize : it->second);
+    }
+
+    void SendSegment(Buffer &&segment)
+    {
+        int64_t arrival_ns;
+        server_->Transmit(SourceAddress(), remote_addr_, segment.size(), true, &arrival_ns);
+        send_buffered_ += segment.size();
+        VirtualSocketServer *server = server_;
+        const uint64_t id = id_;
+        const uint64_t peer_id = peer_id_;
+        std::shared_ptr<Buffer> data = std::make_shared<Buffer>(std::move(segment));
+        server_->Post(arrival_ns, [server, id, peer_id, data] {
+            // the window opens when the data arrives, there are no acks
+            VirtualSocket *sender = server->FindSocket(id);
+            if (sender) { sender->OnSegmentDelivered(data->size()); }
+            VirtualSocket *peer = server->FindSocket(peer_id);
+            if (peer && peer->peer_id_ == id) { peer->OnStreamData(*data); }
+        });
+    }
+
+    void OnSegmentDelivered(size_t size)
+    {
+        send_buffered_ -= size;
+        if (write_blocked_ && send_buffered_ <= SendBufferSize() / 2) {
+            write_blocked_ = false;
+            SignalWriteEvent(this);
+        }
+    }
+
+    void OnStreamData(const Buffer &data)
+    {
+        recv_buffer_.AppendData(data.data(), data.size());
+        last_recv_us_ = sled::TimeMicros();
+        SignalReadEvent(this);
+    }
+
+    void OnDatagram(Buffer &&data, const SocketAddress &from)
+    {
+        if (state_ == CS_CONNECTED && from != remote_addr_) { return; }
+        datagrams_.emplace_back();
+        datagrams_.back().data = std::move(data);
+        datagrams_.back().addr = from;
+        datagrams_.back().timestamp = sled::TimeMicros();
+        SignalReadEvent(this);
+    }
+
+    void OnConnectRequest(uint64_t client_id, const SocketAddress &from, const SocketAddress &to)
+    {
+        std::unique_ptr<VirtualSocket> accepted(new VirtualSocket(server_, family_, SOCK_STREAM));
+        accepted->local_addr_ = to;
+        accepted->remote_addr_ = from;
+        accepted->state_ = CS_CONNECTED;
+        accepted->peer_id_ = client_id;
+        const uint64_t accepted_id = accepted->id_;
+        pending_accepts_.push_back(std::move(accepted));
+
+        int64_t arrival_ns;
+        server_->Transmit(to, from, 0, true, &arrival_ns);
+        VirtualSocketServer *server = server_;
+        server_->Post(arrival_ns, [server, client_id, accepted_id] {
+            VirtualSocket *client = server->FindSocket(client_id);
+            if (client && client->state_ == CS_CONNECTING) { client->OnConnected(accepted_id); }
+        });
+        SignalReadEvent(this);
+    }
+
+    static void
+    RefuseConnect(VirtualSocketServer *server, uint64_t client_id, const SocketAddress &from, const SocketAddress &to)
+    {
+        int64_t arrival_ns;
+        server->Transmit(from, to, 0, true, &arrival_ns);
+        server->Post(arrival_ns, [server, client_id] {
+            VirtualSocket *client = server->FindSocket(client_id);
+            if (client && client->state_ == CS_CONNECTING) {
+                client->state_ = CS_CLOSED;
+                client->error_ = ECONNREFUSED;
+                client->SignalCloseEvent(client, ECONNREFUSED);
+            }
+        });
+    }
+
+    void OnConnected(uint64_t peer_id)
+    {
+        VirtualSocket *peer = server_->FindSocket(peer_id);
+        // the listener went away before accepting
+        if (!peer) {
+            state_ = CS_CLOSED;
+            error_ = ECONNRESET;
+            SignalCloseEvent(this, ECONNRESET);
+            return;
+        }
+        peer_id_ = peer_id;
+        state_ = CS_CONNECTED;
+        SignalConnectEvent(this);
+    }
+
+    void OnPeerClosed()
+    {
+        peer_id_ = 0;
+        peer_closed_ = true;
+        if (state_ != CS_CONNECTED) { return; }
+        state_ = CS_CLOSED;
+        SignalCloseEvent(this, 0);
+    }
+
+    VirtualSocketServer *const server_;
+    const uint64_t id_;
+    const int family_;
+    const int type_;
+    SocketAddress local_addr_;
+    SocketAddress remote_addr_;
+    ConnState state_ = CS_CLOSED;
+    int error_ = 0;
+    bool bound_ = false;
+    bool listening_ = false;
+    std::map<Option, int> options_;
+
+    // stream
+    uint64_t peer_id_ = 0;
+    bool peer_closed_ = false;
+    size_t send_buffered_ = 0;
+    bool write_blocked_ = false;
+    Buffer recv_buffer_;
+    size_t recv_offset_ = 0;
+    int64_t last_recv_us_ = -1;
+    std::deque<std::unique_ptr<VirtualSocket>> pending_accepts_;
+
+    // datagram
+    std::deque<Datagram> datagrams_;
+};
+
+VirtualSocketServer::LinkConfig::LinkConfig()
+    : delay(TimeDelta::Zero()),
+      jitter(TimeDelta::Zero()),
+      bandwidth_bps(0),
+      loss(0),
+      max_queue_delay(TimeDelta::PlusInfinity())
+{}
+
+VirtualSocketServer::VirtualSocketServer(bool use_virtual_clock)
+    : use_virtual_clock_(use_virtual_clock),
+      now_ns_(SystemTimeNanos()),
+      prev_clock_(nullptr),
+      random_(new Random(1))
+{
+    if (use_virtual_clock_) {
+        SLED_DCHECK(GetClockForTesting() == nullptr, "another clock is installed");
+        prev_clock_ = SetClockForTesting(this);
+    }
+}
+
+VirtualSocketServer::~VirtualSocketServer()
+{
+    SLED_DCHECK(sockets_.empty(), "sockets must be destroyed before the server");
+    if (use_virtual_clock_) { SetClockForTesting(prev_clock_); }
+}
+
+void
+VirtualSocketServer::SetLink(const IPAddress &from, const IPAddress &to, const LinkConfig &config)
+{
+    Link &link = links_[std::make_pair(from, to)];
+    link.configured = true;
+    link.config = config;
+}
+
+void
+VirtualSocketServer::SetLinks(const IPAddress &a, const IPAddress &b, const LinkConfig &config)
+{
+    SetLink(a, b, config);
+    SetLink(b, a, config);
+}
+
+void
+VirtualSocketServer::set_seed(uint64_t seed)
+{
+    random_.reset(new Random(seed));
+}
+
+void
+VirtualSocketServer::AdvanceTime(TimeDelta delta)
+{
+    SLED_DCHECK(use_virtual_clock_, "AdvanceTime() needs the virtual clock");
+    const int64_t target_ns = now_ns_ + delta.ns();
+    while (!messages_.empty() && messages_.top().time_ns <= target_ns) {
+        SetTime(std::max<int64_t>(now_ns_, messages_.top().time_ns));
+        ProcessMessagesUntilIdle();
+    }
+    SetTime(target_ns);
+    ProcessMessagesUntilIdle();
+}
+
+bool
+VirtualSocketServer::ProcessMessagesUntilIdle()
+{
+    bool processed = false;
+    while (!messages_.empty() && messages_.top().time_ns <= sled::TimeNanos()) {
+        std::function<void()> callback = std::move(messages_.top().callback);
+        messages_.pop();
+        callback();
+        processed = true;
+    }
+    return processed;
+}
+
+int64_t
+VirtualSocketServer::TimeNanos() const
+{
+    return now_ns_;
+}
+
+Socket *
+VirtualSocketServer::CreateSocket(int family, int type)
+{
+    if (family != AF_INET && family != AF_INET6) { return nullptr; }
+    if (type != SOCK_STREAM && type != SOCK_DGRAM) { return nullptr; }
+    return new VirtualSocket(this, family, type);
+}
+
+bool
+VirtualSocketServer::Wait(TimeDelta max_wait_duration, bool process_io)
+{
+    const int64_t deadline_ns
+        = max_wait_duration.IsPlusInfinity() ? kForeverNs : sled::TimeNanos() + max_wait_duration.ns();
+    while (true) {
+        // the callbacks may have posted tasks, let the thread run them
+        if (process_io && ProcessMessagesUntilIdle()) { return true; }
+        if (wakeup_.Wait(TimeDelta::Zero())) { return true; }
+
+        const int64_t now_ns = sled::TimeNanos();
+        if (now_ns >= deadline_ns) { return true; }
+        int64_t next_ns = deadline_ns;
+        if (process_io && !messages_.empty()) { next_ns = std::min(next_ns, messages_.top().time_ns); }
+
+        if (use_virtual_clock_) {
+            // nothing will ever happen unless another thread posts
+            if (next_ns == kForeverNs) {
+                wakeup_.Wait(Event::kForever);
+                return true;
+            }
+            SetTime(next_ns);
+            continue;
+        }
+        const TimeDelta wait = next_ns == kForeverNs
+                                 ? Event::kForever
+                                 : TimeDelta::Micros((next_ns - now_ns + kNumNanosecsPerMicrosec - 1)
+                                                     / kNumNanosecsPerMicrosec);
+        if (wakeup_.Wait(wait)) { return true; }
+    }
+}
+
+void
+VirtualSocketServer::WakeUp()
+{
+    wakeup_.Set();
+}
+
+uint64_t
+VirtualSocketServer::Register(VirtualSocket *socket)
+{
+    const uint64_t id = next_socket_id_++;
+    sockets_[id] = socket;
+    return id;
+}
+
+void
+VirtualSocketServer::Unregister(uint64_t id)
+{
+    sockets_.erase(id);
+}
+
+VirtualSocket *
+VirtualSocketServer::FindSocket(uint64_t id) const
+{
+    auto it = sockets_.find(id);
+    return it == sockets_.end() ? nullptr : it->second;
+}
+
+int
+VirtualSocketServer::Bind(VirtualSocket *socket, SocketAddress *addr)
+{
+    if (addr->port() == 0) {
+        for (int i = 0; i < 65536 - 49152; ++i) {
+            addr->SetPort(next_port_);
+            next_port_ = next_port_ == 65535 ? 49152 : next_port_ + 1;
+            if (bindings_.find(*addr) == bindings_.end()) { break; }
+        }
+    }
+    if (bindings_.find(*addr) != bindings_.end()) { return EADDRINUSE; }
+    bindings_[*addr] = socket;
+    return 0;
+}
+
+void
+VirtualSocketServer::Unbind(const SocketAddress &addr, VirtualSocket *socket)
+{
+    auto it = bindings_.find(addr);
+    if (it != bindings_.end() && it->second == socket) { bindings_.erase(it); }
+}
+
+VirtualSocket *
+VirtualSocketServer::FindBinding(const SocketAddress &addr) const
+{
+    auto it = bindings_.find(addr);
+    if (it != bindings_.end()) { return it->second; }
+    // a socket bound to the any address receives for every ip
+    it = bindings_.find(SocketAddress(AnyIP(addr.family()), addr.port()));
+    return it == bindings_.end() ? nullptr : it->second;
+}
+
+bool
+VirtualSocketServer::Transmit(const SocketAddress &from,
+                              const SocketAddress &to,
+                              size_t size,
+                              bool reliable,
+                              int64_t *arrival_ns)
+{
+    Link &link = links_[std::make_pair(from.ipaddr(), to.ipaddr())];
+    const LinkConfig &config = link.configured ? link.config : default_link_;
+    const int64_t now_ns = sled::TimeNanos();
+    ++sent_packets_;
+
+    if (!reliable && config.loss > 0 && random_->Rand<double>() < config.loss) {
+        ++dropped_packets_;
+        return false;
+    }
+
+    const int64_t start_ns = std::max(now_ns, link.busy_until_ns);
+    if (!reliable && !config.max_queue_delay.IsPlusInfinity() && start_ns - now_ns > config.max_queue_delay.ns()) {
+        ++dropped_packets_;
+        return false;
+    }
+    int64_t transmit_ns = 0;
+    if (config.bandwidth_bps > 0) {
+        transmit_ns = static_cast<int64_t>(size) * 8 * kNumNanosecsPerSec / config.bandwidth_bps;
+    }
+    link.busy_until_ns = start_ns + transmit_ns;
+
+    int64_t arrival = link.busy_until_ns + config.delay.ns();
+    if (config.jitter > TimeDelta::Zero()) {
+        arrival += static_cast<int64_t>(random_->Rand<double>() * config.jitter.ns());
+    }
+    if (reliable) {
+        arrival = std::max(arrival, link.last_reliable_arrival_ns);
+        link.last_reliable_arrival_ns = arrival;
+    }
+    *arrival_ns = arrival;
+    return true;
+}
+
+void
+VirtualSocketServer::Post(int64_t time_ns, std::function<void()> callback)
+{
+    messages_.push(Message{time_ns, next_message_seq_++, std::move(callback)});
+}
+
+void
+VirtualSocketServer::SetTime(int64_t time_ns)
+{
+    now_ns_ = time_ns;
+}
+
+}// namespace sled
@@ -0,0 +1,148 @@
+/**
+ * @file     : virtual_socket_server
+ * @created  : Saturday Oct 17, 2026 22:04:51 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_NETWORK_VIRTUAL_SOCKET_SERVER_H
+#define SLED_NETWORK_VIRTUAL_SOCKET_SERVER_H
+#pragma once
+
+#include "sled/network/socket_server.h"
+#include "sled/random.h"
+#include "sled/synchronization/event.h"
+#include "sled/time_utils.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace sled {
+
+class VirtualSocket;
+
+/**
+ * In-memory TCP and UDP sockets over a simulated network. Each direction
+ * between two IPs is a link with a delay, jitter, bandwidth and datagram
+ * loss; stream sockets are reliable and ordered, datagrams may be lost and
+ * reordered by jitter. Random choices come from a seeded generator, so a
+ * run is reproducible.
+ *
+ * With `use_virtual_clock` the server installs itself as the process clock
+ * (see SetClockForTesting()) and Wait() jumps to the next network event or
+ * timeout instead of sleeping, so simulated hours pass as fast as the CPU
+ * allows. Only one such server may exist at a time.
+ *
+ * Sockets must be created, used and destroyed on the thread which runs the
+ * server (e.g. Thread thread(&vss)), and before the server goes away.
+ **/
+class VirtualSocketServer : public SocketServer, public ClockInterface {
+public:
+    struct LinkConfig {
+        LinkConfig();
+
+        // one way propagation delay
+        TimeDelta delay;
+        // uniformly distributed extra delay in [0, jitter]
+        TimeDelta jitter;
+        // 0 is unlimited, otherwise packets queue behind each other
+        int64_t bandwidth_bps;
+        // probability in [0, 1] to drop a datagram
+        double loss;
+        // datagrams which would wait longer for the bandwidth are dropped
+        TimeDelta max_queue_delay;
+    };
+
+    explicit VirtualSocketServer(bool use_virtual_clock = false);
+    ~VirtualSocketServer() override;
+
+    void set_default_link(const LinkConfig &config) { default_link_ = config; }
+
+    // the link `from` -> `to`, used instead of the default one
+    void SetLink(const IPAddress &from, const IPAddress &to, const LinkConfig &config);
+    void SetLinks(const IPAddress &a, const IPAddress &b, const LinkConfig &config);
+
+    void set_seed(uint64_t seed);
+
+    bool use_virtual_clock() const { return use_virtual_clock_; }
+
+    // moves the virtual clock forward, delivering what becomes due on the way
+    void AdvanceTime(TimeDelta delta);
+
+    // delivers everything which is due, returns false if there was nothing
+    bool ProcessMessagesUntilIdle();
+
+    size_t sent_packets() const { return sent_packets_; }
+
+    size_t dropped_packets() const { return dropped_packets_; }
+
+    // ClockInterface, the virtual time when it is used
+    int64_t TimeNanos() const override;
+
+    Socket *CreateSocket(int family, int type) override;
+    bool Wait(TimeDelta max_wait_duration, bool process_io) override;
+    void WakeUp() override;
+
+private:
+    friend class VirtualSocket;
+
+    struct Link {
+        bool configured = false;
+        LinkConfig config;
+        // when the bottleneck is free again
+        int64_t busy_until_ns = 0;
+        // keeps reliable packets in order despite jitter
+        int64_t last_reliable_arrival_ns = 0;
+    };
+
+    struct Message {
+        int64_t time_ns;
+        uint64_t seq;
+        mutable std::function<void()> callback;
+    };
+
+    struct MessageLater {
+        bool operator()(const Message &a, const Message &b) const
+        {
+            return a.time_ns > b.time_ns || (a.time_ns == b.time_ns && a.seq > b.seq);
+        }
+    };
+
+    uint64_t Register(VirtualSocket *socket);
+    void Unregister(uint64_t id);
+    VirtualSocket *FindSocket(uint64_t id) const;
+    // binds `addr` (any IP and port 0 allowed), returns 0 or an errno
+    int Bind(VirtualSocket *socket, SocketAddress *addr);
+    void Unbind(const SocketAddress &addr, VirtualSocket *socket);
+    VirtualSocket *FindBinding(const SocketAddress &addr) const;
+    /**
+     * Runs `size` bytes through the link between the two addresses.
+     * @return false if a datagram was lost, otherwise *arrival_ns is set
+     **/
+    bool Transmit(const SocketAddress &from, const SocketAddress &to, size_t size, bool reliable, int64_t *arrival_ns);
+    void Post(int64_t time_ns, std::function<void()> callback);
+    void SetTime(int64_t time_ns);
+
+    const bool use_virtual_clock_;
+    std::atomic<int64_t> now_ns_;
+    ClockInterface *prev_clock_;
+    Event wakeup_;
+    LinkConfig default_link_;
+    std::map<std::pair<IPAddress, IPAddress>, Link> links_;
+    std::unique_ptr<Random> random_;
+
+    std::priority_queue<Message, std::vector<Message>, MessageLater> messages_;
+    uint64_t next_message_seq_ = 0;
+    std::map<uint64_t, VirtualSocket *> sockets_;
+    uint64_t next_socket_id_ = 1;
+    std::map<SocketAddress, VirtualSocket *> bindings_;
+    uint16_t next_port_ = 49152;
+    size_t sent_packets_ = 0;
+    size_t dropped_packets_ = 0;
+};
+
+}// namespace sled
+
+#endif// SLED_NETWORK_VIRTUAL_SOCKET_SERVER_H
@@ -0,0 +1,267 @@
+#include <sled/network/virtual_socket_server.h>
+#include <sled/system/thread.h>
+#include <sled/system_time.h>
+#include <sled/time_utils.h>
+
+namespace {
+struct EventRecorder : public sigslot::has_slots<> {
+    void Watch(sled::Socket *socket)
+    {
+        socket->SignalReadEvent.connect(this, &EventRecorder::OnReadEvent);
+        socket->SignalWriteEvent.connect(this, &EventRecorder::OnWriteEvent);
+        socket->SignalConnectEvent.connect(this, &EventRecorder::OnConnectEvent);
+        socket->SignalCloseEvent.connect(this, &EventRecorder::OnCloseEvent);
+    }
+
+    void OnReadEvent(sled::Socket *) { ++read_events; }
+
+    void OnWriteEvent(sled::Socket *) { ++write_events; }
+
+    void OnConnectEvent(sled::Socket *) { ++connect_events; }
+
+    void OnCloseEvent(sled::Socket *, int error)
+    {
+        ++close_events;
+        close_error = error;
+    }
+
+    int read_events = 0;
+    int write_events = 0;
+    int connect_events = 0;
+    int close_events = 0;
+    int close_error = -1;
+};
+
+sled::VirtualSocketServer::LinkConfig
+Link(int delay_ms, int64_t bandwidth_bps = 0, double loss = 0)
+{
+    sled::VirtualSocketServer::LinkConfig config;
+    config.delay = sled::TimeDelta::Millis(delay_ms);
+    config.bandwidth_bps = bandwidth_bps;
+    config.loss = loss;
+    return config;
+}
+
+// datagrams out of `count` which crossed a lossy link
+int
+DeliveredDatagrams(uint64_t seed, int count)
+{
+    sled::VirtualSocketServer vss(true);
+    vss.set_seed(seed);
+    vss.set_default_link(Link(10, 0, 0.3));
+    std::unique_ptr<sled::Socket> sender(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+    std::unique_ptr<sled::Socket> receiver(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+    receiver->Bind(sled::SocketAddress("127.0.0.1", 0));
+    char buf[16] = {0};
+    for (int i = 0; i < count; ++i) { sender->SendTo(buf, sizeof(buf), receiver->GetLocalAddress()); }
+    vss.AdvanceTime(sled::TimeDelta::Seconds(1));
+    int delivered = 0;
+    while (receiver->Recv(buf, sizeof(buf), nullptr) > 0) { ++delivered; }
+    return delivered;
+}
+}// namespace
+
+TEST_SUITE("VirtualSocketServer")
+{
+    TEST_CASE("udp delay")
+    {
+        sled::VirtualSocketServer vss(true);
+        vss.set_default_link(Link(100));
+        std::unique_ptr<sled::Socket> a(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> b(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+        REQUIRE_EQ(a->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        REQUIRE_EQ(b->Bind(sled::SocketAddress("127.0.0.1", 0)), 0);
+        CHECK_NE(a->GetLocalAddress().port(), b->GetLocalAddress().port());
+        EventRecorder b_events;
+        b_events.Watch(b.get());
+
+        const int64_t sent_ms = sled::TimeMillis();
+        CHECK_EQ(a->SendTo("ping", 4, b->GetLocalAddress()), 4);
+        vss.AdvanceTime(sled::TimeDelta::Millis(99));
+        CHECK_EQ(b_events.read_events, 0);
+        vss.AdvanceTime(sled::TimeDelta::Millis(1));
+        CHECK_EQ(b_events.read_events, 1);
+
+        char buf[16];
+        sled::SocketAddress from;
+        int64_t timestamp;
+        CHECK_EQ(b->RecvFrom(buf, sizeof(buf), &from, &timestamp), 4);
+        CHECK_EQ(from, a->GetLocalAddress());
+        CHECK_EQ(timestamp / 1000 - sent_ms, 100);
+        CHECK_LT(b->RecvFrom(buf, sizeof(buf), &from, nullptr), 0);
+        CHECK(b->IsBlocking());
+    }
+
+    TEST_CASE("udp loss is reproducible")
+    {
+        const int delivered = DeliveredDatagrams(42, 1000);
+        CHECK_GT(delivered, 600);
+        CHECK_LT(delivered, 800);
+        CHECK_EQ(DeliveredDatagrams(42, 1000), delivered);
+    }
+
+    TEST_CASE("tcp connect, bandwidth and close")
+    {
+        sled::VirtualSocketServer vss(true);
+        // 1 Mbps with a 50ms one way delay
+        vss.set_default_link(Link(50, 1000 * 1000));
+        std::unique_ptr<sled::Socket> listener(vss.CreateSocket(AF_INET, SOCK_STREAM));
+        REQUIRE_EQ(listener->Bind(sled::SocketAddress("0.0.0.0", 8080)), 0);
+        REQUIRE_EQ(listener->Listen(5), 0);
+        EventRecorder listener_events;
+        listener_events.Watch(listener.get());
+
+        std::unique_ptr<sled::Socket> client(vss.CreateSocket(AF_INET, SOCK_STREAM));
+        EventRecorder client_events;
+        client_events.Watch(client.get());
+        CHECK_LT(client->Connect(sled::SocketAddress("127.0.0.1", 8080)), 0);
+        CHECK(client->IsBlocking());
+        CHECK_EQ(client->GetState(), sled::Socket::CS_CONNECTING);
+
+        vss.AdvanceTime(sled::TimeDelta::Millis(50));
+        REQUIRE_EQ(listener_events.read_events, 1);
+        sled::SocketAddress remote;
+        std::unique_ptr<sled::Socket> accepted(listener->Accept(&remote));
+        REQUIRE(accepted);
+        CHECK_EQ(remote, client->GetLocalAddress());
+        EventRecorder accepted_events;
+        accepted_events.Watch(accepted.get());
+        vss.AdvanceTime(sled::TimeDelta::Millis(50));
+        CHECK_EQ(client_events.connect_events, 1);
+        CHECK_EQ(client->GetState(), sled::Socket::CS_CONNECTED);
+
+        // 125000 bytes take one second at 1 Mbps, the send buffer stops the writer on the way
+        const int64_t start_ms = sled::TimeMillis();
+        std::string payload(125000, 'x');
+        size_t sent = 0;
+        std::string received;
+        char buf[4096];
+        while (received.size() < payload.size()) {
+            if (sent < payload.size()) {
+                int n = client->Send(payload.data() + sent, payload.size() - sent);
+                if (n > 0) { sent += n; }
+            }
+            vss.AdvanceTime(sled::TimeDelta::Millis(1));
+            int n;
+            while ((n = accepted->Recv(buf, sizeof(buf), nullptr)) > 0) { received.append(buf, n); }
+        }
+        CHECK(received == payload);
+        CHECK_GT(client_events.write_events, 0);
+        const int64_t elapsed_ms = sled::TimeMillis() - start_ms;
+        CHECK_GE(elapsed_ms, 1000);
+        CHECK_LE(elapsed_ms, 1100);
+
+        client->Close();
+        vss.AdvanceTime(sled::TimeDelta::Millis(50));
+        CHECK_EQ(accepted_events.close_events, 1);
+        CHECK_EQ(accepted_events.close_error, 0);
+        CHECK_EQ(accepted->Recv(buf, sizeof(buf), nullptr), 0);
+    }
+
+    TEST_CASE("tcp connection refused")
+    {
+        sled::VirtualSocketServer vss(true);
+        vss.set_default_link(Link(10));
+        std::unique_ptr<sled::Socket> client(vss.CreateSocket(AF_INET, SOCK_STREAM));
+        EventRecorder client_events;
+        client_events.Watch(client.get());
+        client->Connect(sled::SocketAddress("127.0.0.1", 9));
+        vss.AdvanceTime(sled::TimeDelta::Millis(20));
+        CHECK_EQ(client_events.close_events, 1);
+        CHECK_EQ(client_events.close_error, ECONNREFUSED);
+        CHECK_EQ(client->GetState(), sled::Socket::CS_CLOSED);
+    }
+
+    TEST_CASE("per link config")
+    {
+        sled::VirtualSocketServer vss(true);
+        vss.set_default_link(Link(10));
+        const sled::IPAddress near(0x0a000001);
+        const sled::IPAddress far(0x0a000002);
+        vss.SetLinks(near, far, Link(200));
+        std::unique_ptr<sled::Socket> a(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+        std::unique_ptr<sled::Socket> b(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+        a->Bind(sled::SocketAddress(near, 0));
+        b->Bind(sled::SocketAddress(far, 0));
+        EventRecorder b_events;
+        b_events.Watch(b.get());
+        a->SendTo("x", 1, b->GetLocalAddress());
+        vss.AdvanceTime(sled::TimeDelta::Millis(199));
+        CHECK_EQ(b_events.read_events, 0);
+        vss.AdvanceTime(sled::TimeDelta::Millis(1));
+        CHECK_EQ(b_events.read_events, 1);
+    }
+
+    TEST_CASE("an hour of traffic on a thread")
+    {
+        sled::VirtualSocketServer vss(true);
+        vss.set_default_link(Link(20));
+        sled::Thread thread(&vss);
+        thread.Start();
+
+        // one datagram per virtual second, driven by delayed tasks
+        const int64_t real_start_ms = sled::SystemTimeNanos() / sled::kNumNanosecsPerMillisec;
+        const int64_t virtual_start_ms = sled::TimeMillis();
+        std::unique_ptr<sled::Socket> a;
+        std::unique_ptr<sled::Socket> b;
+        int received = 0;
+        sled::Event done;
+        std::function<void(int)> tick = [&](int remaining) {
+            char buf[8];
+            while (b->Recv(buf, sizeof(buf), nullptr) > 0) { ++received; }
+            if (remaining == 0) {
+                done.Set();
+                return;
+            }
+            a->SendTo("tick", 4, b->GetLocalAddress());
+            thread.PostDelayedTask([&tick, remaining] { tick(remaining - 1); }, sled::TimeDelta::Seconds(1));
+        };
+        thread.BlockingCall([&] {
+            a.reset(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+            b.reset(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+            b->Bind(sled::SocketAddress("127.0.0.1", 0));
+            tick(3600);
+        });
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(30)));
+        const int64_t virtual_elapsed_ms = sled::TimeMillis() - virtual_start_ms;
+        thread.BlockingCall([&] {
+            a.reset();
+            b.reset();
+        });
+        thread.Stop();
+
+        CHECK_EQ(received, 3600);
+        CHECK_GE(virtual_elapsed_ms, 3600 * 1000);
+        CHECK_LT(sled::SystemTimeNanos() / sled::kNumNanosecsPerMillisec - real_start_ms, 30 * 1000);
+    }
+
+    TEST_CASE("real clock")
+    {
+        sled::VirtualSocketServer vss;
+        vss.set_default_link(Link(30));
+        sled::Thread thread(&vss);
+        thread.Start();
+
+        std::unique_ptr<sled::Socket> a;
+        std::unique_ptr<sled::Socket> b;
+        EventRecorder b_events;
+        const int64_t start_ms = sled::TimeMillis();
+        thread.BlockingCall([&] {
+            a.reset(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+            b.reset(vss.CreateSocket(AF_INET, SOCK_DGRAM));
+            b->Bind(sled::SocketAddress("127.0.0.1", 0));
+            b_events.Watch(b.get());
+            a->SendTo("x", 1, b->GetLocalAddress());
+        });
+        for (int i = 0; i < 100 && thread.BlockingCall([&] { return b_events.read_events; }) == 0; ++i) {
+            sled::Thread::SleepMs(5);
+        }
+        CHECK_GE(sled::TimeMillis() - start_ms, 30);
+        thread.BlockingCall([&] {
+            CHECK_EQ(b_events.read_events, 1);
+            a.reset();
+            b.reset();
+        });
+        thread.Stop();
+    }
+}
@@ -0,0 +1,184 @@
+/**
+ * @file     : mpsc_queue
+ * @created  : Sunday Oct 18, 2026 15:12:08 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_QUEUE_MPSC_QUEUE_H
+#define SLED_QUEUE_MPSC_QUEUE_H
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace sled {
+
+// the link IntrusiveMpscQueue threads through its elements
+struct MpscQueueNode {
+    MpscQueueNode() : next(nullptr) {}
+
+    std::atomic<MpscQueueNode *> next;
+};
+
+/**
+ * Unbounded multi producer, single consumer queue of nodes the caller owns,
+ * Dmitry Vyukov's intrusive design. T derives from MpscQueueNode, a node is
+ * in at most one queue at a time and the caller gets it back from Pop().
+ * Push() is one atomic exchange and never blocks. Pop() and empty() belong
+ * to the one consumer thread.
+ **/
+template<typename T>
+class IntrusiveMpscQueue {
+public:
+    IntrusiveMpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    IntrusiveMpscQueue(const IntrusiveMpscQueue &) = delete;
+    IntrusiveMpscQueue &operator=(const IntrusiveMpscQueue &) = delete;
+
+    // any thread
+    void Push(T *node) { PushChain(node, node); }
+
+    // any thread, first to last linked through next already, nothing pushed meanwhile gets in between
+    void PushChain(MpscQueueNode *first, MpscQueueNode *last)
+    {
+        last->next.store(nullptr, std::memory_order_relaxed);
+        // seq_cst, so a consumer that checks empty() after announcing it will sleep sees this node
+        MpscQueueNode *prev = head_.exchange(last, std::memory_order_seq_cst);
+        // the consumer can't get past prev until this store, see Pop()
+        prev->next.store(first, std::memory_order_release);
+    }
+
+    /**
+     * consumer, nullptr if the queue is empty, or if the oldest node is
+     * pushed but its producer hasn't linked it yet; empty() tells them apart
+     **/
+    T *Pop()
+    {
+        MpscQueueNode *tail = tail_;
+        MpscQueueNode *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) { return nullptr; }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+        if (tail != head_.load(std::memory_order_acquire)) { return nullptr; }
+        // tail is the last node, the stub goes behind it so tail can be handed out
+        PushChain(&stub_, &stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+        return nullptr;
+    }
+
+    // consumer
+    bool empty() const { return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_; }
+
+private:
+    // producers
+    std::atomic<MpscQueueNode *> head_;
+    char padding_[64];
+    // consumer
+    MpscQueueNode *tail_;
+    MpscQueueNode stub_;
+};
+
+/**
+ * IntrusiveMpscQueue of values, each in a node Push() allocates and Pop()
+ * frees. A mutex-guarded std::queue, what Thread used before, allocates only
+ * once per 512 bytes of values, but every producer takes the lock, and one
+ * preempted while it holds it stalls the others and the consumer. Here a
+ * producer never waits. On one core, where the lock is never contended,
+ * the allocation and the yield below cost 5-15% a task with one producer
+ * and up to 30% with four (see mpsc_queue_bench.cc).
+ *
+ * The window between a producer's exchange and its link is two
+ * instructions, Pop() yields to the producer if it has been preempted there.
+ **/
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() : size_(0) {}
+
+    ~MpscQueue() { Clear(); }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // any thread
+    void Push(T &&value)
+    {
+        queue_.Push(new Node(std::move(value)));
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // any thread, the values come out in order and nothing pushed meanwhile gets in between
+    void Push(T *values, size_t count)
+    {
+        if (count == 0) { return; }
+        Node *first = new Node(std::move(values[0]));
+        Node *last = first;
+        for (size_t i = 1; i < count; ++i) {
+            Node *node = new Node(std::move(values[i]));
+            last->next.store(node, std::memory_order_relaxed);
+            last = node;
+        }
+        // the release store in PushChain() publishes the whole chain
+        queue_.PushChain(first, last);
+        size_.fetch_add(static_cast<long>(count), std::memory_order_relaxed);
+    }
+
+    // consumer, false if nothing was pushed
+    bool Pop(T *value)
+    {
+        Node *node;
+        for (int spins = 0; (node = queue_.Pop()) == nullptr; ++spins) {
+            if (queue_.empty()) { return false; }
+            // a producer swapped head_ but hasn't linked its node yet
+            if (spins >= 64) { std::this_thread::yield(); }
+        }
+        *value = std::move(node->value);
+        delete node;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // consumer
+    bool empty() const { return queue_.empty(); }
+
+    // consumer
+    void Clear()
+    {
+        T value;
+        while (Pop(&value)) {}
+    }
+
+    // any thread, only a snapshot while producers are running
+    size_t size() const
+    {
+        const long size = size_.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+private:
+    struct Node : MpscQueueNode {
+        explicit Node(T &&v) : value(std::move(v)) {}
+
+        T value;
+    };
+
+    IntrusiveMpscQueue<Node> queue_;
+    // Pop() may run before the producer's increment, hence signed
+    std::atomic<long> size_;
+};
+
+}// namespace sled
+
+#endif// SLED_QUEUE_MPSC_QUEUE_H
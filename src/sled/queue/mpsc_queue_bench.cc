@@ -0,0 +1,95 @@
+#include <queue>
+#include <sled/queue/mpsc_queue.h>
+#include <sled/synchronization/mutex.h>
+#include <sled/task_queue/unique_task.h>
+#include <sled/testing/benchmark.h>
+#include <thread>
+#include <vector>
+
+namespace {
+// what Thread queued its tasks in before MpscQueue
+class MutexQueue {
+public:
+    void Push(sled::UniqueTask &&task)
+    {
+        sled::MutexLock lock(&mutex_);
+        tasks_.push(std::move(task));
+    }
+
+    bool Pop(sled::UniqueTask *task)
+    {
+        sled::MutexLock lock(&mutex_);
+        if (tasks_.empty()) { return false; }
+        *task = std::move(tasks_.front());
+        tasks_.pop();
+        return true;
+    }
+
+private:
+    sled::Mutex mutex_;
+    std::queue<sled::UniqueTask> tasks_;
+};
+
+// `producers` threads push s.iterations() tasks between them while this
+// thread pops and runs them, ns/op is per task and the result allocations
+// per task (see -out-fmt=csv), the task itself doesn't allocate
+template<typename Queue>
+void
+PushPop(picobench::state &s, int producers)
+{
+    Queue queue;
+    int ran = 0;
+    std::vector<std::thread> threads;
+    const uint64_t allocs = sled::AllocationCount();
+    s.start_timer();
+    for (int p = 0; p < producers; ++p) {
+        const int count = s.iterations() / producers + (p < s.iterations() % producers ? 1 : 0);
+        threads.emplace_back([&queue, &ran, count] {
+            for (int i = 0; i < count; ++i) {
+                queue.Push([&ran] { ++ran; });
+            }
+        });
+    }
+    sled::UniqueTask task;
+    while (ran < s.iterations()) {
+        if (queue.Pop(&task)) {
+            task();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    for (auto &thread : threads) { thread.join(); }
+    s.stop_timer();
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+}
+}// namespace
+
+static void
+MutexQueue1Producer(picobench::state &s)
+{
+    PushPop<MutexQueue>(s, 1);
+}
+
+static void
+MutexQueue4Producers(picobench::state &s)
+{
+    PushPop<MutexQueue>(s, 4);
+}
+
+static void
+MpscQueue1Producer(picobench::state &s)
+{
+    PushPop<sled::MpscQueue<sled::UniqueTask>>(s, 1);
+}
+
+static void
+MpscQueue4Producers(picobench::state &s)
+{
+    PushPop<sled::MpscQueue<sled::UniqueTask>>(s, 4);
+}
+
+PICOBENCH_SUITE("MpscQueue");
+PICOBENCH(MutexQueue1Producer);
+PICOBENCH(MutexQueue4Producers);
+PICOBENCH(MpscQueue1Producer);
+PICOBENCH(MpscQueue4Producers);
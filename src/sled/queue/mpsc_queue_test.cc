@@ -0,0 +1,119 @@
+#include <memory>
+#include <sled/queue/mpsc_queue.h>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("MpscQueue")
+{
+    TEST_CASE("fifo")
+    {
+        sled::MpscQueue<int> queue;
+        int value = 0;
+        CHECK(queue.empty());
+        CHECK_FALSE(queue.Pop(&value));
+        for (int i = 0; i < 3; ++i) { queue.Push(int(i)); }
+        CHECK_FALSE(queue.empty());
+        CHECK_EQ(queue.size(), 3);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(queue.Pop(&value));
+            CHECK_EQ(value, i);
+        }
+        CHECK(queue.empty());
+        CHECK_EQ(queue.size(), 0);
+    }
+
+    TEST_CASE("batch")
+    {
+        sled::MpscQueue<int> queue;
+        int values[] = {1, 2, 3};
+        queue.Push(0);
+        queue.Push(values, 3);
+        queue.Push(values, 0);
+        queue.Push(4);
+        CHECK_EQ(queue.size(), 5);
+        int value = 0;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(queue.Pop(&value));
+            CHECK_EQ(value, i);
+        }
+        CHECK(queue.empty());
+    }
+
+    TEST_CASE("clear frees the values")
+    {
+        auto value = std::make_shared<int>(1);
+        {
+            sled::MpscQueue<std::shared_ptr<int>> queue;
+            queue.Push(std::shared_ptr<int>(value));
+            queue.Push(std::shared_ptr<int>(value));
+            std::shared_ptr<int> popped;
+            REQUIRE(queue.Pop(&popped));
+            popped.reset();
+            // Pop() frees the node with the moved-from value
+            CHECK_EQ(value.use_count(), 2);
+            queue.Clear();
+            CHECK_EQ(value.use_count(), 1);
+            queue.Push(std::shared_ptr<int>(value));
+        }
+        CHECK_EQ(value.use_count(), 1);
+    }
+
+    TEST_CASE("intrusive")
+    {
+        struct Item : sled::MpscQueueNode {
+            Item(int v) : value(v) {}
+
+            int value;
+        };
+
+        sled::IntrusiveMpscQueue<Item> queue;
+        Item items[] = {{0}, {1}, {2}, {3}};
+        CHECK(queue.empty());
+        CHECK_EQ(queue.Pop(), nullptr);
+        queue.Push(&items[0]);
+        items[1].next.store(&items[2]);
+        queue.PushChain(&items[1], &items[2]);
+        queue.Push(&items[3]);
+        for (int i = 0; i < 4; ++i) {
+            Item *item = queue.Pop();
+            REQUIRE(item != nullptr);
+            CHECK_EQ(item, &items[i]);
+        }
+        CHECK(queue.empty());
+        CHECK_EQ(queue.Pop(), nullptr);
+
+        // a popped node can go in again
+        queue.Push(&items[0]);
+        CHECK_EQ(queue.Pop(), &items[0]);
+        CHECK(queue.empty());
+    }
+
+    TEST_CASE("producers keep their own order")
+    {
+        constexpr int kProducers = 8;
+        constexpr int kPerProducer = 20000;
+        sled::MpscQueue<int> queue;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&queue, p] {
+                for (int i = 0; i < kPerProducer; ++i) { queue.Push(p * kPerProducer + i); }
+            });
+        }
+        std::vector<int> next(kProducers, 0);
+        bool in_order = true;
+        int received = 0;
+        while (received < kProducers * kPerProducer) {
+            int value;
+            if (!queue.Pop(&value)) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int p = value / kPerProducer;
+            in_order = in_order && value % kPerProducer == next[p]++;
+            ++received;
+        }
+        for (auto &t : producers) { t.join(); }
+        CHECK(in_order);
+        CHECK(queue.empty());
+    }
+}
@@ -38,14 +38,24 @@
 // network
 #include "sled/network/async_resolver.h"
 #include "sled/network/async_resolver_interface.h"
+#include "sled/network/connection_pool.h"
+#include "sled/network/host_resolver.h"
+#include "sled/network/io_uring_socket_server.h"
 #include "sled/network/ip_address.h"
+#include "sled/network/kcp/kcp.h"
+#include "sled/network/kcp/kcp_socket.h"
 #include "sled/network/null_socket_server.h"
+#include "sled/network/paced_socket.h"
 #include "sled/network/physical_socket_server.h"
+#include "sled/network/reactor_group.h"
 #include "sled/network/rpc.h"
+#include "sled/network/rpc_socket_connection.h"
 #include "sled/network/socket.h"
 #include "sled/network/socket_address.h"
 #include "sled/network/socket_factory.h"
 #include "sled/network/socket_server.h"
+#include "sled/network/token_bucket.h"
+#include "sled/network/virtual_socket_server.h"
 
 // numerics
 #include "sled/numerics/divide_round.h"
@@ -67,7 +77,11 @@
 // system
 #include "sled/system/fiber/scheduler.h"
 #include "sled/system/fiber/wait_group.h"
+#include "sled/system/cpu_affinity.h"
 #include "sled/system/location.h"
+#include "sled/system/sequenced_task_queue.h"
+#include "sled/system/sharded_runtime.h"
+#include "sled/system/shm_channel.h"
 #include "sled/system/thread.h"
 #include "sled/system/thread_pool.h"
 
@@ -75,6 +89,8 @@
 #include "sled/timer/task_queue_timeout.h"
 #include "sled/timer/timeout.h"
 #include "sled/timer/timer.h"
+#include "sled/timer/timer_service.h"
+#include "sled/timer/timing_wheel.h"
 
 // utility
 #include "sled/utility/move_on_copy.h"
@@ -0,0 +1,107 @@
+#include "sled/system/cpu_affinity.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <thread>
+
+namespace sled {
+
+namespace {
+// "0-3,8,10-11" as /sys writes cpu lists
+std::vector<int>
+ParseCpuList(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        int first = 0;
+        int last = 0;
+        const int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n <= 0) { continue; }
+        if (n == 1) { last = first; }
+        for (int cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+std::string
+NumaNodePath(int node)
+{
+    return "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+}
+}// namespace
+
+std::vector<int>
+AllowedCpus()
+{
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        for (int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+int
+NumaNodeCount()
+{
+    int nodes = 0;
+#if defined(__linux__)
+    while (std::ifstream(NumaNodePath(nodes)).good()) { ++nodes; }
+#endif
+    return std::max(nodes, 1);
+}
+
+std::vector<int>
+NumaNodeCpus(int node)
+{
+    if (node < 0) { return {}; }
+    std::ifstream file(NumaNodePath(node));
+    std::string list;
+    if (!std::getline(file, list)) { return {}; }
+    return ParseCpuList(list);
+}
+
+int
+SetCurrentThreadAffinity(const std::vector<int> &cpus)
+{
+    if (cpus.empty()) { return 0; }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) { return EINVAL; }
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    return ENOTSUP;
+#endif
+}
+
+void
+SetCurrentThreadName(const std::string &name)
+{
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+    pthread_setname_np(name.c_str());
+#endif
+}
+
+}// namespace sled
@@ -0,0 +1,33 @@
+/**
+ * @file     : cpu_affinity
+ * @created  : Sunday Oct 18, 2026 19:02:36 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_SYSTEM_CPU_AFFINITY_H
+#define SLED_SYSTEM_CPU_AFFINITY_H
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sled {
+
+// the cpus this process may run on, in ascending order
+std::vector<int> AllowedCpus();
+
+// NUMA nodes of this host, 1 where the platform doesn't tell
+int NumaNodeCount();
+
+// the cpus of NUMA node `node`, empty if there is no such node or the platform doesn't tell
+std::vector<int> NumaNodeCpus(int node);
+
+// keeps the calling thread to `cpus`, empty leaves it as it is; 0 or an errno value
+int SetCurrentThreadAffinity(const std::vector<int> &cpus);
+
+// the name ps, top and gdb show, Linux keeps the first 15 characters
+void SetCurrentThreadName(const std::string &name);
+
+}// namespace sled
+
+#endif// SLED_SYSTEM_CPU_AFFINITY_H
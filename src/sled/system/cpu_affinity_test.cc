@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <sled/system/cpu_affinity.h>
+#include <sled/system/fiber/wait_group.h>
+#include <sled/system/thread.h>
+#include <sled/system/thread_pool.h>
+
+namespace {
+std::vector<int>
+CurrentThreadCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) { return cpus; }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+std::string
+CurrentThreadName()
+{
+    char name[16] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return name;
+}
+}// namespace
+
+TEST_SUITE("CpuAffinity")
+{
+    TEST_CASE("cpus")
+    {
+        const std::vector<int> allowed = sled::AllowedCpus();
+        REQUIRE_FALSE(allowed.empty());
+        CHECK(std::is_sorted(allowed.begin(), allowed.end()));
+        CHECK_GE(sled::NumaNodeCount(), 1);
+        CHECK(sled::NumaNodeCpus(-1).empty());
+        CHECK(sled::NumaNodeCpus(1 << 20).empty());
+    }
+
+    TEST_CASE("current thread")
+    {
+        const std::vector<int> allowed = sled::AllowedCpus();
+        std::thread([&allowed] {
+            CHECK_EQ(sled::SetCurrentThreadAffinity({allowed.back()}), 0);
+            CHECK_EQ(CurrentThreadCpus(), std::vector<int>{allowed.back()});
+            CHECK_EQ(sled::SetCurrentThreadAffinity({}), 0);
+            CHECK_EQ(CurrentThreadCpus(), std::vector<int>{allowed.back()});
+            CHECK_NE(sled::SetCurrentThreadAffinity({-1}), 0);
+
+            sled::SetCurrentThreadName("a-name-longer-than-fifteen");
+            CHECK_EQ(CurrentThreadName(), "a-name-longer-t");
+        }).join();
+    }
+
+    TEST_CASE("Thread::Start")
+    {
+        const std::vector<int> allowed = sled::AllowedCpus();
+        auto thread = sled::Thread::Create();
+        sled::Thread::StartOptions options;
+        options.name = "sled-test";
+        options.cpus = {allowed.front()};
+        REQUIRE(thread->Start(options));
+        CHECK_EQ(thread->BlockingCall(CurrentThreadName), "sled-test");
+        CHECK_EQ(thread->BlockingCall(CurrentThreadCpus), options.cpus);
+        thread->Stop();
+    }
+
+    TEST_CASE("ThreadPool::Options")
+    {
+        const std::vector<int> allowed = sled::AllowedCpus();
+        sled::ThreadPool::Options options;
+        options.num_threads = 2;
+        options.worker_cpus = {{allowed.front()}, {allowed.back()}};
+        options.name = "pool";
+        options.spin_duration = sled::TimeDelta::Zero();
+        sled::ThreadPool pool(options);
+
+        sled::Mutex mutex;
+        std::vector<std::vector<int>> seen_cpus;
+        std::vector<std::string> seen_names;
+        sled::WaitGroup wg(64);
+        for (int i = 0; i < 64; ++i) {
+            pool.PostTask([&, wg] {
+                {
+                    sled::MutexLock lock(&mutex);
+                    seen_cpus.push_back(CurrentThreadCpus());
+                    seen_names.push_back(CurrentThreadName());
+                }
+                wg.Done();
+            });
+        }
+        wg.Wait();
+        sled::MutexLock lock(&mutex);
+        for (size_t i = 0; i < seen_cpus.size(); ++i) {
+            const bool on_a_worker_cpu =
+                seen_cpus[i] == options.worker_cpus[0] || seen_cpus[i] == options.worker_cpus[1];
+            CHECK(on_a_worker_cpu);
+            const bool named = seen_names[i] == "pool-0" || seen_names[i] == "pool-1";
+            CHECK(named);
+        }
+    }
+
+    TEST_CASE("ThreadPool on a NUMA node")
+    {
+        const std::vector<int> node_cpus = sled::NumaNodeCpus(0);
+        sled::ThreadPool::Options options;
+        options.numa_node = 0;
+        sled::ThreadPool pool(options);
+        if (node_cpus.empty()) { return; }
+        for (int cpu : pool.submit(CurrentThreadCpus).get()) {
+            CHECK(std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end());
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#include "sled/system/sequenced_task_queue.h"
+#include "sled/queue/mpsc_queue.h"
+#include "sled/synchronization/mutex.h"
+#include "sled/utility/move_on_copy.h"
+#include <atomic>
+
+namespace sled {
+
+constexpr size_t SequencedTaskQueue::kDrainBudget;
+
+struct SequencedTaskQueue::State {
+    State(SequencedTaskQueue *queue, ThreadPool *pool)
+        : queue(queue),
+          pool(pool),
+          pending(0),
+          closed(false),
+          running(0)
+    {}
+
+    SequencedTaskQueue *const queue;
+    ThreadPool *const pool;
+    // the drain running at the time is the one consumer
+    MpscQueue<UniqueTask> tasks;
+    // posted and not run yet, whoever raises it from 0 enqueues a drain
+    std::atomic<size_t> pending;
+    // set once the queue is being destroyed, nothing runs after that
+    std::atomic<bool> closed;
+    Mutex mutex;
+    ConditionVariable cv;
+    // drains past their check of `closed`, a new one may start just before the last ends
+    int running SLED_GUARDED_BY(mutex);
+};
+
+SequencedTaskQueue::SequencedTaskQueue(ThreadPool *pool)
+    : pool_(pool),
+      state_(std::make_shared<State>(this, pool))
+{}
+
+SequencedTaskQueue::~SequencedTaskQueue()
+{
+    {
+        MutexLock lock(&state_->mutex);
+        state_->closed.store(true, std::memory_order_release);
+        // the drain stops after the task that destroys us
+        if (IsCurrent()) { return; }
+        state_->cv.Wait(lock, [this]() { return state_->running == 0; });
+    }
+    // no drain runs any more, so the tasks can go right here
+    state_->tasks.Clear();
+}
+
+void
+SequencedTaskQueue::Delete()
+{
+    delete this;
+}
+
+void
+SequencedTaskQueue::PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location)
+{
+    Push(state_, &task, 1);
+}
+
+void
+SequencedTaskQueue::PostDelayedTaskImpl(UniqueTask &&task,
+                                        TimeDelta delay,
+                                        const PostDelayedTaskTraits &traits,
+                                        const Location &location)
+{
+    // the pool keeps the deadline and hands the task back when it is due
+    auto moved = MakeMoveOnCopy(task);
+    std::shared_ptr<State> state = state_;
+    pool_->PostDelayedTaskWithPrecision(traits.high_precision ? DelayPrecision::kHigh : DelayPrecision::kLow,
+                                        [state, moved] { Push(state, &moved.value, 1); }, delay, location);
+}
+
+void
+SequencedTaskQueue::PostTasksImpl(UniqueTask *tasks,
+                                  size_t count,
+                                  const PostTaskTraits &traits,
+                                  const Location &location)
+{
+    Push(state_, tasks, count);
+}
+
+void
+SequencedTaskQueue::BlockingCallImpl(UniqueTask &&functor, const Location &location)
+{
+    // waiting for ourselves would never end
+    if (IsCurrent()) {
+        functor();
+        return;
+    }
+    TaskQueueBase::BlockingCallImpl(std::move(functor), location);
+}
+
+void
+SequencedTaskQueue::Push(const std::shared_ptr<State> &state, UniqueTask *tasks, size_t count)
+{
+    if (state->closed.load(std::memory_order_acquire)) { return; }
+    state->tasks.Push(tasks, count);
+    if (state->pending.fetch_add(count, std::memory_order_acq_rel) == 0) {
+        state->pool->PostTask([state] { Drain(state); });
+    }
+}
+
+void
+SequencedTaskQueue::Drain(const std::shared_ptr<State> &state)
+{
+    {
+        MutexLock lock(&state->mutex);
+        if (state->closed.load(std::memory_order_relaxed)) { return; }
+        ++state->running;
+    }
+
+    bool idle = false;
+    {
+        CurrentTaskQueueSetter set_current(state->queue);
+        for (size_t ran = 0; ran < kDrainBudget && !state->closed.load(std::memory_order_acquire); ++ran) {
+            UniqueTask task;
+            // `pending` counts only what was pushed, at worst the link to it is still on its way
+            state->tasks.Pop(&task);
+            task();
+            task = nullptr;
+            if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                idle = true;
+                break;
+            }
+        }
+    }
+
+    // the budget is used up, the worker's other tasks get a turn first. Still
+    // counted as running, so the pool is there to post to
+    if (!idle && !state->closed.load(std::memory_order_acquire)) {
+        std::shared_ptr<State> self = state;
+        state->pool->PostTask([self] { Drain(self); });
+    }
+    {
+        MutexLock lock(&state->mutex);
+        --state->running;
+    }
+    state->cv.NotifyAll();
+}
+
+}// namespace sled
@@ -0,0 +1,68 @@
+/**
+ * @file     : sequenced_task_queue
+ * @created  : Sunday Oct 18, 2026 19:48:20 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_SYSTEM_SEQUENCED_TASK_QUEUE_H
+#define SLED_SYSTEM_SEQUENCED_TASK_QUEUE_H
+#pragma once
+
+#include "sled/system/thread_pool.h"
+#include <memory>
+
+namespace sled {
+
+/**
+ * A task queue without a thread of its own. Its tasks run on the workers of
+ * a shared ThreadPool, one at a time and in the order they were posted, with
+ * Current() being this queue. That makes it a cheap stand-in for a Thread
+ * where a stream of work only needs ordering, e.g. one per session.
+ *
+ * Posting to an idle queue enqueues a single pool task, which then runs up
+ * to kDrainBudget tasks before it yields the worker and enqueues itself
+ * again. Posting to a busy queue doesn't touch the pool at all.
+ *
+ * Task priorities are ignored, the order is FIFO across all of them.
+ **/
+class SequencedTaskQueue final : public TaskQueueBase {
+public:
+    // tasks run per pool task, before others get a turn on the worker
+    static constexpr size_t kDrainBudget = 64;
+
+    // `pool` must outlive the queue
+    explicit SequencedTaskQueue(ThreadPool *pool);
+    // waits for the running task unless called from it, the others are dropped
+    ~SequencedTaskQueue() override;
+
+    SequencedTaskQueue(const SequencedTaskQueue &) = delete;
+    SequencedTaskQueue &operator=(const SequencedTaskQueue &) = delete;
+
+    void Delete() override;
+
+protected:
+    void PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location) override;
+    void PostDelayedTaskImpl(UniqueTask &&task,
+                             TimeDelta delay,
+                             const PostDelayedTaskTraits &traits,
+                             const Location &location) override;
+    void PostTasksImpl(UniqueTask *tasks,
+                       size_t count,
+                       const PostTaskTraits &traits,
+                       const Location &location) override;
+    void BlockingCallImpl(UniqueTask &&functor, const Location &location) override;
+
+private:
+    struct State;
+
+    static void Push(const std::shared_ptr<State> &state, UniqueTask *tasks, size_t count);
+    static void Drain(const std::shared_ptr<State> &state);
+
+    ThreadPool *const pool_;
+    // shared with the pool and delayed tasks, which may outlive the queue
+    const std::shared_ptr<State> state_;
+};
+
+}// namespace sled
+
+#endif// SLED_SYSTEM_SEQUENCED_TASK_QUEUE_H
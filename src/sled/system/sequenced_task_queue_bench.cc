@@ -0,0 +1,60 @@
+#include <memory>
+#include <sled/system/fiber/wait_group.h>
+#include <sled/system/sequenced_task_queue.h>
+#include <sled/system/thread.h>
+#include <sled/testing/benchmark.h>
+#include <vector>
+
+// s.iterations() tasks spread over `queues` queues on one pool, the result is
+// allocations per task (see -out-fmt=csv)
+static void
+SequencedTaskQueuePostTask(picobench::state &s, size_t queues)
+{
+    sled::ThreadPool pool(-1);
+    std::vector<std::unique_ptr<sled::SequencedTaskQueue>> sequences;
+    for (size_t i = 0; i < queues; ++i) { sequences.emplace_back(new sled::SequencedTaskQueue(&pool)); }
+    sled::WaitGroup wg(s.iterations());
+    const uint64_t allocs = sled::AllocationCount();
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        sequences[i % queues]->PostTask([wg] { wg.Done(); });
+    }
+    wg.Wait();
+    s.stop_timer();
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+}
+
+static void
+SequencedTaskQueue1Queue(picobench::state &s)
+{
+    SequencedTaskQueuePostTask(s, 1);
+}
+
+static void
+SequencedTaskQueue1000Queues(picobench::state &s)
+{
+    SequencedTaskQueuePostTask(s, 1000);
+}
+
+// the same ordering from a dedicated thread
+static void
+SequencedTaskQueueVsThread(picobench::state &s)
+{
+    auto thread = sled::Thread::Create();
+    thread->Start();
+    sled::WaitGroup wg(s.iterations());
+    const uint64_t allocs = sled::AllocationCount();
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        thread->PostTask([wg] { wg.Done(); });
+    }
+    wg.Wait();
+    s.stop_timer();
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+    thread->Stop();
+}
+
+PICOBENCH_SUITE("SequencedTaskQueue");
+PICOBENCH(SequencedTaskQueueVsThread);
+PICOBENCH(SequencedTaskQueue1Queue);
+PICOBENCH(SequencedTaskQueue1000Queues);
@@ -0,0 +1,129 @@
+#include <atomic>
+#include <sled/synchronization/event.h>
+#include <sled/system/fiber/wait_group.h>
+#include <sled/system/sequenced_task_queue.h>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("SequencedTaskQueue")
+{
+    TEST_CASE("fifo, one at a time")
+    {
+        constexpr int kProducers = 4;
+        constexpr int kPerProducer = 5000;
+        sled::ThreadPool pool(4);
+        sled::SequencedTaskQueue queue(&pool);
+        std::vector<int> next(kProducers, 0);
+        std::atomic<int> inside(0);
+        bool in_order = true;
+        bool alone = true;
+        bool current = true;
+        sled::WaitGroup wg(kProducers * kPerProducer);
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < kProducers; ++p) {
+            producers.emplace_back([&, p] {
+                for (int i = 0; i < kPerProducer; ++i) {
+                    queue.PostTask([&, wg, p, i] {
+                        alone &= inside.fetch_add(1) == 0;
+                        current &= queue.IsCurrent();
+                        in_order &= next[p] == i;
+                        next[p] = i + 1;
+                        inside.fetch_sub(1);
+                        wg.Done();
+                    });
+                }
+            });
+        }
+        for (auto &t : producers) { t.join(); }
+        wg.Wait();
+        // the tasks ran on other threads, the queue publishes what they wrote
+        CHECK(queue.BlockingCall([&] { return in_order && alone && current; }));
+        CHECK_FALSE(queue.IsCurrent());
+    }
+
+    TEST_CASE("batch and delayed tasks keep their place")
+    {
+        sled::ThreadPool pool(2);
+        sled::SequencedTaskQueue queue(&pool);
+        std::vector<int> ran;
+        std::vector<sled::UniqueTask> tasks;
+        for (int i = 1; i <= 3; ++i) {
+            tasks.push_back([&ran, i] { ran.push_back(i); });
+        }
+        sled::Event done;
+        queue.PostDelayedTask(
+            [&] {
+                ran.push_back(4);
+                done.Set();
+            },
+            sled::TimeDelta::Millis(20));
+        queue.PostTask([&ran] { ran.push_back(0); });
+        queue.PostTasks(tasks.begin(), tasks.end());
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_EQ(queue.BlockingCall([&ran] { return ran; }), std::vector<int>{0, 1, 2, 3, 4});
+    }
+
+    TEST_CASE("BlockingCall from the queue itself")
+    {
+        sled::ThreadPool pool(1);
+        sled::SequencedTaskQueue queue(&pool);
+        CHECK_EQ(queue.BlockingCall([&queue] { return queue.BlockingCall([] { return 7; }); }), 7);
+    }
+
+    TEST_CASE("queues on one pool run side by side")
+    {
+        sled::ThreadPool pool(2);
+        sled::SequencedTaskQueue a(&pool);
+        sled::SequencedTaskQueue b(&pool);
+        sled::Event a_started;
+        sled::Event b_done;
+        bool b_ran_meanwhile = false;
+        a.PostTask([&] {
+            a_started.Set();
+            b_ran_meanwhile = b_done.Wait(sled::TimeDelta::Seconds(5));
+        });
+        REQUIRE(a_started.Wait(sled::TimeDelta::Seconds(5)));
+        b.PostTask([&] { b_done.Set(); });
+        CHECK(a.BlockingCall([&] { return b_ran_meanwhile; }));
+    }
+
+    TEST_CASE("destruction drops the pending tasks")
+    {
+        sled::ThreadPool pool(1);
+        auto value = std::make_shared<int>(0);
+        sled::Event release;
+        sled::Event started;
+        auto *queue = new sled::SequencedTaskQueue(&pool);
+        queue->PostTask([&] {
+            started.Set();
+            release.Wait(sled::TimeDelta::Seconds(5));
+        });
+        queue->PostTask([value] { ++*value; });
+        queue->PostDelayedTask([value] { ++*value; }, sled::TimeDelta::Millis(10));
+        REQUIRE(started.Wait(sled::TimeDelta::Seconds(5)));
+        std::thread releaser([&release] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            release.Set();
+        });
+        // waits for the running task
+        queue->Delete();
+        releaser.join();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_EQ(*value, 0);
+        CHECK_EQ(value.use_count(), 1);
+    }
+
+    TEST_CASE("a task may destroy its queue")
+    {
+        sled::ThreadPool pool(1);
+        sled::Event done;
+        auto *queue = new sled::SequencedTaskQueue(&pool);
+        queue->PostTask([queue, &done] {
+            delete queue;
+            done.Set();
+        });
+        queue->PostTask([] { FAIL("ran after the queue was destroyed"); });
+        CHECK(done.Wait(sled::TimeDelta::Seconds(5)));
+    }
+}
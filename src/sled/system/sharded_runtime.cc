@@ -0,0 +1,287 @@
+#include "sled/system/sharded_runtime.h"
+#include "sled/log/log.h"
+#include "sled/network/physical_socket_server.h"
+#include "sled/system/cpu_affinity.h"
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace sled {
+
+namespace {
+// tasks one mailbox runs before the others get a turn
+constexpr size_t kDrainBudget = 256;
+constexpr size_t kCacheLineSize = 64;
+
+thread_local const ShardedRuntime *current_runtime = nullptr;
+thread_local int current_index = -1;
+
+size_t
+RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) { result <<= 1; }
+    return result;
+}
+
+void
+PinCurrentThread(int cpu)
+{
+    int err = SetCurrentThreadAffinity({cpu});
+    if (err != 0) { LOGW("ShardedRuntime", "failed to pin a shard to cpu {}: {}", cpu, strerror(err)); }
+}
+}// namespace
+
+/**
+ * A bounded ring in which head_ only moves on the producer and tail_ only on
+ * the consumer. Both keep a cached copy of the other's index and only load it
+ * again when the ring looks full or empty.
+ **/
+class ShardedRuntime::Mailbox {
+public:
+    explicit Mailbox(size_t capacity)
+        : slots_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2))),
+          mask_(slots_.size() - 1),
+          head_(0),
+          cached_tail_(0),
+          tail_(0),
+          cached_head_(0)
+    {}
+
+    // producer, keeps the order of what the ring had no room for
+    bool Push(std::function<void()> &&task)
+    {
+        if (overflow_.empty() && TryPush(task)) { return true; }
+        overflow_.push_back(std::move(task));
+        return false;
+    }
+
+    // producer, returns the number of tasks moved from the overflow into the ring
+    size_t FlushOverflow()
+    {
+        size_t moved = 0;
+        while (!overflow_.empty() && TryPush(overflow_.front())) {
+            overflow_.pop_front();
+            ++moved;
+        }
+        return moved;
+    }
+
+    bool overflow_empty() const { return overflow_.empty(); }
+
+    // consumer, runs up to `budget` tasks, false if more are waiting
+    bool Drain(size_t budget)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        for (size_t n = 0; n < budget; ++n) {
+            if (tail == cached_head_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail == cached_head_) { return true; }
+            }
+            std::function<void()> task = std::move(slots_[tail & mask_]);
+            slots_[tail & mask_] = nullptr;
+            tail_.store(++tail, std::memory_order_release);
+            task();
+        }
+        return tail == head_.load(std::memory_order_acquire);
+    }
+
+private:
+    bool TryPush(std::function<void()> &task)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ > mask_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ > mask_) { return false; }
+        }
+        slots_[head & mask_] = std::move(task);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::vector<std::function<void()>> slots_;
+    const size_t mask_;
+
+    // producer side
+    std::atomic<size_t> head_;
+    size_t cached_tail_;
+    std::deque<std::function<void()>> overflow_;
+    char padding_[kCacheLineSize];
+
+    // consumer side
+    std::atomic<size_t> tail_;
+    size_t cached_head_;
+};
+
+/**
+ * Drains its inbound mailboxes when its eventfd fires. Senders only write to
+ * the eventfd when no wakeup is pending yet, so a busy shard takes one
+ * syscall per batch rather than one per task.
+ **/
+class ShardedRuntime::Shard : public Dispatcher {
+public:
+    Shard(size_t index, size_t num_shards, size_t mailbox_capacity)
+        : index_(index),
+          thread_(Thread::CreateWithSocketServer()),
+          event_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+          wake_pending_(false),
+          flush_scheduled_(false)
+    {
+        if (event_fd_ < 0) { LOGE("ShardedRuntime", "eventfd failed: {}", strerror(errno)); }
+        for (size_t i = 0; i < num_shards; ++i) { inbound_.emplace_back(new Mailbox(mailbox_capacity)); }
+    }
+
+    ~Shard() override
+    {
+        if (event_fd_ >= 0) { close(event_fd_); }
+    }
+
+    void Start(const ShardedRuntime *runtime, int cpu)
+    {
+        thread_->Start();
+        thread_->BlockingCall([&] {
+            current_runtime = runtime;
+            current_index = static_cast<int>(index_);
+            if (cpu >= 0) { PinCurrentThread(cpu); }
+            server()->Add(this);
+        });
+    }
+
+    void Stop()
+    {
+        thread_->BlockingCall([this] {
+            server()->Remove(this);
+            current_runtime = nullptr;
+            current_index = -1;
+        });
+        thread_->Stop();
+    }
+
+    size_t index() const { return index_; }
+
+    Thread *thread() const { return thread_.get(); }
+
+    // the mailbox shard `from` sends to this one through
+    Mailbox *inbound(size_t from) const { return inbound_[from].get(); }
+
+    void Wake()
+    {
+        if (wake_pending_.exchange(true, std::memory_order_acq_rel)) { return; }
+        const uint64_t value = 1;
+        (void) ::write(event_fd_, &value, sizeof(value));
+    }
+
+    // the sending side, on this shard's thread only
+    bool flush_scheduled() const { return flush_scheduled_; }
+
+    void set_flush_scheduled(bool scheduled) { flush_scheduled_ = scheduled; }
+
+    uint32_t GetRequestedEvents() override { return DE_READ; }
+
+    void OnEvent(uint32_t, int) override
+    {
+        uint64_t value;
+        (void) ::read(event_fd_, &value, sizeof(value));
+        // pairs with Wake(), a sender either sees false and writes again or its task is drained below
+        wake_pending_.exchange(false, std::memory_order_acq_rel);
+        bool idle = true;
+        for (auto &mailbox : inbound_) { idle = mailbox->Drain(kDrainBudget) && idle; }
+        // gives sockets and posted tasks a turn before the rest
+        if (!idle) { Wake(); }
+    }
+
+    int GetDescriptor() override { return event_fd_; }
+
+    bool IsDescriptorClosed() override { return false; }
+
+private:
+    PhysicalSocketServer *server() const { return static_cast<PhysicalSocketServer *>(thread_->socketserver()); }
+
+    const size_t index_;
+    std::unique_ptr<Thread> thread_;
+    const int event_fd_;
+    std::atomic<bool> wake_pending_;
+    std::vector<std::unique_ptr<Mailbox>> inbound_;
+    bool flush_scheduled_;
+};
+
+ShardedRuntime::Options::Options() : num_shards(-1), pin_threads(true), mailbox_capacity(1024) {}
+
+ShardedRuntime::ShardedRuntime() : ShardedRuntime(Options()) {}
+
+ShardedRuntime::ShardedRuntime(const Options &options)
+{
+    const std::vector<int> cpus = AllowedCpus();
+    const size_t num_shards = options.num_shards > 0 ? options.num_shards : cpus.size();
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        shards_.emplace_back(new Shard(i, num_shards, options.mailbox_capacity));
+    }
+    for (size_t i = 0; i < num_shards; ++i) {
+        shards_[i]->Start(this, options.pin_threads ? cpus[i % cpus.size()] : -1);
+    }
+}
+
+ShardedRuntime::~ShardedRuntime()
+{
+    // every mailbox stays valid until no shard runs anymore
+    for (auto &shard : shards_) { shard->Stop(); }
+}
+
+Thread *
+ShardedRuntime::shard(size_t index) const
+{
+    return shards_[index]->thread();
+}
+
+int
+ShardedRuntime::current_shard() const
+{
+    return current_runtime == this ? current_index : -1;
+}
+
+void
+ShardedRuntime::SubmitTo(size_t shard, std::function<void()> task)
+{
+    Shard *to = shards_[shard].get();
+    if (current_runtime != this) {
+        to->thread()->PostTask(std::move(task));
+        return;
+    }
+
+    Shard *from = shards_[current_index].get();
+    if (!to->inbound(from->index())->Push(std::move(task)) && !from->flush_scheduled()) {
+        from->set_flush_scheduled(true);
+        from->thread()->PostTask([this, from] { FlushOverflow(from); });
+    }
+    to->Wake();
+}
+
+void
+ShardedRuntime::FlushOverflow(Shard *from)
+{
+    from->set_flush_scheduled(false);
+    size_t moved = 0;
+    bool pending = false;
+    for (auto &to : shards_) {
+        Mailbox *mailbox = to->inbound(from->index());
+        if (mailbox->overflow_empty()) { continue; }
+        const size_t n = mailbox->FlushOverflow();
+        if (n > 0) { to->Wake(); }
+        moved += n;
+        pending = pending || !mailbox->overflow_empty();
+    }
+    if (!pending) { return; }
+
+    from->set_flush_scheduled(true);
+    // back off while the receivers make no progress, so a stuck shard doesn't keep this one spinning
+    if (moved > 0) {
+        from->thread()->PostTask([this, from] { FlushOverflow(from); });
+    } else {
+        from->thread()->PostDelayedTask([this, from] { FlushOverflow(from); }, TimeDelta::Millis(1));
+    }
+}
+
+}// namespace sled
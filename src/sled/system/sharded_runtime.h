@@ -0,0 +1,73 @@
+/**
+ * @file     : sharded_runtime
+ * @created  : Sunday Oct 18, 2026 13:05:31 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_SYSTEM_SHARDED_RUNTIME_H
+#define SLED_SYSTEM_SHARDED_RUNTIME_H
+#pragma once
+
+#include "sled/system/thread.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sled {
+
+/**
+ * One thread per core, each with its own PhysicalSocketServer, which share
+ * nothing but messages. Every ordered pair of shards has a lock-free single
+ * producer, single consumer mailbox, so SubmitTo() from one shard to another
+ * neither takes a lock nor, while the target is busy, makes a syscall.
+ *
+ * Sockets, timers and whatever else a shard owns stay on its thread(); work
+ * for another shard is handed over with SubmitTo().
+ **/
+class ShardedRuntime final {
+public:
+    struct Options {
+        Options();
+
+        // -1 is one per core the process may run on
+        int num_shards;
+        // pins shard i to the i-th of those cores
+        bool pin_threads;
+        // tasks per mailbox, more wait in the sender until there is room
+        size_t mailbox_capacity;
+    };
+
+    ShardedRuntime();
+    explicit ShardedRuntime(const Options &options);
+    // stops all shards, tasks not run yet are dropped
+    ~ShardedRuntime();
+
+    ShardedRuntime(const ShardedRuntime &) = delete;
+    ShardedRuntime &operator=(const ShardedRuntime &) = delete;
+
+    size_t size() const { return shards_.size(); }
+
+    Thread *shard(size_t index) const;
+    // the index of the calling shard, -1 if it isn't one of ours
+    int current_shard() const;
+
+    /**
+     * Runs `task` on `shard`. From a shard it goes through the mailbox of the
+     * pair, from any other thread through the shard's task queue. Tasks from
+     * one sender to one shard run in the order they were submitted.
+     **/
+    void SubmitTo(size_t shard, std::function<void()> task);
+
+private:
+    class Mailbox;
+    class Shard;
+
+    // on the sending shard, retries the tasks its full mailboxes held back
+    void FlushOverflow(Shard *from);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}// namespace sled
+
+#endif// SLED_SYSTEM_SHARDED_RUNTIME_H
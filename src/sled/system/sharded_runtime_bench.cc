@@ -0,0 +1,47 @@
+#include <atomic>
+#include <sled/synchronization/event.h>
+#include <sled/system/sharded_runtime.h>
+
+namespace {
+sled::ShardedRuntime::Options
+TwoShards()
+{
+    sled::ShardedRuntime::Options options;
+    options.num_shards = 2;
+    return options;
+}
+}// namespace
+
+// shard 0 feeds shard 1, through the mailbox or through the mutex guarded task queue
+static void
+ShardedRuntimeCrossShard(picobench::state &s, bool mailbox)
+{
+    sled::ShardedRuntime runtime(TwoShards());
+    std::atomic<int> done(0);
+    runtime.shard(0)->BlockingCall([&] {
+        for (auto _ : s) {
+            if (mailbox) {
+                runtime.SubmitTo(1, [&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            } else {
+                runtime.shard(1)->PostTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        }
+    });
+    while (done.load(std::memory_order_relaxed) < s.iterations()) { std::this_thread::yield(); }
+}
+
+void
+ShardedRuntimeSubmitTo(picobench::state &s)
+{
+    ShardedRuntimeCrossShard(s, true);
+}
+
+void
+ShardedRuntimeThreadPostTask(picobench::state &s)
+{
+    ShardedRuntimeCrossShard(s, false);
+}
+
+PICOBENCH_SUITE("ShardedRuntime");
+PICOBENCH(ShardedRuntimeSubmitTo);
+PICOBENCH(ShardedRuntimeThreadPostTask);
@@ -0,0 +1,97 @@
+#include <atomic>
+#include <sled/synchronization/event.h>
+#include <sled/system/sharded_runtime.h>
+
+namespace {
+sled::ShardedRuntime::Options
+Shards(int num_shards, size_t mailbox_capacity = 1024)
+{
+    sled::ShardedRuntime::Options options;
+    options.num_shards = num_shards;
+    options.mailbox_capacity = mailbox_capacity;
+    return options;
+}
+}// namespace
+
+TEST_SUITE("ShardedRuntime")
+{
+    TEST_CASE("submit from outside")
+    {
+        sled::ShardedRuntime runtime(Shards(4));
+        REQUIRE_EQ(runtime.size(), 4);
+        CHECK_EQ(runtime.current_shard(), -1);
+        for (size_t i = 0; i < runtime.size(); ++i) {
+            sled::Event done;
+            int current = -1;
+            bool on_shard = false;
+            runtime.SubmitTo(i, [&] {
+                current = runtime.current_shard();
+                on_shard = sled::Thread::Current() == runtime.shard(i);
+                done.Set();
+            });
+            REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+            CHECK_EQ(current, static_cast<int>(i));
+            CHECK(on_shard);
+        }
+    }
+
+    TEST_CASE("default size")
+    {
+        sled::ShardedRuntime runtime;
+        CHECK_GE(runtime.size(), 1);
+    }
+
+    TEST_CASE("order survives a full mailbox")
+    {
+        // far more tasks than the mailbox holds
+        sled::ShardedRuntime runtime(Shards(2, 16));
+        constexpr int kTasks = 100000;
+        int next = 0;
+        bool in_order = true;
+        sled::Event done;
+        runtime.SubmitTo(0, [&] {
+            for (int i = 0; i < kTasks; ++i) {
+                runtime.SubmitTo(1, [&, i] {
+                    in_order = in_order && i == next;
+                    if (++next == kTasks) { done.Set(); }
+                });
+            }
+        });
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(10)));
+        CHECK(in_order);
+        CHECK_EQ(next, kTasks);
+    }
+
+    TEST_CASE("all pairs")
+    {
+        sled::ShardedRuntime runtime(Shards(4, 64));
+        const int num_shards = static_cast<int>(runtime.size());
+        constexpr int kRounds = 1000;
+        // replies[i] counts the replies shard i got, it is only touched on shard i
+        std::vector<int> replies(num_shards, 0);
+        std::atomic<int> finished(0);
+        std::atomic<bool> misrouted(false);
+        sled::Event done;
+        for (int from = 0; from < num_shards; ++from) {
+            runtime.SubmitTo(from, [&, from] {
+                for (int round = 0; round < kRounds; ++round) {
+                    for (int to = 0; to < num_shards; ++to) {
+                        runtime.SubmitTo(to, [&, from, to] {
+                            if (runtime.current_shard() != to) { misrouted = true; }
+                            runtime.SubmitTo(from, [&, from] {
+                                if (++replies[from] == kRounds * num_shards && ++finished == num_shards) {
+                                    done.Set();
+                                }
+                            });
+                        });
+                    }
+                }
+            });
+        }
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(10)));
+        CHECK_FALSE(misrouted.load());
+        for (int i = 0; i < num_shards; ++i) {
+            CHECK_EQ(runtime.shard(i)->BlockingCall([&] { return replies[i]; }), kRounds * num_shards);
+        }
+    }
+}
@@ -0,0 +1,303 @@
+#include "sled/system/shm_channel.h"
+#include "sled/log/log.h"
+#include "sled/network/physical_socket_server.h"
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace sled {
+
+namespace {
+constexpr uint64_t kMagic = 0x6d68735f64656c73ULL;// "sled_shm"
+// the ring starts after the Header and its cache lines
+constexpr size_t kDataOffset = 256;
+constexpr size_t kMinCapacity = 4096;
+constexpr size_t kAlignment = 8;
+constexpr uint32_t kPadding = 1;
+
+// precedes every message, and the padding which skips the end of the ring
+struct RecordHeader {
+    uint32_t size;
+    uint32_t flags;
+};
+
+inline size_t
+AlignRecord(size_t size)
+{
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+inline size_t
+RoundUpToPowerOfTwo(size_t value)
+{
+    size_t result = kMinCapacity;
+    while (result < value) { result <<= 1; }
+    return result;
+}
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory needs address free atomics");
+}// namespace
+
+/**
+ * Positions only grow, the offset in the ring is `pos & (capacity - 1)`.
+ * Writers claim space by moving claim_pos and publish it by moving
+ * commit_pos in the same order, the reader never looks past commit_pos.
+ **/
+struct ShmChannel::Header {
+    uint64_t magic;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> claim_pos;
+    alignas(64) std::atomic<uint64_t> commit_pos;
+    alignas(64) std::atomic<uint64_t> read_pos;
+    // set by the reader before it waits on the eventfd
+    std::atomic<uint32_t> reader_sleeping;
+};
+
+class ShmChannel::Reader : public Dispatcher {
+public:
+    Reader(ShmChannel *channel, PhysicalSocketServer *ss, MessageHandler handler)
+        : channel_(channel),
+          ss_(ss),
+          handler_(std::move(handler))
+    {
+        ss_->Add(this);
+        // picks up what was written before
+        const uint64_t value = 1;
+        (void) ::write(channel_->event_fd_, &value, sizeof(value));
+    }
+
+    ~Reader() override { ss_->Remove(this); }
+
+    uint32_t GetRequestedEvents() override { return DE_READ; }
+
+    void OnEvent(uint32_t ff, int err) override
+    {
+        uint64_t value;
+        (void) ::read(channel_->event_fd_, &value, sizeof(value));
+        do { channel_->Read(handler_); } while (!channel_->PrepareToSleep());
+    }
+
+    int GetDescriptor() override { return channel_->event_fd_; }
+
+    bool IsDescriptorClosed() override { return false; }
+
+private:
+    ShmChannel *const channel_;
+    PhysicalSocketServer *const ss_;
+    const MessageHandler handler_;
+};
+
+std::unique_ptr<ShmChannel>
+ShmChannel::Create(size_t capacity)
+{
+#if defined(__linux__)
+    static_assert(sizeof(Header) <= kDataOffset, "Header overlaps the ring");
+    capacity = RoundUpToPowerOfTwo(capacity);
+    const size_t memory_size = kDataOffset + capacity;
+    int memory_fd = memfd_create("sled_shm_channel", MFD_CLOEXEC);
+    if (memory_fd < 0) {
+        LOGE("ShmChannel", "memfd_create failed: {}", strerror(errno));
+        return nullptr;
+    }
+    if (ftruncate(memory_fd, static_cast<off_t>(memory_size)) != 0) {
+        LOGE("ShmChannel", "ftruncate failed: {}", strerror(errno));
+        close(memory_fd);
+        return nullptr;
+    }
+    int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0) {
+        LOGE("ShmChannel", "eventfd failed: {}", strerror(errno));
+        close(memory_fd);
+        return nullptr;
+    }
+    void *memory = mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+    if (memory == MAP_FAILED) {
+        LOGE("ShmChannel", "mmap failed: {}", strerror(errno));
+        close(memory_fd);
+        close(event_fd);
+        return nullptr;
+    }
+
+    Header *header = new (memory) Header();
+    header->magic = kMagic;
+    header->capacity = capacity;
+    header->claim_pos.store(0, std::memory_order_relaxed);
+    header->commit_pos.store(0, std::memory_order_relaxed);
+    header->read_pos.store(0, std::memory_order_relaxed);
+    header->reader_sleeping.store(0, std::memory_order_relaxed);
+    return std::unique_ptr<ShmChannel>(new ShmChannel(memory_fd, event_fd, memory, memory_size));
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<ShmChannel>
+ShmChannel::Open(int memory_fd, int event_fd)
+{
+    struct stat st;
+    void *memory = MAP_FAILED;
+    if (fstat(memory_fd, &st) == 0 && static_cast<size_t>(st.st_size) > kDataOffset) {
+        memory = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+    }
+    const Header *header = static_cast<const Header *>(memory);
+    if (memory == MAP_FAILED || header->magic != kMagic
+        || kDataOffset + header->capacity != static_cast<size_t>(st.st_size)) {
+        LOGE("ShmChannel", "fd {} does not hold a channel", memory_fd);
+        if (memory != MAP_FAILED) { munmap(memory, st.st_size); }
+        close(memory_fd);
+        close(event_fd);
+        return nullptr;
+    }
+    fcntl(event_fd, F_SETFL, fcntl(event_fd, F_GETFL, 0) | O_NONBLOCK);
+    return std::unique_ptr<ShmChannel>(new ShmChannel(memory_fd, event_fd, memory, st.st_size));
+}
+
+ShmChannel::ShmChannel(int memory_fd, int event_fd, void *memory, size_t memory_size)
+    : memory_fd_(memory_fd),
+      event_fd_(event_fd),
+      memory_(memory),
+      memory_size_(memory_size),
+      header_(static_cast<Header *>(memory))
+{}
+
+ShmChannel::~ShmChannel()
+{
+    reader_.reset();
+    munmap(memory_, memory_size_);
+    close(memory_fd_);
+    close(event_fd_);
+}
+
+bool
+ShmChannel::SetInheritable(bool inheritable)
+{
+    for (int fd : {memory_fd_, event_fd_}) {
+        int flags = fcntl(fd, F_GETFD);
+        if (flags < 0) { return false; }
+        flags = inheritable ? (flags & ~FD_CLOEXEC) : (flags | FD_CLOEXEC);
+        if (fcntl(fd, F_SETFD, flags) != 0) { return false; }
+    }
+    return true;
+}
+
+size_t
+ShmChannel::capacity() const
+{
+    return header_->capacity;
+}
+
+size_t
+ShmChannel::max_message_size() const
+{
+    // the padding in front of a record is shorter than the record
+    return capacity() / 2 - sizeof(RecordHeader);
+}
+
+uint8_t *
+ShmChannel::data() const
+{
+    return static_cast<uint8_t *>(memory_) + kDataOffset;
+}
+
+bool
+ShmChannel::Write(const void *data, size_t size)
+{
+    if (size > max_message_size()) { return false; }
+
+    const uint64_t capacity = header_->capacity;
+    const uint64_t record = AlignRecord(sizeof(RecordHeader) + size);
+    uint64_t pos = header_->claim_pos.load(std::memory_order_relaxed);
+    uint64_t padding;
+    do {
+        // a record never wraps, the rest of the ring is skipped instead
+        const uint64_t contiguous = capacity - (pos & (capacity - 1));
+        padding = record > contiguous ? contiguous : 0;
+        if (pos + padding + record - header_->read_pos.load(std::memory_order_acquire) > capacity) { return false; }
+    } while (!header_->claim_pos.compare_exchange_weak(pos, pos + padding + record, std::memory_order_relaxed));
+
+    uint8_t *ring = this->data();
+    if (padding > 0) {
+        const RecordHeader skip = {static_cast<uint32_t>(padding - sizeof(RecordHeader)), kPadding};
+        memcpy(ring + (pos & (capacity - 1)), &skip, sizeof(skip));
+    }
+    uint8_t *dest = ring + ((pos + padding) & (capacity - 1));
+    const RecordHeader message = {static_cast<uint32_t>(size), 0};
+    memcpy(dest, &message, sizeof(message));
+    memcpy(dest + sizeof(message), data, size);
+
+    // writers which claimed earlier publish first, they are one memcpy() away
+    for (int spins = 0; header_->commit_pos.load(std::memory_order_acquire) != pos; ++spins) {
+        if (spins > 64) { sched_yield(); }
+    }
+    header_->commit_pos.store(pos + padding + record, std::memory_order_release);
+    WakeReader();
+    return true;
+}
+
+size_t
+ShmChannel::Read(const MessageHandler &handler, size_t max_messages)
+{
+    const uint64_t mask = header_->capacity - 1;
+    const uint8_t *ring = data();
+    uint64_t pos = header_->read_pos.load(std::memory_order_relaxed);
+    uint64_t end = header_->commit_pos.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (pos != end && count < max_messages) {
+        RecordHeader record;
+        memcpy(&record, ring + (pos & mask), sizeof(record));
+        if (!(record.flags & kPadding)) {
+            handler(ring + (pos & mask) + sizeof(record), record.size);
+            ++count;
+        }
+        pos += AlignRecord(sizeof(record) + record.size);
+        // hand the space back right away, writers may be waiting for it
+        header_->read_pos.store(pos, std::memory_order_release);
+        if (pos == end) { end = header_->commit_pos.load(std::memory_order_acquire); }
+    }
+    return count;
+}
+
+void
+ShmChannel::StartReading(PhysicalSocketServer *ss, MessageHandler handler)
+{
+    reader_.reset();
+    reader_.reset(new Reader(this, ss, std::move(handler)));
+}
+
+void
+ShmChannel::StopReading()
+{
+    reader_.reset();
+    header_->reader_sleeping.store(0, std::memory_order_relaxed);
+}
+
+bool
+ShmChannel::PrepareToSleep()
+{
+    header_->reader_sleeping.store(1, std::memory_order_seq_cst);
+    if (header_->commit_pos.load(std::memory_order_seq_cst) == header_->read_pos.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    header_->reader_sleeping.store(0, std::memory_order_relaxed);
+    return false;
+}
+
+void
+ShmChannel::WakeReader()
+{
+    // pairs with PrepareToSleep(): either the reader sees the commit or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->reader_sleeping.load(std::memory_order_relaxed) == 0) { return; }
+    if (header_->reader_sleeping.exchange(0, std::memory_order_acq_rel) == 0) { return; }
+    const uint64_t value = 1;
+    (void) ::write(event_fd_, &value, sizeof(value));
+}
+
+}// namespace sled
@@ -0,0 +1,104 @@
+/**
+ * @file     : shm_channel
+ * @created  : Sunday Oct 18, 2026 09:12:40 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_SYSTEM_SHM_CHANNEL_H
+#define SLED_SYSTEM_SHM_CHANNEL_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+namespace sled {
+
+class PhysicalSocketServer;
+
+/**
+ * A ring of variable size messages in shared memory, for talking to child
+ * processes without going through a pipe. Writers copy a message straight
+ * into the ring, the reader gets a pointer into it, so a message is copied
+ * once instead of twice.
+ *
+ * The ring lives in a memfd and the reader is woken through an eventfd.
+ * fork()ed children inherit both; after exec() they must be reopened with
+ * Open() from inherited descriptors (see SetInheritable()) or ones passed
+ * with Socket::SendWithFds().
+ *
+ * Any number of threads or processes may Write(). Exactly one reads, either
+ * by calling Read() or through StartReading() on a PhysicalSocketServer, e.g.
+ * the one of Thread::CreateWithSocketServer(). A writer which dies in the
+ * middle of Write() stalls the ring.
+ **/
+class ShmChannel final {
+public:
+    using MessageHandler = std::function<void(const uint8_t *data, size_t size)>;
+
+    // `capacity` is rounded up to a power of two, nullptr if the kernel refuses
+    static std::unique_ptr<ShmChannel> Create(size_t capacity);
+    // maps the ring of another ShmChannel, takes ownership of the descriptors
+    static std::unique_ptr<ShmChannel> Open(int memory_fd, int event_fd);
+
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel &) = delete;
+    ShmChannel &operator=(const ShmChannel &) = delete;
+
+    int memory_fd() const { return memory_fd_; }
+
+    int event_fd() const { return event_fd_; }
+
+    // keeps both descriptors open across exec(), they are close-on-exec by default
+    bool SetInheritable(bool inheritable);
+
+    size_t capacity() const;
+
+    // larger messages are refused by Write()
+    size_t max_message_size() const;
+
+    /**
+     * Copies one message into the ring and wakes the reader if it sleeps.
+     * @return false if the ring is full or the message too large
+     **/
+    bool Write(const void *data, size_t size);
+
+    /**
+     * Hands up to `max_messages` messages to `handler`, in the order their
+     * writes finished. The data is only valid during the call.
+     * @return the number of messages read
+     **/
+    size_t Read(const MessageHandler &handler, size_t max_messages = std::numeric_limits<size_t>::max());
+
+    /**
+     * Reads whenever something arrives, `handler` runs on the thread of `ss`.
+     * Call both on that thread.
+     **/
+    void StartReading(PhysicalSocketServer *ss, MessageHandler handler);
+    void StopReading();
+
+private:
+    struct Header;
+    class Reader;
+
+    ShmChannel(int memory_fd, int event_fd, void *memory, size_t memory_size);
+
+    uint8_t *data() const;
+    // arms the wakeup, false if messages arrived in the meantime
+    bool PrepareToSleep();
+    void WakeReader();
+
+    const int memory_fd_;
+    const int event_fd_;
+    void *const memory_;
+    const size_t memory_size_;
+    Header *const header_;
+    std::unique_ptr<Reader> reader_;
+};
+
+}// namespace sled
+
+#endif// SLED_SYSTEM_SHM_CHANNEL_H
@@ -0,0 +1,38 @@
+#include <sled/system/shm_channel.h>
+#include <unistd.h>
+
+// one iteration is a 64 byte message written and read back on the same thread
+static void
+ShmChannelWriteRead(picobench::state &s)
+{
+    auto channel = sled::ShmChannel::Create(64 * 1024);
+    uint8_t payload[64] = {0};
+    size_t received = 0;
+    for (auto _ : s) {
+        channel->Write(payload, sizeof(payload));
+        channel->Read([&](const uint8_t *, size_t size) { received += size; });
+    }
+    s.set_result(received);
+}
+
+// the same through a pipe, what Process offers for talking to a child
+static void
+PipeWriteRead(picobench::state &s)
+{
+    int fds[2];
+    if (pipe(fds) != 0) { return; }
+    uint8_t payload[64] = {0};
+    uint8_t buf[64];
+    size_t received = 0;
+    for (auto _ : s) {
+        (void) write(fds[1], payload, sizeof(payload));
+        received += read(fds[0], buf, sizeof(buf));
+    }
+    close(fds[0]);
+    close(fds[1]);
+    s.set_result(received);
+}
+
+PICOBENCH_SUITE("ShmChannel");
+PICOBENCH(ShmChannelWriteRead);
+PICOBENCH(PipeWriteRead);
@@ -0,0 +1,162 @@
+#include <atomic>
+#include <sled/network/physical_socket_server.h>
+#include <sled/synchronization/event.h>
+#include <sled/system/shm_channel.h>
+#include <sled/system/thread.h>
+#include <sled/time_utils.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+std::string
+Message(int i)
+{
+    // 1 to 300 bytes, so records wrap at every offset
+    return std::string(1 + (i * 37) % 300, static_cast<char>('a' + i % 26));
+}
+}// namespace
+
+TEST_SUITE("ShmChannel")
+{
+    TEST_CASE("write and read")
+    {
+        auto channel = sled::ShmChannel::Create(0);
+        REQUIRE(channel);
+        CHECK_EQ(channel->capacity(), 4096);
+
+        int written = 0;
+        int read = 0;
+        while (read < 10000) {
+            while (written < 10000) {
+                const std::string message = Message(written);
+                if (!channel->Write(message.data(), message.size())) { break; }
+                ++written;
+            }
+            CHECK_GT(written, read);
+            channel->Read([&](const uint8_t *data, size_t size) {
+                CHECK_EQ(std::string(reinterpret_cast<const char *>(data), size), Message(read));
+                ++read;
+            });
+            CHECK_EQ(read, written);
+        }
+        CHECK_EQ(channel->Read([](const uint8_t *, size_t) {}), 0);
+    }
+
+    TEST_CASE("full")
+    {
+        auto channel = sled::ShmChannel::Create(4096);
+        REQUIRE(channel);
+        CHECK_FALSE(channel->Write(std::string(channel->max_message_size() + 1, 'x').data(),
+                                   channel->max_message_size() + 1));
+        const std::string message(channel->max_message_size(), 'x');
+        CHECK(channel->Write(message.data(), message.size()));
+        CHECK(channel->Write(message.data(), message.size()));
+        CHECK_FALSE(channel->Write("", 0));
+        CHECK_EQ(channel->Read([](const uint8_t *, size_t) {}, 1), 1);
+        // wraps to the start, where the first message was
+        CHECK(channel->Write(message.data(), message.size()));
+        CHECK_FALSE(channel->Write("", 0));
+        size_t sizes = 0;
+        CHECK_EQ(channel->Read([&](const uint8_t *, size_t size) { sizes += size; }), 2);
+        CHECK_EQ(sizes, 2 * message.size());
+        CHECK(channel->Write("", 0));
+    }
+
+    TEST_CASE("many writers, one dispatcher")
+    {
+        auto channel = sled::ShmChannel::Create(64 * 1024);
+        REQUIRE(channel);
+        auto thread = sled::Thread::CreateWithSocketServer();
+        thread->Start();
+
+        constexpr int kWriters = 4;
+        constexpr int kMessages = 20000;
+        std::vector<int> next(kWriters, 0);
+        std::atomic<int> received(0);
+        std::atomic<bool> in_order(true);
+        sled::Event done;
+        thread->BlockingCall([&] {
+            channel->StartReading(static_cast<sled::PhysicalSocketServer *>(thread->socketserver()),
+                                  [&](const uint8_t *data, size_t size) {
+                                      int message[2];
+                                      memcpy(message, data, sizeof(message));
+                                      // each writer's messages arrive in its order
+                                      if (size != sizeof(message) || message[1] != next[message[0]]++) {
+                                          in_order = false;
+                                      }
+                                      if (++received == kWriters * kMessages) { done.Set(); }
+                                  });
+        });
+
+        std::vector<std::thread> writers;
+        for (int w = 0; w < kWriters; ++w) {
+            writers.emplace_back([&, w] {
+                for (int i = 0; i < kMessages; ++i) {
+                    const int message[2] = {w, i};
+                    while (!channel->Write(message, sizeof(message))) { std::this_thread::yield(); }
+                    // gives the reader a chance to go to sleep now and then
+                    if (i % 1000 == 0) { sled::Thread::SleepMs(1); }
+                }
+            });
+        }
+        for (auto &writer : writers) { writer.join(); }
+        CHECK(done.Wait(sled::TimeDelta::Seconds(10)));
+        CHECK_EQ(received.load(), kWriters * kMessages);
+        CHECK(in_order.load());
+        thread->BlockingCall([&] { channel->StopReading(); });
+        thread->Stop();
+    }
+
+    TEST_CASE("forked writer")
+    {
+        auto channel = sled::ShmChannel::Create(8192);
+        REQUIRE(channel);
+        constexpr int kMessages = 5000;
+        const pid_t pid = fork();
+        REQUIRE_GE(pid, 0);
+        if (pid == 0) {
+            for (int i = 0; i < kMessages; ++i) {
+                const std::string message = Message(i);
+                while (!channel->Write(message.data(), message.size())) { sched_yield(); }
+            }
+            _exit(0);
+        }
+
+        int read = 0;
+        bool equal = true;
+        const int64_t deadline_ms = sled::TimeMillis() + 10000;
+        while (read < kMessages && sled::TimeMillis() < deadline_ms) {
+            channel->Read([&](const uint8_t *data, size_t size) {
+                equal = equal && std::string(reinterpret_cast<const char *>(data), size) == Message(read);
+                ++read;
+            });
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        CHECK_EQ(read, kMessages);
+        CHECK(equal);
+        CHECK(WIFEXITED(status));
+    }
+
+    TEST_CASE("open from descriptors")
+    {
+        auto writer = sled::ShmChannel::Create(4096);
+        REQUIRE(writer);
+        CHECK(writer->SetInheritable(true));
+        auto reader = sled::ShmChannel::Open(dup(writer->memory_fd()), dup(writer->event_fd()));
+        REQUIRE(reader);
+        CHECK_EQ(reader->capacity(), writer->capacity());
+        CHECK(writer->Write("hello", 5));
+        std::string received;
+        CHECK_EQ(reader->Read([&](const uint8_t *data, size_t size) {
+                     received.assign(reinterpret_cast<const char *>(data), size);
+                 }),
+                 1);
+        CHECK_EQ(received, "hello");
+
+        int fds[2];
+        REQUIRE_EQ(pipe(fds), 0);
+        CHECK_FALSE(sled::ShmChannel::Open(fds[0], fds[1]));
+    }
+}
@@ -1,11 +1,14 @@
 #include "sled/system/thread.h"
 #include "sled/cleanup.h"
+#include "sled/log/log.h"
 #include "sled/network/null_socket_server.h"
 #include "sled/network/socket_server.h"
 #include "sled/synchronization/event.h"
 #include "sled/synchronization/thread_local.h"
+#include "sled/system/cpu_affinity.h"
 #include "sled/time_utils.h"
 #include <atomic>
+#include <cstring>
 #include <memory>
 #include <thread>
 
@@ -117,6 +120,9 @@ Thread::Thread(std::unique_ptr<SocketServer> ss) : Thread(std::move(ss), /*do_in
 
 Thread::Thread(SocketServer *ss, bool do_init)
     : delayed_next_num_(0),
+      wheel_(std::make_shared<TimingWheel>(TimeMillis())),
+      next_delayed_run_ms_(TimingWheel::kNever),
+      waiting_(false),
       fInitialized_(false),
       fDestroyed_(false),
       stop_(0),
@@ -151,8 +157,10 @@ Thread::DoDestroy()
     fDestroyed_ = true;
     if (ss_) { ss_->SetMessageQueue(nullptr); }
     CurrentTaskQueueSetter set_current(this);
-    messages_ = {};
+    for (auto &messages : messages_) { messages.Clear(); }
     delayed_messages_ = {};
+    wheel_->Clear();
+    next_delayed_run_ms_.store(TimingWheel::kNever, std::memory_order_relaxed);
 }
 
 SocketServer *
@@ -199,7 +207,7 @@ Thread::Run()
     ProcessMessages(kForever);
 }
 
-std::function<void()>
+UniqueTask
 Thread::Get(int cmsWait)
 {
     int64_t cmsTotal = cmsWait;
@@ -208,26 +216,35 @@ Thread::Get(int cmsWait)
     int64_t msCurrent = msStart;
 
     while (true) {
-        int64_t cmsDelayNext = kForever;
-        {
+        waiting_.store(false, std::memory_order_relaxed);
+        // move the due delayed messages behind the posted kNormal ones
+        if (msCurrent >= next_delayed_run_ms_.load(std::memory_order_acquire)) {
             MutexLock lock(&mutex_);
-            // check delayed_messages_
-            while (!delayed_messages_.empty()) {
-                int64_t first_run_time_ms = delayed_messages_.top().run_time_ms;
-                if (msCurrent < first_run_time_ms) {
-                    cmsDelayNext = TimeDiff(first_run_time_ms, msCurrent);
-                    break;
-                }
-                messages_.push(std::move(delayed_messages_.top().functor));
+            MpscQueue<UniqueTask> &normal = messages_[static_cast<int>(Priority::kNormal)];
+            while (!delayed_messages_.empty() && msCurrent >= delayed_messages_.top().run_time_ms) {
+                normal.Push(std::move(delayed_messages_.top().functor));
                 delayed_messages_.pop();
             }
-            // check messages_
-            if (!messages_.empty()) {
-                std::function<void()> task = std::move(messages_.front());
-                messages_.pop();
-                return std::move(task);
-            }
+            wheel_->Advance(msCurrent, &due_);
+            for (auto &task : due_) { normal.Push(std::move(task)); }
+            due_.clear();
+            next_delayed_run_ms_.store(
+                std::min(delayed_messages_.empty() ? TimingWheel::kNever : delayed_messages_.top().run_time_ms,
+                         wheel_->NextExpiry()),
+                std::memory_order_release);
         }
+        const int level = picker_.Pick([this](int priority) { return !messages_[priority].empty(); });
+        UniqueTask task;
+        if (level >= 0 && messages_[level].Pop(&task)) { return task; }
+
+        // anything posted from now on must interrupt the Wait() below, pairs
+        // with the seq_cst push and load in PostTaskImpl()/PostDelayedTaskImpl()
+        waiting_.store(true, std::memory_order_seq_cst);
+        if (HasMessages()) { continue; }
+        const int64_t next_delayed_run_ms = next_delayed_run_ms_.load(std::memory_order_seq_cst);
+        if (msCurrent >= next_delayed_run_ms) { continue; }
+        int64_t cmsDelayNext = kForever;
+        if (next_delayed_run_ms != TimingWheel::kNever) { cmsDelayNext = TimeDiff(next_delayed_run_ms, msCurrent); }
 
         if (IsQuitting()) { break; }
 
@@ -255,42 +272,98 @@ Thread::Get(int cmsWait)
 }
 
 void
-Thread::PostTaskImpl(std::function<void()> &&task, const PostTaskTraits &traits, const Location &location)
+Thread::PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location)
 {
     if (IsQuitting()) { return; }
-    {
-        MutexLock lock(&mutex_);
-        messages_.push(std::move(task));
-    }
-    WakeUpSocketServer();
+    messages_[static_cast<int>(traits.priority)].Push(std::move(task));
+    // the loop checks messages_ again before it waits
+    if (waiting_.load(std::memory_order_seq_cst)) { WakeUpSocketServer(); }
 }
 
 void
-Thread::PostDelayedTaskImpl(std::function<void()> &&task,
+Thread::PostDelayedTaskImpl(UniqueTask &&task,
                             TimeDelta delay,
                             const PostDelayedTaskTraits &traits,
                             const Location &location)
 {
     if (IsQuitting()) { return; }
+    PostDelayedMessages(&task, 1, delay, traits.high_precision, nullptr);
+}
+
+void
+Thread::PostTasksImpl(UniqueTask *tasks, size_t count, const PostTaskTraits &traits, const Location &location)
+{
+    if (IsQuitting()) { return; }
+    messages_[static_cast<int>(traits.priority)].Push(tasks, count);
+    if (waiting_.load(std::memory_order_seq_cst)) { WakeUpSocketServer(); }
+}
+
+void
+Thread::PostDelayedTasksImpl(UniqueTask *tasks,
+                             size_t count,
+                             TimeDelta delay,
+                             const PostDelayedTaskTraits &traits,
+                             const Location &location)
+{
+    if (IsQuitting()) { return; }
+    PostDelayedMessages(tasks, count, delay, traits.high_precision, nullptr);
+}
+
+DelayedTaskHandle
+Thread::PostCancelableDelayedTaskImpl(UniqueTask &&task,
+                                     TimeDelta delay,
+                                     const PostDelayedTaskTraits &traits,
+                                     const Location &location)
+{
+    // high precision tasks stay in the heap and are only skipped
+    if (traits.high_precision) {
+        return TaskQueueBase::PostCancelableDelayedTaskImpl(std::move(task), delay, traits, location);
+    }
+    if (IsQuitting()) { return DelayedTaskHandle(); }
+    TimingWheel::TaskId id;
+    PostDelayedMessages(&task, 1, delay, false, &id);
+    std::weak_ptr<TimingWheel> weak_wheel = wheel_;
+    return DelayedTaskHandle([weak_wheel, id] {
+        std::shared_ptr<TimingWheel> wheel = weak_wheel.lock();
+        return wheel && wheel->Cancel(id);
+    });
+}
 
+void
+Thread::PostDelayedMessages(UniqueTask *tasks,
+                            size_t count,
+                            TimeDelta delay,
+                            bool high_precision,
+                            TimingWheel::TaskId *ids)
+{
     int64_t delay_ms = delay.RoundUpTo(TimeDelta::Millis(1)).ms<int>();
     int64_t run_time_ms = TimeAfterMillis(delay_ms);
     {
         MutexLock lock(&mutex_);
-        delayed_messages_.push({.delay_ms = delay_ms,
-                                .run_time_ms = run_time_ms,
-                                .message_number = delayed_next_num_,
-                                .functor = std::move(task)
-
-        });
-        ++delayed_next_num_;
-        // assert delayed_next_num_ != 0
+        for (size_t i = 0; i < count; ++i) {
+            if (high_precision) {
+                delayed_messages_.push({.delay_ms = delay_ms,
+                                        .run_time_ms = run_time_ms,
+                                        .message_number = delayed_next_num_,
+                                        .functor = std::move(tasks[i])
+
+                });
+                ++delayed_next_num_;
+                // assert delayed_next_num_ != 0
+            } else {
+                const TimingWheel::TaskId id = wheel_->Schedule(run_time_ms, std::move(tasks[i]));
+                if (ids) { ids[i] = id; }
+            }
+        }
+        // only a new earliest message changes how long the loop may wait
+        if (run_time_ms >= next_delayed_run_ms_.load(std::memory_order_relaxed)) { return; }
+        next_delayed_run_ms_.store(run_time_ms, std::memory_order_seq_cst);
     }
-    WakeUpSocketServer();
+    if (waiting_.load(std::memory_order_seq_cst)) { WakeUpSocketServer(); }
 }
 
 void
-Thread::BlockingCallImpl(std::function<void()> &&functor, const Location &location)
+Thread::BlockingCallImpl(UniqueTask &&functor, const Location &location)
 {
     if (IsQuitting()) { return; }
     if (IsCurrent()) {
@@ -300,21 +373,42 @@ Thread::BlockingCallImpl(std::function<void()> &&functor, const Location &locati
 
     Thread *current_thread = Thread::Current();
     Event done;
-    PostTask([functor, &done] {
+    // the caller waits, so the task can borrow `functor`
+    PostTask([&functor, &done] {
         functor();
         done.Set();
     });
     done.Wait(Event::kForever);
 }
 
+bool
+Thread::HasMessages() const
+{
+    for (const auto &messages : messages_) {
+        if (!messages.empty()) { return true; }
+    }
+    return false;
+}
+
+size_t
+Thread::MessageCount() const
+{
+    size_t count = 0;
+    for (const auto &messages : messages_) { count += messages.size(); }
+    return count;
+}
+
 int
 Thread::GetDelay()
 {
-    MutexLock lock(&mutex_);
-    if (!messages_.empty()) { return 0; }
+    if (MessageCount() > 0) { return 0; }
 
-    if (!delayed_messages_.empty()) {
-        int delay = TimeUntilMillis(delayed_messages_.top().run_time_ms);
+    MutexLock lock(&mutex_);
+    const int64_t next_run_time_ms =
+        std::min(delayed_messages_.empty() ? TimingWheel::kNever : delayed_messages_.top().run_time_ms,
+                 wheel_->NextExpiry());
+    if (next_run_time_ms != TimingWheel::kNever) {
+        int delay = TimeUntilMillis(next_run_time_ms);
         return std::max<int>(0, delay);
     }
 
@@ -322,7 +416,7 @@ Thread::GetDelay()
 }
 
 void
-Thread::Dispatch(std::function<void()> &&task)
+Thread::Dispatch(UniqueTask &&task)
 {
     int64_t start_time = TimeMillis();
     std::move(task)();
@@ -370,9 +464,16 @@ Thread::ClearCurrentTaskQueue()
 
 bool
 Thread::Start()
+{
+    return Start(StartOptions());
+}
+
+bool
+Thread::Start(const StartOptions &options)
 {
     if (IsRunning()) { return false; }
 
+    start_options_ = options;
     Restart();
     ThreadManager::Instance();
     owned_ = true;
@@ -404,6 +505,10 @@ void *
 Thread::PreRun(void *pv)
 {
     Thread *thread = static_cast<Thread *>(pv);
+    const StartOptions &options = thread->start_options_;
+    if (!options.name.empty()) { SetCurrentThreadName(options.name); }
+    const int err = SetCurrentThreadAffinity(options.cpus);
+    if (err != 0) { LOGW("Thread", "failed to set the cpus of {}: {}", thread->name(), strerror(err)); }
     ThreadManager::Instance()->SetCurrentThread(thread);
     thread->Run();
     ThreadManager::Instance()->SetCurrentThread(nullptr);
@@ -467,6 +572,12 @@ Thread::CreateWithSocketServer()
     return std::unique_ptr<Thread>(new Thread(CreateDefaultSocketServer()));
 }
 
+/* static */ std::unique_ptr<Thread>
+Thread::CreateWithIoUringSocketServer()
+{
+    return std::unique_ptr<Thread>(new Thread(CreateIoUringSocketServer()));
+}
+
 /* static */ std::unique_ptr<Thread>
 Thread::Create()
 {
@@ -7,14 +7,19 @@
 #pragma once
 #ifndef SLED_SYSTEM_THREAD_H
 #define SLED_SYSTEM_THREAD_H
+#include "sled/queue/mpsc_queue.h"
 #include "sled/synchronization/mutex.h"
 #include "sled/synchronization/thread_local.h"
+#include "sled/task_queue/priority_picker.h"
 #include "sled/task_queue/task_queue_base.h"
+#include "sled/timer/timing_wheel.h"
 #include <atomic>
 #include <memory>
 #include <queue>
+#include <string>
 #include <thread>
 #include <type_traits>
+#include <vector>
 
 namespace sled {
 
@@ -51,6 +56,14 @@ private:
 class Thread : public TaskQueueBase {
 public:
     static const int kForever = -1;
+
+    struct StartOptions {
+        // the name the OS shows for the thread, empty keeps the one inherited
+        std::string name;
+        // the cpus the thread may run on, empty is any the process may
+        std::vector<int> cpus;
+    };
+
     explicit Thread(SocketServer *);
     explicit Thread(std::unique_ptr<SocketServer>);
     Thread(SocketServer *ss, bool do_init);
@@ -60,6 +73,7 @@ public:
     Thread &operator=(const Thread &) = delete;
 
     static std::unique_ptr<Thread> CreateWithSocketServer();
+    static std::unique_ptr<Thread> CreateWithIoUringSocketServer();
     static std::unique_ptr<Thread> Create();
     static Thread *Current();
 
@@ -68,13 +82,13 @@ public:
     bool empty() const
     {
         MutexLock lock(&mutex_);
-        return messages_.empty() && delayed_messages_.empty();
+        return MessageCount() == 0 && delayed_messages_.empty() && wheel_->size() == 0;
     }
 
     size_t size() const
     {
         MutexLock lock(&mutex_);
-        return messages_.size() + delayed_messages_.size();
+        return MessageCount() + delayed_messages_.size() + wheel_->size();
     }
 
     virtual void Quit();
@@ -90,6 +104,8 @@ public:
     // Amount of time until the next message can be retrieved.
     virtual int GetDelay();
     bool Start();
+    // name and cpus are set on the new thread before it runs any task
+    bool Start(const StartOptions &options);
     void Join();
     bool IsCurrent() const;
     static bool SleepMs(int millis);
@@ -109,23 +125,46 @@ protected:
         int64_t delay_ms;
         int64_t run_time_ms;
         uint32_t message_number;
-        mutable std::function<void()> functor;
+        mutable UniqueTask functor;
     };
 
-    void PostTaskImpl(std::function<void()> &&task, const PostTaskTraits &traits, const Location &location) override;
-    void PostDelayedTaskImpl(std::function<void()> &&task,
+    void PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location) override;
+    void PostDelayedTaskImpl(UniqueTask &&task,
                              TimeDelta delay,
                              const PostDelayedTaskTraits &traits,
                              const Location &location) override;
-    void BlockingCallImpl(std::function<void()> &&functor, const Location &location) override;
+    void PostTasksImpl(UniqueTask *tasks,
+                       size_t count,
+                       const PostTaskTraits &traits,
+                       const Location &location) override;
+    void PostDelayedTasksImpl(UniqueTask *tasks,
+                              size_t count,
+                              TimeDelta delay,
+                              const PostDelayedTaskTraits &traits,
+                              const Location &location) override;
+    DelayedTaskHandle PostCancelableDelayedTaskImpl(UniqueTask &&task,
+                                                    TimeDelta delay,
+                                                    const PostDelayedTaskTraits &traits,
+                                                    const Location &location) override;
+    void BlockingCallImpl(UniqueTask &&functor, const Location &location) override;
 
     void DoInit();
     void DoDestroy();
     void WakeUpSocketServer();
 
 private:
-    std::function<void()> Get(int cmsWait);
-    void Dispatch(std::function<void()> &&task);
+    UniqueTask Get(int cmsWait);
+    // high precision tasks go to delayed_messages_, the others to wheel_, whose ids go to `ids` unless null
+    void PostDelayedMessages(UniqueTask *tasks,
+                             size_t count,
+                             TimeDelta delay,
+                             bool high_precision,
+                             TimingWheel::TaskId *ids);
+    void Dispatch(UniqueTask &&task);
+    // consumer
+    bool HasMessages() const;
+    // any thread, a snapshot
+    size_t MessageCount() const;
     static void *PreRun(void *pv);
     bool WrapCurrentWithThreadManager(ThreadManager *thread_manager, bool need_synchronize_access);
     bool IsRunning();
@@ -134,10 +173,21 @@ private:
     void EnsureIsCurrentTaskQueue();
     void ClearCurrentTaskQueue();
 
+    // posted tasks by priority, due delayed ones join kNormal, Get() is the only consumer
+    MpscQueue<UniqueTask> messages_[kNumPriorities];
+    PriorityPicker picker_;
     mutable Mutex mutex_;
-    std::queue<std::function<void()>> messages_ GUARDED_BY(mutex_);
     std::priority_queue<DelayedMessage> delayed_messages_ GUARDED_BY(mutex_);
     uint32_t delayed_next_num_ GUARDED_BY(mutex_);
+    // low precision delayed tasks, shared with the handles that cancel them
+    const std::shared_ptr<TimingWheel> wheel_;
+    // tasks the wheel handed over, only used by Get()
+    std::vector<UniqueTask> due_;
+    // the earliest of delayed_messages_ and wheel_, lets Get() skip the lock until it is due
+    std::atomic<int64_t> next_delayed_run_ms_;
+    // true while Get() is (about to be) blocked in ss_->Wait(), posts only
+    // wake the socket server in that case
+    std::atomic<bool> waiting_;
     bool fInitialized_;
     bool fDestroyed_;
     std::atomic<int> stop_;
@@ -145,6 +195,7 @@ private:
     std::unique_ptr<SocketServer> own_ss_;
     std::string name_;
     std::unique_ptr<std::thread> thread_;
+    StartOptions start_options_;
     bool owned_;
 
     std::unique_ptr<TaskQueueBase::CurrentTaskQueueSetter> task_queue_registration_;
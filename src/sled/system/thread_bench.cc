@@ -1,13 +1,18 @@
+#include <atomic>
 #include <sled/system/thread.h>
+#include <thread>
+#include <vector>
 
 void
 ThreadBlockingCallByDefaultSocketServer(picobench::state &s)
 {
     auto thread = sled::Thread::CreateWithSocketServer();
     thread->Start();
+    const uint64_t allocs = sled::AllocationCount();
     for (auto _ : s) {
         (void) thread->BlockingCall([] { return 1; });
     }
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
 }
 
 void
@@ -15,10 +20,211 @@ ThreadBlockingCallByNullSocketServer(picobench::state &s)
 {
     auto thread = sled::Thread::Create();
     thread->Start();
+    const uint64_t allocs = sled::AllocationCount();
     for (auto _ : s) {
         (void) thread->BlockingCall([] { return 1; });
     }
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+}
+
+// cross-thread post throughput, posts that find the loop busy skip the wakeup,
+// the result is allocations per task (see -out-fmt=csv)
+static void
+ThreadPostTask(picobench::state &s, sled::Thread *thread)
+{
+    std::atomic<int> done(0);
+    thread->Start();
+    const uint64_t allocs = sled::AllocationCount();
+    for (auto _ : s) {
+        thread->PostTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    while (done.load(std::memory_order_relaxed) < s.iterations()) { std::this_thread::yield(); }
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+    thread->Stop();
+}
+
+void
+ThreadPostTaskByDefaultSocketServer(picobench::state &s)
+{
+    auto thread = sled::Thread::CreateWithSocketServer();
+    ThreadPostTask(s, thread.get());
+}
+
+void
+ThreadPostTaskByNullSocketServer(picobench::state &s)
+{
+    auto thread = sled::Thread::Create();
+    ThreadPostTask(s, thread.get());
+}
+
+// like ThreadPostTask() but `batch` tasks at a time through PostTasks()
+static void
+ThreadPostTasks(picobench::state &s, size_t batch)
+{
+    auto thread = sled::Thread::CreateWithSocketServer();
+    std::atomic<int> done(0);
+    thread->Start();
+    std::vector<sled::UniqueTask> tasks;
+    tasks.reserve(batch);
+    const uint64_t allocs = sled::AllocationCount();
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        tasks.push_back([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        if (tasks.size() == batch || i + 1 == s.iterations()) {
+            thread->PostTasks(tasks.begin(), tasks.end());
+            tasks.clear();
+        }
+    }
+    while (done.load(std::memory_order_relaxed) < s.iterations()) { std::this_thread::yield(); }
+    s.stop_timer();
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+    thread->Stop();
+}
+
+void
+ThreadPostTasksBatch16(picobench::state &s)
+{
+    ThreadPostTasks(s, 16);
+}
+
+void
+ThreadPostTasksBatch256(picobench::state &s)
+{
+    ThreadPostTasks(s, 256);
+}
+
+// posts s.iterations() high precision tasks a minute out, `batch` at a time,
+// every post takes the heap's lock once
+static void
+ThreadPostDelayedTasks(picobench::state &s, size_t batch)
+{
+    auto thread = sled::Thread::CreateWithSocketServer();
+    thread->Start();
+    std::vector<sled::UniqueTask> tasks;
+    tasks.reserve(batch);
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        tasks.push_back([] {});
+        if (tasks.size() == batch || i + 1 == s.iterations()) {
+            if (batch == 1) {
+                thread->PostDelayedHighPrecisionTask(std::move(tasks.front()), sled::TimeDelta::Seconds(60));
+            } else {
+                thread->PostDelayedTasks(tasks.begin(), tasks.end(), sled::TimeDelta::Seconds(60),
+                                         sled::TaskQueueBase::DelayPrecision::kHigh);
+            }
+            tasks.clear();
+        }
+    }
+    s.stop_timer();
+    thread->Stop();
+}
+
+void
+ThreadPostDelayedTaskSingle(picobench::state &s)
+{
+    ThreadPostDelayedTasks(s, 1);
+}
+
+void
+ThreadPostDelayedTasksBatch256(picobench::state &s)
+{
+    ThreadPostDelayedTasks(s, 256);
+}
+
+// `producers` threads post s.iterations() tasks between them to one loop
+static void
+ThreadPostTaskContended(picobench::state &s, int producers)
+{
+    auto thread = sled::Thread::CreateWithSocketServer();
+    std::atomic<int> done(0);
+    std::atomic<bool> go(false);
+    thread->Start();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i) {
+        const int count = s.iterations() / producers + (i < s.iterations() % producers ? 1 : 0);
+        threads.emplace_back([&, count] {
+            while (!go.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+            for (int n = 0; n < count; ++n) {
+                thread->PostTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    const uint64_t allocs = sled::AllocationCount();
+    s.start_timer();
+    go.store(true, std::memory_order_release);
+    for (auto &t : threads) { t.join(); }
+    while (done.load(std::memory_order_relaxed) < s.iterations()) { std::this_thread::yield(); }
+    s.stop_timer();
+    s.set_result(sled::AllocationsPerIteration(s, allocs));
+    thread->Stop();
+}
+
+void
+ThreadPostTask1Producer(picobench::state &s)
+{
+    ThreadPostTaskContended(s, 1);
+}
+
+void
+ThreadPostTask4Producers(picobench::state &s)
+{
+    ThreadPostTaskContended(s, 4);
+}
+
+void
+ThreadPostTask16Producers(picobench::state &s)
+{
+    ThreadPostTaskContended(s, 16);
+}
+
+void
+ThreadPostTask64Producers(picobench::state &s)
+{
+    ThreadPostTaskContended(s, 64);
+}
+
+// posts s.iterations() timeouts up to a minute out, then cancels them all
+static void
+ThreadPostAndCancelDelayedTasks(picobench::state &s, sled::TaskQueueBase::DelayPrecision precision)
+{
+    auto thread = sled::Thread::Create();
+    thread->Start();
+    std::vector<sled::DelayedTaskHandle> handles(s.iterations());
+    s.start_timer();
+    thread->BlockingCall([&] {
+        for (int i = 0; i < s.iterations(); ++i) {
+            const sled::TimeDelta delay = sled::TimeDelta::Millis(1000 + (i * 7919) % 60000);
+            handles[i] = thread->PostCancelableDelayedTask([] {}, delay, precision);
+        }
+        for (auto &handle : handles) { handle.Cancel(); }
+    });
+    s.stop_timer();
+    thread->Stop();
+}
+
+void
+ThreadPostAndCancelLowPrecision(picobench::state &s)
+{
+    ThreadPostAndCancelDelayedTasks(s, sled::TaskQueueBase::DelayPrecision::kLow);
+}
+
+void
+ThreadPostAndCancelHighPrecision(picobench::state &s)
+{
+    ThreadPostAndCancelDelayedTasks(s, sled::TaskQueueBase::DelayPrecision::kHigh);
 }
 
 PICOBENCH(ThreadBlockingCallByDefaultSocketServer);
 PICOBENCH(ThreadBlockingCallByNullSocketServer);
+PICOBENCH(ThreadPostTaskByDefaultSocketServer);
+PICOBENCH(ThreadPostTaskByNullSocketServer);
+PICOBENCH(ThreadPostTasksBatch16);
+PICOBENCH(ThreadPostTasksBatch256);
+PICOBENCH(ThreadPostDelayedTaskSingle);
+PICOBENCH(ThreadPostDelayedTasksBatch256);
+PICOBENCH(ThreadPostTask1Producer);
+PICOBENCH(ThreadPostTask4Producers);
+PICOBENCH(ThreadPostTask16Producers);
+PICOBENCH(ThreadPostTask64Producers);
+PICOBENCH(ThreadPostAndCancelLowPrecision);
+PICOBENCH(ThreadPostAndCancelHighPrecision);
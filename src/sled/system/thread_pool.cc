@@ -1,47 +1,229 @@
 #include "sled/system/thread_pool.h"
+#include "sled/log/log.h"
+#include "sled/system/cpu_affinity.h"
 #include "sled/system/location.h"
 #include "sled/task_queue/task_queue_base.h"
+#include "sled/utility/move_on_copy.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
 namespace sled {
-ThreadPool::ThreadPool(int num_threads) : delayed_thread_(sled::Thread::Create())
+namespace {
+ThreadPool::Options
+WithThreads(int num_threads)
 {
-    if (num_threads == -1) { num_threads = std::thread::hardware_concurrency(); }
-    scheduler_ = new sled::Scheduler(sled::Scheduler::Config().setWorkerThreadCount(num_threads));
-    delayed_thread_->Start();
+    ThreadPool::Options options;
+    options.num_threads = num_threads;
+    return options;
 }
 
-ThreadPool::~ThreadPool() { delete scheduler_; }
+// options.cpus, or the cpus the process may run on, narrowed down to options.numa_node
+std::vector<int>
+PoolCpus(const ThreadPool::Options &options)
+{
+    if (options.numa_node < 0) { return options.cpus; }
+    std::vector<int> node_cpus = NumaNodeCpus(options.numa_node);
+    if (node_cpus.empty()) {
+        LOGW("ThreadPool", "found no cpus of NUMA node {}, the workers may run anywhere", options.numa_node);
+        return options.cpus;
+    }
+    std::vector<int> cpus;
+    for (int cpu : options.cpus.empty() ? AllowedCpus() : options.cpus) {
+        if (std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end()) { cpus.push_back(cpu); }
+    }
+    if (cpus.empty()) { LOGW("ThreadPool", "none of the cpus is on NUMA node {}", options.numa_node); }
+    return cpus;
+}
+}// namespace
+
+ThreadPool::Options::Options() : num_threads(-1), numa_node(-1), spin_duration(TimeDelta::Millis(1)) {}
+
+ThreadPool::ThreadPool(int num_threads) : ThreadPool(WithThreads(num_threads)) {}
+
+ThreadPool::ThreadPool(const Options &options) : timer_service_(TimerService::Default())
+{
+    const std::vector<int> cpus = PoolCpus(options);
+    const std::vector<std::vector<int>> worker_cpus = options.worker_cpus;
+    const std::string name = options.name;
+
+    int num_threads = options.num_threads;
+    if (num_threads == -1) {
+        if (!worker_cpus.empty()) {
+            num_threads = static_cast<int>(worker_cpus.size());
+        } else if (!cpus.empty()) {
+            num_threads = static_cast<int>(cpus.size());
+        } else {
+            num_threads = std::thread::hardware_concurrency();
+        }
+    }
+
+    sled::Scheduler::Config config;
+    config.setWorkerThreadCount(num_threads)
+        .setWorkerThreadSpinDuration(std::chrono::microseconds(options.spin_duration.us()))
+        .setWorkerThreadInitializer([name, cpus, worker_cpus](int worker_id) {
+            if (!name.empty()) { SetCurrentThreadName(name + "-" + std::to_string(worker_id)); }
+            const std::vector<int> &mine = worker_cpus.empty() ? cpus : worker_cpus[worker_id % worker_cpus.size()];
+            const int err = SetCurrentThreadAffinity(mine);
+            if (err != 0) { LOGW("ThreadPool", "failed to set the cpus of worker {}: {}", worker_id, strerror(err)); }
+        });
+    scheduler_ = new sled::Scheduler(config);
+    workers_ = std::make_shared<Workers>(scheduler_);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        // delayed tasks that come due from now on are dropped
+        MutexLock lock(&workers_->mutex);
+        workers_->scheduler = nullptr;
+    }
+    delete scheduler_;
+}
 
 void
 ThreadPool::Delete()
 {}
 
 void
-ThreadPool::PostTaskImpl(std::function<void()> &&task, const PostTaskTraits &traits, const Location &location)
+ThreadPool::PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location)
 {
-    scheduler_->enqueue(marl::Task([task] { task(); }));
+    Enqueue(workers_.get(), scheduler_, &task, 1, traits.priority);
 }
 
 void
-ThreadPool::PostDelayedTaskImpl(std::function<void()> &&task,
+ThreadPool::PostDelayedTaskImpl(UniqueTask &&task,
                                 TimeDelta delay,
                                 const PostDelayedTaskTraits &traits,
                                 const Location &location)
 {
-    auto move_task_to_fiber = [task]() { task(); };
-    if (traits.high_precision) {
-        delayed_thread_->PostDelayedTaskWithPrecision(
-            TaskQueueBase::DelayPrecision::kHigh,
-            std::move(move_task_to_fiber),
-            delay,
-            location);
-    } else {
-        delayed_thread_->PostDelayedTaskWithPrecision(
-            TaskQueueBase::DelayPrecision::kLow,
-            std::move(move_task_to_fiber),
-            delay,
-            location);
+    // the timer thread only hands the task over, it runs on a worker like any other
+    auto moved = MakeMoveOnCopy(task);
+    std::shared_ptr<Workers> workers = workers_;
+    timer_service_.Schedule(delay, [workers, moved] {
+        MutexLock lock(&workers->mutex);
+        if (workers->scheduler) { Enqueue(workers.get(), workers->scheduler, &moved.value, 1, Priority::kNormal); }
+    });
+}
+
+void
+ThreadPool::PostTasksImpl(UniqueTask *tasks, size_t count, const PostTaskTraits &traits, const Location &location)
+{
+    Enqueue(workers_.get(), scheduler_, tasks, count, traits.priority);
+}
+
+void
+ThreadPool::PostDelayedTasksImpl(UniqueTask *tasks,
+                                 size_t count,
+                                 TimeDelta delay,
+                                 const PostDelayedTaskTraits &traits,
+                                 const Location &location)
+{
+    auto moved = MakeMoveOnCopy(
+        std::vector<UniqueTask>(std::make_move_iterator(tasks), std::make_move_iterator(tasks + count)));
+    std::shared_ptr<Workers> workers = workers_;
+    timer_service_.Schedule(delay, [workers, moved] {
+        MutexLock lock(&workers->mutex);
+        if (workers->scheduler) {
+            Enqueue(workers.get(), workers->scheduler, moved.value.data(), moved.value.size(), Priority::kNormal);
+        }
+    });
+}
+
+void
+ThreadPool::Enqueue(Workers *workers, sled::Scheduler *scheduler, UniqueTask *tasks, size_t count, Priority priority)
+{
+    // the pool deletes the scheduler, which runs every marl task, before it lets go of `workers`
+    if (priority != Priority::kNormal) {
+        {
+            MutexLock lock(&workers->side_mutex);
+            std::deque<UniqueTask> &queue = workers->side[static_cast<int>(priority)];
+            for (size_t i = 0; i < count; ++i) { queue.push_back(std::move(tasks[i])); }
+            workers->side_count.fetch_add(static_cast<int>(count), std::memory_order_release);
+        }
+        // one runner per task, a kNormal task may have taken it by the time it starts
+        for (size_t i = 0; i < count; ++i) { scheduler->enqueue(marl::Task([workers] { RunSide(workers); })); }
+        return;
+    }
+
+    workers->normal_count.fetch_add(static_cast<int>(count), std::memory_order_relaxed);
+    if (count == 1) {
+        // marl::Task holds a copyable std::function
+        auto moved = MakeMoveOnCopy(tasks[0]);
+        scheduler->enqueue(marl::Task([workers, moved] { RunNormal(workers, moved.value); }));
+        return;
+    }
+
+    struct Batch {
+        Batch(UniqueTask *tasks, size_t count)
+            : tasks(std::make_move_iterator(tasks), std::make_move_iterator(tasks + count)),
+              next(0)
+        {}
+
+        std::vector<UniqueTask> tasks;
+        std::atomic<size_t> next;
+    };
+
+    auto batch = std::make_shared<Batch>(tasks, count);
+    // every worker takes the next task until none is left, so a slow task holds up no more than its own worker
+    const size_t drainers = std::min<size_t>(count, std::max(1, scheduler->config().workerThread.count));
+    for (size_t i = 0; i < drainers; ++i) {
+        scheduler->enqueue(marl::Task([workers, batch] {
+            for (size_t next; (next = batch->next.fetch_add(1, std::memory_order_relaxed)) < batch->tasks.size();) {
+                RunNormal(workers, batch->tasks[next]);
+            }
+        }));
+    }
+}
+
+void
+ThreadPool::RunNormal(Workers *workers, UniqueTask &task)
+{
+    workers->normal_count.fetch_sub(1, std::memory_order_relaxed);
+    while (workers->side_count.load(std::memory_order_acquire) > 0) {
+        UniqueTask ahead;
+        {
+            MutexLock lock(&workers->side_mutex);
+            const int next = workers->picker.Pick([workers](int priority) {
+                return priority == static_cast<int>(Priority::kNormal) || !workers->side[priority].empty();
+            });
+            if (next == static_cast<int>(Priority::kNormal)) { break; }
+            ahead = std::move(workers->side[next].front());
+            workers->side[next].pop_front();
+            workers->side_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        ahead();
+    }
+    UniqueTask mine = std::move(task);
+    mine();
+}
+
+void
+ThreadPool::RunSide(Workers *workers)
+{
+    UniqueTask task;
+    {
+        MutexLock lock(&workers->side_mutex);
+        const int next = workers->picker.Pick([workers](int priority) {
+            if (priority == static_cast<int>(Priority::kNormal)) {
+                return workers->normal_count.load(std::memory_order_relaxed) > 0;
+            }
+            return !workers->side[priority].empty();
+        });
+        if (next < 0) { return; }
+        if (next != static_cast<int>(Priority::kNormal)) {
+            task = std::move(workers->side[next].front());
+            workers->side[next].pop_front();
+            workers->side_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (!task) {
+        // comes back behind the kNormal tasks of this worker, the picker hands
+        // the turn down after kBurst of them, so it doesn't come back for long
+        sled::Scheduler::get()->enqueue(marl::Task([workers] { RunSide(workers); }, marl::Task::Flags::SameThread));
+        return;
     }
+    task();
 }
 
 }// namespace sled
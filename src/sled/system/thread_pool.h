@@ -3,42 +3,111 @@
 #define SLED_SYSTEM_THREAD_POOL_H
 #include "sled/system/fiber/scheduler.h"
 #include "sled/system/thread.h"
+#include "sled/task_queue/priority_picker.h"
+#include "sled/timer/timer_service.h"
+#include <atomic>
 #include <functional>
+#include <deque>
 #include <future>
+#include <string>
+#include <vector>
 
 namespace sled {
 class ThreadPool final : public TaskQueueBase {
 public:
+    /**
+     * Where the workers run and how they wait. With cpus, worker_cpus or
+     * numa_node a latency critical pool can be kept off the cores of a batch
+     * pool, or next to its memory.
+     **/
+    struct Options {
+        Options();
+
+        // -1 is one per cpu the workers may run on, or per hardware thread if that isn't limited
+        int num_threads;
+        // the cpus every worker may run on, empty is any the process may
+        std::vector<int> cpus;
+        // worker i runs on worker_cpus[i % worker_cpus.size()], takes precedence over cpus and numa_node
+        std::vector<std::vector<int>> worker_cpus;
+        // keeps the workers to the cpus of this NUMA node, and of cpus if that is set too, -1 is any node
+        int numa_node;
+        // worker i is named "<name>-<i>", empty keeps the name it inherits
+        std::string name;
+        // how long an idle worker looks for work before it sleeps
+        TimeDelta spin_duration;
+    };
+
     /**
     * @param num_threads The number of threads to create in the thread pool. If
     * -1, the number of threads will be equal to the number of hardware threads
     **/
     ThreadPool(int num_threads = -1);
+    explicit ThreadPool(const Options &options);
     ~ThreadPool();
 
     template<typename F, typename... Args>
     auto submit(F &&f, Args &&...args) -> std::future<decltype(f(args...))>
     {
-        std::function<decltype(f(args...))()> func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        auto task_ptr                              = std::make_shared<std::packaged_task<decltype(f(args...))()>>(func);
-        auto future                                = task_ptr->get_future();
-        scheduler_->enqueue(marl::Task([task_ptr]() { (*task_ptr)(); }));
+        // the packaged_task is move-only and fits inline in a UniqueTask
+        std::packaged_task<decltype(f(args...))()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        auto future = task.get_future();
+        PostTask(std::move(task));
         return future;
     }
 
     void Delete() override;
 
 protected:
-    void PostTaskImpl(std::function<void()> &&task, const PostTaskTraits &traits, const Location &location) override;
+    void PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location) override;
 
-    void PostDelayedTaskImpl(std::function<void()> &&task,
+    // PostDelayedTaskTraits carries no priority, so delayed tasks run at kNormal once due
+    void PostDelayedTaskImpl(UniqueTask &&task,
                              TimeDelta delay,
                              const PostDelayedTaskTraits &traits,
                              const Location &location) override;
 
+    // one marl task per worker drains a kNormal batch
+    void PostTasksImpl(UniqueTask *tasks,
+                       size_t count,
+                       const PostTaskTraits &traits,
+                       const Location &location) override;
+    // the batch takes one timer and is spread over the workers when it comes due
+    void PostDelayedTasksImpl(UniqueTask *tasks,
+                              size_t count,
+                              TimeDelta delay,
+                              const PostDelayedTaskTraits &traits,
+                              const Location &location) override;
+
 private:
+    // what a delayed task sees of the pool, the scheduler is gone once the pool is
+    struct Workers {
+        explicit Workers(sled::Scheduler *scheduler) : scheduler(scheduler), side_count(0), normal_count(0) {}
+
+        Mutex mutex;
+        sled::Scheduler *scheduler SLED_GUARDED_BY(mutex);
+
+        // kNormal tasks go straight to marl, only kHigh and kLow ones wait
+        // here for the picker, so a pool that doesn't use priorities takes no lock
+        Mutex side_mutex;
+        std::deque<UniqueTask> side[kNumPriorities] SLED_GUARDED_BY(side_mutex);
+        PriorityPicker picker SLED_GUARDED_BY(side_mutex);
+        // the tasks in side, lets kNormal tasks skip the lock while there are none
+        std::atomic<int> side_count;
+        // kNormal tasks handed to marl that haven't started yet
+        std::atomic<int> normal_count;
+    };
+
+    static void
+    Enqueue(Workers *workers, sled::Scheduler *scheduler, UniqueTask *tasks, size_t count, Priority priority);
+    // runs the kHigh and kLow tasks the picker puts before `task`, a kNormal one, then `task`
+    static void RunNormal(Workers *workers, UniqueTask &task);
+    // runs the kHigh or kLow task the picker chooses, or comes back later if it chooses kNormal
+    static void RunSide(Workers *workers);
+
     sled::Scheduler *scheduler_;
-    std::unique_ptr<sled::Thread> delayed_thread_;
+    std::shared_ptr<Workers> workers_;
+    // keeps the deadlines of delayed tasks, they run on the pool's workers
+    TimerService &timer_service_;
 };
 
 }// namespace sled
@@ -1,17 +1,131 @@
 #include <sled/system/fiber/wait_group.h>
 #include <sled/system/thread_pool.h>
 #include <sled/testing/benchmark.h>
+#include <sled/time_utils.h>
+#include <thread>
 
+// the result is allocations per task (see -out-fmt=csv)
 static void
 ThreadPoolBench(picobench::state &state)
 {
     sled::ThreadPool pool(-1);
+    const uint64_t allocs = sled::AllocationCount();
     for (auto _ : state) {
         std::future<int> f = pool.submit([]() { return 1; });
         (void) f.get();
     }
+    state.set_result(sled::AllocationsPerIteration(state, allocs));
+}
+
+static void
+ThreadPoolPostTask(picobench::state &state)
+{
+    sled::ThreadPool pool(-1);
+    sled::WaitGroup wg(state.iterations());
+    const uint64_t allocs = sled::AllocationCount();
+    for (auto _ : state) {
+        pool.PostTask([wg] { wg.Done(); });
+    }
+    wg.Wait();
+    state.set_result(sled::AllocationsPerIteration(state, allocs));
+}
+
+// like ThreadPoolPostTask but 4 threads post a quarter of the tasks each, ns/op is per task
+static void
+ThreadPoolPostTask4Producers(picobench::state &state)
+{
+    constexpr int kProducers = 4;
+    sled::ThreadPool pool(-1);
+    sled::WaitGroup wg(state.iterations());
+    std::vector<std::thread> producers;
+    state.start_timer();
+    for (int p = 0; p < kProducers; ++p) {
+        const int count = state.iterations() / kProducers + (p < state.iterations() % kProducers ? 1 : 0);
+        producers.emplace_back([&pool, wg, count] {
+            for (int i = 0; i < count; ++i) {
+                pool.PostTask([wg] { wg.Done(); });
+            }
+        });
+    }
+    for (auto &producer : producers) { producer.join(); }
+    wg.Wait();
+    state.stop_timer();
+}
+
+// like ThreadPoolPostTask but 256 tasks at a time through PostTasks()
+static void
+ThreadPoolPostTasksBatch256(picobench::state &state)
+{
+    sled::ThreadPool pool(-1);
+    sled::WaitGroup wg(state.iterations());
+    std::vector<sled::UniqueTask> tasks;
+    tasks.reserve(256);
+    const uint64_t allocs = sled::AllocationCount();
+    state.start_timer();
+    for (int i = 0; i < state.iterations(); ++i) {
+        tasks.push_back([wg] { wg.Done(); });
+        if (tasks.size() == 256 || i + 1 == state.iterations()) {
+            pool.PostTasks(tasks.begin(), tasks.end());
+            tasks.clear();
+        }
+    }
+    wg.Wait();
+    state.stop_timer();
+    state.set_result(sled::AllocationsPerIteration(state, allocs));
+}
+
+// s.iterations() tasks come due together and spin for about 10us each, a pool
+// with more workers gets through them sooner
+static void
+ThreadPoolPostDelayedTask(picobench::state &s, int workers)
+{
+    sled::ThreadPool pool(workers);
+    sled::WaitGroup wg(s.iterations());
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        pool.PostDelayedTask(
+            [wg] {
+                const int64_t until_us = sled::TimeMicros() + 10;
+                while (sled::TimeMicros() < until_us) {}
+                wg.Done();
+            },
+            sled::TimeDelta::Millis(1));
+    }
+    wg.Wait();
+    s.stop_timer();
+}
+
+static void
+ThreadPoolPostDelayedTask1Worker(picobench::state &s)
+{
+    ThreadPoolPostDelayedTask(s, 1);
+}
+
+static void
+ThreadPoolPostDelayedTask2Workers(picobench::state &s)
+{
+    ThreadPoolPostDelayedTask(s, 2);
+}
+
+static void
+ThreadPoolPostDelayedTask4Workers(picobench::state &s)
+{
+    ThreadPoolPostDelayedTask(s, 4);
+}
+
+static void
+ThreadPoolPostDelayedTask8Workers(picobench::state &s)
+{
+    ThreadPoolPostDelayedTask(s, 8);
 }
 
 // BENCHMARK(ThreadPoolBench)->RangeMultiplier(10)->Range(10, 10000);
 PICOBENCH_SUITE("TheadPool");
 PICOBENCH(ThreadPoolBench);
+PICOBENCH(ThreadPoolPostTask);
+PICOBENCH(ThreadPoolPostTask4Producers);
+PICOBENCH(ThreadPoolPostTasksBatch256);
+PICOBENCH(ThreadPoolPostDelayedTask1Worker);
+PICOBENCH(ThreadPoolPostDelayedTask2Workers);
+PICOBENCH(ThreadPoolPostDelayedTask4Workers);
+PICOBENCH(ThreadPoolPostDelayedTask8Workers);
@@ -1,5 +1,6 @@
 #include <random>
 #include <sled/synchronization/event.h>
+#include <sled/system/fiber/wait_group.h>
 #include <sled/system/thread_pool.h>
 
 std::random_device rd;
@@ -81,4 +82,98 @@ TEST_SUITE("ThreadPool")
         CHECK(waiter.Wait(sled::TimeDelta::Millis(150)));
         delete tp;
     }
+
+    TEST_CASE("PostDelayedTask runs on the workers")
+    {
+        sled::ThreadPool *tp = new sled::ThreadPool(2);
+        sled::WaitGroup wg(2);
+        sled::Event release;
+        bool released = false;
+        // both come due together, the second must not wait for the first to finish
+        tp->PostDelayedTask(
+            [&] {
+                released = release.Wait(sled::TimeDelta::Seconds(5));
+                wg.Done();
+            },
+            sled::TimeDelta::Millis(10));
+        tp->PostDelayedTask(
+            [&] {
+                release.Set();
+                wg.Done();
+            },
+            sled::TimeDelta::Millis(10));
+        wg.Wait();
+        CHECK(released);
+        delete tp;
+    }
+
+    TEST_CASE("PostDelayedTask is dropped with the pool")
+    {
+        auto value = std::make_shared<int>(0);
+        sled::ThreadPool *tp = new sled::ThreadPool(1);
+        tp->PostDelayedTask([value] { ++*value; }, sled::TimeDelta::Millis(20));
+        delete tp;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK_EQ(value.use_count(), 1);
+        CHECK_EQ(*value, 0);
+    }
+
+    TEST_CASE("PostTasks")
+    {
+        sled::ThreadPool *tp = new sled::ThreadPool(4);
+        std::atomic<int> sum(0);
+        sled::WaitGroup wg(200);
+        std::vector<sled::UniqueTask> tasks;
+        for (int i = 1; i <= 100; ++i) {
+            tasks.push_back([&sum, wg, i] {
+                sum.fetch_add(i);
+                wg.Done();
+            });
+        }
+        tp->PostTasks(tasks.begin(), tasks.begin() + 1);
+        tp->PostTasks(tasks.begin() + 1, tasks.end());
+        for (int i = 1; i <= 100; ++i) {
+            tasks[i - 1] = [&sum, wg, i] {
+                sum.fetch_add(i);
+                wg.Done();
+            };
+        }
+        tp->PostDelayedTasks(tasks.begin(), tasks.end(), sled::TimeDelta::Millis(10));
+        wg.Wait();
+        CHECK_EQ(sum.load(), 2 * 5050);
+        delete tp;
+    }
+
+    TEST_CASE("PostTaskWithPriority")
+    {
+        sled::ThreadPool *tp = new sled::ThreadPool(1);
+        sled::Event started;
+        sled::Event release;
+        sled::Mutex mutex;
+        std::vector<int> ran;
+        sled::WaitGroup wg(5);
+        // a plain thread, so waiting doesn't let the worker pick up the rest
+        tp->PostTask([&] {
+            started.Set();
+            std::thread([&release] { release.Wait(sled::TimeDelta::Seconds(5)); }).join();
+        });
+        REQUIRE(started.Wait(sled::TimeDelta::Seconds(5)));
+        auto record = [&](int value) {
+            return [&, wg, value] {
+                {
+                    sled::MutexLock lock(&mutex);
+                    ran.push_back(value);
+                }
+                wg.Done();
+            };
+        };
+        for (int i = 0; i < 3; ++i) { tp->PostTaskWithPriority(sled::TaskQueueBase::Priority::kLow, record(2)); }
+        tp->PostTask(record(1));
+        tp->PostTaskWithPriority(sled::TaskQueueBase::Priority::kHigh, record(0));
+        release.Set();
+        wg.Wait();
+        sled::MutexLock lock(&mutex);
+        CHECK_EQ(ran, std::vector<int>{0, 1, 2, 2, 2});
+        delete tp;
+    }
 }
@@ -0,0 +1,42 @@
+/**
+ * @file     : delayed_task_handle
+ * @created  : Sunday Oct 18, 2026 16:02:47 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_TASK_QUEUE_DELAYED_TASK_HANDLE_H
+#define SLED_TASK_QUEUE_DELAYED_TASK_HANDLE_H
+#pragma once
+
+#include <functional>
+
+namespace sled {
+
+/**
+ * Returned by TaskQueueBase::PostCancelableDelayedTask(). Cancel() may be
+ * called from any thread, also after the task queue is gone.
+ **/
+class DelayedTaskHandle {
+public:
+    DelayedTaskHandle() = default;
+
+    explicit DelayedTaskHandle(std::function<bool()> cancel) : cancel_(std::move(cancel)) {}
+
+    // true if the task hadn't started yet and now never will, the handle is empty afterwards
+    bool Cancel()
+    {
+        if (!cancel_) { return false; }
+        std::function<bool()> cancel = std::move(cancel_);
+        cancel_ = nullptr;
+        return cancel();
+    }
+
+    bool IsValid() const { return static_cast<bool>(cancel_); }
+
+private:
+    std::function<bool()> cancel_;
+};
+
+}// namespace sled
+
+#endif// SLED_TASK_QUEUE_DELAYED_TASK_HANDLE_H
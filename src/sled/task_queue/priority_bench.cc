@@ -0,0 +1,82 @@
+#include <atomic>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/system/thread_pool.h>
+#include <sled/testing/benchmark.h>
+#include <sled/time_utils.h>
+#include <thread>
+
+// another thread keeps kBacklog kLow tasks of about 2us each queued while
+// s.iterations() probes of `priority` go in one after the other, ns/op is
+// the time from posting a probe until it ran
+static void
+PriorityLatency(picobench::state &s, sled::TaskQueueBase *queue, sled::TaskQueueBase::Priority priority)
+{
+    constexpr int kBacklog = 1000;
+    std::atomic<int> queued(0);
+    std::atomic<bool> stop(false);
+    std::thread flood([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (queued.load(std::memory_order_relaxed) >= kBacklog) {
+                std::this_thread::yield();
+                continue;
+            }
+            queued.fetch_add(1, std::memory_order_relaxed);
+            queue->PostTaskWithPriority(sled::TaskQueueBase::Priority::kLow, [&queued] {
+                const int64_t until_us = sled::TimeMicros() + 2;
+                while (sled::TimeMicros() < until_us) {}
+                queued.fetch_sub(1, std::memory_order_relaxed);
+            });
+        }
+    });
+    while (queued.load(std::memory_order_relaxed) < kBacklog) { std::this_thread::yield(); }
+
+    s.start_timer();
+    for (int i = 0; i < s.iterations(); ++i) {
+        sled::Event ran;
+        queue->PostTaskWithPriority(priority, [&ran] { ran.Set(); });
+        ran.Wait(sled::Event::kForever);
+    }
+    s.stop_timer();
+
+    stop.store(true, std::memory_order_relaxed);
+    flood.join();
+    // the backlog refers to `queued`
+    while (queued.load(std::memory_order_relaxed) > 0) { std::this_thread::yield(); }
+}
+
+static void
+ThreadHighPriorityLatency(picobench::state &s)
+{
+    auto thread = sled::Thread::Create();
+    thread->Start();
+    PriorityLatency(s, thread.get(), sled::TaskQueueBase::Priority::kHigh);
+}
+
+static void
+ThreadLowPriorityLatency(picobench::state &s)
+{
+    auto thread = sled::Thread::Create();
+    thread->Start();
+    PriorityLatency(s, thread.get(), sled::TaskQueueBase::Priority::kLow);
+}
+
+static void
+ThreadPoolHighPriorityLatency(picobench::state &s)
+{
+    sled::ThreadPool pool(-1);
+    PriorityLatency(s, &pool, sled::TaskQueueBase::Priority::kHigh);
+}
+
+static void
+ThreadPoolLowPriorityLatency(picobench::state &s)
+{
+    sled::ThreadPool pool(-1);
+    PriorityLatency(s, &pool, sled::TaskQueueBase::Priority::kLow);
+}
+
+PICOBENCH_SUITE("Priority");
+PICOBENCH(ThreadLowPriorityLatency);
+PICOBENCH(ThreadHighPriorityLatency);
+PICOBENCH(ThreadPoolLowPriorityLatency);
+PICOBENCH(ThreadPoolHighPriorityLatency);
@@ -0,0 +1,59 @@
+/**
+ * @file     : priority_picker
+ * @created  : Sunday Oct 18, 2026 20:31:05 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_TASK_QUEUE_PRIORITY_PICKER_H
+#define SLED_TASK_QUEUE_PRIORITY_PICKER_H
+#pragma once
+
+#include "sled/task_queue/task_queue_base.h"
+
+namespace sled {
+
+/**
+ * Picks the TaskQueueBase::Priority level a queue serves next: the highest
+ * one with tasks, except that a level which had kBurst turns in a row while
+ * a lower one waited passes the next turn down. Under a flood of kHigh
+ * tasks kNormal gets one turn in kBurst + 1 and kLow one in about
+ * (kBurst + 1)^2.
+ *
+ * Not thread-safe, it belongs to the consumer.
+ **/
+class PriorityPicker {
+public:
+    static constexpr int kBurst = 8;
+
+    PriorityPicker()
+    {
+        for (int &streak : streak_) { streak = 0; }
+    }
+
+    // `has_tasks(level)` tells whether level 0 (kHigh) to 2 (kLow) has any, -1 if none does
+    template<typename HasTasks>
+    int Pick(const HasTasks &has_tasks)
+    {
+        int level = 0;
+        while (level < TaskQueueBase::kNumPriorities && !has_tasks(level)) { ++level; }
+        if (level == TaskQueueBase::kNumPriorities) { return -1; }
+        while (streak_[level] >= kBurst) {
+            int lower = level + 1;
+            while (lower < TaskQueueBase::kNumPriorities && !has_tasks(lower)) { ++lower; }
+            if (lower == TaskQueueBase::kNumPriorities) { break; }
+            streak_[level] = 0;
+            level = lower;
+        }
+        ++streak_[level];
+        // the levels above had their turns
+        for (int higher = 0; higher < level; ++higher) { streak_[higher] = 0; }
+        return level;
+    }
+
+private:
+    int streak_[TaskQueueBase::kNumPriorities];
+};
+
+}// namespace sled
+
+#endif// SLED_TASK_QUEUE_PRIORITY_PICKER_H
@@ -0,0 +1,52 @@
+#include <sled/task_queue/priority_picker.h>
+
+namespace {
+// picks `n` times with `waiting` tasks per level and returns how many each level got
+std::vector<int>
+Serve(sled::PriorityPicker &picker, std::vector<int> waiting, int n)
+{
+    std::vector<int> served(sled::TaskQueueBase::kNumPriorities, 0);
+    for (int i = 0; i < n; ++i) {
+        const int level = picker.Pick([&waiting](int priority) { return waiting[priority] > 0; });
+        if (level < 0) { break; }
+        --waiting[level];
+        ++served[level];
+    }
+    return served;
+}
+}// namespace
+
+TEST_SUITE("PriorityPicker")
+{
+    TEST_CASE("highest first")
+    {
+        sled::PriorityPicker picker;
+        CHECK_EQ(picker.Pick([](int) { return false; }), -1);
+        CHECK_EQ(Serve(picker, {3, 2, 1}, 6), std::vector<int>{3, 2, 1});
+        CHECK_EQ(picker.Pick([](int priority) { return priority == 2; }), 2);
+    }
+
+    TEST_CASE("lower levels make progress")
+    {
+        constexpr int kBurst = sled::PriorityPicker::kBurst;
+        sled::PriorityPicker picker;
+        const int kFlood = 1 << 20;
+        // one turn for kNormal after every kBurst of kHigh
+        CHECK_EQ(Serve(picker, {kFlood, kFlood, 0}, 10 * (kBurst + 1)), std::vector<int>{10 * kBurst, 10, 0});
+
+        sled::PriorityPicker fresh;
+        const int rounds = (kBurst + 1) * (kBurst + 1);
+        const std::vector<int> served = Serve(fresh, {kFlood, kFlood, kFlood}, 2 * rounds);
+        CHECK_EQ(served[2], 2);
+        CHECK_GT(served[0], served[1]);
+    }
+
+    TEST_CASE("a level that waited is served at once")
+    {
+        sled::PriorityPicker picker;
+        // kHigh alone used up its turns, kLow gets the next one as soon as it has a task
+        CHECK_EQ(Serve(picker, {100, 0, 0}, 50), std::vector<int>{50, 0, 0});
+        CHECK_EQ(Serve(picker, {100, 0, 1}, 1), std::vector<int>{0, 0, 1});
+        CHECK_EQ(Serve(picker, {100, 0, 1}, 1), std::vector<int>{1, 0, 0});
+    }
+}
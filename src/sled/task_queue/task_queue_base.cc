@@ -1,11 +1,16 @@
 #include "sled/task_queue/task_queue_base.h"
 #include "sled/synchronization/event.h"
+#include "sled/utility/move_on_copy.h"
+#include <atomic>
+#include <memory>
 
 namespace sled {
 namespace {
 thread_local TaskQueueBase *current = nullptr;
 }
 
+constexpr int TaskQueueBase::kNumPriorities;
+
 TaskQueueBase *
 TaskQueueBase::Current()
 {
@@ -20,10 +25,48 @@ TaskQueueBase::CurrentTaskQueueSetter::CurrentTaskQueueSetter(TaskQueueBase *tas
 TaskQueueBase::CurrentTaskQueueSetter::~CurrentTaskQueueSetter() { current = previous_; }
 
 void
-TaskQueueBase::BlockingCallImpl(std::function<void()> &&functor, const sled::Location &from)
+TaskQueueBase::PostTasksImpl(UniqueTask *tasks, size_t count, const PostTaskTraits &traits, const Location &location)
+{
+    for (size_t i = 0; i < count; ++i) { PostTaskImpl(std::move(tasks[i]), traits, location); }
+}
+
+void
+TaskQueueBase::PostDelayedTasksImpl(UniqueTask *tasks,
+                                    size_t count,
+                                    TimeDelta delay,
+                                    const PostDelayedTaskTraits &traits,
+                                    const Location &location)
+{
+    for (size_t i = 0; i < count; ++i) { PostDelayedTaskImpl(std::move(tasks[i]), delay, traits, location); }
+}
+
+DelayedTaskHandle
+TaskQueueBase::PostCancelableDelayedTaskImpl(UniqueTask &&task,
+                                            TimeDelta delay,
+                                            const PostDelayedTaskTraits &traits,
+                                            const Location &location)
+{
+    enum { kPending, kStarted, kCancelled };
+    auto state = std::make_shared<std::atomic<int>>(kPending);
+    auto moved = MakeMoveOnCopy(task);
+    PostDelayedTaskImpl(
+        [state, moved] {
+            int expected = kPending;
+            if (state->compare_exchange_strong(expected, kStarted)) { moved.value(); }
+        },
+        delay, traits, location);
+    return DelayedTaskHandle([state] {
+        int expected = kPending;
+        return state->compare_exchange_strong(expected, kCancelled);
+    });
+}
+
+void
+TaskQueueBase::BlockingCallImpl(UniqueTask &&functor, const sled::Location &from)
 {
     Event done;
-    PostTask([functor, &done] {
+    // the caller waits, so the task can borrow `functor`
+    PostTask([&functor, &done] {
         functor();
         done.Set();
     });
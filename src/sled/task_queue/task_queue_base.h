@@ -9,8 +9,12 @@
 #define SLED_TASK_QUEUE_TASK_QUEUE_BASE_H
 
 #include "sled/system/location.h"
+#include "sled/task_queue/delayed_task_handle.h"
+#include "sled/task_queue/unique_task.h"
 #include "sled/units/time_delta.h"
 #include <functional>
+#include <iterator>
+#include <vector>
 
 namespace sled {
 
@@ -21,24 +25,44 @@ public:
         kHigh,
     };
 
+    /**
+     * Which of the posted tasks a queue runs first, e.g. heartbeats and
+     * cancellations kHigh, bulk work kLow. A level only takes a limited
+     * number of turns in a row while a lower one waits, so no level starves.
+     * Queues that promise FIFO order across all tasks ignore it. Delayed
+     * tasks carry no priority, they run at kNormal once due.
+     **/
+    enum class Priority {
+        kHigh = 0,
+        kNormal,
+        kLow,
+    };
+    static constexpr int kNumPriorities = 3;
+
     struct Deleter {
         void operator()(TaskQueueBase *task_queue) const { task_queue->Delete(); }
     };
 
     virtual void Delete() = 0;
 
-    inline void PostTask(std::function<void()> &&task, const Location &location = Location::Current())
+    inline void PostTask(UniqueTask &&task, const Location &location = Location::Current())
     {
         PostTaskImpl(std::move(task), PostTaskTraits{}, location);
     }
 
     inline void
-    PostDelayedTask(std::function<void()> &&task, TimeDelta delay, const Location &location = Location::Current())
+    PostTaskWithPriority(Priority priority, UniqueTask &&task, const Location &location = Location::Current())
+    {
+        PostTaskImpl(std::move(task), PostTaskTraits(priority), location);
+    }
+
+    inline void
+    PostDelayedTask(UniqueTask &&task, TimeDelta delay, const Location &location = Location::Current())
     {
         PostDelayedTaskImpl(std::move(task), delay, PostDelayedTaskTraits{}, location);
     }
 
-    inline void PostDelayedHighPrecisionTask(std::function<void()> &&task,
+    inline void PostDelayedHighPrecisionTask(UniqueTask &&task,
                                              TimeDelta delay,
                                              const Location &location = Location::Current())
     {
@@ -47,7 +71,7 @@ public:
     }
 
     inline void PostDelayedTaskWithPrecision(DelayPrecision precision,
-                                             std::function<void()> &&task,
+                                             UniqueTask &&task,
                                              TimeDelta delay,
                                              const Location &location = Location::Current())
     {
@@ -61,7 +85,66 @@ public:
         }
     }
 
-    void BlockingCall(std::function<void()> functor, const Location &location = Location::Current())
+    /**
+     * Posts the tasks in [first, last) as if one by one, in order, but lets
+     * the queue take them in with one lock and one wakeup. The tasks are
+     * moved out of the range, a forward one.
+     **/
+    template<typename Iterator>
+    void PostTasks(Iterator first, Iterator last, const Location &location = Location::Current())
+    {
+        std::vector<UniqueTask> tasks = MoveTasks(first, last);
+        if (!tasks.empty()) { PostTasksImpl(tasks.data(), tasks.size(), PostTaskTraits{}, location); }
+    }
+
+    // UniqueTasks in a vector are posted in place
+    void PostTasks(std::vector<UniqueTask>::iterator first,
+                   std::vector<UniqueTask>::iterator last,
+                   const Location &location = Location::Current())
+    {
+        if (first != last) { PostTasksImpl(&*first, last - first, PostTaskTraits{}, location); }
+    }
+
+    // all of [first, last) come due together, after `delay`
+    template<typename Iterator>
+    void PostDelayedTasks(Iterator first,
+                          Iterator last,
+                          TimeDelta delay,
+                          DelayPrecision precision = DelayPrecision::kLow,
+                          const Location &location = Location::Current())
+    {
+        std::vector<UniqueTask> tasks = MoveTasks(first, last);
+        if (tasks.empty()) { return; }
+        PostDelayedTasksImpl(tasks.data(), tasks.size(), delay,
+                             PostDelayedTaskTraits(precision == DelayPrecision::kHigh), location);
+    }
+
+    void PostDelayedTasks(std::vector<UniqueTask>::iterator first,
+                          std::vector<UniqueTask>::iterator last,
+                          TimeDelta delay,
+                          DelayPrecision precision = DelayPrecision::kLow,
+                          const Location &location = Location::Current())
+    {
+        if (first == last) { return; }
+        PostDelayedTasksImpl(&*first, last - first, delay, PostDelayedTaskTraits(precision == DelayPrecision::kHigh),
+                             location);
+    }
+
+    /**
+     * Like PostDelayedTaskWithPrecision(), the handle can take the task back
+     * until it starts. Queues that support it drop the task right away,
+     * others only skip it once it is due.
+     **/
+    inline DelayedTaskHandle PostCancelableDelayedTask(UniqueTask &&task,
+                                                       TimeDelta delay,
+                                                       DelayPrecision precision = DelayPrecision::kLow,
+                                                       const Location &location = Location::Current())
+    {
+        return PostCancelableDelayedTaskImpl(std::move(task), delay,
+                                             PostDelayedTaskTraits(precision == DelayPrecision::kHigh), location);
+    }
+
+    void BlockingCall(UniqueTask functor, const Location &location = Location::Current())
     {
         BlockingCallImpl(std::move(functor), location);
     }
@@ -81,7 +164,11 @@ public:
     bool IsCurrent() const { return Current() == this; };
 
 protected:
-    struct PostTaskTraits {};
+    struct PostTaskTraits {
+        PostTaskTraits(Priority priority = Priority::kNormal) : priority(priority) {}
+
+        Priority priority = Priority::kNormal;
+    };
 
     struct PostDelayedTaskTraits {
         PostDelayedTaskTraits(bool high_precision = false) : high_precision(high_precision) {}
@@ -89,14 +176,35 @@ protected:
         bool high_precision = false;
     };
 
-    virtual void PostTaskImpl(std::function<void()> &&task, const PostTaskTraits &traits, const Location &location) = 0;
-    virtual void PostDelayedTaskImpl(std::function<void()> &&task,
+    virtual void PostTaskImpl(UniqueTask &&task, const PostTaskTraits &traits, const Location &location) = 0;
+    virtual void PostDelayedTaskImpl(UniqueTask &&task,
                                      TimeDelta delay,
                                      const PostDelayedTaskTraits &traits,
                                      const Location &location) = 0;
-    virtual void BlockingCallImpl(std::function<void()> &&task, const Location &location);
+    // the default posts the tasks one by one, `tasks` may be moved from
+    virtual void
+    PostTasksImpl(UniqueTask *tasks, size_t count, const PostTaskTraits &traits, const Location &location);
+    virtual void PostDelayedTasksImpl(UniqueTask *tasks,
+                                      size_t count,
+                                      TimeDelta delay,
+                                      const PostDelayedTaskTraits &traits,
+                                      const Location &location);
+    virtual DelayedTaskHandle PostCancelableDelayedTaskImpl(UniqueTask &&task,
+                                                            TimeDelta delay,
+                                                            const PostDelayedTaskTraits &traits,
+                                                            const Location &location);
+    virtual void BlockingCallImpl(UniqueTask &&task, const Location &location);
     virtual ~TaskQueueBase() = default;
 
+    template<typename Iterator>
+    static std::vector<UniqueTask> MoveTasks(Iterator first, Iterator last)
+    {
+        std::vector<UniqueTask> tasks;
+        tasks.reserve(std::distance(first, last));
+        for (; first != last; ++first) { tasks.emplace_back(std::move(*first)); }
+        return tasks;
+    }
+
     class CurrentTaskQueueSetter {
     public:
         explicit CurrentTaskQueueSetter(TaskQueueBase *task_queue);
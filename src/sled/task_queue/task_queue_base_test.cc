@@ -0,0 +1,116 @@
+#include <deque>
+#include <list>
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/task_queue/task_queue_base.h>
+
+namespace {
+// keeps what is posted, so the default batch implementation can be checked
+class RecordingQueue : public sled::TaskQueueBase {
+public:
+    void Delete() override {}
+
+    std::deque<sled::UniqueTask> tasks;
+    std::vector<sled::TimeDelta> delays;
+
+protected:
+    void PostTaskImpl(sled::UniqueTask &&task, const PostTaskTraits &, const sled::Location &) override
+    {
+        tasks.push_back(std::move(task));
+    }
+
+    void PostDelayedTaskImpl(sled::UniqueTask &&task,
+                             sled::TimeDelta delay,
+                             const PostDelayedTaskTraits &,
+                             const sled::Location &) override
+    {
+        tasks.push_back(std::move(task));
+        delays.push_back(delay);
+    }
+};
+}// namespace
+
+TEST_SUITE("TaskQueueBase")
+{
+    TEST_CASE("PostTasks falls back to PostTask")
+    {
+        RecordingQueue queue;
+        std::vector<int> ran;
+        std::list<std::function<void()>> tasks;
+        for (int i = 0; i < 3; ++i) {
+            tasks.push_back([&ran, i] { ran.push_back(i); });
+        }
+        queue.PostTasks(tasks.begin(), tasks.end());
+        queue.PostDelayedTasks(tasks.begin(), tasks.begin(), sled::TimeDelta::Millis(10));
+        REQUIRE_EQ(queue.tasks.size(), 3);
+        CHECK(queue.delays.empty());
+        for (auto &task : queue.tasks) { task(); }
+        CHECK_EQ(ran, std::vector<int>{0, 1, 2});
+    }
+
+    TEST_CASE("PostDelayedTasks falls back to PostDelayedTask")
+    {
+        RecordingQueue queue;
+        std::vector<sled::UniqueTask> tasks(2);
+        for (auto &task : tasks) { task = [] {}; }
+        queue.PostDelayedTasks(tasks.begin(), tasks.end(), sled::TimeDelta::Millis(10));
+        CHECK_EQ(queue.tasks.size(), 2);
+        CHECK_EQ(queue.delays,
+                 std::vector<sled::TimeDelta>{sled::TimeDelta::Millis(10), sled::TimeDelta::Millis(10)});
+    }
+
+    TEST_CASE("Thread runs a batch in order")
+    {
+        auto thread = sled::Thread::Create();
+        thread->Start();
+        std::vector<int> ran;
+        std::vector<sled::UniqueTask> tasks;
+        for (int i = 0; i < 100; ++i) {
+            tasks.push_back([&ran, i] { ran.push_back(i); });
+        }
+        thread->PostTask([&ran] { ran.push_back(-1); });
+        thread->PostTasks(tasks.begin(), tasks.end());
+        thread->PostDelayedTasks(tasks.begin(), tasks.begin(), sled::TimeDelta::Millis(10));
+        thread->BlockingCall([&ran] { ran.push_back(100); });
+        REQUIRE_EQ(ran.size(), 102);
+        for (int i = 0; i < 102; ++i) { CHECK_EQ(ran[i], i - 1); }
+    }
+
+    TEST_CASE("Thread runs a delayed batch together")
+    {
+        auto thread = sled::Thread::Create();
+        thread->Start();
+        for (auto precision : {sled::TaskQueueBase::DelayPrecision::kLow, sled::TaskQueueBase::DelayPrecision::kHigh}) {
+            sled::Event done;
+            std::vector<int> ran;
+            std::vector<sled::UniqueTask> tasks;
+            for (int i = 0; i < 3; ++i) {
+                tasks.push_back([&ran, i] { ran.push_back(i); });
+            }
+            tasks.push_back([&done] { done.Set(); });
+            thread->PostDelayedTasks(tasks.begin(), tasks.end(), sled::TimeDelta::Millis(20), precision);
+            CHECK_EQ(thread->size(), 4);
+            REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+            CHECK_EQ(ran, std::vector<int>{0, 1, 2});
+        }
+    }
+
+    TEST_CASE("Thread runs higher priorities first")
+    {
+        auto thread = sled::Thread::Create();
+        thread->Start();
+        sled::Event release;
+        std::vector<int> ran;
+        thread->PostTask([&release] { release.Wait(sled::TimeDelta::Seconds(5)); });
+        for (int i = 0; i < 3; ++i) {
+            thread->PostTaskWithPriority(sled::TaskQueueBase::Priority::kLow, [&ran] { ran.push_back(2); });
+        }
+        thread->PostTask([&ran] { ran.push_back(1); });
+        thread->PostTaskWithPriority(sled::TaskQueueBase::Priority::kHigh, [&ran] { ran.push_back(0); });
+        sled::Event done;
+        thread->PostTaskWithPriority(sled::TaskQueueBase::Priority::kLow, [&done] { done.Set(); });
+        release.Set();
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_EQ(thread->BlockingCall([&ran] { return ran; }), std::vector<int>{0, 1, 2, 2, 2});
+    }
+}
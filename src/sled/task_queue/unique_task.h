@@ -0,0 +1,149 @@
+/**
+ * @file     : unique_task
+ * @created  : Sunday Oct 18, 2026 17:21:40 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_TASK_QUEUE_UNIQUE_TASK_H
+#define SLED_TASK_QUEUE_UNIQUE_TASK_H
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sled {
+
+/**
+ * A move-only `void()` callable. Callables of up to kInlineSize bytes that
+ * can be moved without throwing are kept inline, so posting a lambda with a
+ * few captures doesn't allocate. Larger ones go to the heap once. Unlike
+ * std::function it also takes move-only callables such as a
+ * std::packaged_task or a lambda holding a std::unique_ptr.
+ **/
+class UniqueTask {
+public:
+    static constexpr size_t kInlineSize = 48;
+
+    UniqueTask() noexcept : ops_(nullptr) {}
+
+    UniqueTask(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template<typename F,
+             typename Fn = typename std::decay<F>::type,
+             typename = typename std::enable_if<!std::is_same<Fn, UniqueTask>::value>::type,
+             typename = decltype(std::declval<Fn &>()())>
+    UniqueTask(F &&f) : ops_(nullptr)
+    {
+        Init<Fn>(std::forward<F>(f), std::integral_constant<bool, IsInline<Fn>()>());
+    }
+
+    UniqueTask(UniqueTask &&other) noexcept : ops_(other.ops_)
+    {
+        if (ops_) { ops_->move(&storage_, &other.storage_); }
+        other.ops_ = nullptr;
+    }
+
+    UniqueTask &operator=(UniqueTask &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_) { ops_->move(&storage_, &other.storage_); }
+            other.ops_ = nullptr;
+        }
+        return *this;
+    }
+
+    UniqueTask &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    UniqueTask(const UniqueTask &) = delete;
+    UniqueTask &operator=(const UniqueTask &) = delete;
+
+    ~UniqueTask() { reset(); }
+
+    void operator()() { ops_->invoke(&storage_); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+private:
+    struct Ops {
+        void (*invoke)(void *storage);
+        // move constructs into `to` and destroys what is left in `from`
+        void (*move)(void *to, void *from);
+        void (*destroy)(void *storage);
+    };
+
+    template<typename Fn>
+    static constexpr bool IsInline()
+    {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template<typename Fn>
+    struct InlineOps {
+        static void Invoke(void *storage) { (*static_cast<Fn *>(storage))(); }
+
+        static void Move(void *to, void *from)
+        {
+            Fn *fn = static_cast<Fn *>(from);
+            ::new (to) Fn(std::move(*fn));
+            fn->~Fn();
+        }
+
+        static void Destroy(void *storage) { static_cast<Fn *>(storage)->~Fn(); }
+
+        static const Ops ops;
+    };
+
+    // the storage holds a pointer to the callable
+    template<typename Fn>
+    struct HeapOps {
+        static void Invoke(void *storage) { (**static_cast<Fn **>(storage))(); }
+
+        static void Move(void *to, void *from) { *static_cast<Fn **>(to) = *static_cast<Fn **>(from); }
+
+        static void Destroy(void *storage) { delete *static_cast<Fn **>(storage); }
+
+        static const Ops ops;
+    };
+
+    template<typename Fn, typename F>
+    void Init(F &&f, std::true_type)
+    {
+        ::new (&storage_) Fn(std::forward<F>(f));
+        ops_ = &InlineOps<Fn>::ops;
+    }
+
+    template<typename Fn, typename F>
+    void Init(F &&f, std::false_type)
+    {
+        *reinterpret_cast<Fn **>(&storage_) = new Fn(std::forward<F>(f));
+        ops_ = &HeapOps<Fn>::ops;
+    }
+
+    void reset() noexcept
+    {
+        if (ops_) { ops_->destroy(&storage_); }
+        ops_ = nullptr;
+    }
+
+    typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type storage_;
+    const Ops *ops_;
+};
+
+template<typename Fn>
+const UniqueTask::Ops UniqueTask::InlineOps<Fn>::ops = {&Invoke, &Move, &Destroy};
+
+template<typename Fn>
+const UniqueTask::Ops UniqueTask::HeapOps<Fn>::ops = {&Invoke, &Move, &Destroy};
+
+}// namespace sled
+
+#endif// SLED_TASK_QUEUE_UNIQUE_TASK_H
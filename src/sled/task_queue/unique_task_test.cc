@@ -0,0 +1,84 @@
+#include <functional>
+#include <future>
+#include <memory>
+#include <sled/system/thread.h>
+#include <sled/task_queue/unique_task.h>
+
+namespace {
+struct Counted {
+    explicit Counted(int *alive) : alive(alive) { ++*alive; }
+
+    Counted(Counted &&other) noexcept : alive(other.alive) { ++*alive; }
+
+    ~Counted() { --*alive; }
+
+    int *alive;
+};
+}// namespace
+
+TEST_SUITE("UniqueTask")
+{
+    TEST_CASE("inline and heap")
+    {
+        int calls = 0;
+        int alive = 0;
+        {
+            std::shared_ptr<Counted> small = std::make_shared<Counted>(&alive);
+            sled::UniqueTask inline_task([&calls, small] { ++calls; });
+            char padding[sled::UniqueTask::kInlineSize] = {};
+            sled::UniqueTask heap_task([&calls, small, padding] { calls += 1 + padding[0]; });
+            small.reset();
+            CHECK_EQ(alive, 1);
+
+            sled::UniqueTask moved(std::move(heap_task));
+            CHECK_FALSE(heap_task);
+            REQUIRE(moved);
+            moved();
+            inline_task();
+            CHECK_EQ(calls, 2);
+
+            inline_task = std::move(moved);
+            inline_task();
+            CHECK_EQ(calls, 3);
+            CHECK_EQ(alive, 1);
+            inline_task = nullptr;
+            CHECK_EQ(alive, 0);
+        }
+        CHECK_EQ(alive, 0);
+        CHECK_EQ(sizeof(sled::UniqueTask), 64);
+    }
+
+    TEST_CASE("move-only callables")
+    {
+        std::unique_ptr<int> value(new int(41));
+        int *raw = value.get();
+        std::packaged_task<int()> packaged([raw] { return *raw + 1; });
+        std::future<int> future = packaged.get_future();
+        sled::UniqueTask task(std::move(packaged));
+        task();
+        CHECK_EQ(future.get(), 42);
+
+        int alive = 0;
+        sled::UniqueTask holder;
+        {
+            Counted counted(&alive);
+            holder = sled::UniqueTask(std::bind([](const Counted &) {}, std::move(counted)));
+        }
+        CHECK_EQ(alive, 1);
+        holder = sled::UniqueTask();
+        CHECK_EQ(alive, 0);
+    }
+
+    TEST_CASE("post")
+    {
+        auto thread = sled::Thread::Create();
+        thread->Start();
+        std::unique_ptr<int> value(new int(1));
+        int *raw = value.get();
+        std::function<void()> copyable = [raw] { ++*raw; };
+        thread->PostTask(copyable);
+        // a BlockingCall() behind it sees its effect
+        CHECK_EQ(thread->BlockingCall([raw] { return *raw; }), 2);
+        thread->Stop();
+    }
+}
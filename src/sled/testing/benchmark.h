@@ -2,5 +2,41 @@
 #define SLED_TESTING_BENCHAMRK_H
 
 #include "sled/testing/picobench.h"
+#include <atomic>
+#include <stdint.h>
+#if defined(__linux__)
+#include <gperftools/malloc_hook.h>
+#endif
+
+namespace sled {
+
+// heap allocations of the whole process since the first call, always 0 without tcmalloc's hooks
+inline uint64_t
+AllocationCount()
+{
+#if defined(__linux__)
+    static std::atomic<uint64_t> count(0);
+
+    struct Hook {
+        static void OnNew(const void *, size_t) { count.fetch_add(1, std::memory_order_relaxed); }
+    };
+
+    static const bool installed = MallocHook::AddNewHook(&Hook::OnNew);
+    (void) installed;
+    return count.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+// allocations per iteration since AllocationCount() was `since`, report it with set_result() (see -out-fmt=csv)
+inline uintptr_t
+AllocationsPerIteration(const picobench::state &s, uint64_t since)
+{
+    const uint64_t iterations = s.iterations() > 0 ? s.iterations() : 1;
+    return static_cast<uintptr_t>((AllocationCount() - since + iterations / 2) / iterations);
+}
+
+}// namespace sled
 
 #endif// SLED_TESTING_BENCHAMRK_H
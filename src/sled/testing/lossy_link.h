@@ -0,0 +1,46 @@
+#ifndef SLED_TESTING_LOSSY_LINK_H
+#define SLED_TESTING_LOSSY_LINK_H
+
+#include "sled/random.h"
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <utility>
+
+namespace sled {
+
+// one direction of a link with a fixed delay and random loss, on a virtual millisecond clock
+class LossyLink {
+public:
+    LossyLink(uint32_t delay_ms, uint32_t loss_percent, uint64_t seed)
+        : delay_ms_(delay_ms),
+          loss_percent_(loss_percent),
+          random_(seed)
+    {}
+
+    void Send(uint32_t now, const uint8_t *data, size_t size)
+    {
+        if (random_.Rand(99u) < loss_percent_) { return; }
+        packets_.emplace_back(now + delay_ms_, std::string(reinterpret_cast<const char *>(data), size));
+    }
+
+    // hands the packets due by `now` to receiver->Input(), e.g. a KCP
+    template<typename Receiver>
+    void Deliver(uint32_t now, Receiver *receiver)
+    {
+        while (!packets_.empty() && static_cast<int32_t>(now - packets_.front().first) >= 0) {
+            receiver->Input(packets_.front().second.data(), packets_.front().second.size());
+            packets_.pop_front();
+        }
+    }
+
+private:
+    const uint32_t delay_ms_;
+    const uint32_t loss_percent_;
+    Random random_;
+    std::deque<std::pair<uint32_t, std::string>> packets_;
+};
+
+}// namespace sled
+
+#endif// SLED_TESTING_LOSSY_LINK_H
@@ -7,6 +7,20 @@ namespace sled {
 
 ClockInterface *g_clock = nullptr;
 
+ClockInterface *
+SetClockForTesting(ClockInterface *clock)
+{
+    ClockInterface *prev = g_clock;
+    g_clock = clock;
+    return prev;
+}
+
+ClockInterface *
+GetClockForTesting()
+{
+    return g_clock;
+}
+
 int64_t
 TimeSecs()
 {
@@ -25,6 +25,11 @@ public:
     virtual int64_t TimeNanos() const = 0;
 };
 
+// replaces the clock behind TimeNanos() and friends process wide, nullptr
+// restores the system clock; returns the previous clock
+ClockInterface *SetClockForTesting(ClockInterface *clock);
+ClockInterface *GetClockForTesting();
+
 int64_t SystemTimeMillis();
 int64_t TimeSecs();
 int64_t TimeMillis();
@@ -14,6 +14,7 @@ TaskQueueTimeoutFactory::TaskQueueTimeout::TaskQueueTimeout(TaskQueueTimeoutFact
 TaskQueueTimeoutFactory::TaskQueueTimeout::~TaskQueueTimeout()
 {
     SLED_DCHECK_RUN_ON(&parent_.thread_checker_);
+    posted_task_.Cancel();
     safety_flag_->SetNotAlive();
 }
 
@@ -30,6 +31,7 @@ TaskQueueTimeoutFactory::TaskQueueTimeout::Start(DurationMs duration_ms, Timeout
         LOGV("timer",
              "New timeout duration is less than scheduled - "
              "ghosting old delayed task");
+        posted_task_.Cancel();
         safety_flag_->SetNotAlive();
         safety_flag_ = PendingTaskSafetyFlag::Create();
     }
@@ -37,8 +39,7 @@ TaskQueueTimeoutFactory::TaskQueueTimeout::Start(DurationMs duration_ms, Timeout
     posted_task_expiration_ = timeout_expiration_;
     auto safety_flag        = safety_flag_;
 
-    parent_.task_queue_.PostDelayedTaskWithPrecision(
-        precision_,
+    posted_task_ = parent_.task_queue_.PostCancelableDelayedTask(
         SafeTask(safety_flag_,
                  [timeout_id, this]() {
                      LOGV("timer", "Timeout expired id={}", timeout_id);
@@ -65,7 +66,7 @@ TaskQueueTimeoutFactory::TaskQueueTimeout::Start(DurationMs duration_ms, Timeout
                          }
                      }
                  }),
-        sled::TimeDelta::Millis(duration_ms));
+        sled::TimeDelta::Millis(duration_ms), precision_);
 }
 
 void
@@ -74,6 +75,8 @@ TaskQueueTimeoutFactory::TaskQueueTimeout::Stop()
 
     SLED_DCHECK_RUN_ON(&parent_.thread_checker_);
     timeout_expiration_ = std::numeric_limits<TimeMs>::max();
+    // if it was already on its way, the posted task sees the timeout stopped
+    if (posted_task_.Cancel()) { posted_task_expiration_ = std::numeric_limits<TimeMs>::max(); }
 }
 
 }// namespace sled
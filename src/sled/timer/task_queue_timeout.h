@@ -44,6 +44,8 @@ private:
         TimeMs timeout_expiration_ = std::numeric_limits<TimeMs>::max();
         TimeoutID timeout_id_ = TimeoutID(0);
         scoped_refptr<PendingTaskSafetyFlag> safety_flag_;
+        // takes the posted task out of the queue when it is no longer needed
+        DelayedTaskHandle posted_task_;
     };
 
     sled::SequenceChecker thread_checker_;
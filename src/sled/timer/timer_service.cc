@@ -0,0 +1,83 @@
+#include "sled/timer/timer_service.h"
+#include "sled/time_utils.h"
+#include <algorithm>
+#include <vector>
+
+namespace sled {
+
+TimerService &
+TimerService::Default()
+{
+    static TimerService instance;
+    return instance;
+}
+
+TimerService::TimerService()
+    : wheel_(TimeMillis()),
+      wake_up_ms_(TimingWheel::kNever),
+      stopped_(false),
+      thread_(&TimerService::Run, this)
+{}
+
+TimerService::~TimerService()
+{
+    {
+        MutexLock lock(&mutex_);
+        stopped_ = true;
+    }
+    cv_.NotifyAll();
+    thread_.join();
+    wheel_.Clear();
+}
+
+TimerService::TaskId
+TimerService::Schedule(TimeDelta delay, UniqueTask &&on_expired)
+{
+    const int64_t run_time_ms = TimeMillis() + std::max<int64_t>(delay.ms(), 0);
+    const TaskId id = wheel_.Schedule(run_time_ms, std::move(on_expired));
+    MutexLock lock(&mutex_);
+    // the timer thread reads the wheel under mutex_ before it sleeps, so it either saw the task or is told here
+    if (run_time_ms < wake_up_ms_) {
+        wake_up_ms_ = run_time_ms;
+        cv_.NotifyOne();
+    }
+    return id;
+}
+
+bool
+TimerService::Cancel(TaskId id)
+{
+    // the timer thread may still wake up for it, and finds nothing due
+    return wheel_.Cancel(id);
+}
+
+size_t
+TimerService::size() const
+{
+    return wheel_.size();
+}
+
+void
+TimerService::Run()
+{
+    std::vector<UniqueTask> due;
+    while (true) {
+        wheel_.Advance(TimeMillis(), &due);
+        for (UniqueTask &task : due) { task(); }
+        due.clear();
+
+        MutexLock lock(&mutex_);
+        if (stopped_) { break; }
+        const int64_t now_ms = TimeMillis();
+        const int64_t wake_up_ms = wheel_.NextExpiry();
+        if (wake_up_ms <= now_ms) { continue; }
+        wake_up_ms_ = wake_up_ms;
+        const TimeDelta timeout = wake_up_ms == TimingWheel::kNever ? ConditionVariable::kForever
+                                                                    : TimeDelta::Millis(wake_up_ms - now_ms);
+        cv_.WaitFor(lock, timeout, [this, wake_up_ms] {
+            return stopped_ || wake_up_ms_ < wake_up_ms;
+        });
+    }
+}
+
+}// namespace sled
@@ -0,0 +1,60 @@
+/**
+ * @file     : timer_service
+ * @created  : Sunday Oct 18, 2026 18:05:12 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_TIMER_TIMER_SERVICE_H
+#define SLED_TIMER_TIMER_SERVICE_H
+#pragma once
+
+#include "sled/synchronization/mutex.h"
+#include "sled/task_queue/unique_task.h"
+#include "sled/timer/timing_wheel.h"
+#include "sled/units/time_delta.h"
+#include <thread>
+
+namespace sled {
+
+/**
+ * One thread that only keeps deadlines. A scheduled task runs on that thread
+ * when it comes due, so it should do no more than hand the real work off to
+ * where it belongs, e.g. enqueue it onto a worker pool. Deadlines live in a
+ * TimingWheel, one millisecond resolution.
+ *
+ * All methods are thread-safe.
+ **/
+class TimerService {
+public:
+    typedef TimingWheel::TaskId TaskId;
+
+    // shared by everyone who has no reason for a timer thread of their own
+    static TimerService &Default();
+
+    TimerService();
+    // drops the tasks that haven't come due yet
+    ~TimerService();
+
+    TimerService(const TimerService &) = delete;
+    TimerService &operator=(const TimerService &) = delete;
+
+    TaskId Schedule(TimeDelta delay, UniqueTask &&on_expired);
+    // false if the task already came due or was cancelled
+    bool Cancel(TaskId id);
+    size_t size() const;
+
+private:
+    void Run();
+
+    TimingWheel wheel_;
+    Mutex mutex_;
+    ConditionVariable cv_;
+    // when the timer thread wakes up next, TimingWheel::kNever while it waits for a task
+    int64_t wake_up_ms_ SLED_GUARDED_BY(mutex_);
+    bool stopped_ SLED_GUARDED_BY(mutex_);
+    std::thread thread_;
+};
+
+}// namespace sled
+
+#endif// SLED_TIMER_TIMER_SERVICE_H
@@ -0,0 +1,62 @@
+#include <sled/synchronization/event.h>
+#include <sled/time_utils.h>
+#include <sled/timer/timer_service.h>
+#include <thread>
+
+TEST_SUITE("TimerService")
+{
+    TEST_CASE("runs on the timer thread when due")
+    {
+        sled::TimerService service;
+        sled::Event done;
+        std::thread::id ran_on;
+        const int64_t start_ms = sled::TimeMillis();
+        int64_t ran_ms = 0;
+        service.Schedule(sled::TimeDelta::Millis(50), [&] {
+            ran_ms = sled::TimeMillis();
+            ran_on = std::this_thread::get_id();
+            done.Set();
+        });
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_GE(ran_ms - start_ms, 50);
+        CHECK_NE(ran_on, std::this_thread::get_id());
+    }
+
+    TEST_CASE("an earlier task wakes the timer thread")
+    {
+        sled::TimerService service;
+        sled::Event done;
+        service.Schedule(sled::TimeDelta::Seconds(60), [] {});
+        // let the timer thread go to sleep for the minute
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        service.Schedule(sled::TimeDelta::Millis(10), [&done] { done.Set(); });
+        CHECK(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_EQ(service.size(), 1);
+    }
+
+    TEST_CASE("cancel")
+    {
+        sled::TimerService service;
+        sled::Event done;
+        auto value = std::make_shared<int>(0);
+        const sled::TimerService::TaskId id =
+            service.Schedule(sled::TimeDelta::Millis(10), [value] { ++*value; });
+        service.Schedule(sled::TimeDelta::Millis(20), [&done] { done.Set(); });
+        CHECK(service.Cancel(id));
+        CHECK_EQ(value.use_count(), 1);
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_EQ(*value, 0);
+        CHECK_FALSE(service.Cancel(id));
+    }
+
+    TEST_CASE("pending tasks are dropped with the service")
+    {
+        auto value = std::make_shared<int>(0);
+        {
+            sled::TimerService service;
+            service.Schedule(sled::TimeDelta::Seconds(60), [value] { ++*value; });
+        }
+        CHECK_EQ(value.use_count(), 1);
+        CHECK_EQ(*value, 0);
+    }
+}
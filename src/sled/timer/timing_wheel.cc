@@ -0,0 +1,243 @@
+#include "sled/timer/timing_wheel.h"
+#include <algorithm>
+
+namespace sled {
+
+namespace {
+// level 0 has 256 slots of 1ms, every level above 64 slots of 64 times the one below
+constexpr int kShift[] = {0, 8, 14, 20, 26};
+constexpr int kBits[] = {8, 6, 6, 6, 6};
+constexpr int kOffset[] = {0, 256, 320, 384, 448};
+}// namespace
+
+constexpr int64_t TimingWheel::kNever;
+constexpr int TimingWheel::kLevels;
+constexpr int TimingWheel::kSlots;
+constexpr uint32_t TimingWheel::kNil;
+
+TimingWheel::TimingWheel(int64_t now_ms) : current_ms_(now_ms), free_(kNil), size_(0)
+{
+    for (Slot &slot : slots_) { slot.head = slot.tail = kNil; }
+    std::fill(std::begin(occupied_), std::end(occupied_), 0);
+}
+
+TimingWheel::TaskId
+TimingWheel::Schedule(int64_t run_time_ms, UniqueTask &&task)
+{
+    MutexLock lock(&mutex_);
+    const uint32_t index = Allocate();
+    Entry &entry = entries_[index];
+    entry.run_time_ms = run_time_ms;
+    entry.task = std::move(task);
+    Place(index);
+    return (static_cast<TaskId>(entry.generation) << 32) | index;
+}
+
+bool
+TimingWheel::Cancel(TaskId id)
+{
+    const uint32_t index = static_cast<uint32_t>(id);
+    const uint32_t generation = static_cast<uint32_t>(id >> 32);
+    // destroyed after the lock is released
+    UniqueTask task;
+    {
+        MutexLock lock(&mutex_);
+        if (index >= entries_.size() || entries_[index].generation != generation) { return false; }
+        Unlink(index);
+        task = std::move(entries_[index].task);
+        Release(index);
+    }
+    return true;
+}
+
+void
+TimingWheel::Advance(int64_t now_ms, std::vector<UniqueTask> *due)
+{
+    MutexLock lock(&mutex_);
+    while (current_ms_ <= now_ms) {
+        // nothing comes due or moves down before that
+        const int64_t next_ms = NextExpiryLocked();
+        if (next_ms > now_ms) {
+            current_ms_ = now_ms + 1;
+            break;
+        }
+        current_ms_ = std::max(current_ms_, next_ms);
+
+        const int index = static_cast<int>(current_ms_ & 255);
+        if (index == 0) {
+            for (int level = 1; level < kLevels; ++level) {
+                const int slot = static_cast<int>((current_ms_ >> kShift[level]) & 63);
+                Cascade(kOffset[level] + slot);
+                if (slot != 0) { break; }
+            }
+        }
+
+        for (uint32_t i = slots_[index].head; i != kNil;) {
+            const uint32_t next = entries_[i].next;
+            due->push_back(std::move(entries_[i].task));
+            Release(i);
+            i = next;
+        }
+        slots_[index].head = slots_[index].tail = kNil;
+        occupied_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+        ++current_ms_;
+    }
+}
+
+int64_t
+TimingWheel::NextExpiry() const
+{
+    MutexLock lock(&mutex_);
+    return NextExpiryLocked();
+}
+
+size_t
+TimingWheel::size() const
+{
+    MutexLock lock(&mutex_);
+    return size_;
+}
+
+void
+TimingWheel::Clear()
+{
+    std::vector<UniqueTask> tasks;
+    {
+        MutexLock lock(&mutex_);
+        for (int slot = 0; slot < kSlots; ++slot) {
+            for (uint32_t i = slots_[slot].head; i != kNil;) {
+                const uint32_t next = entries_[i].next;
+                tasks.push_back(std::move(entries_[i].task));
+                Release(i);
+                i = next;
+            }
+            slots_[slot].head = slots_[slot].tail = kNil;
+        }
+        std::fill(std::begin(occupied_), std::end(occupied_), 0);
+    }
+}
+
+int64_t
+TimingWheel::NextExpiryLocked() const
+{
+    if (size_ == 0) { return kNever; }
+
+    int64_t next = kNever;
+    const int distance = DistanceToOccupied(0, static_cast<int>(current_ms_ & 255));
+    if (distance >= 0) { next = current_ms_ + distance; }
+    for (int level = 1; level < kLevels; ++level) {
+        // a slot comes up, and its tasks move down, at the first millisecond it covers
+        const int64_t unit = current_ms_ >> kShift[level];
+        const int64_t first = (current_ms_ & ((int64_t(1) << kShift[level]) - 1)) == 0 ? unit : unit + 1;
+        const int d = DistanceToOccupied(level, static_cast<int>(first & 63));
+        if (d >= 0) { next = std::min(next, (first + d) << kShift[level]); }
+    }
+    return next;
+}
+
+uint32_t
+TimingWheel::Allocate()
+{
+    ++size_;
+    if (free_ != kNil) {
+        const uint32_t index = free_;
+        free_ = entries_[index].next;
+        return index;
+    }
+    entries_.emplace_back();
+    entries_.back().generation = 1;
+    return static_cast<uint32_t>(entries_.size() - 1);
+}
+
+void
+TimingWheel::Release(uint32_t index)
+{
+    Entry &entry = entries_[index];
+    entry.task = nullptr;
+    // ids of the released task no longer match
+    if (++entry.generation == 0) { entry.generation = 1; }
+    entry.next = free_;
+    free_ = index;
+    --size_;
+}
+
+void
+TimingWheel::Place(uint32_t index)
+{
+    const int64_t run_time_ms = entries_[index].run_time_ms;
+    const int64_t delta = run_time_ms - current_ms_;
+    if (delta < 0) {
+        Link(index, static_cast<int>(current_ms_ & 255));
+        return;
+    }
+
+    int level = 0;
+    while (level < kLevels - 1 && delta >= (int64_t(1) << (kShift[level] + kBits[level]))) { ++level; }
+    // beyond the last level, waits in its furthest slot and is placed again when that comes up
+    const int64_t span = int64_t(1) << (kShift[kLevels - 1] + kBits[kLevels - 1]);
+    const int64_t at = delta < span ? run_time_ms : current_ms_ + span - 1;
+    Link(index, kOffset[level] + static_cast<int>((at >> kShift[level]) & ((1 << kBits[level]) - 1)));
+}
+
+void
+TimingWheel::Link(uint32_t index, int slot)
+{
+    Entry &entry = entries_[index];
+    entry.slot = static_cast<uint16_t>(slot);
+    entry.next = kNil;
+    entry.prev = slots_[slot].tail;
+    if (entry.prev == kNil) {
+        slots_[slot].head = index;
+    } else {
+        entries_[entry.prev].next = index;
+    }
+    slots_[slot].tail = index;
+    occupied_[slot >> 6] |= uint64_t(1) << (slot & 63);
+}
+
+void
+TimingWheel::Unlink(uint32_t index)
+{
+    Entry &entry = entries_[index];
+    Slot &slot = slots_[entry.slot];
+    if (entry.prev == kNil) {
+        slot.head = entry.next;
+    } else {
+        entries_[entry.prev].next = entry.next;
+    }
+    if (entry.next == kNil) {
+        slot.tail = entry.prev;
+    } else {
+        entries_[entry.next].prev = entry.prev;
+    }
+    if (slot.head == kNil) { occupied_[entry.slot >> 6] &= ~(uint64_t(1) << (entry.slot & 63)); }
+}
+
+void
+TimingWheel::Cascade(int slot)
+{
+    uint32_t i = slots_[slot].head;
+    slots_[slot].head = slots_[slot].tail = kNil;
+    occupied_[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+    while (i != kNil) {
+        const uint32_t next = entries_[i].next;
+        Place(i);
+        i = next;
+    }
+}
+
+int
+TimingWheel::DistanceToOccupied(int level, int from) const
+{
+    const int slots = 1 << kBits[level];
+    const uint64_t *bits = occupied_ + kOffset[level] / 64;
+    for (int d = 0; d < slots;) {
+        const int i = (from + d) & (slots - 1);
+        const uint64_t word = bits[i >> 6] >> (i & 63);
+        if (word != 0) { return d + __builtin_ctzll(word); }
+        d += 64 - (i & 63);
+    }
+    return -1;
+}
+
+}// namespace sled
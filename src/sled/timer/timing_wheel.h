@@ -0,0 +1,97 @@
+/**
+ * @file     : timing_wheel
+ * @created  : Sunday Oct 18, 2026 16:10:15 CST
+ * @license  : MIT
+ **/
+
+#ifndef SLED_TIMER_TIMING_WHEEL_H
+#define SLED_TIMER_TIMING_WHEEL_H
+#pragma once
+
+#include "sled/synchronization/mutex.h"
+#include "sled/task_queue/unique_task.h"
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+namespace sled {
+
+/**
+ * Hierarchical timing wheel with a resolution of one millisecond: 256 slots
+ * of 1ms, then four levels of 64 slots, each 64 times coarser than the one
+ * below, about 49 days in all. Tasks further out wait in the last level and
+ * are placed again every time it turns.
+ *
+ * Schedule() and Cancel() are O(1). A task moves down a level whenever the
+ * slot it waits in comes up, and is due in the millisecond it was scheduled
+ * for. Tasks due in the same millisecond come out in the order they reached
+ * the lowest level.
+ *
+ * All methods are thread-safe. Tasks are never destroyed or run with the
+ * lock held.
+ **/
+class TimingWheel {
+public:
+    typedef uint64_t TaskId;
+    static constexpr int64_t kNever = std::numeric_limits<int64_t>::max();
+
+    explicit TimingWheel(int64_t now_ms);
+
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    TaskId Schedule(int64_t run_time_ms, UniqueTask &&task);
+    // false if `id` already came due or was cancelled
+    bool Cancel(TaskId id);
+    // appends every task due at `now_ms` to `due`
+    void Advance(int64_t now_ms, std::vector<UniqueTask> *due);
+    // nothing comes due before this, kNever when empty
+    int64_t NextExpiry() const;
+    size_t size() const;
+    // drops all tasks
+    void Clear();
+
+private:
+    struct Entry {
+        int64_t run_time_ms;
+        uint32_t generation;
+        uint32_t prev;
+        uint32_t next;
+        uint16_t slot;
+        UniqueTask task;
+    };
+
+    struct Slot {
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    static constexpr int kLevels = 5;
+    static constexpr int kSlots = 256 + 64 * (kLevels - 1);
+    static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+
+    uint32_t Allocate() SLED_REQUIRES(mutex_);
+    void Release(uint32_t index) SLED_REQUIRES(mutex_);
+    void Place(uint32_t index) SLED_REQUIRES(mutex_);
+    void Link(uint32_t index, int slot) SLED_REQUIRES(mutex_);
+    void Unlink(uint32_t index) SLED_REQUIRES(mutex_);
+    // places the tasks of a level > 0 slot again, one level lower or more
+    void Cascade(int slot) SLED_REQUIRES(mutex_);
+    int64_t NextExpiryLocked() const SLED_REQUIRES(mutex_);
+    // slots from `from` on until the next one in use in `level`, -1 if none is
+    int DistanceToOccupied(int level, int from) const SLED_REQUIRES(mutex_);
+
+    mutable Mutex mutex_;
+    // the next millisecond Advance() handles
+    int64_t current_ms_ SLED_GUARDED_BY(mutex_);
+    std::vector<Entry> entries_ SLED_GUARDED_BY(mutex_);
+    uint32_t free_ SLED_GUARDED_BY(mutex_);
+    size_t size_ SLED_GUARDED_BY(mutex_);
+    Slot slots_[kSlots] SLED_GUARDED_BY(mutex_);
+    // one bit per slot in use
+    uint64_t occupied_[kSlots / 64] SLED_GUARDED_BY(mutex_);
+};
+
+}// namespace sled
+
+#endif// SLED_TIMER_TIMING_WHEEL_H
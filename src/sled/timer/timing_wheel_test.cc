@@ -0,0 +1,123 @@
+#include <sled/synchronization/event.h>
+#include <sled/system/thread.h>
+#include <sled/timer/timing_wheel.h>
+
+namespace {
+// advances `wheel` to `now_ms` and returns the values of the tasks that came due
+std::vector<int>
+AdvanceTo(sled::TimingWheel &wheel, int64_t now_ms, std::vector<int> &fired)
+{
+    std::vector<sled::UniqueTask> due;
+    wheel.Advance(now_ms, &due);
+    fired.clear();
+    for (auto &task : due) { task(); }
+    return fired;
+}
+}// namespace
+
+TEST_SUITE("TimingWheel")
+{
+    TEST_CASE("due in order")
+    {
+        sled::TimingWheel wheel(1000);
+        std::vector<int> fired;
+        CHECK_EQ(wheel.NextExpiry(), sled::TimingWheel::kNever);
+        // level 0, the levels above and past the end of the wheel
+        const std::vector<int64_t> delays = {0, 1, 255, 256, 300, 16384, 100000, 5000000, int64_t(1) << 33};
+        for (size_t i = 0; i < delays.size(); ++i) {
+            const int value = static_cast<int>(i);
+            wheel.Schedule(1000 + delays[i], [&fired, value] { fired.push_back(value); });
+        }
+        CHECK_EQ(wheel.size(), delays.size());
+
+        int64_t now_ms = 1000;
+        for (size_t i = 0; i < delays.size(); ++i) {
+            const int64_t run_time_ms = 1000 + delays[i];
+            // the wheel may wake up early to move tasks down, but never late
+            std::vector<int> due;
+            while ((due = AdvanceTo(wheel, now_ms, fired)).empty()) {
+                const int64_t next_ms = wheel.NextExpiry();
+                REQUIRE_GT(next_ms, now_ms);
+                REQUIRE_LE(next_ms, run_time_ms);
+                now_ms = next_ms;
+            }
+            CHECK_EQ(now_ms, run_time_ms);
+            CHECK_EQ(due, std::vector<int>{static_cast<int>(i)});
+        }
+        CHECK_EQ(wheel.size(), 0);
+    }
+
+    TEST_CASE("same millisecond keeps the order")
+    {
+        sled::TimingWheel wheel(0);
+        std::vector<int> fired;
+        for (int i = 0; i < 5; ++i) {
+            wheel.Schedule(20000, [&fired, i] { fired.push_back(i); });
+        }
+        CHECK(AdvanceTo(wheel, 19999, fired).empty());
+        CHECK_EQ(AdvanceTo(wheel, 20000, fired), std::vector<int>{0, 1, 2, 3, 4});
+    }
+
+    TEST_CASE("overdue tasks come due right away")
+    {
+        sled::TimingWheel wheel(0);
+        std::vector<int> fired;
+        AdvanceTo(wheel, 500, fired);
+        wheel.Schedule(100, [&fired] { fired.push_back(1); });
+        CHECK_EQ(wheel.NextExpiry(), 501);
+        CHECK_EQ(AdvanceTo(wheel, 501, fired), std::vector<int>{1});
+    }
+
+    TEST_CASE("cancel")
+    {
+        sled::TimingWheel wheel(0);
+        std::vector<int> fired;
+        auto value = std::make_shared<int>(0);
+        const sled::TimingWheel::TaskId a = wheel.Schedule(10, [&fired] { fired.push_back(1); });
+        const sled::TimingWheel::TaskId b = wheel.Schedule(10, [&fired, value] { fired.push_back(2); });
+        const sled::TimingWheel::TaskId c = wheel.Schedule(10000, [&fired] { fired.push_back(3); });
+        CHECK(wheel.Cancel(b));
+        // the task is gone, not only skipped
+        CHECK_EQ(value.use_count(), 1);
+        CHECK_FALSE(wheel.Cancel(b));
+        CHECK(wheel.Cancel(c));
+        CHECK_EQ(wheel.size(), 1);
+
+        // the released entries don't answer to the old ids
+        wheel.Schedule(10, [&fired] { fired.push_back(4); });
+        CHECK_FALSE(wheel.Cancel(b));
+        CHECK_FALSE(wheel.Cancel(c));
+        CHECK_EQ(AdvanceTo(wheel, 10, fired), std::vector<int>{1, 4});
+        CHECK_FALSE(wheel.Cancel(a));
+        CHECK_EQ(wheel.NextExpiry(), sled::TimingWheel::kNever);
+    }
+
+    TEST_CASE("thread")
+    {
+        auto thread = sled::Thread::Create();
+        thread->Start();
+        sled::Event done;
+        auto value = std::make_shared<int>(0);
+        sled::DelayedTaskHandle cancelled =
+            thread->PostCancelableDelayedTask([value] { ++*value; }, sled::TimeDelta::Seconds(60));
+        sled::DelayedTaskHandle high = thread->PostCancelableDelayedTask(
+            [value] { ++*value; }, sled::TimeDelta::Millis(50), sled::TaskQueueBase::DelayPrecision::kHigh);
+        sled::DelayedTaskHandle fired = thread->PostCancelableDelayedTask([&done] { done.Set(); },
+                                                                          sled::TimeDelta::Millis(100));
+        CHECK_EQ(thread->size(), 3);
+        CHECK(cancelled.Cancel());
+        CHECK_FALSE(cancelled.IsValid());
+        // low precision tasks are dropped right away
+        CHECK_EQ(value.use_count(), 2);
+        CHECK(high.Cancel());
+        REQUIRE(done.Wait(sled::TimeDelta::Seconds(5)));
+        CHECK_FALSE(fired.Cancel());
+        CHECK_EQ(thread->BlockingCall([&] { return *value; }), 0);
+
+        sled::DelayedTaskHandle orphan = thread->PostCancelableDelayedTask([] {}, sled::TimeDelta::Seconds(60));
+        thread->Stop();
+        thread.reset();
+        CHECK(orphan.IsValid());
+        CHECK_FALSE(orphan.Cancel());
+    }
+}